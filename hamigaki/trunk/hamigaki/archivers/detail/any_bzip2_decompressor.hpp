@@ -0,0 +1,72 @@
+// any_bzip2_decompressor.hpp: bzip2 decompressor selected at runtime
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/archivers for library home page.
+
+#ifndef HAMIGAKI_ARCHIVERS_DETAIL_ANY_BZIP2_DECOMPRESSOR_HPP
+#define HAMIGAKI_ARCHIVERS_DETAIL_ANY_BZIP2_DECOMPRESSOR_HPP
+
+#include <hamigaki/archivers/detail/bzip2.hpp>
+#include <hamigaki/iostreams/filter/parallel_bzip2.hpp>
+#include <boost/iostreams/close.hpp>
+#include <boost/iostreams/read.hpp>
+#include <boost/optional.hpp>
+
+namespace hamigaki { namespace archivers { namespace detail {
+
+// bzip2_decompressor or parallel_bzip2_decompressor
+class any_bzip2_decompressor
+{
+public:
+    typedef char char_type;
+
+    struct category
+        : boost::iostreams::input
+        , boost::iostreams::filter_tag
+        , boost::iostreams::multichar_tag
+        , boost::iostreams::closable_tag
+    {};
+
+    explicit any_bzip2_decompressor(
+        std::size_t thread_count = 0,
+        int buffer_size = boost::iostreams::default_device_buffer_size)
+    {
+        if (thread_count != 0)
+        {
+            parallel_ = iostreams::parallel_bzip2_decompressor(
+                thread_count, static_cast<std::size_t>(buffer_size));
+        }
+        else
+            bzip2_ = boost::iostreams::bzip2_decompressor(false, buffer_size);
+    }
+
+    template<class Source>
+    std::streamsize read(Source& src, char* s, std::streamsize n)
+    {
+        if (parallel_)
+            return boost::iostreams::read(*parallel_, src, s, n);
+        else
+            return boost::iostreams::read(*bzip2_, src, s, n);
+    }
+
+    template<class Source>
+    void close(Source& src)
+    {
+        if (parallel_)
+            boost::iostreams::close(*parallel_, src, BOOST_IOS::in);
+        else
+            boost::iostreams::close(*bzip2_, src, BOOST_IOS::in);
+    }
+
+private:
+    boost::optional<boost::iostreams::bzip2_decompressor> bzip2_;
+    boost::optional<iostreams::parallel_bzip2_decompressor> parallel_;
+};
+
+} } } // End namespaces detail, archivers, hamigaki.
+
+#endif // HAMIGAKI_ARCHIVERS_DETAIL_ANY_BZIP2_DECOMPRESSOR_HPP
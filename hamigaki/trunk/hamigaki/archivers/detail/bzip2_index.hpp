@@ -0,0 +1,314 @@
+// bzip2_index.hpp: checkpoints for the random access to bzip2 files
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/archivers for library home page.
+
+#ifndef HAMIGAKI_ARCHIVERS_DETAIL_BZIP2_INDEX_HPP
+#define HAMIGAKI_ARCHIVERS_DETAIL_BZIP2_INDEX_HPP
+
+#include <hamigaki/archivers/detail/gzip_index.hpp>
+#include <hamigaki/archivers/tar/index.hpp>
+#include <hamigaki/integer/auto_min.hpp>
+#include <hamigaki/iostreams/detail/bzip2_block.hpp>
+#include <hamigaki/iostreams/blocking.hpp>
+#include <boost/iostreams/detail/ios.hpp>
+#include <boost/iostreams/positioning.hpp>
+#include <boost/iostreams/read.hpp>
+#include <boost/iostreams/seek.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace hamigaki { namespace archivers { namespace detail {
+
+// decompresses the bzip2 file block by block and records the blocks
+template<class Source>
+class bzip2_index_builder_impl : private boost::noncopyable
+{
+private:
+    typedef iostreams::detail::bzip2_marker marker_type;
+
+    static const std::size_t buffer_size = 64*1024;
+
+    // the number of the fake magics in a block which can be merged
+    static const std::size_t max_merge_count = 16;
+
+public:
+    explicit bzip2_index_builder_impl(const Source& src)
+        : src_(src), buffer_(buffer_size), base_(0), eof_(false)
+        , block_pos_(0), pos_(0), crc_(0)
+    {
+    }
+
+    std::streamsize read(char* s, std::streamsize n)
+    {
+        std::streamsize total = 0;
+        while (total < n)
+        {
+            if (block_pos_ == block_.size())
+            {
+                if (!this->next_block())
+                    break;
+                continue;
+            }
+
+            std::size_t amt =
+                hamigaki::auto_min(block_.size() - block_pos_, n - total);
+            std::memcpy(s + total, block_.data() + block_pos_, amt);
+            block_pos_ += amt;
+            pos_ += amt;
+            total += static_cast<std::streamsize>(amt);
+        }
+        return total != 0 ? total : -1;
+    }
+
+    boost::uint64_t position() const
+    {
+        return pos_;
+    }
+
+    const std::vector<tar::index_checkpoint>& checkpoints() const
+    {
+        return points_;
+    }
+
+private:
+    Source src_;
+    std::vector<char> buffer_;
+    iostreams::detail::bzip2_marker_scanner scanner_;
+    std::vector<marker_type> found_;
+    std::deque<marker_type> markers_;
+
+    // the compressed data from the byte offset base_
+    std::string data_;
+    boost::uint64_t base_;
+    bool eof_;
+
+    iostreams::detail::bzip2_block_decoder decoder_;
+    std::string block_;
+    std::size_t block_pos_;
+    boost::uint64_t pos_;
+    boost::uint32_t crc_;
+    std::vector<tar::index_checkpoint> points_;
+
+    bool read_more()
+    {
+        if (eof_)
+            return false;
+
+        std::streamsize amt = boost::iostreams::read(
+            src_, &buffer_[0], static_cast<std::streamsize>(buffer_.size()));
+        if (amt <= 0)
+        {
+            eof_ = true;
+            return false;
+        }
+
+        data_.append(&buffer_[0], static_cast<std::size_t>(amt));
+
+        found_.clear();
+        scanner_.scan(&buffer_[0], static_cast<std::size_t>(amt), found_);
+        markers_.insert(markers_.end(), found_.begin(), found_.end());
+        return true;
+    }
+
+    bool has_markers(std::size_t n)
+    {
+        while (markers_.size() < n)
+        {
+            if (!this->read_more())
+                return false;
+        }
+        return true;
+    }
+
+    void require_bits(boost::uint64_t bit)
+    {
+        while ((base_ + data_.size()) * 8 < bit)
+        {
+            if (!this->read_more())
+                throw BOOST_IOSTREAMS_FAILURE("unexpected end of bzip2 data");
+        }
+    }
+
+    void discard_data(boost::uint64_t bit)
+    {
+        boost::uint64_t byte = bit / 8;
+        data_.erase(0, static_cast<std::size_t>(byte - base_));
+        base_ = byte;
+    }
+
+    void check_stream_crc(const marker_type& m)
+    {
+        this->require_bits(m.bit_offset + 80);
+
+        boost::uint32_t crc = iostreams::detail::read_bzip2_bits(
+            data_.data(), m.bit_offset + 48 - base_*8, 32);
+        if (crc != crc_)
+            throw BOOST_IOSTREAMS_FAILURE("bzip2 CRC error");
+        crc_ = 0;
+    }
+
+    bool next_block()
+    {
+        while (this->has_markers(1))
+        {
+            const marker_type m = markers_.front();
+            if (m.kind == marker_type::end_of_stream)
+            {
+                this->check_stream_crc(m);
+                markers_.pop_front();
+                this->discard_data(m.bit_offset);
+                continue;
+            }
+
+            for (std::size_t k = 1; k <= max_merge_count; ++k)
+            {
+                if (!this->has_markers(k+1))
+                    break;
+
+                const marker_type last = markers_[k];
+                this->require_bits(last.bit_offset);
+
+                boost::uint64_t base_bits = base_*8;
+                boost::uint32_t crc;
+                if (decoder_.decode(
+                    data_.data(),
+                    m.bit_offset - base_bits, last.bit_offset - base_bits,
+                    m.level, block_, crc) )
+                {
+                    this->add_checkpoint(m, last.bit_offset - m.bit_offset);
+                    crc_ = iostreams::detail::bzip2_combine_crc(crc_, crc);
+
+                    markers_.erase(markers_.begin(), markers_.begin() + k);
+                    this->discard_data(last.bit_offset);
+                    block_pos_ = 0;
+                    return true;
+                }
+                // the magic appeared in the compressed data by chance
+            }
+            throw BOOST_IOSTREAMS_FAILURE("bzip2 data error");
+        }
+        return false;
+    }
+
+    void add_checkpoint(const marker_type& m, boost::uint64_t bit_size)
+    {
+        tar::index_checkpoint point;
+        point.offset = pos_;
+        point.bit_offset = m.bit_offset;
+        point.bit_size = bit_size;
+        point.level = m.level;
+        points_.push_back(point);
+    }
+};
+
+// decompresses the blocks recorded in the index
+template<class Source>
+class bzip2_index_reader_impl : private boost::noncopyable
+{
+public:
+    bzip2_index_reader_impl(
+            const Source& src,
+            const std::vector<tar::index_checkpoint>& points)
+        : src_(src), points_(points)
+        , index_(0), loaded_(false), block_pos_(0)
+    {
+    }
+
+    std::streamsize read(char* s, std::streamsize n)
+    {
+        std::streamsize total = 0;
+        while (total < n)
+        {
+            if (!loaded_)
+            {
+                if (points_.empty())
+                    break;
+                this->load(0);
+            }
+            else if (block_pos_ == block_.size())
+            {
+                if (index_ + 1 >= points_.size())
+                    break;
+                this->load(index_ + 1);
+                continue;
+            }
+
+            std::size_t amt =
+                hamigaki::auto_min(block_.size() - block_pos_, n - total);
+            std::memcpy(s + total, block_.data() + block_pos_, amt);
+            block_pos_ += amt;
+            total += static_cast<std::streamsize>(amt);
+        }
+        return total != 0 ? total : -1;
+    }
+
+    void seek(boost::uint64_t off)
+    {
+        std::size_t index = find_index_checkpoint(points_, off);
+        if (!loaded_ || (index != index_))
+            this->load(index);
+
+        boost::uint64_t pos = off - points_[index].offset;
+        if (pos > block_.size())
+            throw BOOST_IOSTREAMS_FAILURE("bad seek offset");
+        block_pos_ = static_cast<std::size_t>(pos);
+    }
+
+    boost::uint64_t position() const
+    {
+        if (loaded_)
+            return points_[index_].offset + block_pos_;
+        else
+            return 0;
+    }
+
+private:
+    Source src_;
+    const std::vector<tar::index_checkpoint>& points_;
+    iostreams::detail::bzip2_block_decoder decoder_;
+    std::string data_;
+    std::string block_;
+    std::size_t index_;
+    bool loaded_;
+    std::size_t block_pos_;
+
+    void load(std::size_t index)
+    {
+        typedef boost::iostreams::stream_offset off_t;
+
+        const tar::index_checkpoint& point = points_[index];
+        boost::uint64_t first = point.bit_offset / 8;
+        boost::uint64_t last = (point.bit_offset + point.bit_size + 7) / 8;
+
+        boost::iostreams::seek(
+            src_, static_cast<off_t>(first), BOOST_IOS::beg);
+        data_.resize(static_cast<std::size_t>(last - first));
+        iostreams::blocking_read(
+            src_, &data_[0], static_cast<std::streamsize>(data_.size()));
+
+        boost::uint64_t bit = point.bit_offset - first*8;
+        boost::uint32_t crc;
+        if (!decoder_.decode(
+            data_.data(), bit, bit + point.bit_size, point.level, block_, crc))
+        {
+            throw BOOST_IOSTREAMS_FAILURE("bzip2 data error");
+        }
+
+        index_ = index;
+        loaded_ = true;
+        block_pos_ = 0;
+    }
+};
+
+} } } // End namespaces detail, archivers, hamigaki.
+
+#endif // HAMIGAKI_ARCHIVERS_DETAIL_BZIP2_INDEX_HPP
@@ -0,0 +1,426 @@
+// gzip_index.hpp: checkpoints for the random access to gzip files
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/archivers for library home page.
+
+#ifndef HAMIGAKI_ARCHIVERS_DETAIL_GZIP_INDEX_HPP
+#define HAMIGAKI_ARCHIVERS_DETAIL_GZIP_INDEX_HPP
+
+#include <hamigaki/archivers/tar/index.hpp>
+#include <hamigaki/integer/auto_min.hpp>
+#include <boost/iostreams/detail/ios.hpp>
+#include <boost/iostreams/positioning.hpp>
+#include <boost/iostreams/read.hpp>
+#include <boost/iostreams/seek.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+namespace hamigaki { namespace archivers { namespace detail {
+
+const std::size_t gzip_window_size = 32*1024;
+
+// keeps the last 32KiB of the uncompressed data
+class gzip_window
+{
+public:
+    gzip_window() : buffer_(gzip_window_size), pos_(0), size_(0)
+    {
+    }
+
+    void append(const char* s, std::size_t n)
+    {
+        if (n > gzip_window_size)
+        {
+            s += n - gzip_window_size;
+            n = gzip_window_size;
+        }
+
+        while (n != 0)
+        {
+            std::size_t amt = (std::min)(n, gzip_window_size - pos_);
+            std::memcpy(&buffer_[pos_], s, amt);
+            pos_ = (pos_ + amt) % gzip_window_size;
+            size_ = (std::min)(size_ + amt, gzip_window_size);
+            s += amt;
+            n -= amt;
+        }
+    }
+
+    // returns the window compressed by zlib
+    std::string compress() const
+    {
+        std::string data;
+        data.reserve(size_);
+        if (size_ == gzip_window_size)
+            data.append(&buffer_[pos_], gzip_window_size - pos_);
+        data.append(&buffer_[0], pos_);
+
+        if (data.empty())
+            return data;
+
+        ::uLongf size = ::compressBound(static_cast< ::uLong>(data.size()));
+        std::string out(size, '\0');
+        if (::compress2(
+            reinterpret_cast< ::Bytef*>(&out[0]), &size,
+            reinterpret_cast<const ::Bytef*>(data.data()),
+            static_cast< ::uLong>(data.size()), Z_BEST_COMPRESSION) != Z_OK)
+        {
+            throw BOOST_IOSTREAMS_FAILURE("failed to compress gzip window");
+        }
+        out.resize(size);
+        return out;
+    }
+
+private:
+    std::vector<char> buffer_;
+    std::size_t pos_;
+    std::size_t size_;
+};
+
+inline std::string uncompress_gzip_window(const std::string& window)
+{
+    if (window.empty())
+        return window;
+
+    std::string data(gzip_window_size, '\0');
+    ::uLongf size = static_cast< ::uLongf>(data.size());
+    if (::uncompress(
+        reinterpret_cast< ::Bytef*>(&data[0]), &size,
+        reinterpret_cast<const ::Bytef*>(window.data()),
+        static_cast< ::uLong>(window.size())) != Z_OK)
+    {
+        throw BOOST_IOSTREAMS_FAILURE("broken gzip window");
+    }
+    data.resize(size);
+    return data;
+}
+
+class inflate_base : private boost::noncopyable
+{
+protected:
+    static const std::size_t buffer_size = 64*1024;
+
+    explicit inflate_base(int window_bits) : buffer_(buffer_size)
+    {
+        std::memset(&zs_, 0, sizeof(zs_));
+        if (::inflateInit2(&zs_, window_bits) != Z_OK)
+            throw BOOST_IOSTREAMS_FAILURE("failed to initialize inflate");
+    }
+
+    ~inflate_base()
+    {
+        ::inflateEnd(&zs_);
+    }
+
+    void reset(int window_bits)
+    {
+        ::inflateEnd(&zs_);
+        std::memset(&zs_, 0, sizeof(zs_));
+        if (::inflateInit2(&zs_, window_bits) != Z_OK)
+            throw BOOST_IOSTREAMS_FAILURE("failed to initialize inflate");
+    }
+
+    template<class Source>
+    bool fill(Source& src)
+    {
+        std::streamsize amt = boost::iostreams::read(
+            src, &buffer_[0], static_cast<std::streamsize>(buffer_.size()));
+        if (amt <= 0)
+            return false;
+
+        zs_.next_in = reinterpret_cast< ::Bytef*>(&buffer_[0]);
+        zs_.avail_in = static_cast< ::uInt>(amt);
+        return true;
+    }
+
+    // the next gzip member follows the trailer in the concatenated file
+    template<class Source>
+    bool has_next_member(Source& src)
+    {
+        if ((zs_.avail_in == 0) && !this->fill(src))
+            return false;
+        return zs_.next_in[0] == 0x1F;
+    }
+
+    static void check_inflate_result(int ret)
+    {
+        if ((ret != Z_OK) && (ret != Z_STREAM_END) && (ret != Z_BUF_ERROR))
+            throw BOOST_IOSTREAMS_FAILURE("gzip data error");
+    }
+
+    ::z_stream zs_;
+    std::vector<char> buffer_;
+};
+
+// decompresses the gzip file and records the checkpoints
+template<class Source>
+class gzip_index_builder_impl : private inflate_base
+{
+public:
+    gzip_index_builder_impl(const Source& src, boost::uint64_t span)
+        : inflate_base(MAX_WBITS + 16), src_(src), span_(span)
+        , in_pos_(0), pos_(0), end_(false)
+    {
+    }
+
+    std::streamsize read(char* s, std::streamsize n)
+    {
+        zs_.next_out = reinterpret_cast< ::Bytef*>(s);
+        zs_.avail_out = static_cast< ::uInt>(n);
+
+        while ((zs_.avail_out != 0) && !end_)
+        {
+            if ((zs_.avail_in == 0) && !this->fill(src_))
+                throw BOOST_IOSTREAMS_FAILURE("unexpected end of gzip data");
+
+            ::uInt in_size = zs_.avail_in;
+            char* out = reinterpret_cast<char*>(zs_.next_out);
+            ::uInt out_size = zs_.avail_out;
+
+            int ret = ::inflate(&zs_, Z_BLOCK);
+            check_inflate_result(ret);
+
+            in_pos_ += in_size - zs_.avail_in;
+            window_.append(out, out_size - zs_.avail_out);
+            pos_ += out_size - zs_.avail_out;
+
+            if (ret == Z_STREAM_END)
+            {
+                if (this->has_next_member(src_))
+                    ::inflateReset(&zs_);
+                else
+                    end_ = true;
+            }
+            else if (((zs_.data_type & 128) != 0) &&
+                ((zs_.data_type & 64) == 0) )
+            {
+                // the end of the header or the deflate block
+                if (points_.empty() || (pos_ - points_.back().offset >= span_))
+                    this->add_checkpoint();
+            }
+        }
+
+        std::streamsize total =
+            n - static_cast<std::streamsize>(zs_.avail_out);
+        return total != 0 ? total : -1;
+    }
+
+    boost::uint64_t position() const
+    {
+        return pos_;
+    }
+
+    const std::vector<tar::index_checkpoint>& checkpoints() const
+    {
+        return points_;
+    }
+
+private:
+    Source src_;
+    boost::uint64_t span_;
+    boost::uint64_t in_pos_;
+    boost::uint64_t pos_;
+    bool end_;
+    gzip_window window_;
+    std::vector<tar::index_checkpoint> points_;
+
+    void add_checkpoint()
+    {
+        tar::index_checkpoint point;
+        point.offset = pos_;
+        point.bit_offset = in_pos_*8 - (zs_.data_type & 7);
+        point.window = window_.compress();
+        points_.push_back(point);
+    }
+};
+
+struct index_checkpoint_offset_less
+{
+    bool operator()(
+        const tar::index_checkpoint& lhs, boost::uint64_t rhs) const
+    {
+        return lhs.offset < rhs;
+    }
+
+    bool operator()(
+        boost::uint64_t lhs, const tar::index_checkpoint& rhs) const
+    {
+        return lhs < rhs.offset;
+    }
+};
+
+// returns the index of the last checkpoint before off
+inline std::size_t find_index_checkpoint(
+    const std::vector<tar::index_checkpoint>& points, boost::uint64_t off)
+{
+    std::vector<tar::index_checkpoint>::const_iterator it =
+        std::upper_bound(
+            points.begin(), points.end(), off,
+            index_checkpoint_offset_less());
+    if (it == points.begin())
+        throw BOOST_IOSTREAMS_FAILURE("bad seek offset");
+    return static_cast<std::size_t>(it - points.begin()) - 1;
+}
+
+// restarts the raw inflate from the checkpoints like zran.c of zlib
+template<class Source>
+class gzip_index_reader_impl : private inflate_base
+{
+public:
+    gzip_index_reader_impl(
+            const Source& src,
+            const std::vector<tar::index_checkpoint>& points)
+        : inflate_base(-MAX_WBITS), src_(src), points_(points)
+        , pos_(0), end_(false), raw_(true)
+    {
+        if (points_.empty())
+            throw BOOST_IOSTREAMS_FAILURE("empty gzip index");
+        this->restart(0);
+    }
+
+    std::streamsize read(char* s, std::streamsize n)
+    {
+        zs_.next_out = reinterpret_cast< ::Bytef*>(s);
+        zs_.avail_out = static_cast< ::uInt>(n);
+
+        while ((zs_.avail_out != 0) && !end_)
+        {
+            if ((zs_.avail_in == 0) && !this->fill(src_))
+                throw BOOST_IOSTREAMS_FAILURE("unexpected end of gzip data");
+
+            ::uInt out_size = zs_.avail_out;
+            int ret = ::inflate(&zs_, Z_NO_FLUSH);
+            check_inflate_result(ret);
+            pos_ += out_size - zs_.avail_out;
+
+            if (ret == Z_STREAM_END)
+                this->next_member();
+        }
+
+        std::streamsize total =
+            n - static_cast<std::streamsize>(zs_.avail_out);
+        return total != 0 ? total : -1;
+    }
+
+    void seek(boost::uint64_t off)
+    {
+        // restarts only if no checkpoint is nearer than the current position
+        std::size_t index = find_index_checkpoint(points_, off);
+        if ((off < pos_) || (points_[index].offset > pos_))
+            this->restart(index);
+
+        this->discard(off - pos_);
+    }
+
+    boost::uint64_t position() const
+    {
+        return pos_;
+    }
+
+private:
+    Source src_;
+    const std::vector<tar::index_checkpoint>& points_;
+    boost::uint64_t pos_;
+    bool end_;
+    bool raw_;
+    std::vector<char> discard_buffer_;
+
+    void discard(boost::uint64_t n)
+    {
+        if (discard_buffer_.empty())
+            discard_buffer_.resize(buffer_size);
+
+        while (n != 0)
+        {
+            std::streamsize amt = this->read(
+                &discard_buffer_[0],
+                hamigaki::auto_min(discard_buffer_.size(), n));
+            if (amt == -1)
+                throw BOOST_IOSTREAMS_FAILURE("bad seek offset");
+            n -= static_cast<boost::uint64_t>(amt);
+        }
+    }
+
+    void restart(std::size_t index)
+    {
+        typedef boost::iostreams::stream_offset off_t;
+
+        const tar::index_checkpoint& point = points_[index];
+        boost::uint64_t in_pos = (point.bit_offset + 7) / 8;
+        int bits = static_cast<int>(in_pos*8 - point.bit_offset);
+
+        this->reset(-MAX_WBITS);
+        boost::iostreams::seek(
+            src_, static_cast<off_t>(in_pos - (bits ? 1 : 0)), BOOST_IOS::beg);
+
+        if (bits != 0)
+        {
+            if (!this->fill(src_))
+                throw BOOST_IOSTREAMS_FAILURE("unexpected end of gzip data");
+
+            int c = zs_.next_in[0];
+            ++zs_.next_in;
+            --zs_.avail_in;
+            ::inflatePrime(&zs_, bits, c >> (8 - bits));
+        }
+
+        const std::string& dict = uncompress_gzip_window(point.window);
+        if (!dict.empty())
+        {
+            ::inflateSetDictionary(&zs_,
+                reinterpret_cast<const ::Bytef*>(dict.data()),
+                static_cast< ::uInt>(dict.size()));
+        }
+
+        pos_ = point.offset;
+        end_ = false;
+        raw_ = true;
+    }
+
+    void next_member()
+    {
+        // the raw inflate leaves the trailer (CRC32 and ISIZE)
+        if (raw_)
+        {
+            for (int i = 0; i < 8; ++i)
+            {
+                if ((zs_.avail_in == 0) && !this->fill(src_))
+                    throw BOOST_IOSTREAMS_FAILURE("bad gzip trailer");
+                ++zs_.next_in;
+                --zs_.avail_in;
+            }
+        }
+
+        if (!this->has_next_member(src_))
+        {
+            end_ = true;
+            return;
+        }
+
+        if (raw_)
+        {
+            ::z_stream zs = zs_;
+            this->reset(MAX_WBITS + 16);
+            zs_.next_in = zs.next_in;
+            zs_.avail_in = zs.avail_in;
+            zs_.next_out = zs.next_out;
+            zs_.avail_out = zs.avail_out;
+            raw_ = false;
+        }
+        else
+            ::inflateReset(&zs_);
+    }
+};
+
+} } } // End namespaces detail, archivers, hamigaki.
+
+#endif // HAMIGAKI_ARCHIVERS_DETAIL_GZIP_INDEX_HPP
@@ -11,6 +11,7 @@
 #define HAMIGAKI_ARCHIVERS_DETAIL_LZH_FILE_SINK_IMPL_HPP
 
 #include <hamigaki/archivers/detail/raw_lzh_file_sink_impl.hpp>
+#include <hamigaki/checksum/crc.hpp>
 #include <hamigaki/iostreams/filter/lzhuf.hpp>
 #include <boost/ref.hpp>
 #include <memory>
@@ -114,7 +115,7 @@ public:
 private:
     raw_type raw_;
     boost::int64_t pos_;
-    boost::crc_16_type crc_;
+    hamigaki::checksum::crc_16_type crc_;
     lha::compress_method method_;
     bool compressed_;
     std::auto_ptr<iostreams::lzhuf_compressor> lzhuf_ptr_;
@@ -11,6 +11,7 @@
 #define HAMIGAKI_ARCHIVERS_DETAIL_LZH_FILE_SOURCE_IMPL_HPP
 
 #include <hamigaki/archivers/detail/raw_lzh_file_source_impl.hpp>
+#include <hamigaki/checksum/crc.hpp>
 #include <hamigaki/integer/auto_min.hpp>
 #include <hamigaki/iostreams/filter/lzhuf.hpp>
 #include <boost/ref.hpp>
@@ -93,7 +94,7 @@ public:
 private:
     raw_type raw_;
     boost::int64_t pos_;
-    boost::crc_16_type crc_;
+    hamigaki::checksum::crc_16_type crc_;
     std::auto_ptr<iostreams::lzhuf_decompressor> lzhuf_ptr_;
 
     std::streamsize read_impl(char* s, std::streamsize n)
@@ -11,13 +11,13 @@
 #define HAMIGAKI_ARCHIVERS_DETAIL_LZH_HEADER_PARSER_HPP
 
 #include <hamigaki/archivers/lha/headers.hpp>
+#include <hamigaki/checksum/crc.hpp>
 #include <hamigaki/checksum/sum8.hpp>
 #include <hamigaki/iostreams/binary_io.hpp>
 #include <hamigaki/iostreams/relative_restrict.hpp>
 #include <boost/iostreams/detail/adapter/direct_adapter.hpp>
 #include <boost/iostreams/device/array.hpp>
 #include <boost/tuple/tuple.hpp>
-#include <boost/crc.hpp>
 #include <boost/scoped_array.hpp>
 #include <algorithm>
 #include <stdexcept>
@@ -390,7 +390,7 @@ private:
     Source& src_;
     header_type header_;
     char buffer_[hamigaki::struct_size<lha::lv0_header>::value];
-    boost::crc_16_type crc_;
+    hamigaki::checksum::crc_16_type crc_;
 
     void parse_lv0_header()
     {
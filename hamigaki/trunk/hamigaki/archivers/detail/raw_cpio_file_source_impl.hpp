@@ -19,6 +19,7 @@
 #include <boost/noncopyable.hpp>
 #include <boost/scoped_array.hpp>
 #include <cstring>
+#include <vector>
 
 namespace hamigaki { namespace archivers { namespace detail {
 
@@ -139,7 +140,7 @@ public:
     bool next_entry()
     {
         if (boost::uint32_t rest = header_.file_size - pos_)
-            iostreams::skip(src_, rest);
+            iostreams::skip(src_, rest, skip_buffer_);
         pos_ = 0;
 
         header_ = read_header();
@@ -180,6 +181,7 @@ private:
     Source src_;
     cpio::header header_;
     boost::uint32_t pos_;
+    std::vector<char> skip_buffer_;
 
     cpio::header read_header()
     {
@@ -13,6 +13,7 @@
 #include <hamigaki/archivers/detail/path.hpp>
 #include <hamigaki/archivers/lha/headers.hpp>
 #include <hamigaki/archivers/error.hpp>
+#include <hamigaki/checksum/crc.hpp>
 #include <hamigaki/checksum/sum8.hpp>
 #include <hamigaki/iostreams/binary_io.hpp>
 #include <hamigaki/iostreams/seek.hpp>
@@ -20,7 +21,6 @@
 #include <boost/iostreams/device/back_inserter.hpp>
 #include <boost/iostreams/close.hpp>
 #include <boost/tuple/tuple.hpp>
-#include <boost/crc.hpp>
 #include <algorithm>
 #include <iterator>
 #include <sstream>
@@ -564,7 +564,7 @@ private:
         sum.process_bytes(buffer.c_str()+2, basic_size);
         buffer[1] = sum.checksum();
 
-        boost::crc_16_type crc;
+        hamigaki::checksum::crc_16_type crc;
         crc.process_bytes(buffer.c_str(), buffer.size());
         char crc_buf[2];
         hamigaki::encode_uint<little,2>(crc_buf, crc.checksum());
@@ -707,7 +707,7 @@ private:
         buffer[0] = size_buf[0];
         buffer[1] = size_buf[1];
 
-        boost::crc_16_type crc;
+        hamigaki::checksum::crc_16_type crc;
         crc.process_bytes(buffer.c_str(), buffer.size());
         char crc_buf[2];
         hamigaki::encode_uint<little,2>(crc_buf, crc.checksum());
@@ -13,6 +13,7 @@
 #include <hamigaki/archivers/detail/lzh_header_parser.hpp>
 #include <hamigaki/integer/auto_min.hpp>
 #include <hamigaki/iostreams/skip.hpp>
+#include <vector>
 
 namespace hamigaki { namespace archivers { namespace detail {
 
@@ -39,7 +40,7 @@ public:
     bool next_entry()
     {
         if (boost::int64_t rest = header_.compressed_size - pos_)
-            iostreams::skip(src_, rest);
+            iostreams::skip(src_, rest, skip_buffer_);
         pos_ = 0;
 
         lzh_detail::lzh_header_parser<Source,Path> parser(src_);
@@ -72,6 +73,7 @@ private:
     Source src_;
     header_type header_;
     boost::int64_t pos_;
+    std::vector<char> skip_buffer_;
 };
 
 } } } // End namespaces detail, archivers, hamigaki.
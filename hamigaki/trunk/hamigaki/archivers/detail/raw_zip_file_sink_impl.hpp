@@ -17,7 +17,6 @@
 #include <boost/iostreams/device/back_inserter.hpp>
 #include <boost/iostreams/categories.hpp>
 #include <boost/iostreams/close.hpp>
-#include <boost/crc.hpp>
 #include <boost/noncopyable.hpp>
 #include <stdexcept>
 #include <vector>
@@ -237,6 +236,15 @@ public:
     {
     }
 
+    // appends the entries after "headers" which are already in the sink
+    basic_raw_zip_file_sink_impl(
+            const Sink& sink,
+            const std::vector<zip_internal_header<Path> >& headers)
+        : sink_(sink), size_(0), overflow_(false), zip64_(false)
+        , headers_(headers)
+    {
+    }
+
     void create_entry(const header_type& head)
     {
         if (overflow_)
@@ -259,6 +267,12 @@ public:
         if (header_.offset >= 0xFFFFFFFFull)
             zip64_ = true;
 
+        header_.made_by = 20;
+        header_.flags = default_zip_flags<Path>::value;
+        if (header_.encrypted)
+            header_.flags |= zip::flags::encrypted | zip::flags::has_data_dec;
+        header_.internal_attributes = 0;
+
         write_local_file_header(header_);
 
         size_ = 0;
@@ -282,11 +296,14 @@ public:
 
     std::streamsize write(const char* s, std::streamsize n)
     {
-        // Note: If header_.file_size >= 2^32, use ZIP64.
-        boost::uint32_t max_size =
-            static_cast<boost::uint32_t>(header_.file_size);
-        if (header_.encrypted)
-            max_size += zip::consts::encryption_header_size;
+        // the size is known if the data is already compressed
+        boost::uint64_t max_size = header_.compressed_size;
+        if (max_size == 0)
+        {
+            max_size = header_.file_size;
+            if (header_.encrypted)
+                max_size += zip::consts::encryption_header_size;
+        }
 
         if (size_ + n > max_size)
         {
@@ -295,7 +312,7 @@ public:
         }
 
         iostreams::blocking_write(sink_, s, n);
-        size_ += static_cast<boost::uint32_t>(n);
+        size_ += static_cast<boost::uint64_t>(n);
         return n;
     }
 
@@ -333,7 +350,22 @@ public:
         headers_.back() = header_;
     }
 
+    // the comment of the archive (not converted)
+    void archive_comment(const std::string& s)
+    {
+        if (s.size() > 0xFFFFu)
+            throw std::runtime_error("too long ZIP comment");
+        comment_ = s;
+    }
+
     void close_archive()
+    {
+        write_central_dir();
+        boost::iostreams::close(sink_, BOOST_IOS::out);
+    }
+
+    // writes the central directory and the end records
+    void write_central_dir()
     {
         boost::uint64_t start_offset =
             static_cast<boost::uint64_t>(iostreams::tell_offset(sink_));
@@ -352,24 +384,29 @@ public:
             detail::write_central_extra_field(ex_sink, head);
 
             zip::file_header file_head;
-            file_head.made_by = 20;
+            file_head.made_by = head.made_by;
             file_head.needed_to_extract = head.version;
-
-            file_head.flags = default_zip_flags<Path>::value;
-            if (head.encrypted)
-            {
-                file_head.flags |=
-                    zip::flags::encrypted | zip::flags::has_data_dec;
-            }
+            file_head.flags = head.flags;
 
             const std::string& comment = detail::make_zip_comment(head.comment);
 
             file_head.method = head.method;
             file_head.update_date_time = msdos::date_time(head.update_time);
-            file_head.compressed_size =
-                static_cast<boost::uint32_t>(head.compressed_size);
+            if (head.compressed_size < 0xFFFFFFFFull)
+            {
+                file_head.compressed_size =
+                    static_cast<boost::uint32_t>(head.compressed_size);
+            }
+            else
+                file_head.compressed_size = 0xFFFFFFFFu;
             file_head.crc32_checksum = head.crc32_checksum;
-            file_head.file_size = static_cast<boost::uint32_t>(head.file_size);
+            if (head.file_size < 0xFFFFFFFFull)
+            {
+                file_head.file_size =
+                    static_cast<boost::uint32_t>(head.file_size);
+            }
+            else
+                file_head.file_size = 0xFFFFFFFFu;
             file_head.file_name_length =
                 static_cast<boost::uint16_t>(filename.size());
             file_head.extra_field_length =
@@ -377,7 +414,7 @@ public:
             file_head.comment_length =
                 static_cast<boost::uint16_t>(comment.size());
             file_head.disk_number_start = 0; // TODO
-            file_head.internal_attributes = 0; // TODO
+            file_head.internal_attributes = head.internal_attributes;
             file_head.external_attributes =
                 head.attributes |
                 (static_cast<boost::uint32_t>(head.permissions) << 16);
@@ -461,22 +498,23 @@ public:
         else
             footer.offset = 0xFFFFFFFFu;
 
-        footer.comment_length = 0; //TODO
+        footer.comment_length = static_cast<boost::uint16_t>(comment_.size());
 
         iostreams::write_uint32<little>(
             sink_, zip::end_of_central_directory::signature);
         iostreams::binary_write(sink_, footer);
-
-        boost::iostreams::close(sink_, BOOST_IOS::out);
+        if (!comment_.empty())
+            iostreams::blocking_write(sink_, comment_);
     }
 
 private:
     Sink sink_;
     zip_internal_header<Path> header_;
-    boost::uint32_t size_;
+    boost::uint64_t size_;
     bool overflow_;
     bool zip64_;
     std::vector<zip_internal_header<Path> > headers_;
+    std::string comment_;
 
     void write_local_file_header(const header_type& head)
     {
@@ -17,9 +17,12 @@
 #include <boost/iostreams/device/array.hpp>
 #include <boost/iostreams/categories.hpp>
 #include <boost/iostreams/seek.hpp>
+#include <boost/functional/hash/hash.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/scoped_array.hpp>
+#include <algorithm>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
 #if !defined(BOOST_FILESYSTEM_NARROW_ONLY)
@@ -67,6 +70,16 @@ struct zip_source_traits<boost::filesystem::wpath>
 };
 #endif
 
+// consistent with the comparison of the path elements by operator==
+template<class Path>
+inline std::size_t zip_path_hash(const Path& ph)
+{
+    std::size_t seed = 0;
+    for (typename Path::iterator it = ph.begin(); it != ph.end(); ++it)
+        boost::hash_combine(seed, *it);
+    return seed;
+}
+
 inline const char* find_footer_signature(const char* start, const char* last)
 {
     const char* cur = last - 4;
@@ -254,12 +267,23 @@ public:
         , boost::iostreams::device_tag
     {};
 
+    typedef std::vector<zip_internal_header<Path> > headers_type;
+
     explicit basic_raw_zip_file_source_impl(const Source& src)
-        : src_(src), pos_(0), next_index_(0)
+        : src_(src), pos_(0), data_offset_(0), central_dir_offset_(0)
+        , next_index_(0)
     {
         read_central_dir();
     }
 
+    // uses the central directory which was already read
+    basic_raw_zip_file_source_impl(
+            const Source& src, const headers_type& headers)
+        : src_(src), pos_(0), data_offset_(0), central_dir_offset_(0)
+        , next_index_(0), headers_(headers)
+    {
+    }
+
     bool next_entry()
     {
         using namespace boost::filesystem;
@@ -273,15 +297,24 @@ public:
 
     void select_entry(const Path& ph)
     {
-        typedef std::vector<zip_internal_header<Path> > headers_type;
-        typedef typename headers_type::const_iterator iter_type;
+        typedef typename index_type::const_iterator iter_type;
 
-        iter_type pos = std::find_if(
-            headers_.begin(), headers_.end(), zip::header_path_match(ph));
-        if (pos == headers_.end())
-            throw std::runtime_error("no such path");
+        if (index_.empty())
+            build_index();
 
-        select_entry(pos - headers_.begin());
+        std::size_t hash = detail::zip_path_hash(ph);
+        iter_type pos = std::lower_bound(
+            index_.begin(), index_.end(),
+            std::make_pair(hash, static_cast<std::size_t>(0)));
+        for ( ; (pos != index_.end()) && (pos->first == hash); ++pos)
+        {
+            if (headers_[pos->second].path == ph)
+            {
+                select_entry(pos->second);
+                return;
+            }
+        }
+        throw std::runtime_error("no such path");
     }
 
     header_type header() const
@@ -289,6 +322,29 @@ public:
         return header_;
     }
 
+    const headers_type& headers() const
+    {
+        return headers_;
+    }
+
+    // the offset of the data of the current entry in the archive
+    boost::uint64_t data_offset() const
+    {
+        return data_offset_;
+    }
+
+    // the offset of the central directory (the end of the entries)
+    boost::uint64_t central_dir_offset() const
+    {
+        return central_dir_offset_;
+    }
+
+    // the comment of the archive (not converted)
+    const std::string& archive_comment() const
+    {
+        return comment_;
+    }
+
     std::streamsize read(char* s, std::streamsize n)
     {
         if ((pos_ >= header_.compressed_size) || (n <= 0))
@@ -302,11 +358,28 @@ public:
     }
 
 private:
+    // (hash of path, index of headers_) sorted for select_entry(const Path&)
+    typedef std::vector<std::pair<std::size_t,std::size_t> > index_type;
+
     Source src_;
     header_type header_;
     boost::uint64_t pos_;
+    boost::uint64_t data_offset_;
+    boost::uint64_t central_dir_offset_;
     std::size_t next_index_;
-    std::vector<zip_internal_header<Path> > headers_;
+    headers_type headers_;
+    std::string comment_;
+    index_type index_;
+
+    void build_index()
+    {
+        index_type tmp;
+        tmp.reserve(headers_.size());
+        for (std::size_t i = 0; i < headers_.size(); ++i)
+            tmp.push_back(std::make_pair(zip_path_hash(headers_[i].path), i));
+        std::sort(tmp.begin(), tmp.end());
+        tmp.swap(index_);
+    }
 
     void read_central_dir()
     {
@@ -318,7 +391,16 @@ private:
         zip::end_of_central_directory footer;
         iostreams::binary_read(src_, footer);
 
-        if (footer.offset == 0xFFFFFFFF)
+        std::string comment;
+        if (footer.comment_length != 0)
+        {
+            comment.resize(footer.comment_length);
+            iostreams::blocking_read(src_, &comment[0], footer.comment_length);
+        }
+        comment_.swap(comment);
+
+        boost::uint64_t entries = footer.entries;
+        if ((footer.offset == 0xFFFFFFFF) || (footer.entries == 0xFFFF))
         {
             std::streamsize entry_size = static_cast<std::streamsize>(
                 struct_size<zip::zip64_end_cent_dir_locator>::value);
@@ -342,6 +424,7 @@ private:
 
                 zip::zip64_end_cent_dir zip64;
                 iostreams::binary_read(src_, zip64);
+                entries = zip64.entries;
                 boost::iostreams::seek(
                     src_,
                     static_cast<boost::iostreams::stream_offset>(zip64.offset),
@@ -353,9 +436,11 @@ private:
         else
             boost::iostreams::seek(src_, footer.offset, BOOST_IOS::beg);
 
-        tmp.reserve(footer.entries);
+        central_dir_offset_ =
+            static_cast<boost::uint64_t>(iostreams::tell_offset(src_));
+        tmp.reserve(static_cast<std::size_t>(entries));
 
-        for (boost::uint16_t i = 0; i < footer.entries; ++i)
+        for (boost::uint64_t i = 0; i < entries; ++i)
         {
             boost::uint32_t signature = iostreams::read_uint32<little>(src_);
             if (signature != zip::file_header::signature)
@@ -385,6 +470,9 @@ private:
             head.permissions =
                 static_cast<boost::uint16_t>(file_head.external_attributes>>16);
             head.offset = file_head.offset;
+            head.made_by = file_head.made_by;
+            head.flags = file_head.flags;
+            head.internal_attributes = file_head.internal_attributes;
 
             if (file_head.file_name_length != 0)
             {
@@ -441,8 +529,12 @@ private:
         tmp.swap(headers_);
     }
 
+public:
     void select_entry(std::size_t index)
     {
+        if (index >= headers_.size())
+            throw std::out_of_range("bad ZIP entry index");
+
         zip_internal_header<Path> head = headers_[index];
         next_index_ = ++index;
 
@@ -514,6 +606,8 @@ private:
         }
 
         header_ = head;
+        data_offset_ = static_cast<boost::uint64_t>(
+            iostreams::tell_offset(src_));
     }
 };
 
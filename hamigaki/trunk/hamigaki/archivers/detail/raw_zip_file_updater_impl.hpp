@@ -0,0 +1,247 @@
+// raw_zip_file_updater_impl.hpp: raw ZIP file updater implementation
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/archivers for library home page.
+
+#ifndef HAMIGAKI_ARCHIVERS_DETAIL_RAW_ZIP_FILE_UPDATER_IMPL_HPP
+#define HAMIGAKI_ARCHIVERS_DETAIL_RAW_ZIP_FILE_UPDATER_IMPL_HPP
+
+#include <hamigaki/archivers/detail/raw_zip_file_sink_impl.hpp>
+#include <hamigaki/archivers/detail/raw_zip_file_source_impl.hpp>
+#include <hamigaki/iostreams/blocking.hpp>
+#include <hamigaki/iostreams/seek.hpp>
+#include <hamigaki/integer/auto_min.hpp>
+#include <boost/iostreams/seek.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace hamigaki { namespace archivers { namespace detail {
+
+// moves [src, src+size) to dst (dst < src) by the large blocks
+template<class Device>
+inline void move_zip_block(
+    Device& dev, boost::uint64_t dst, boost::uint64_t src,
+    boost::uint64_t size, std::vector<char>& buffer)
+{
+    typedef boost::iostreams::stream_offset off_t;
+
+    while (size != 0)
+    {
+        std::streamsize amt = hamigaki::auto_min(
+            static_cast<std::streamsize>(buffer.size()), size);
+
+        boost::iostreams::seek(dev, static_cast<off_t>(src), BOOST_IOS::beg);
+        iostreams::blocking_read(dev, &buffer[0], amt);
+
+        boost::iostreams::seek(dev, static_cast<off_t>(dst), BOOST_IOS::beg);
+        iostreams::blocking_write(dev, &buffer[0], amt);
+
+        src += static_cast<boost::uint64_t>(amt);
+        dst += static_cast<boost::uint64_t>(amt);
+        size -= static_cast<boost::uint64_t>(amt);
+    }
+}
+
+template<class Device, class Path>
+class basic_raw_zip_file_updater_impl : private boost::noncopyable
+{
+private:
+    typedef basic_raw_zip_file_source_impl<Device,Path> source_type;
+    typedef basic_raw_zip_file_sink_impl<Device,Path> sink_type;
+
+public:
+    typedef char char_type;
+    typedef Path path_type;
+    typedef zip::basic_header<Path> header_type;
+    typedef std::vector<zip_internal_header<Path> > headers_type;
+
+    static const std::size_t move_buffer_size = 1024*1024;
+
+    explicit basic_raw_zip_file_updater_impl(const Device& dev)
+        : dev_(dev), end_offset_(0)
+    {
+        source_type src(dev_);
+        headers_ = src.headers();
+        end_offset_ = src.central_dir_offset();
+        comment_ = src.archive_comment();
+        erased_.resize(headers_.size());
+    }
+
+    std::size_t entries() const
+    {
+        return headers_.size();
+    }
+
+    header_type header(std::size_t index) const
+    {
+        return headers_[index];
+    }
+
+    bool erase_entry(const Path& ph)
+    {
+        if (sink_)
+            throw std::runtime_error("cannot erase ZIP entry after appending");
+
+        typedef typename index_type::const_iterator iter_type;
+
+        // the headers are not changed until the first create_entry()
+        if (index_.empty())
+            build_index();
+
+        std::size_t hash = detail::zip_path_hash(ph);
+        iter_type pos = std::lower_bound(
+            index_.begin(), index_.end(),
+            std::make_pair(hash, static_cast<std::size_t>(0)));
+
+        bool found = false;
+        for ( ; (pos != index_.end()) && (pos->first == hash); ++pos)
+        {
+            std::size_t i = pos->second;
+            if (!erased_[i] && (headers_[i].path == ph))
+            {
+                erased_[i] = true;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    void create_entry(const header_type& head)
+    {
+        start_append();
+        sink_->create_entry(head);
+    }
+
+    void rewind_entry()
+    {
+        sink_->rewind_entry();
+    }
+
+    std::streamsize write(const char* s, std::streamsize n)
+    {
+        return sink_->write(s, n);
+    }
+
+    void close()
+    {
+        sink_->close();
+    }
+
+    // rewrites the central directory and truncates the old one
+    void close_archive()
+    {
+        start_append();
+        sink_->write_central_dir();
+
+        boost::iostreams::stream_offset size = iostreams::tell_offset(dev_);
+        dev_.truncate(size);
+    }
+
+private:
+    typedef std::vector<std::pair<std::size_t,std::size_t> > index_type;
+
+    Device dev_;
+    headers_type headers_;
+    std::vector<bool> erased_;
+    index_type index_;
+    boost::uint64_t end_offset_;
+    std::string comment_;
+    boost::scoped_ptr<sink_type> sink_;
+
+    // (hash, index) sorted by the hash of the path
+    void build_index()
+    {
+        index_type tmp;
+        tmp.reserve(headers_.size());
+        for (std::size_t i = 0; i < headers_.size(); ++i)
+            tmp.push_back(std::make_pair(zip_path_hash(headers_[i].path), i));
+        std::sort(tmp.begin(), tmp.end());
+        tmp.swap(index_);
+    }
+
+    void start_append()
+    {
+        if (sink_)
+            return;
+
+        compact();
+
+        boost::iostreams::seek(
+            dev_,
+            static_cast<boost::iostreams::stream_offset>(end_offset_),
+            BOOST_IOS::beg);
+        sink_.reset(new sink_type(dev_, headers_));
+        sink_->archive_comment(comment_);
+    }
+
+    // moves the kept entries over the erased entries
+    // The archive is broken if this is interrupted, because the central
+    // directory is written after all entries are moved.
+    void compact()
+    {
+        if (std::find(erased_.begin(), erased_.end(), true) == erased_.end())
+            return;
+
+        // (offset, index) in the order of the file
+        std::vector<std::pair<boost::uint64_t,std::size_t> > order;
+        order.reserve(headers_.size());
+        for (std::size_t i = 0; i < headers_.size(); ++i)
+            order.push_back(std::make_pair(headers_[i].offset, i));
+        std::sort(order.begin(), order.end());
+
+        std::vector<char> buffer;
+        headers_type kept;
+        kept.reserve(headers_.size());
+
+        boost::uint64_t dst = order.empty() ? end_offset_ : order[0].first;
+        std::size_t i = 0;
+        while (i < order.size())
+        {
+            if (erased_[order[i].second])
+            {
+                ++i;
+                continue;
+            }
+
+            // the contiguous kept entries are moved at once
+            boost::uint64_t src = order[i].first;
+            std::size_t j = i;
+            for ( ; (j < order.size()) && !erased_[order[j].second]; ++j)
+            {
+                zip_internal_header<Path> head = headers_[order[j].second];
+                head.offset = dst + (head.offset - src);
+                kept.push_back(head);
+            }
+            boost::uint64_t end =
+                (j < order.size()) ? order[j].first : end_offset_;
+
+            if (src != dst)
+            {
+                if (buffer.empty())
+                    buffer.resize(move_buffer_size);
+                move_zip_block(dev_, dst, src, end - src, buffer);
+            }
+            dst += end - src;
+            i = j;
+        }
+
+        // the central directory keeps the order of the file
+        headers_.swap(kept);
+        erased_.assign(headers_.size(), false);
+        index_.clear();
+        end_offset_ = dst;
+    }
+};
+
+} } } // End namespaces detail, archivers, hamigaki.
+
+#endif // HAMIGAKI_ARCHIVERS_DETAIL_RAW_ZIP_FILE_UPDATER_IMPL_HPP
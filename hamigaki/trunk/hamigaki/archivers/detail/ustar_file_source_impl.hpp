@@ -14,6 +14,7 @@
 #include <hamigaki/archivers/tar/headers.hpp>
 #include <hamigaki/integer/auto_min.hpp>
 #include <hamigaki/iostreams/blocking.hpp>
+#include <hamigaki/iostreams/skip.hpp>
 #include <hamigaki/binary/binary_io.hpp>
 #include <hamigaki/dec_format.hpp>
 #include <hamigaki/oct_format.hpp>
@@ -21,6 +22,7 @@
 #include <boost/noncopyable.hpp>
 #include <algorithm>
 #include <cstring>
+#include <vector>
 
 namespace hamigaki { namespace archivers { namespace tar_detail {
 
@@ -174,11 +176,14 @@ public:
     {
         if (header_.is_regular() && (pos_ < header_.file_size))
         {
+            boost::uint64_t end =
+                tar::raw_header::round_up_block_size(header_.file_size);
             pos_ = tar::raw_header::round_up_block_size(pos_);
-            while (pos_ < header_.file_size)
+            if (pos_ < end)
             {
-                iostreams::blocking_read(src_, block_, sizeof(block_));
-                pos_ += tar::raw_header::block_size;
+                iostreams::skip(
+                    src_, static_cast<boost::iostreams::stream_offset>(
+                        end - pos_), skip_buffer_);
             }
         }
         pos_ = 0;
@@ -231,6 +236,7 @@ private:
     tar::header header_;
     boost::uint64_t pos_;
     char block_[tar::raw_header::block_size];
+    std::vector<char> skip_buffer_;
 };
 
 } } } // End namespaces detail, archivers, hamigaki.
@@ -0,0 +1,495 @@
+// zip_file_batch_sink_impl.hpp: parallel ZIP file sink implementation
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/archivers for library home page.
+
+#ifndef HAMIGAKI_ARCHIVERS_DETAIL_ZIP_FILE_BATCH_SINK_IMPL_HPP
+#define HAMIGAKI_ARCHIVERS_DETAIL_ZIP_FILE_BATCH_SINK_IMPL_HPP
+
+#include <boost/config.hpp>
+
+#ifdef BOOST_MSVC
+    #pragma warning(push)
+    #pragma warning(disable : 4251)
+#endif
+
+#include <boost/thread/condition.hpp>
+#include <boost/thread/thread.hpp>
+
+#ifdef BOOST_MSVC
+    #pragma warning(pop)
+#endif
+
+#include <hamigaki/archivers/detail/zip_encryption_keys.hpp>
+#include <hamigaki/archivers/detail/zip_file_sink_impl.hpp>
+#include <hamigaki/checksum/crc.hpp>
+#include <hamigaki/iostreams/device/tmp_file.hpp>
+#include <hamigaki/iostreams/blocking.hpp>
+#include <hamigaki/thread/exception_storage.hpp>
+#include <boost/iostreams/constants.hpp>
+#include <boost/iostreams/read.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/bind.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/ref.hpp>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace hamigaki { namespace archivers { namespace detail {
+
+class zip_batch_source_base
+{
+public:
+    virtual ~zip_batch_source_base() {}
+
+    std::streamsize read(char* s, std::streamsize n)
+    {
+        return do_read(s, n);
+    }
+
+private:
+    virtual std::streamsize do_read(char* s, std::streamsize n) = 0;
+};
+
+template<class Source>
+class zip_batch_source : public zip_batch_source_base
+{
+public:
+    explicit zip_batch_source(const Source& src) : src_(src)
+    {
+    }
+
+private:
+    Source src_;
+
+    std::streamsize do_read(char* s, std::streamsize n) // virtual
+    {
+        return boost::iostreams::read(src_, s, n);
+    }
+};
+
+// the memory buffer which spills into a temporary file
+class zip_batch_buffer
+{
+public:
+    typedef char char_type;
+
+    struct category
+        : boost::iostreams::output
+        , boost::iostreams::device_tag
+    {};
+
+    static const std::size_t spill_size = 4*1024*1024;
+
+    zip_batch_buffer() : size_(0)
+    {
+    }
+
+    boost::uint64_t size() const
+    {
+        return size_;
+    }
+
+    std::streamsize write(const char* s, std::streamsize n)
+    {
+        if (!file_ && (buffer_.size() + n > spill_size))
+        {
+            file_ = iostreams::tmp_file();
+            if (!buffer_.empty())
+                iostreams::blocking_write(*file_, buffer_);
+            std::string tmp;
+            buffer_.swap(tmp);
+        }
+
+        if (file_)
+            iostreams::blocking_write(*file_, s, n);
+        else
+            buffer_.append(s, static_cast<std::size_t>(n));
+        size_ += n;
+        return n;
+    }
+
+    template<class Sink>
+    void copy_to(Sink& sink)
+    {
+        if (!file_)
+        {
+            if (!buffer_.empty())
+                sink.write(buffer_.c_str(), buffer_.size());
+            return;
+        }
+
+        boost::iostreams::seek(*file_, 0, BOOST_IOS::beg);
+
+        char buf[boost::iostreams::default_device_buffer_size];
+        std::streamsize amt;
+        while ((amt = file_->read(buf, sizeof(buf))) > 0)
+            sink.write(buf, amt);
+    }
+
+    void clear()
+    {
+        if (file_)
+            file_->close();
+        file_ = boost::none;
+        std::string tmp;
+        buffer_.swap(tmp);
+        size_ = 0;
+    }
+
+private:
+    std::string buffer_;
+    boost::optional<iostreams::tmp_file> file_;
+    boost::uint64_t size_;
+};
+
+// encrypts the data on the worker thread if needed
+class zip_batch_writer
+{
+public:
+    typedef char char_type;
+
+    struct category
+        : boost::iostreams::output
+        , boost::iostreams::device_tag
+    {};
+
+    explicit zip_batch_writer(zip_batch_buffer& buffer) : buffer_(&buffer)
+    {
+    }
+
+    template<class Path>
+    void start(
+        const zip::basic_header<Path>& head, const std::string& password,
+        boost::mt19937& rand_gen)
+    {
+        buffer_->clear();
+        if (!head.encrypted)
+            return;
+
+        keys_ = zip_encryption_keys(password);
+
+        char enc_header[zip::consts::encryption_header_size];
+        make_zip_encryption_header(enc_header, head, *keys_, rand_gen);
+        buffer_->write(enc_header, sizeof(enc_header));
+    }
+
+    std::streamsize write(const char* s, std::streamsize n)
+    {
+        if (!keys_)
+            return buffer_->write(s, n);
+
+        char buf[1024];
+        std::streamsize total = 0;
+        while (total < n)
+        {
+            std::streamsize amt = (std::min)(
+                n-total, static_cast<std::streamsize>(sizeof(buf)));
+
+            for (std::streamsize i = 0; i < amt; ++i)
+                buf[i] = keys_->encrypt(s[total+i]);
+            buffer_->write(buf, amt);
+            total += amt;
+        }
+        return total;
+    }
+
+private:
+    zip_batch_buffer* buffer_;
+    boost::optional<zip_encryption_keys> keys_;
+};
+
+template<class Sink, class Path>
+class basic_zip_file_batch_sink_impl : private boost::noncopyable
+{
+private:
+    typedef basic_zip_file_sink_impl<Sink,Path> sink_type;
+
+    struct entry
+    {
+        zip::basic_header<Path> header;
+        boost::shared_ptr<zip_batch_source_base> source;
+        zip_batch_buffer data;
+        bool done;
+    };
+
+public:
+    typedef Path path_type;
+    typedef zip::basic_header<Path> header_type;
+
+    basic_zip_file_batch_sink_impl(const Sink& sink, std::size_t thread_count)
+        : sink_(sink), thread_count_(thread_count != 0 ? thread_count : 1)
+        , next_index_(0), written_(0), failed_(false)
+    {
+    }
+
+    void password(const std::string& pswd)
+    {
+        password_ = pswd;
+    }
+
+    void add_entry(const header_type& head)
+    {
+        entry e;
+        e.header = head;
+        e.done = false;
+        entries_.push_back(e);
+    }
+
+    template<class Source>
+    void add_entry(const header_type& head, const Source& src)
+    {
+        entry e;
+        e.header = head;
+        e.source.reset(new zip_batch_source<Source>(src));
+        e.done = false;
+        entries_.push_back(e);
+    }
+
+    void flush()
+    {
+        if (entries_.empty())
+            return;
+
+        next_index_ = 0;
+        written_ = 0;
+        failed_ = false;
+
+        std::vector<hamigaki::thread::exception_storage>
+            errors(thread_count_+1);
+        boost::thread_group threads;
+        for (std::size_t i = 0; i < thread_count_; ++i)
+        {
+            threads.create_thread(
+                boost::bind(
+                    &basic_zip_file_batch_sink_impl::run,
+                    this, boost::ref(errors[i])
+                )
+            );
+        }
+
+        try
+        {
+            for (std::size_t i = 0; i < entries_.size(); ++i)
+            {
+                if (!wait_entry(i))
+                    break;
+
+                write_entry(entries_[i]);
+                entries_[i].data.clear();
+                entries_[i].source.reset();
+                set_written(i+1);
+            }
+        }
+        catch (...)
+        {
+            errors[thread_count_].store();
+            set_failed();
+        }
+        threads.join_all();
+        entries_.clear();
+
+        for (std::size_t i = 0; i < errors.size(); ++i)
+            errors[i].rethrow();
+    }
+
+    void close_archive()
+    {
+        flush();
+        sink_.close_archive();
+    }
+
+private:
+    sink_type sink_;
+    std::string password_;
+    std::size_t thread_count_;
+    std::vector<entry> entries_;
+    boost::mutex mutex_;
+    boost::condition cond_;
+    std::size_t next_index_;
+    std::size_t written_;
+    bool failed_;
+
+    // the workers compress at most this many entries ahead of the writer
+    std::size_t window_size() const
+    {
+        return thread_count_ * 2;
+    }
+
+    bool next_index(std::size_t& index)
+    {
+        boost::mutex::scoped_lock locking(mutex_);
+        while (!failed_ && (next_index_ < entries_.size()) &&
+            (next_index_ >= written_ + window_size()) )
+        {
+            cond_.wait(locking);
+        }
+
+        if (failed_ || (next_index_ >= entries_.size()))
+            return false;
+        index = next_index_++;
+        return true;
+    }
+
+    bool wait_entry(std::size_t index)
+    {
+        boost::mutex::scoped_lock locking(mutex_);
+        while (!failed_ && !entries_[index].done)
+            cond_.wait(locking);
+        return !failed_;
+    }
+
+    void set_done(std::size_t index)
+    {
+        boost::mutex::scoped_lock locking(mutex_);
+        entries_[index].done = true;
+        cond_.notify_all();
+    }
+
+    void set_written(std::size_t count)
+    {
+        boost::mutex::scoped_lock locking(mutex_);
+        written_ = count;
+        cond_.notify_all();
+    }
+
+    void set_failed()
+    {
+        boost::mutex::scoped_lock locking(mutex_);
+        failed_ = true;
+        cond_.notify_all();
+    }
+
+    void run(hamigaki::thread::exception_storage& error)
+    {
+        try
+        {
+            std::size_t index;
+            while (next_index(index))
+            {
+                compress_entry(entries_[index], index);
+                set_done(index);
+            }
+        }
+        catch (...)
+        {
+            error.store();
+            set_failed();
+        }
+    }
+
+    // The uncompressed data is kept to store it if the compression does
+    // not help. The larger entries are always written in the requested
+    // method, so that the data is not buffered twice.
+    void compress_entry(entry& e, std::size_t index)
+    {
+        header_type& head = e.header;
+        if (head.is_directory() || !head.link_path.empty())
+            return;
+
+        if (!e.source)
+        {
+            head.file_size = 0;
+            head.compressed_size = 0;
+            return;
+        }
+
+        boost::mt19937 rand_gen(
+            make_random_seed() ^ static_cast<boost::uint32_t>(index));
+
+        zip_batch_writer out(e.data);
+        out.start(head, password_, rand_gen);
+
+        boost::iostreams::zlib_compressor zlib(make_zlib_params());
+#if !defined(HAMIGAKI_ARCHIVERS_NO_BZIP2)
+        boost::iostreams::bzip2_compressor bzip2;
+#endif
+
+        std::string raw;
+        bool keep_raw = head.method != zip::method::store;
+
+        boost::uint64_t file_size = 0;
+        hamigaki::checksum::crc_32_type crc32;
+        char buf[boost::iostreams::default_device_buffer_size];
+        std::streamsize amt;
+        while ((amt = e.source->read(buf, sizeof(buf))) != -1)
+        {
+            if (amt == 0)
+                continue;
+
+            crc32.process_bytes(buf, amt);
+            file_size += amt;
+
+            if (keep_raw)
+            {
+                if (raw.size() + amt > zip_batch_buffer::spill_size)
+                {
+                    keep_raw = false;
+                    std::string tmp;
+                    raw.swap(tmp);
+                }
+                else
+                    raw.append(buf, static_cast<std::size_t>(amt));
+            }
+
+            if (head.method == zip::method::deflate)
+                boost::iostreams::write(zlib, out, buf, amt);
+#if !defined(HAMIGAKI_ARCHIVERS_NO_BZIP2)
+            else if (head.method == zip::method::bzip2)
+                boost::iostreams::write(bzip2, out, buf, amt);
+#endif
+            else
+                out.write(buf, amt);
+        }
+
+        if (head.method == zip::method::deflate)
+            boost::iostreams::close(zlib, out, BOOST_IOS::out);
+#if !defined(HAMIGAKI_ARCHIVERS_NO_BZIP2)
+        else if (head.method == zip::method::bzip2)
+            boost::iostreams::close(bzip2, out, BOOST_IOS::out);
+#endif
+
+        head.crc32_checksum = crc32.checksum();
+        head.file_size = file_size;
+
+        boost::uint64_t overhead = 0;
+        if (head.encrypted)
+            overhead = zip::consts::encryption_header_size;
+
+        if (keep_raw &&
+            ((file_size < 6) || (e.data.size() - overhead >= file_size)) )
+        {
+            head.method = zip::method::store;
+            out.start(head, password_, rand_gen);
+            if (!raw.empty())
+                iostreams::blocking_write(out, raw);
+        }
+
+        // the sink writes the data as is
+        head.compressed_size = e.data.size();
+    }
+
+    void write_entry(entry& e)
+    {
+        const header_type& head = e.header;
+
+        sink_.create_entry(head);
+        if (head.is_directory() || !head.link_path.empty())
+            return;
+
+        e.data.copy_to(sink_);
+        sink_.close();
+    }
+};
+
+} } } // End namespaces detail, archivers, hamigaki.
+
+#endif // HAMIGAKI_ARCHIVERS_DETAIL_ZIP_FILE_BATCH_SINK_IMPL_HPP
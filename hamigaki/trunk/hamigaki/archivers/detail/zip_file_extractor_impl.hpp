@@ -0,0 +1,190 @@
+// zip_file_extractor_impl.hpp: parallel ZIP extractor implementation
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/archivers for library home page.
+
+#ifndef HAMIGAKI_ARCHIVERS_DETAIL_ZIP_FILE_EXTRACTOR_IMPL_HPP
+#define HAMIGAKI_ARCHIVERS_DETAIL_ZIP_FILE_EXTRACTOR_IMPL_HPP
+
+#include <boost/config.hpp>
+
+#ifdef BOOST_MSVC
+    #pragma warning(push)
+    #pragma warning(disable : 4251)
+#endif
+
+#include <boost/thread/thread.hpp>
+
+#ifdef BOOST_MSVC
+    #pragma warning(pop)
+#endif
+
+#include <hamigaki/archivers/detail/zip_file_source_impl.hpp>
+#include <hamigaki/thread/exception_storage.hpp>
+#include <boost/iostreams/constants.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/ref.hpp>
+#include <vector>
+
+namespace hamigaki { namespace archivers { namespace detail {
+
+template<class Source, class Path>
+class zip_entry_reader
+{
+private:
+    typedef basic_zip_file_source_impl<Source,Path> impl_type;
+
+public:
+    typedef char char_type;
+
+    struct category
+        : boost::iostreams::input
+        , boost::iostreams::device_tag
+    {};
+
+    typedef Path path_type;
+    typedef zip::basic_header<Path> header_type;
+
+    explicit zip_entry_reader(impl_type& impl) : impl_(&impl)
+    {
+    }
+
+    header_type header() const
+    {
+        return impl_->header();
+    }
+
+    std::streamsize read(char* s, std::streamsize n)
+    {
+        return impl_->read(s, n);
+    }
+
+private:
+    impl_type* impl_;
+};
+
+template<class Source, class Path>
+class basic_zip_file_extractor_impl : private boost::noncopyable
+{
+private:
+    typedef basic_zip_file_source_impl<Source,Path> source_type;
+    typedef typename source_type::headers_type headers_type;
+
+public:
+    typedef Path path_type;
+    typedef zip::basic_header<Path> header_type;
+    typedef zip_entry_reader<Source,Path> reader_type;
+    typedef boost::function0<Source> opener_type;
+
+    explicit basic_zip_file_extractor_impl(const opener_type& open)
+        : open_(open), next_index_(0), failed_(false)
+    {
+        basic_raw_zip_file_source_impl<Source,Path> raw(open_());
+        headers_ = raw.headers();
+    }
+
+    void password(const std::string& pswd)
+    {
+        password_ = pswd;
+    }
+
+    std::size_t entries() const
+    {
+        return headers_.size();
+    }
+
+    header_type header(std::size_t index) const
+    {
+        return headers_[index];
+    }
+
+    template<class Function>
+    void extract(Function f, std::size_t thread_count)
+    {
+        if (thread_count == 0)
+            thread_count = 1;
+
+        next_index_ = 0;
+        failed_ = false;
+
+        std::vector<hamigaki::thread::exception_storage> errors(thread_count);
+        boost::thread_group threads;
+        for (std::size_t i = 0; i < thread_count; ++i)
+        {
+            threads.create_thread(
+                boost::bind(
+                    &basic_zip_file_extractor_impl::template run<Function>,
+                    this, f, boost::ref(errors[i])
+                )
+            );
+        }
+        threads.join_all();
+
+        for (std::size_t i = 0; i < thread_count; ++i)
+            errors[i].rethrow();
+    }
+
+private:
+    opener_type open_;
+    std::string password_;
+    headers_type headers_;
+    boost::mutex mutex_;
+    std::size_t next_index_;
+    bool failed_;
+
+    bool next_index(std::size_t& index)
+    {
+        boost::mutex::scoped_lock locking(mutex_);
+        if (failed_ || (next_index_ >= headers_.size()))
+            return false;
+        index = next_index_++;
+        return true;
+    }
+
+    void set_failed()
+    {
+        boost::mutex::scoped_lock locking(mutex_);
+        failed_ = true;
+    }
+
+    template<class Function>
+    void run(Function f, hamigaki::thread::exception_storage& error)
+    {
+        try
+        {
+            // each worker reads the archive through its own Source
+            source_type src(open_(), headers_);
+            src.password(password_);
+
+            reader_type reader(src);
+            char buf[boost::iostreams::default_device_buffer_size];
+
+            std::size_t index;
+            while (next_index(index))
+            {
+                src.select_entry(index);
+                f(reader);
+
+                // check the CRC even if f did not read the whole entry
+                while (src.read(buf, sizeof(buf)) != -1)
+                    ;
+            }
+        }
+        catch (...)
+        {
+            error.store();
+            set_failed();
+        }
+    }
+};
+
+} } } // End namespaces detail, archivers, hamigaki.
+
+#endif // HAMIGAKI_ARCHIVERS_DETAIL_ZIP_FILE_EXTRACTOR_IMPL_HPP
@@ -13,6 +13,7 @@
 #include <hamigaki/archivers/detail/raw_zip_file_sink_impl.hpp>
 #include <hamigaki/archivers/detail/zip_encryption_keys.hpp>
 #include <hamigaki/archivers/detail/zlib_params.hpp>
+#include <hamigaki/checksum/crc.hpp>
 #include <boost/functional/hash/hash.hpp>
 #include <boost/random/mersenne_twister.hpp>
 #include <boost/random/uniform_int.hpp>
@@ -41,6 +42,40 @@ inline boost::uint32_t make_random_seed()
     return static_cast<boost::uint32_t>(val);
 }
 
+// makes the encrypted header which precedes the encrypted data
+template<class Path>
+inline void make_zip_encryption_header(
+    char* buf, const zip::basic_header<Path>& head,
+    zip_encryption_keys& keys, boost::mt19937& rand_gen)
+{
+    boost::variate_generator<
+        boost::mt19937&,
+        boost::uniform_int<unsigned char>
+    > rand(rand_gen, boost::uniform_int<unsigned char>(0, 0xFF));
+
+    char* beg = buf;
+    char* end = beg + zip::consts::encryption_header_size;
+
+    if (head.version < 20)
+    {
+        end -= 2;
+        hamigaki::encode_uint<little,2>(
+            end, msdos::date_time(head.update_time).time);
+    }
+    else
+    {
+        --end;
+        *end = static_cast<char>(static_cast<unsigned char>(
+            msdos::date_time(head.update_time).time >> 8));
+    }
+
+    while (beg != end)
+        *(beg++) = static_cast<char>(rand());
+
+    for (std::size_t i = 0; i < zip::consts::encryption_header_size; ++i)
+        buf[i] = keys.encrypt(buf[i]);
+}
+
 template<class Sink, class Path>
 class zip_encrypter
 {
@@ -131,33 +166,7 @@ private:
             keys_ = zip_encryption_keys(password_);
 
             char enc_haeder[zip::consts::encryption_header_size];
-
-            boost::variate_generator<
-                boost::mt19937&,
-                boost::uniform_int<unsigned char>
-            > rand(rand_gen_, boost::uniform_int<unsigned char>(0, 0xFF));
-
-            char* beg = &enc_haeder[0];
-            char* end = beg + sizeof(enc_haeder);
-
-            if (header_.version < 20)
-            {
-                end -= 2;
-                hamigaki::encode_uint<little,2>(
-                    end, msdos::date_time(header_.update_time).time);
-            }
-            else
-            {
-                --end;
-                *end = static_cast<char>(static_cast<unsigned char>(
-                    msdos::date_time(header_.update_time).time >> 8));
-            }
-
-            while (beg != end)
-                *(beg++) = static_cast<char>(rand());
-
-            for (std::size_t i = 0; i < sizeof(enc_haeder); ++i)
-                enc_haeder[i] = keys_->encrypt(enc_haeder[i]);
+            make_zip_encryption_header(enc_haeder, header_, *keys_, rand_gen_);
             raw_.write(enc_haeder, sizeof(enc_haeder));
 
             if (header_.is_directory())
@@ -272,7 +281,7 @@ public:
 private:
     raw_zip_type raw_;
     boost::uint16_t method_;
-    boost::crc_32_type crc32_;
+    hamigaki::checksum::crc_32_type crc32_;
     boost::uint64_t size_;
     bool compressed_;
     boost::iostreams::zlib_compressor zlib_;
@@ -13,11 +13,12 @@
 #include <hamigaki/archivers/detail/raw_zip_file_source_impl.hpp>
 #include <hamigaki/archivers/detail/zip_encryption_keys.hpp>
 #include <hamigaki/archivers/detail/zlib_params.hpp>
+#include <hamigaki/checksum/crc.hpp>
 #include <boost/none.hpp>
 #include <boost/ref.hpp>
 
 #if !defined(HAMIGAKI_ARCHIVERS_NO_BZIP2)
-    #include <hamigaki/archivers/detail/bzip2.hpp>
+    #include <hamigaki/archivers/detail/any_bzip2_decompressor.hpp>
 #endif
 
 namespace hamigaki { namespace archivers { namespace detail {
@@ -38,12 +39,18 @@ public:
 
     typedef Path path_type;
     typedef zip::basic_header<Path> header_type;
+    typedef typename raw_type::headers_type headers_type;
 
     explicit zip_decrypter(const Source& src)
         : raw_(src)
     {
     }
 
+    zip_decrypter(const Source& src, const headers_type& headers)
+        : raw_(src, headers)
+    {
+    }
+
     void password(const std::string& pswd)
     {
         password_ = pswd;
@@ -64,11 +71,31 @@ public:
         prepare_reading();
     }
 
+    void select_entry(std::size_t index)
+    {
+        raw_.select_entry(index);
+        prepare_reading();
+    }
+
     header_type header() const
     {
         return header_;
     }
 
+    const headers_type& headers() const
+    {
+        return raw_.headers();
+    }
+
+    // the data of the encrypted entry follows the encryption header
+    boost::uint64_t data_offset() const
+    {
+        if (header_.encrypted)
+            return raw_.data_offset() + zip::consts::encryption_header_size;
+        else
+            return raw_.data_offset();
+    }
+
     std::streamsize read(char* s, std::streamsize n)
     {
         if (header_.encrypted && !keys_)
@@ -131,6 +158,7 @@ private:
 public:
     typedef Path path_type;
     typedef zip::basic_header<Path> header_type;
+    typedef typename raw_type::headers_type headers_type;
 
     explicit basic_zip_file_source_impl(const Source& src)
         : raw_(src)
@@ -139,11 +167,26 @@ public:
         header_.method = zip::method::store;
     }
 
+    basic_zip_file_source_impl(const Source& src, const headers_type& headers)
+        : raw_(src, headers)
+        , zlib_(make_zlib_params())
+    {
+        header_.method = zip::method::store;
+    }
+
     void password(const std::string& pswd)
     {
         raw_.password(pswd);
     }
 
+    // decompresses the bzip2 entries on the n worker threads
+    void thread_count(std::size_t n)
+    {
+#if !defined(HAMIGAKI_ARCHIVERS_NO_BZIP2)
+        bzip2_ = any_bzip2_decompressor(n);
+#endif
+    }
+
     bool next_entry()
     {
         if (!raw_.next_entry())
@@ -159,11 +202,27 @@ public:
         prepare_reading();
     }
 
+    void select_entry(std::size_t index)
+    {
+        raw_.select_entry(index);
+        prepare_reading();
+    }
+
     header_type header() const
     {
         return header_;
     }
 
+    const headers_type& headers() const
+    {
+        return raw_.headers();
+    }
+
+    boost::uint64_t data_offset() const
+    {
+        return raw_.data_offset();
+    }
+
     std::streamsize read(char* s, std::streamsize n)
     {
         std::streamsize amt = read_impl(s, n);
@@ -177,10 +236,10 @@ public:
 private:
     raw_type raw_;
     header_type header_;
-    boost::crc_32_type crc32_;
+    hamigaki::checksum::crc_32_type crc32_;
     boost::iostreams::zlib_decompressor zlib_;
 #if !defined(HAMIGAKI_ARCHIVERS_NO_BZIP2)
-    boost::iostreams::bzip2_decompressor bzip2_;
+    any_bzip2_decompressor bzip2_;
 #endif
 
     std::streamsize read_impl(char* s, std::streamsize n)
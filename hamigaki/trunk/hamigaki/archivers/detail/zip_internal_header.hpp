@@ -19,7 +19,13 @@ struct zip_internal_header : public zip::basic_header<Path>
 {
     boost::uint64_t offset;
 
-    zip_internal_header() : offset(0)
+    // the fields of the central directory which are not in basic_header
+    boost::uint16_t made_by;
+    boost::uint16_t flags;
+    boost::uint16_t internal_attributes;
+
+    zip_internal_header()
+        : offset(0), made_by(20), flags(0), internal_attributes(0)
     {
     }
 };
@@ -0,0 +1,315 @@
+// indexed_tar_file.hpp: random access tar.gz/tar.bz2 file device
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/archivers for library home page.
+
+#ifndef HAMIGAKI_ARCHIVERS_INDEXED_TAR_FILE_HPP
+#define HAMIGAKI_ARCHIVERS_INDEXED_TAR_FILE_HPP
+
+#include <hamigaki/archivers/detail/gzip_index.hpp>
+#include <hamigaki/archivers/tar/index.hpp>
+#include <hamigaki/archivers/tar_file.hpp>
+#include <hamigaki/iostreams/device/file.hpp>
+#include <boost/iostreams/detail/ios.hpp>
+#include <boost/iostreams/positioning.hpp>
+#include <boost/iostreams/seek.hpp>
+#include <boost/shared_ptr.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+#if !defined(HAMIGAKI_ARCHIVERS_NO_BZIP2)
+    #include <hamigaki/archivers/detail/bzip2_index.hpp>
+#endif
+
+namespace hamigaki { namespace archivers {
+
+namespace detail
+{
+
+template<class Impl>
+class tar_index_builder_device
+{
+public:
+    typedef char char_type;
+    typedef boost::iostreams::source_tag category;
+
+    explicit tar_index_builder_device(const boost::shared_ptr<Impl>& pimpl)
+        : pimpl_(pimpl)
+    {
+    }
+
+    std::streamsize read(char* s, std::streamsize n)
+    {
+        return pimpl_->read(s, n);
+    }
+
+private:
+    boost::shared_ptr<Impl> pimpl_;
+};
+
+// walks the tar stream and records the offsets of the headers
+template<class Impl>
+inline std::vector<tar::index_entry>
+make_tar_index_entries(const boost::shared_ptr<Impl>& pimpl)
+{
+    typedef tar_index_builder_device<Impl> device_type;
+    typedef boost::filesystem::path path_type;
+
+    basic_tar_file_source_impl<device_type,path_type>
+        tar((device_type(pimpl)));
+
+    std::vector<tar::index_entry> entries;
+    boost::uint64_t offset = 0;
+    while (tar.next_entry())
+    {
+        const tar::header& head = tar.header();
+
+        tar::index_entry entry;
+        entry.path = head.path.string();
+        entry.offset = offset;
+        entries.push_back(entry);
+
+        offset = pimpl->position();
+        if (head.is_regular())
+            offset += tar::raw_header::round_up_block_size(head.file_size);
+    }
+    return entries;
+}
+
+// the uncompressed tar stream which seeks by the checkpoints
+template<class Source>
+class indexed_tar_device
+{
+private:
+    typedef gzip_index_reader_impl<Source> gzip_impl;
+#if !defined(HAMIGAKI_ARCHIVERS_NO_BZIP2)
+    typedef bzip2_index_reader_impl<Source> bzip2_impl;
+#endif
+
+public:
+    typedef char char_type;
+
+    struct category
+        : boost::iostreams::input_seekable
+        , boost::iostreams::device_tag
+    {};
+
+    indexed_tar_device(
+            const Source& src,
+            const boost::shared_ptr<const tar::archive_index>& index)
+        : index_(index)
+    {
+        if (index_->compression == tar::index_compression::gzip)
+            gzip_.reset(new gzip_impl(src, index_->checkpoints));
+#if !defined(HAMIGAKI_ARCHIVERS_NO_BZIP2)
+        else if (index_->compression == tar::index_compression::bzip2)
+            bzip2_.reset(new bzip2_impl(src, index_->checkpoints));
+#endif
+        else
+            throw BOOST_IOSTREAMS_FAILURE("unsupported tar index");
+    }
+
+    std::streamsize read(char* s, std::streamsize n)
+    {
+#if !defined(HAMIGAKI_ARCHIVERS_NO_BZIP2)
+        if (bzip2_)
+            return bzip2_->read(s, n);
+#endif
+        return gzip_->read(s, n);
+    }
+
+    std::streampos seek(
+        boost::iostreams::stream_offset off, BOOST_IOS::seekdir way)
+    {
+        if (way == BOOST_IOS::cur)
+            off += static_cast<boost::iostreams::stream_offset>(position());
+        else if (way != BOOST_IOS::beg)
+            throw BOOST_IOSTREAMS_FAILURE("bad seek direction");
+
+        if (off < 0)
+            throw BOOST_IOSTREAMS_FAILURE("bad seek offset");
+
+#if !defined(HAMIGAKI_ARCHIVERS_NO_BZIP2)
+        if (bzip2_)
+            bzip2_->seek(static_cast<boost::uint64_t>(off));
+        else
+#endif
+            gzip_->seek(static_cast<boost::uint64_t>(off));
+
+        return boost::iostreams::offset_to_position(off);
+    }
+
+private:
+    boost::shared_ptr<const tar::archive_index> index_;
+    boost::shared_ptr<gzip_impl> gzip_;
+#if !defined(HAMIGAKI_ARCHIVERS_NO_BZIP2)
+    boost::shared_ptr<bzip2_impl> bzip2_;
+#endif
+
+    boost::uint64_t position() const
+    {
+#if !defined(HAMIGAKI_ARCHIVERS_NO_BZIP2)
+        if (bzip2_)
+            return bzip2_->position();
+#endif
+        return gzip_->position();
+    }
+};
+
+} // namespace detail
+
+// builds the index of tar.gz file
+// the checkpoints are recorded every "span" bytes of the tar stream
+template<class Source>
+inline tar::archive_index
+make_tgz_index(const Source& src, std::size_t span = 1024*1024)
+{
+    typedef detail::gzip_index_builder_impl<Source> impl_type;
+    boost::shared_ptr<impl_type> pimpl(new impl_type(src, span));
+
+    tar::archive_index index;
+    index.compression = tar::index_compression::gzip;
+    index.entries = detail::make_tar_index_entries(pimpl);
+    index.checkpoints = pimpl->checkpoints();
+    return index;
+}
+
+#if !defined(HAMIGAKI_ARCHIVERS_NO_BZIP2)
+// builds the index of tar.bz2 file
+// the checkpoints are the bzip2 blocks
+template<class Source>
+inline tar::archive_index make_tbz2_index(const Source& src)
+{
+    typedef detail::bzip2_index_builder_impl<Source> impl_type;
+    boost::shared_ptr<impl_type> pimpl(new impl_type(src));
+
+    tar::archive_index index;
+    index.compression = tar::index_compression::bzip2;
+    index.entries = detail::make_tar_index_entries(pimpl);
+    index.checkpoints = pimpl->checkpoints();
+    return index;
+}
+#endif // !defined(HAMIGAKI_ARCHIVERS_NO_BZIP2)
+
+// Note: select_entry() ignores the pax global headers before the entry
+template<class Source>
+class basic_indexed_tar_file_source
+{
+private:
+    typedef detail::indexed_tar_device<Source> device_type;
+    typedef detail::basic_tar_file_source_impl<
+        device_type,boost::filesystem::path> impl_type;
+
+public:
+    typedef char char_type;
+
+    struct category
+        : boost::iostreams::input
+        , boost::iostreams::device_tag
+    {};
+
+    typedef boost::filesystem::path path_type;
+    typedef tar::header header_type;
+
+    basic_indexed_tar_file_source(
+            const Source& src, const tar::archive_index& index)
+        : index_(new tar::archive_index(index))
+        , device_(src, index_), pimpl_(new impl_type(device_))
+    {
+        // the last one is used like the tar command
+        for (std::size_t i = 0; i < index.entries.size(); ++i)
+            offsets_[index.entries[i].path] = index.entries[i].offset;
+    }
+
+    bool next_entry()
+    {
+        return pimpl_->next_entry();
+    }
+
+    // moves to the entry without decompressing the preceding entries
+    bool select_entry(const path_type& ph)
+    {
+        typedef std::map<
+            std::string,boost::uint64_t>::const_iterator iter_type;
+
+        iter_type it = offsets_.find(ph.string());
+        if (it == offsets_.end())
+            return false;
+
+        boost::iostreams::seek(
+            device_,
+            static_cast<boost::iostreams::stream_offset>(it->second),
+            BOOST_IOS::beg);
+
+        pimpl_.reset(new impl_type(device_));
+        return pimpl_->next_entry();
+    }
+
+    header_type header() const
+    {
+        return pimpl_->header();
+    }
+
+    std::streamsize read(char* s, std::streamsize n)
+    {
+        return pimpl_->read(s, n);
+    }
+
+private:
+    boost::shared_ptr<const tar::archive_index> index_;
+    device_type device_;
+    boost::shared_ptr<impl_type> pimpl_;
+    std::map<std::string,boost::uint64_t> offsets_;
+};
+
+class indexed_tar_file_source
+{
+public:
+    typedef char char_type;
+
+    struct category
+        : boost::iostreams::input
+        , boost::iostreams::device_tag
+    {};
+
+    typedef boost::filesystem::path path_type;
+    typedef tar::header header_type;
+
+    indexed_tar_file_source(
+            const std::string& filename, const tar::archive_index& index)
+        : impl_(iostreams::file_source(filename, BOOST_IOS::binary), index)
+    {
+    }
+
+    bool next_entry()
+    {
+        return impl_.next_entry();
+    }
+
+    bool select_entry(const path_type& ph)
+    {
+        return impl_.select_entry(ph);
+    }
+
+    header_type header() const
+    {
+        return impl_.header();
+    }
+
+    std::streamsize read(char* s, std::streamsize n)
+    {
+        return impl_.read(s, n);
+    }
+
+private:
+    basic_indexed_tar_file_source<iostreams::file_source> impl_;
+};
+
+} } // End namespaces archivers, hamigaki.
+
+#endif // HAMIGAKI_ARCHIVERS_INDEXED_TAR_FILE_HPP
@@ -12,6 +12,7 @@
 
 #include <hamigaki/archivers/detail/raw_zip_file_sink_impl.hpp>
 #include <hamigaki/archivers/detail/raw_zip_file_source_impl.hpp>
+#include <hamigaki/archivers/detail/raw_zip_file_updater_impl.hpp>
 #include <hamigaki/iostreams/device/file.hpp>
 
 namespace hamigaki { namespace archivers {
@@ -53,6 +54,13 @@ public:
         return pimpl_->header();
     }
 
+    // the offset of the (compressed) data of the current entry;
+    // the stored entry can be accessed directly through the mapped file
+    boost::uint64_t data_offset() const
+    {
+        return pimpl_->data_offset();
+    }
+
     std::streamsize read(char* s, std::streamsize n)
     {
         return pimpl_->read(s, n);
@@ -208,6 +216,149 @@ private:
     basic_raw_zip_file_sink<iostreams::file_sink> impl_;
 };
 
+// Updates the archive in place.
+// The entries are appended after the last entry and only the central
+// directory is rewritten. The erased entries are removed by moving
+// the following entries, so erase_entry() must precede create_entry().
+// The original fields of the central directory and the archive comment
+// are kept. The entries are moved in place without a backup, so if
+// the update is interrupted by an error or a crash after the first
+// entry is moved, the archive is broken and cannot be recovered.
+// Update a copy of the archive if it must survive such failures.
+// "Device" needs to be seekable and to have truncate().
+template<class Device, class Path=boost::filesystem::path>
+class basic_raw_zip_file_updater
+{
+private:
+    typedef detail::basic_raw_zip_file_updater_impl<Device,Path> impl_type;
+
+public:
+    typedef char char_type;
+
+    struct category
+        : boost::iostreams::output
+        , boost::iostreams::device_tag
+        , boost::iostreams::closable_tag
+    {};
+
+    typedef Path path_type;
+    typedef zip::basic_header<Path> header_type;
+
+    explicit basic_raw_zip_file_updater(const Device& dev)
+        : pimpl_(new impl_type(dev))
+    {
+    }
+
+    // the entries before the update
+    std::size_t entries() const
+    {
+        return pimpl_->entries();
+    }
+
+    header_type header(std::size_t index) const
+    {
+        return pimpl_->header(index);
+    }
+
+    // returns false if no entry has the path
+    bool erase_entry(const Path& ph)
+    {
+        return pimpl_->erase_entry(ph);
+    }
+
+    void create_entry(const header_type& head)
+    {
+        pimpl_->create_entry(head);
+    }
+
+    void rewind_entry()
+    {
+        pimpl_->rewind_entry();
+    }
+
+    std::streamsize write(const char* s, std::streamsize n)
+    {
+        return pimpl_->write(s, n);
+    }
+
+    void close()
+    {
+        pimpl_->close();
+    }
+
+    void close_archive()
+    {
+        pimpl_->close_archive();
+    }
+
+private:
+    boost::shared_ptr<impl_type> pimpl_;
+};
+
+class raw_zip_file_updater
+{
+public:
+    typedef char char_type;
+
+    struct category
+        : boost::iostreams::output
+        , boost::iostreams::device_tag
+        , boost::iostreams::closable_tag
+    {};
+
+    typedef boost::filesystem::path path_type;
+    typedef zip::header header_type;
+
+    explicit raw_zip_file_updater(const std::string& filename)
+        : impl_(iostreams::file(
+            filename, BOOST_IOS::in|BOOST_IOS::out|BOOST_IOS::binary))
+    {
+    }
+
+    std::size_t entries() const
+    {
+        return impl_.entries();
+    }
+
+    zip::header header(std::size_t index) const
+    {
+        return impl_.header(index);
+    }
+
+    bool erase_entry(const boost::filesystem::path& ph)
+    {
+        return impl_.erase_entry(ph);
+    }
+
+    void create_entry(const zip::header& head)
+    {
+        impl_.create_entry(head);
+    }
+
+    void rewind_entry()
+    {
+        impl_.rewind_entry();
+    }
+
+    std::streamsize write(const char* s, std::streamsize n)
+    {
+        return impl_.write(s, n);
+    }
+
+    void close()
+    {
+        impl_.close();
+    }
+
+    void close_archive()
+    {
+        impl_.close_archive();
+    }
+
+private:
+    basic_raw_zip_file_updater<iostreams::file> impl_;
+};
+
 #if !defined(BOOST_FILESYSTEM_NARROW_ONLY)
 class wraw_zip_file_source
 {
@@ -301,6 +452,69 @@ public:
 private:
     basic_raw_zip_file_sink<iostreams::file_sink,path_type> impl_;
 };
+class wraw_zip_file_updater
+{
+public:
+    typedef char char_type;
+
+    struct category
+        : boost::iostreams::output
+        , boost::iostreams::device_tag
+        , boost::iostreams::closable_tag
+    {};
+
+    typedef boost::filesystem::wpath path_type;
+    typedef zip::wheader header_type;
+
+    explicit wraw_zip_file_updater(const std::string& filename)
+        : impl_(iostreams::file(
+            filename, BOOST_IOS::in|BOOST_IOS::out|BOOST_IOS::binary))
+    {
+    }
+
+    std::size_t entries() const
+    {
+        return impl_.entries();
+    }
+
+    zip::wheader header(std::size_t index) const
+    {
+        return impl_.header(index);
+    }
+
+    bool erase_entry(const boost::filesystem::wpath& ph)
+    {
+        return impl_.erase_entry(ph);
+    }
+
+    void create_entry(const zip::wheader& head)
+    {
+        impl_.create_entry(head);
+    }
+
+    void rewind_entry()
+    {
+        impl_.rewind_entry();
+    }
+
+    std::streamsize write(const char* s, std::streamsize n)
+    {
+        return impl_.write(s, n);
+    }
+
+    void close()
+    {
+        impl_.close();
+    }
+
+    void close_archive()
+    {
+        impl_.close_archive();
+    }
+
+private:
+    basic_raw_zip_file_updater<iostreams::file,path_type> impl_;
+};
 #endif // !defined(BOOST_FILESYSTEM_NARROW_ONLY)
 
 } } // End namespaces archivers, hamigaki.
@@ -0,0 +1,220 @@
+// index.hpp: random access index for the compressed tar files
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/archivers for library home page.
+
+#ifndef HAMIGAKI_ARCHIVERS_TAR_INDEX_HPP
+#define HAMIGAKI_ARCHIVERS_TAR_INDEX_HPP
+
+#include <hamigaki/binary/endian.hpp>
+#include <hamigaki/iostreams/device/file.hpp>
+#include <hamigaki/iostreams/blocking.hpp>
+#include <boost/iostreams/detail/ios.hpp>
+#include <boost/cstdint.hpp>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace hamigaki { namespace archivers { namespace tar {
+
+struct index_compression
+{
+    static const boost::uint8_t gzip    = 1;
+    static const boost::uint8_t bzip2   = 2;
+};
+
+// the point where the decompression can restart
+struct index_checkpoint
+{
+    // the offset in the uncompressed tar stream
+    boost::uint64_t offset;
+
+    // the offset in the compressed stream in bits
+    boost::uint64_t bit_offset;
+
+    // bzip2: the size of the block in bits
+    boost::uint64_t bit_size;
+
+    // bzip2: the block size of the stream ('1'-'9')
+    char level;
+
+    // gzip: the compressed last 32KiB of the uncompressed data
+    std::string window;
+
+    index_checkpoint() : offset(0), bit_offset(0), bit_size(0), level(0)
+    {
+    }
+};
+
+struct index_entry
+{
+    std::string path;
+
+    // the offset of the first header block in the uncompressed tar stream
+    boost::uint64_t offset;
+
+    index_entry() : offset(0)
+    {
+    }
+};
+
+struct archive_index
+{
+    boost::uint8_t compression;
+    std::vector<index_checkpoint> checkpoints;
+    std::vector<index_entry> entries;
+
+    archive_index() : compression(0)
+    {
+    }
+};
+
+} } } // End namespaces tar, archivers, hamigaki.
+
+namespace hamigaki { namespace archivers { namespace tar_detail {
+
+const char index_signature[4] = { 'H', 'T', 'I', 'X' };
+const boost::uint16_t index_version = 1;
+
+template<class Sink, class T>
+inline void write_index_uint(Sink& sink, T n)
+{
+    char buf[sizeof(T)];
+    hamigaki::encode_uint<little,sizeof(T)>(buf, n);
+    iostreams::blocking_write(sink, buf);
+}
+
+template<class Source, class T>
+inline void read_index_uint(Source& src, T& n)
+{
+    char buf[sizeof(T)];
+    iostreams::blocking_read(src, buf);
+    n = hamigaki::decode_uint<little,sizeof(T)>(buf);
+}
+
+template<class Sink>
+inline void write_index_string(Sink& sink, const std::string& s)
+{
+    tar_detail::write_index_uint(sink, static_cast<boost::uint32_t>(s.size()));
+    if (!s.empty())
+    {
+        iostreams::blocking_write(
+            sink, s.data(), static_cast<std::streamsize>(s.size()));
+    }
+}
+
+template<class Source>
+inline void read_index_string(Source& src, std::string& s)
+{
+    boost::uint32_t size;
+    tar_detail::read_index_uint(src, size);
+    s.resize(size);
+    if (size != 0)
+    {
+        iostreams::blocking_read(
+            src, &s[0], static_cast<std::streamsize>(size));
+    }
+}
+
+} } } // End namespaces tar_detail, archivers, hamigaki.
+
+namespace hamigaki { namespace archivers { namespace tar {
+
+template<class Sink>
+inline void write_index(Sink& sink, const archive_index& index)
+{
+    iostreams::blocking_write(sink, tar_detail::index_signature);
+    tar_detail::write_index_uint(sink, tar_detail::index_version);
+    tar_detail::write_index_uint(sink, index.compression);
+
+    const std::vector<index_checkpoint>& points = index.checkpoints;
+    tar_detail::write_index_uint(
+        sink, static_cast<boost::uint32_t>(points.size()));
+    for (std::size_t i = 0; i < points.size(); ++i)
+    {
+        const index_checkpoint& point = points[i];
+        tar_detail::write_index_uint(sink, point.offset);
+        tar_detail::write_index_uint(sink, point.bit_offset);
+        tar_detail::write_index_uint(sink, point.bit_size);
+        tar_detail::write_index_uint(
+            sink, static_cast<boost::uint8_t>(point.level));
+        tar_detail::write_index_string(sink, point.window);
+    }
+
+    const std::vector<index_entry>& entries = index.entries;
+    tar_detail::write_index_uint(
+        sink, static_cast<boost::uint32_t>(entries.size()));
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        tar_detail::write_index_string(sink, entries[i].path);
+        tar_detail::write_index_uint(sink, entries[i].offset);
+    }
+}
+
+template<class Source>
+inline archive_index read_index(Source& src)
+{
+    char signature[sizeof(tar_detail::index_signature)];
+    iostreams::blocking_read(src, signature);
+    if (std::memcmp(signature,
+        tar_detail::index_signature, sizeof(signature)) != 0)
+    {
+        throw BOOST_IOSTREAMS_FAILURE("invalid tar index signature");
+    }
+
+    boost::uint16_t version;
+    tar_detail::read_index_uint(src, version);
+    if (version != tar_detail::index_version)
+        throw BOOST_IOSTREAMS_FAILURE("unsupported tar index version");
+
+    archive_index index;
+    tar_detail::read_index_uint(src, index.compression);
+
+    boost::uint32_t count;
+    tar_detail::read_index_uint(src, count);
+    index.checkpoints.resize(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        index_checkpoint& point = index.checkpoints[i];
+        tar_detail::read_index_uint(src, point.offset);
+        tar_detail::read_index_uint(src, point.bit_offset);
+        tar_detail::read_index_uint(src, point.bit_size);
+
+        boost::uint8_t level;
+        tar_detail::read_index_uint(src, level);
+        point.level = static_cast<char>(level);
+
+        tar_detail::read_index_string(src, point.window);
+    }
+
+    tar_detail::read_index_uint(src, count);
+    index.entries.resize(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        tar_detail::read_index_string(src, index.entries[i].path);
+        tar_detail::read_index_uint(src, index.entries[i].offset);
+    }
+
+    return index;
+}
+
+// saves the index as the sidecar file (e.g. "foo.tar.gz.idx")
+inline void save_index(const archive_index& index, const std::string& filename)
+{
+    iostreams::file_sink sink(filename, BOOST_IOS::binary);
+    tar::write_index(sink, index);
+}
+
+inline archive_index load_index(const std::string& filename)
+{
+    iostreams::file_source src(filename, BOOST_IOS::binary);
+    return tar::read_index(src);
+}
+
+} } } // End namespaces tar, archivers, hamigaki.
+
+#endif // HAMIGAKI_ARCHIVERS_TAR_INDEX_HPP
@@ -10,7 +10,7 @@
 #ifndef HAMIGAKI_ARCHIVERS_TBZ2_FILE_HPP
 #define HAMIGAKI_ARCHIVERS_TBZ2_FILE_HPP
 
-#include <hamigaki/archivers/detail/bzip2.hpp>
+#include <hamigaki/archivers/detail/any_bzip2_decompressor.hpp>
 #include <hamigaki/archivers/tar_file.hpp>
 #include <boost/iostreams/compose.hpp>
 
@@ -21,7 +21,7 @@ class basic_tbz2_file_source
 {
 private:
     typedef boost::iostreams::composite<
-        boost::iostreams::bzip2_decompressor,
+        detail::any_bzip2_decompressor,
         Source
     > source_type;
 
@@ -36,8 +36,14 @@ public:
     typedef Path path_type;
     typedef tar::basic_header<Path> header_type;
 
-    explicit basic_tbz2_file_source(const Source& src)
-        : impl_(source_type(boost::iostreams::bzip2_decompressor(), src))
+    // the large input buffer reduces the reads while skipping the entries
+    // if thread_count is not zero, decompress by parallel_bzip2_decompressor
+    explicit basic_tbz2_file_source(
+            const Source& src, std::size_t thread_count=0)
+        : impl_(source_type(
+            detail::any_bzip2_decompressor(
+                thread_count, static_cast<int>(iostreams::skip_buffer_size)),
+            src))
     {
     }
 
@@ -73,8 +79,10 @@ public:
     typedef boost::filesystem::path path_type;
     typedef tar::header header_type;
 
-    explicit tbz2_file_source(const std::string& filename)
-        : impl_(iostreams::file_source(filename, BOOST_IOS::binary))
+    explicit tbz2_file_source(
+            const std::string& filename, std::size_t thread_count=0)
+        : impl_(
+            iostreams::file_source(filename, BOOST_IOS::binary), thread_count)
     {
     }
 
@@ -12,10 +12,63 @@
 
 #include <hamigaki/archivers/detail/gzip.hpp>
 #include <hamigaki/archivers/tar_file.hpp>
+#include <hamigaki/iostreams/filter/parallel_gzip.hpp>
+#include <boost/iostreams/close.hpp>
 #include <boost/iostreams/compose.hpp>
+#include <boost/iostreams/write.hpp>
+#include <boost/optional.hpp>
 
 namespace hamigaki { namespace archivers {
 
+namespace detail
+{
+
+// gzip_compressor or parallel_gzip_compressor
+class tgz_compressor
+{
+public:
+    typedef char char_type;
+
+    struct category
+        : boost::iostreams::output
+        , boost::iostreams::filter_tag
+        , boost::iostreams::multichar_tag
+        , boost::iostreams::closable_tag
+    {};
+
+    explicit tgz_compressor(std::size_t thread_count)
+    {
+        if (thread_count != 0)
+            parallel_ = iostreams::parallel_gzip_compressor(thread_count);
+        else
+            gzip_ = boost::iostreams::gzip_compressor();
+    }
+
+    template<class Sink>
+    std::streamsize write(Sink& sink, const char* s, std::streamsize n)
+    {
+        if (parallel_)
+            return boost::iostreams::write(*parallel_, sink, s, n);
+        else
+            return boost::iostreams::write(*gzip_, sink, s, n);
+    }
+
+    template<class Sink>
+    void close(Sink& sink)
+    {
+        if (parallel_)
+            boost::iostreams::close(*parallel_, sink, BOOST_IOS::out);
+        else
+            boost::iostreams::close(*gzip_, sink, BOOST_IOS::out);
+    }
+
+private:
+    boost::optional<boost::iostreams::gzip_compressor> gzip_;
+    boost::optional<iostreams::parallel_gzip_compressor> parallel_;
+};
+
+} // namespace detail
+
 template<class Source, class Path=boost::filesystem::path>
 class basic_tgz_file_source
 {
@@ -36,8 +89,13 @@ public:
     typedef Path path_type;
     typedef tar::basic_header<Path> header_type;
 
+    // the large input buffer reduces the reads while skipping the entries
     explicit basic_tgz_file_source(const Source& src)
-        : impl_(source_type(boost::iostreams::gzip_decompressor(), src))
+        : impl_(source_type(
+            boost::iostreams::gzip_decompressor(
+                boost::iostreams::gzip::default_window_bits,
+                static_cast<int>(iostreams::skip_buffer_size)),
+            src))
     {
     }
 
@@ -103,7 +161,7 @@ class basic_tgz_file_sink
 {
 private:
     typedef boost::iostreams::composite<
-        boost::iostreams::gzip_compressor,
+        detail::tgz_compressor,
         Sink
     > sink_type;
 
@@ -119,8 +177,9 @@ public:
     typedef Path path_type;
     typedef tar::basic_header<Path> header_type;
 
-    explicit basic_tgz_file_sink(const Sink& sink)
-        : impl_(sink_type(boost::iostreams::gzip_compressor(), sink))
+    // if thread_count is not zero, compress by parallel_gzip_compressor
+    explicit basic_tgz_file_sink(const Sink& sink, std::size_t thread_count=0)
+        : impl_(sink_type(detail::tgz_compressor(thread_count), sink))
     {
     }
 
@@ -167,8 +226,10 @@ public:
     typedef boost::filesystem::path path_type;
     typedef tar::header header_type;
 
-    explicit tgz_file_sink(const std::string& filename)
-        : impl_(iostreams::file_sink(filename, BOOST_IOS::binary))
+    explicit tgz_file_sink(
+            const std::string& filename, std::size_t thread_count=0)
+        : impl_(
+            iostreams::file_sink(filename, BOOST_IOS::binary), thread_count)
     {
     }
 
@@ -253,8 +314,10 @@ public:
     typedef boost::filesystem::wpath path_type;
     typedef tar::wheader header_type;
 
-    explicit wtgz_file_sink(const std::string& filename)
-        : impl_(iostreams::file_sink(filename, BOOST_IOS::binary))
+    explicit wtgz_file_sink(
+            const std::string& filename, std::size_t thread_count=0)
+        : impl_(
+            iostreams::file_sink(filename, BOOST_IOS::binary), thread_count)
     {
     }
 
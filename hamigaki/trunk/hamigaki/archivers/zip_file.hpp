@@ -43,6 +43,11 @@ public:
         pimpl_->password(pswd);
     }
 
+    void thread_count(std::size_t n)
+    {
+        pimpl_->thread_count(n);
+    }
+
     bool next_entry()
     {
         return pimpl_->next_entry();
@@ -58,6 +63,13 @@ public:
         return pimpl_->header();
     }
 
+    // the offset of the (compressed) data of the current entry;
+    // the stored entry can be accessed directly through the mapped file
+    boost::uint64_t data_offset() const
+    {
+        return pimpl_->data_offset();
+    }
+
     std::streamsize read(char* s, std::streamsize n)
     {
         return pimpl_->read(s, n);
@@ -90,6 +102,11 @@ public:
         impl_.password(pswd);
     }
 
+    void thread_count(std::size_t n)
+    {
+        impl_.thread_count(n);
+    }
+
     bool next_entry()
     {
         return impl_.next_entry();
@@ -249,6 +266,11 @@ public:
         impl_.password(pswd);
     }
 
+    void thread_count(std::size_t n)
+    {
+        impl_.thread_count(n);
+    }
+
     bool next_entry()
     {
         return impl_.next_entry();
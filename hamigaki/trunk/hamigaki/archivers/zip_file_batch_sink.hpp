@@ -0,0 +1,157 @@
+// zip_file_batch_sink.hpp: parallel ZIP file sink
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/archivers for library home page.
+
+#ifndef HAMIGAKI_ARCHIVERS_ZIP_FILE_BATCH_SINK_HPP
+#define HAMIGAKI_ARCHIVERS_ZIP_FILE_BATCH_SINK_HPP
+
+#include <hamigaki/archivers/detail/zip_file_batch_sink_impl.hpp>
+#include <hamigaki/iostreams/device/file.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace hamigaki { namespace archivers {
+
+// Compresses the queued entries on the worker threads,
+// and writes them into the archive in the order of add_entry().
+// Each Source is read on a worker thread, so the sources must not
+// share any state with each other.
+// The encrypted entries are compressed on the calling thread.
+template<class Sink, class Path=boost::filesystem::path>
+class basic_zip_file_batch_sink
+{
+private:
+    typedef detail::basic_zip_file_batch_sink_impl<Sink,Path> impl_type;
+
+public:
+    typedef Path path_type;
+    typedef zip::basic_header<Path> header_type;
+
+    basic_zip_file_batch_sink(const Sink& sink, std::size_t thread_count)
+        : pimpl_(new impl_type(sink, thread_count))
+    {
+    }
+
+    void password(const std::string& pswd)
+    {
+        pimpl_->password(pswd);
+    }
+
+    void add_entry(const header_type& head)
+    {
+        pimpl_->add_entry(head);
+    }
+
+    template<class Source>
+    void add_entry(const header_type& head, const Source& src)
+    {
+        pimpl_->add_entry(head, src);
+    }
+
+    void flush()
+    {
+        pimpl_->flush();
+    }
+
+    void close_archive()
+    {
+        pimpl_->close_archive();
+    }
+
+private:
+    boost::shared_ptr<impl_type> pimpl_;
+};
+
+class zip_file_batch_sink
+{
+public:
+    typedef boost::filesystem::path path_type;
+    typedef zip::header header_type;
+
+    zip_file_batch_sink(const std::string& filename, std::size_t thread_count)
+        : impl_(
+            iostreams::file_sink(filename, BOOST_IOS::binary), thread_count)
+    {
+    }
+
+    void password(const std::string& pswd)
+    {
+        impl_.password(pswd);
+    }
+
+    void add_entry(const zip::header& head)
+    {
+        impl_.add_entry(head);
+    }
+
+    template<class Source>
+    void add_entry(const zip::header& head, const Source& src)
+    {
+        impl_.add_entry(head, src);
+    }
+
+    void flush()
+    {
+        impl_.flush();
+    }
+
+    void close_archive()
+    {
+        impl_.close_archive();
+    }
+
+private:
+    basic_zip_file_batch_sink<iostreams::file_sink> impl_;
+};
+
+#if !defined(BOOST_FILESYSTEM_NARROW_ONLY)
+class wzip_file_batch_sink
+{
+public:
+    typedef boost::filesystem::wpath path_type;
+    typedef zip::wheader header_type;
+
+    wzip_file_batch_sink(const std::string& filename, std::size_t thread_count)
+        : impl_(
+            iostreams::file_sink(filename, BOOST_IOS::binary), thread_count)
+    {
+    }
+
+    void password(const std::string& pswd)
+    {
+        impl_.password(pswd);
+    }
+
+    void add_entry(const zip::wheader& head)
+    {
+        impl_.add_entry(head);
+    }
+
+    template<class Source>
+    void add_entry(const zip::wheader& head, const Source& src)
+    {
+        impl_.add_entry(head, src);
+    }
+
+    void flush()
+    {
+        impl_.flush();
+    }
+
+    void close_archive()
+    {
+        impl_.close_archive();
+    }
+
+private:
+    basic_zip_file_batch_sink<iostreams::file_sink,path_type> impl_;
+};
+#endif // !defined(BOOST_FILESYSTEM_NARROW_ONLY)
+
+} } // End namespaces archivers, hamigaki.
+
+#endif // HAMIGAKI_ARCHIVERS_ZIP_FILE_BATCH_SINK_HPP
@@ -0,0 +1,171 @@
+// zip_file_extractor.hpp: parallel ZIP extractor
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/archivers for library home page.
+
+#ifndef HAMIGAKI_ARCHIVERS_ZIP_FILE_EXTRACTOR_HPP
+#define HAMIGAKI_ARCHIVERS_ZIP_FILE_EXTRACTOR_HPP
+
+#include <hamigaki/archivers/detail/zip_file_extractor_impl.hpp>
+#include <hamigaki/iostreams/device/file.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace hamigaki { namespace archivers {
+
+namespace detail
+{
+
+class zip_file_opener
+{
+public:
+    explicit zip_file_opener(const std::string& filename)
+        : filename_(filename)
+    {
+    }
+
+    iostreams::file_source operator()() const
+    {
+        return iostreams::file_source(filename_, BOOST_IOS::binary);
+    }
+
+private:
+    std::string filename_;
+};
+
+} // namespace detail
+
+// Extracts the entries on the worker threads.
+// "open" makes a new Source of the same archive for each worker.
+// "f" is called with the reader of each entry, possibly concurrently.
+template<class Source, class Path=boost::filesystem::path>
+class basic_zip_file_extractor
+{
+private:
+    typedef detail::basic_zip_file_extractor_impl<Source,Path> impl_type;
+
+public:
+    typedef Path path_type;
+    typedef zip::basic_header<Path> header_type;
+    typedef typename impl_type::reader_type reader_type;
+
+    template<class Opener>
+    explicit basic_zip_file_extractor(Opener open)
+        : pimpl_(new impl_type(open))
+    {
+    }
+
+    void password(const std::string& pswd)
+    {
+        pimpl_->password(pswd);
+    }
+
+    std::size_t entries() const
+    {
+        return pimpl_->entries();
+    }
+
+    header_type header(std::size_t index) const
+    {
+        return pimpl_->header(index);
+    }
+
+    template<class Function>
+    void extract(Function f, std::size_t thread_count)
+    {
+        pimpl_->extract(f, thread_count);
+    }
+
+private:
+    boost::shared_ptr<impl_type> pimpl_;
+};
+
+class zip_file_extractor
+{
+private:
+    typedef basic_zip_file_extractor<iostreams::file_source> impl_type;
+
+public:
+    typedef boost::filesystem::path path_type;
+    typedef zip::header header_type;
+    typedef impl_type::reader_type reader_type;
+
+    explicit zip_file_extractor(const std::string& filename)
+        : impl_(detail::zip_file_opener(filename))
+    {
+    }
+
+    void password(const std::string& pswd)
+    {
+        impl_.password(pswd);
+    }
+
+    std::size_t entries() const
+    {
+        return impl_.entries();
+    }
+
+    zip::header header(std::size_t index) const
+    {
+        return impl_.header(index);
+    }
+
+    template<class Function>
+    void extract(Function f, std::size_t thread_count)
+    {
+        impl_.extract(f, thread_count);
+    }
+
+private:
+    impl_type impl_;
+};
+
+#if !defined(BOOST_FILESYSTEM_NARROW_ONLY)
+class wzip_file_extractor
+{
+private:
+    typedef basic_zip_file_extractor<
+        iostreams::file_source,boost::filesystem::wpath> impl_type;
+
+public:
+    typedef boost::filesystem::wpath path_type;
+    typedef zip::wheader header_type;
+    typedef impl_type::reader_type reader_type;
+
+    explicit wzip_file_extractor(const std::string& filename)
+        : impl_(detail::zip_file_opener(filename))
+    {
+    }
+
+    void password(const std::string& pswd)
+    {
+        impl_.password(pswd);
+    }
+
+    std::size_t entries() const
+    {
+        return impl_.entries();
+    }
+
+    zip::wheader header(std::size_t index) const
+    {
+        return impl_.header(index);
+    }
+
+    template<class Function>
+    void extract(Function f, std::size_t thread_count)
+    {
+        impl_.extract(f, thread_count);
+    }
+
+private:
+    impl_type impl_;
+};
+#endif // !defined(BOOST_FILESYSTEM_NARROW_ONLY)
+
+} } // End namespaces archivers, hamigaki.
+
+#endif // HAMIGAKI_ARCHIVERS_ZIP_FILE_EXTRACTOR_HPP
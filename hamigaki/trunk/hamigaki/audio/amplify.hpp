@@ -10,6 +10,8 @@
 #ifndef HAMIGAKI_AUDIO_AMPLIFY_HPP
 #define HAMIGAKI_AUDIO_AMPLIFY_HPP
 
+#include <hamigaki/audio/detail/mix.hpp>
+#include <hamigaki/iostreams/catable.hpp>
 #include <boost/iostreams/categories.hpp>
 #include <boost/iostreams/detail/adapter/direct_adapter.hpp>
 #include <boost/iostreams/detail/ios.hpp>
@@ -17,8 +19,6 @@
 #include <boost/iostreams/optimal_buffer_size.hpp>
 #include <boost/iostreams/read.hpp>
 #include <boost/iostreams/traits.hpp>
-#include <algorithm>
-#include <functional>
 
 namespace hamigaki { namespace audio {
 
@@ -54,14 +54,8 @@ public:
         std::streamsize amt = boost::iostreams::read(src_, s, n);
         if (amt != -1)
         {
-            // TODO: shall support non-floating type
-            std::transform(
-                s, s+amt, s,
-                std::bind2nd(
-                    std::multiplies<char_type>(),
-                    static_cast<char_type>(amp_)
-                )
-            );
+            // the integer samples are saturated
+            detail::apply_gain(s, static_cast<std::size_t>(amt), amp_);
         }
         return amt;
     }
@@ -90,4 +84,6 @@ amplify(const Source& src, float amp)
 
 } } // End namespaces audio, hamigaki.
 
+HAMIGAKI_IOSTREAMS_CATABLE(hamigaki::audio::amplifier, 1)
+
 #endif // HAMIGAKI_AUDIO_AMPLIFY_HPP
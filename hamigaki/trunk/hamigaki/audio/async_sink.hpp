@@ -0,0 +1,381 @@
+// async_sink.hpp: asynchronous writer of the audio devices
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+#ifndef HAMIGAKI_AUDIO_ASYNC_SINK_HPP
+#define HAMIGAKI_AUDIO_ASYNC_SINK_HPP
+
+#include <boost/config.hpp>
+
+#ifdef BOOST_MSVC
+    #pragma warning(push)
+    #pragma warning(disable : 4251)
+#endif
+
+#include <boost/thread/condition.hpp>
+#include <boost/thread/thread.hpp>
+
+#ifdef BOOST_MSVC
+    #pragma warning(pop)
+#endif
+
+#include <hamigaki/audio/device_delay.hpp>
+#include <hamigaki/iostreams/blocking.hpp>
+#include <hamigaki/iostreams/detail/spsc_ring.hpp>
+#include <hamigaki/thread/exception_storage.hpp>
+#include <boost/iostreams/categories.hpp>
+#include <boost/iostreams/close.hpp>
+#include <boost/iostreams/positioning.hpp>
+#include <boost/iostreams/traits.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+
+namespace hamigaki { namespace audio {
+
+namespace detail
+{
+
+using hamigaki::iostreams::detail::shared_offset;
+using hamigaki::iostreams::detail::single_writer_flag;
+using hamigaki::iostreams::detail::spsc_ring;
+
+template<class Sink>
+class async_sink_impl : private boost::noncopyable
+{
+private:
+    typedef typename boost::iostreams::char_type_of<Sink>::type char_type;
+
+public:
+    async_sink_impl(
+            const Sink& sink, std::streamsize buffer_size,
+            std::size_t buffer_count)
+        : sink_(sink), ring_(buffer_size, buffer_count)
+        , slot_(0), fill_(0), submitted_(0)
+        , stop_(false), closed_(false)
+        , thread_(boost::bind(&async_sink_impl::run, this))
+    {
+    }
+
+    // the queued samples are written before the thread exits
+    ~async_sink_impl()
+    {
+        try
+        {
+            if (!closed_)
+            {
+                if (fill_ != 0)
+                    submit();
+                stop();
+            }
+        }
+        catch (...)
+        {
+        }
+    }
+
+    std::streamsize buffer_size() const
+    {
+        return ring_.slot_size();
+    }
+
+    void notify(const boost::function0<void>& f)
+    {
+        boost::mutex::scoped_lock locking(mutex_);
+        notify_ = f;
+    }
+
+    std::streamsize write_some(const char_type* s, std::streamsize n)
+    {
+        check_error();
+
+        std::streamsize total = 0;
+        while (total < n)
+        {
+            if (!slot_)
+            {
+                slot_ = ring_.write_slot();
+                if (!slot_)
+                    break;
+            }
+
+            std::streamsize amt =
+                (std::min)(n - total, ring_.slot_size() - fill_);
+            std::copy(s + total, s + total + amt, slot_ + fill_);
+            fill_ += amt;
+            total += amt;
+
+            if (fill_ == ring_.slot_size())
+                submit();
+        }
+        return total;
+    }
+
+    std::streamsize write(const char_type* s, std::streamsize n)
+    {
+        std::streamsize total = write_some(s, n);
+        while (total < n)
+        {
+            {
+                boost::mutex::scoped_lock locking(mutex_);
+                while (!failed_.get() && (ring_.size() == ring_.slot_count()))
+                    cond_.wait(locking);
+            }
+            total += write_some(s + total, n - total);
+        }
+        return total;
+    }
+
+    // waits until the device accepts all samples
+    bool flush()
+    {
+        if (fill_ != 0)
+            submit();
+
+        {
+            boost::mutex::scoped_lock locking(mutex_);
+            while (!failed_.get() && (written_.load() != submitted_))
+                cond_.wait(locking);
+        }
+
+        check_error();
+        return true;
+    }
+
+    void close()
+    {
+        closed_ = true;
+        if (fill_ != 0)
+            submit();
+        stop();
+        check_error();
+
+        boost::iostreams::close(sink_, BOOST_IOS::out);
+    }
+
+    std::streamsize queued() const
+    {
+        return static_cast<std::streamsize>(
+            submitted_ + fill_ - written_.load());
+    }
+
+    std::streamsize delay() const
+    {
+        return queued() + device_delay(sink_);
+    }
+
+    boost::iostreams::stream_offset position() const
+    {
+        boost::iostreams::stream_offset pos =
+            written_.load() - device_delay(sink_);
+        return (pos > 0) ? pos : 0;
+    }
+
+private:
+    Sink sink_;
+    spsc_ring<char_type> ring_;
+
+    // the producer side
+    char_type* slot_;
+    std::streamsize fill_;
+    boost::iostreams::stream_offset submitted_;
+
+    shared_offset written_;        // written by the device thread
+    single_writer_flag failed_;    // by the device thread
+    hamigaki::thread::exception_storage error_;
+
+    boost::mutex mutex_;
+    boost::condition cond_;
+    boost::function0<void> notify_;
+    bool stop_;
+    bool closed_;
+    boost::thread thread_;
+
+    void submit()
+    {
+        ring_.commit(fill_);
+        submitted_ += fill_;
+        slot_ = 0;
+        fill_ = 0;
+
+        boost::mutex::scoped_lock locking(mutex_);
+        cond_.notify_all();
+    }
+
+    void stop()
+    {
+        {
+            boost::mutex::scoped_lock locking(mutex_);
+            stop_ = true;
+            cond_.notify_all();
+        }
+        thread_.join();
+    }
+
+    void check_error()
+    {
+        if (failed_.get())
+        {
+            error_.rethrow();
+            throw BOOST_IOSTREAMS_FAILURE("async_sink write failed");
+        }
+    }
+
+    void run()
+    {
+        boost::iostreams::stream_offset written = 0;
+        while (true)
+        {
+            const char_type* s;
+            std::streamsize n;
+            {
+                boost::mutex::scoped_lock locking(mutex_);
+                while (((s = ring_.read_slot(n)) == 0) && !stop_)
+                    cond_.wait(locking);
+                if (!s)
+                    return;
+            }
+
+            // the samples after an error are discarded
+            if (!failed_.get())
+            {
+                try
+                {
+                    typedef iostreams::blocking_writer<Sink> writer;
+                    if (!writer::write(sink_, s, n))
+                        throw BOOST_IOSTREAMS_FAILURE("cannot write device");
+                }
+                catch (...)
+                {
+                    error_.store();
+                    failed_.set();
+                }
+            }
+
+            ring_.release();
+
+            boost::function0<void> f;
+            {
+                boost::mutex::scoped_lock locking(mutex_);
+                f = notify_;
+            }
+            if (f)
+                f();
+
+            // flush() returns after the notification
+            written += n;
+            {
+                boost::mutex::scoped_lock locking(mutex_);
+                written_.store(written);
+                cond_.notify_all();
+            }
+        }
+    }
+};
+
+} // namespace detail
+
+// Writes to "Sink" on a dedicated thread through a queue of the buffers,
+// so that the caller does not stall on the device.
+// write() blocks only while the queue is full, and write_some() never
+// blocks. The function set by notify() is called on the device thread
+// after each buffer is written.
+// Wrap the converting adaptors (e.g. widen<float>(sink)) with this,
+// because this does not have the PCM format. delay() and position()
+// count the samples of char_type.
+template<class Sink>
+class async_sink
+{
+private:
+    typedef detail::async_sink_impl<Sink> impl_type;
+
+public:
+    typedef typename boost::iostreams::char_type_of<Sink>::type char_type;
+
+    struct category
+        : boost::iostreams::output
+        , boost::iostreams::device_tag
+        , boost::iostreams::closable_tag
+        , boost::iostreams::flushable_tag
+        , boost::iostreams::optimally_buffered_tag
+        , delay_tag
+    {};
+
+    async_sink(
+            const Sink& sink, std::streamsize buffer_size,
+            std::size_t buffer_count=4)
+        : pimpl_(new impl_type(sink, buffer_size, buffer_count))
+    {
+    }
+
+    std::streamsize optimal_buffer_size() const
+    {
+        return pimpl_->buffer_size();
+    }
+
+    std::streamsize write(const char_type* s, std::streamsize n)
+    {
+        return pimpl_->write(s, n);
+    }
+
+    // returns the number of the queued samples without blocking
+    std::streamsize write_some(const char_type* s, std::streamsize n)
+    {
+        return pimpl_->write_some(s, n);
+    }
+
+    bool flush()
+    {
+        return pimpl_->flush();
+    }
+
+    void close()
+    {
+        pimpl_->close();
+    }
+
+    void notify(const boost::function0<void>& f)
+    {
+        pimpl_->notify(f);
+    }
+
+    // the samples in the queue
+    std::streamsize queued() const
+    {
+        return pimpl_->queued();
+    }
+
+    // the samples not played yet (the queue and the device)
+    std::streamsize delay() const
+    {
+        return pimpl_->delay();
+    }
+
+    // the samples played
+    boost::iostreams::stream_offset position() const
+    {
+        return pimpl_->position();
+    }
+
+private:
+    boost::shared_ptr<impl_type> pimpl_;
+};
+
+template<class Sink>
+inline async_sink<Sink> make_async_sink(
+    const Sink& sink, std::streamsize buffer_size, std::size_t buffer_count=4)
+{
+    return async_sink<Sink>(sink, buffer_size, buffer_count);
+}
+
+} } // End namespaces audio, hamigaki.
+
+#endif // HAMIGAKI_AUDIO_ASYNC_SINK_HPP
@@ -28,12 +28,14 @@
     #pragma warning(pop)
 #endif
 
+#include <hamigaki/iostreams/detail/spsc_ring.hpp>
 #include <hamigaki/thread/exception_storage.hpp>
-#include <boost/iostreams/detail/buffer.hpp>
+#include <boost/detail/atomic_count.hpp>
 #include <boost/iostreams/constants.hpp>
 #include <boost/iostreams/flush.hpp>
 #include <boost/iostreams/positioning.hpp>
 #include <boost/iostreams/read.hpp>
+#include <boost/iostreams/seek.hpp>
 #include <boost/iostreams/traits.hpp>
 #include <boost/iostreams/write.hpp>
 #include <boost/thread/mutex.hpp>
@@ -43,9 +45,33 @@
 
 namespace hamigaki { namespace audio {
 
+struct background_player_statistics
+{
+    // the number of times the device waited for the decoder
+    // before the end of the source
+    unsigned long underruns;
+
+    // the number of times the decoder waited for a free buffer
+    // (the normal case for a real-time device)
+    unsigned long overruns;
+
+    // the number of the filled buffers
+    std::size_t buffered;
+
+    background_player_statistics()
+        : underruns(0), overruns(0), buffered(0)
+    {
+    }
+};
+
 namespace detail
 {
 
+using hamigaki::iostreams::detail::shared_offset;
+using hamigaki::iostreams::detail::single_writer_flag;
+using hamigaki::iostreams::detail::spsc_ring;
+using hamigaki::iostreams::detail::state_event;
+
 template<typename T> 
 struct seek_in_impl;
 
@@ -109,6 +135,21 @@ public:
         return do_stop();
     }
 
+    void pause()
+    {
+        return do_pause();
+    }
+
+    void resume()
+    {
+        return do_resume();
+    }
+
+    bool paused()
+    {
+        return do_paused();
+    }
+
     void reset()
     {
         return do_reset();
@@ -121,130 +162,310 @@ public:
         return do_seek(off, way);
     }
 
+    std::streamsize latency()
+    {
+        return do_latency();
+    }
+
+    background_player_statistics statistics()
+    {
+        return do_statistics();
+    }
+
 private:
     virtual void do_run() = 0;
     virtual bool do_done() = 0;
     virtual std::streampos do_tell() = 0;
     virtual void do_stop() = 0;
+    virtual void do_pause() = 0;
+    virtual void do_resume() = 0;
+    virtual bool do_paused() = 0;
     virtual void do_reset() = 0;
 
     virtual std::streampos do_seek(
         boost::iostreams::stream_offset off,
         BOOST_IOS::seekdir way) = 0;
+
+    virtual std::streamsize do_latency() = 0;
+    virtual background_player_statistics do_statistics() = 0;
 };
 
+// The decoder thread reads the source into a ring of the buffers,
+// and the device thread writes them to the sink.
+// The ring and the flags are shared through the atomic counters.
+// A thread waits on state_event only when it cannot proceed.
 template<class Source, class Sink, class ExceptionStorage>
 class bg_player_impl
     : public bg_player_base
 {
     typedef typename boost::iostreams::char_type_of<Source>::type char_type;
-    typedef boost::iostreams::detail::buffer<char_type> buffer_type;
 
 public:
     bg_player_impl(
             const Source& src, const Sink& sink,
-            std::streamsize buffer_size, ExceptionStorage& storage)
-        : src_(src), sink_(sink), buffer_(buffer_size)
-        , done_(false), interrupted_(false), except_ptr_(&storage)
+            std::streamsize buffer_size, std::size_t buffer_count,
+            ExceptionStorage& storage)
+        : src_(src), sink_(sink), ring_(buffer_size, buffer_count)
+        , underruns_(0), overruns_(0), stored_(false), except_ptr_(&storage)
     {
-        buffer_.set(0, 0);
-        position_ = boost::iostreams::position_to_offset(
-            hamigaki::audio::detail::seek_in(src_, 0, BOOST_IOS::cur));
-        seekable_ = (position_ != std::streampos(-1));
+        boost::iostreams::stream_offset pos =
+            boost::iostreams::position_to_offset(
+                hamigaki::audio::detail::seek_in(src_, 0, BOOST_IOS::cur));
+        seekable_ = (pos != -1);
+        position_.store(pos);
     }
 
 private:
-    boost::mutex mutex_;
+    boost::mutex except_mutex_; // used only when an exception is thrown
     Source src_;
     Sink sink_;
-    buffer_type buffer_;
+    spsc_ring<char_type> ring_;
     bool seekable_;
-    volatile boost::iostreams::stream_offset position_;
-    volatile bool done_;
-    volatile bool interrupted_;
+    shared_offset position_;        // written by the device thread
+    single_writer_flag eof_;        // by the decoder thread
+    single_writer_flag failed_;     // by the decoder thread
+    single_writer_flag finished_;   // by the device thread
+    single_writer_flag done_;       // by the device thread
+    single_writer_flag interrupted_;
+    single_writer_flag paused_;
+    boost::detail::atomic_count underruns_;
+    boost::detail::atomic_count overruns_;
+    state_event event_;
+    bool stored_;
     ExceptionStorage* except_ptr_;
 
     void do_run() // virtual
     {
         try
         {
-            buffer_type& buf = buffer_;
-
-            while (!interrupted())
+            // fills the ring before starting the device
+            while (!eof_.get())
             {
-                if (buf.ptr() == buf.eptr())
-                {
-                    std::streamsize amt =
-                        boost::iostreams::read(src_, buf.data(), buf.size());
-
-                    if (amt == -1)
-                        break;
-
-                    buf.set(0, amt);
-                }
-
-                while (buf.ptr() != buf.eptr())
-                {
-                    std::streamsize amt =
-                        boost::iostreams::write(
-                            sink_, buf.ptr(), buf.eptr() - buf.ptr());
-
-                    buf.ptr() += amt;
-
-                    if (seekable_)
-                    {
-                        boost::mutex::scoped_lock locking(mutex_);
-                        position_ += amt;
-                    }
-                }
+                char_type* s = ring_.write_slot();
+                if (!s)
+                    break;
+                decode(s);
             }
-            boost::iostreams::flush(sink_);
         }
         catch (...)
         {
-            except_ptr_->store();
+            store_exception();
+            failed_.set();
         }
 
-        boost::mutex::scoped_lock locking(mutex_);
-        done_ = true;
+        boost::thread decoder(
+            boost::bind(&bg_player_impl::decode_loop, this));
+
+        play_loop();
+        finished_.set();
+        event_.notify();
+        decoder.join();
+
+        done_.set();
     }
 
     bool do_done() // virtual
     {
-        boost::mutex::scoped_lock locking(mutex_);
-        return done_;
+        return done_.get();
     }
 
     std::streampos do_tell() // virtual
     {
-        boost::mutex::scoped_lock locking(mutex_);
-        return boost::iostreams::offset_to_position(position_);
+        return boost::iostreams::offset_to_position(position_.load());
     }
 
     void do_stop() // virtual
     {
-        boost::mutex::scoped_lock locking(mutex_);
-        interrupted_ = true;
+        interrupted_.set();
+        event_.notify();
+    }
+
+    void do_pause() // virtual
+    {
+        paused_.set();
     }
 
-    bool interrupted()
+    void do_resume() // virtual
     {
-        boost::mutex::scoped_lock locking(mutex_);
-        return interrupted_;
+        paused_.clear();
+        event_.notify();
     }
 
+    bool do_paused() // virtual
+    {
+        return paused_.get();
+    }
+
+    // the buffered samples are kept for the next play
     void do_reset() // virtual
     {
-        done_ = false;
-        interrupted_ = false;
+        failed_.clear();
+        finished_.clear();
+        done_.clear();
+        interrupted_.clear();
+        paused_.clear();
+        stored_ = false;
     }
 
     std::streampos do_seek(
         boost::iostreams::stream_offset off,
         BOOST_IOS::seekdir way) // virtual
     {
-        position_ = hamigaki::audio::detail::seek_in(src_, off, way);
-        return boost::iostreams::offset_to_position(position_);
+        // the source is ahead of the device by the buffered samples
+        if (seekable_ && (way == BOOST_IOS::cur))
+        {
+            off += position_.load();
+            way = BOOST_IOS::beg;
+        }
+
+        std::streampos pos = hamigaki::audio::detail::seek_in(src_, off, way);
+        ring_.clear();
+        eof_.clear();
+        position_.store(boost::iostreams::position_to_offset(pos));
+        return pos;
+    }
+
+    std::streamsize do_latency() // virtual
+    {
+        return ring_.slot_size() *
+            static_cast<std::streamsize>(ring_.slot_count());
+    }
+
+    background_player_statistics do_statistics() // virtual
+    {
+        background_player_statistics stat;
+        stat.underruns = static_cast<long>(underruns_);
+        stat.overruns = static_cast<long>(overruns_);
+        stat.buffered = ring_.size();
+        return stat;
+    }
+
+    bool can_decode()
+    {
+        return (ring_.size() != ring_.slot_count()) ||
+            finished_.get() || interrupted_.get();
+    }
+
+    bool can_play()
+    {
+        if (interrupted_.get() || failed_.get())
+            return true;
+        return !paused_.get() && ((ring_.size() != 0) || eof_.get());
+    }
+
+    void store_exception()
+    {
+        boost::mutex::scoped_lock locking(except_mutex_);
+        if (!stored_)
+        {
+            except_ptr_->store();
+            stored_ = true;
+        }
+    }
+
+    void decode(char_type* s)
+    {
+        std::streamsize amt =
+            boost::iostreams::read(src_, s, ring_.slot_size());
+
+        if (amt == -1)
+            eof_.set();
+        else if (amt != 0)
+            ring_.commit(amt);
+    }
+
+    void decode_loop()
+    {
+        try
+        {
+            bool waiting = false;
+            while (!eof_.get() && !failed_.get() &&
+                !finished_.get() && !interrupted_.get())
+            {
+                if (char_type* s = ring_.write_slot())
+                {
+                    waiting = false;
+                    decode(s);
+                    event_.notify();
+                }
+                else
+                {
+                    if (!waiting && !paused_.get())
+                    {
+                        ++overruns_;
+                        waiting = true;
+                    }
+                    event_.wait(
+                        boost::bind(&bg_player_impl::can_decode, this));
+                }
+            }
+        }
+        catch (...)
+        {
+            store_exception();
+            failed_.set();
+            event_.notify();
+        }
+    }
+
+    void play_loop()
+    {
+        try
+        {
+            bool waiting = false;
+            boost::iostreams::stream_offset pos = position_.load();
+            while (!interrupted_.get() && !failed_.get())
+            {
+                if (paused_.get())
+                {
+                    event_.wait(boost::bind(&bg_player_impl::can_play, this));
+                    continue;
+                }
+
+                std::streamsize size;
+                const char_type* s = ring_.read_slot(size);
+                if (!s)
+                {
+                    // the last slot is committed before eof_ is set
+                    if (eof_.get())
+                    {
+                        if (ring_.size() == 0)
+                            break;
+                        continue;
+                    }
+
+                    if (!waiting)
+                    {
+                        ++underruns_;
+                        waiting = true;
+                    }
+                    event_.wait(boost::bind(&bg_player_impl::can_play, this));
+                    continue;
+                }
+                waiting = false;
+
+                while (size > 0)
+                {
+                    std::streamsize amt =
+                        boost::iostreams::write(sink_, s, size);
+                    s += amt;
+                    size -= amt;
+
+                    if (seekable_)
+                    {
+                        pos += amt;
+                        position_.store(pos);
+                    }
+                }
+                ring_.release();
+                event_.notify();
+            }
+            boost::iostreams::flush(sink_);
+        }
+        catch (...)
+        {
+            store_exception();
+        }
     }
 };
 
@@ -266,12 +487,14 @@ private:
 public:
     basic_background_player(){}
 
+    // the latency is "buffer_size" * "buffer_count" samples
     template<typename Source, typename Sink>
     basic_background_player(const Source& src, const Sink& sink,
         std::streamsize buffer_size = 
-            boost::iostreams::default_device_buffer_size)
+            boost::iostreams::default_device_buffer_size,
+        std::size_t buffer_count = 2)
     {
-        this->open(src, sink, buffer_size);
+        this->open(src, sink, buffer_size, buffer_count);
     }
 
     ~basic_background_player()
@@ -291,7 +514,8 @@ public:
     template<typename Source, typename Sink>
     void open(const Source& src, const Sink& sink,
         std::streamsize buffer_size = 
-            boost::iostreams::default_device_buffer_size)
+            boost::iostreams::default_device_buffer_size,
+        std::size_t buffer_count = 2)
     {
         BOOST_ASSERT(pimpl_.get() == 0);
 
@@ -299,7 +523,8 @@ public:
             Source,Sink,ExceptionStorage> impl_type;
 
         pimpl_.reset(new impl_type(
-            src, sink, buffer_size, static_cast<ExceptionStorage&>(*this)));
+            src, sink, buffer_size, buffer_count,
+            static_cast<ExceptionStorage&>(*this)));
     }
 
     void close()
@@ -369,6 +594,28 @@ public:
         ExceptionStorage::rethrow();
     }
 
+    // keeps the device thread and the buffered samples
+    void pause()
+    {
+        BOOST_ASSERT(pimpl_.get());
+
+        pimpl_->pause();
+    }
+
+    void resume()
+    {
+        BOOST_ASSERT(pimpl_.get());
+
+        pimpl_->resume();
+    }
+
+    bool paused()
+    {
+        BOOST_ASSERT(pimpl_.get());
+
+        return pimpl_->paused();
+    }
+
     std::streampos tell()
     {
         BOOST_ASSERT(pimpl_.get());
@@ -386,6 +633,21 @@ public:
         return pimpl_->seek(off, way);
     }
 
+    // the maximum samples buffered between the source and the sink
+    std::streamsize latency()
+    {
+        BOOST_ASSERT(pimpl_.get());
+
+        return pimpl_->latency();
+    }
+
+    background_player_statistics statistics()
+    {
+        BOOST_ASSERT(pimpl_.get());
+
+        return pimpl_->statistics();
+    }
+
     const ExceptionStorage& exception() const
     {
         return static_cast<const ExceptionStorage&>(*this);
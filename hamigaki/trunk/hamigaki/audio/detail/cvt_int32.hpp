@@ -84,7 +84,9 @@ template<> struct cvt_int32<int_le24>
 {
     static boost::int32_t decode(const char* s)
     {
-        boost::int32_t val = hamigaki::decode_int<little,3>(s);
+        // sign extension without the branch
+        boost::int32_t val = static_cast<boost::int32_t>(
+            hamigaki::decode_uint<little,3>(s) ^ 0x800000) - 0x800000;
         return val * 256;
     }
 
@@ -100,7 +102,9 @@ template<> struct cvt_int32<int_be24>
 {
     static boost::int32_t decode(const char* s)
     {
-        boost::int32_t val = hamigaki::decode_int<big,3>(s);
+        // sign extension without the branch
+        boost::int32_t val = static_cast<boost::int32_t>(
+            hamigaki::decode_uint<big,3>(s) ^ 0x800000) - 0x800000;
         return val * 256;
     }
 
@@ -0,0 +1,192 @@
+// meter.hpp: level and loudness kernels
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+#ifndef HAMIGAKI_AUDIO_DETAIL_METER_HPP
+#define HAMIGAKI_AUDIO_DETAIL_METER_HPP
+
+#include <boost/cstdint.hpp>
+#include <boost/static_assert.hpp>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace hamigaki { namespace audio { namespace detail {
+
+// The kernels read one channel of the interleaved frames
+// with the stride "channels" and accumulate it in double.
+
+template<class CharT, bool IsInteger=std::numeric_limits<CharT>::is_integer>
+struct level_traits
+{
+    // the full scale is 1.0
+    static double scale()
+    {
+        return 1.0;
+    }
+
+    static bool is_clipped(CharT x)
+    {
+        return (x >= static_cast<CharT>(1)) || (x <= static_cast<CharT>(-1));
+    }
+};
+
+template<class CharT>
+struct level_traits<CharT,true>
+{
+    // the bytes of the PCM devices are not samples
+    BOOST_STATIC_ASSERT(sizeof(CharT) > 1);
+
+    static double scale()
+    {
+        return -1.0 / static_cast<double>((std::numeric_limits<CharT>::min)());
+    }
+
+    static bool is_clipped(CharT x)
+    {
+        return
+            (x == (std::numeric_limits<CharT>::max)()) ||
+            (x == (std::numeric_limits<CharT>::min)()) ;
+    }
+};
+
+struct channel_level
+{
+    double peak;
+    double sum; // the sum of the squares
+    boost::uintmax_t clips;
+
+    channel_level() : peak(0.0), sum(0.0), clips(0)
+    {
+    }
+};
+
+// accumulates s[i*channels] to "lv"
+template<class CharT>
+inline void accumulate_level(
+    channel_level& lv, const CharT* s, std::size_t frames, unsigned channels)
+{
+    typedef level_traits<CharT> traits;
+
+    const double scale = traits::scale();
+    double peak = lv.peak;
+    double sum = lv.sum;
+    boost::uintmax_t clips = 0;
+    for (std::size_t i = 0; i < frames; ++i)
+    {
+        const CharT x = s[i*channels];
+        const double d = static_cast<double>(x) * scale;
+        const double a = (d < 0.0) ? -d : d;
+        if (a > peak)
+            peak = a;
+        sum += d * d;
+        if (traits::is_clipped(x))
+            ++clips;
+    }
+    lv.peak = peak;
+    lv.sum = sum;
+    lv.clips += clips;
+}
+
+// the transposed direct form II
+struct biquad
+{
+    double b0, b1, b2, a1, a2;
+    double z1, z2;
+
+    biquad() : b0(1.0), b1(0.0), b2(0.0), a1(0.0), a2(0.0), z1(0.0), z2(0.0)
+    {
+    }
+
+    double operator()(double x)
+    {
+        double y = b0*x + z1;
+        z1 = b1*x - a1*y + z2;
+        z2 = b2*x - a2*y;
+        return y;
+    }
+};
+
+// the K-weighting filter of ITU-R BS.1770
+// The coefficients are derived for any sampling rate.
+class k_weighting_filter
+{
+public:
+    explicit k_weighting_filter(double rate)
+    {
+        const double pi = 3.14159265358979323846;
+
+        // the high shelf of the head
+        {
+            const double f0 = 1681.974450955533;
+            const double gain = 3.999843853973347;
+            const double q = 0.7071752369554196;
+
+            const double k = std::tan(pi * f0 / rate);
+            const double vh = std::pow(10.0, gain / 20.0);
+            const double vb = std::pow(vh, 0.4996667741545416);
+            const double a0 = 1.0 + k/q + k*k;
+
+            shelf_.b0 = (vh + vb*k/q + k*k) / a0;
+            shelf_.b1 = 2.0 * (k*k - vh) / a0;
+            shelf_.b2 = (vh - vb*k/q + k*k) / a0;
+            shelf_.a1 = 2.0 * (k*k - 1.0) / a0;
+            shelf_.a2 = (1.0 - k/q + k*k) / a0;
+        }
+
+        // the high pass (RLB weighting)
+        {
+            const double f0 = 38.13547087602444;
+            const double q = 0.5003270373238773;
+
+            const double k = std::tan(pi * f0 / rate);
+            const double a0 = 1.0 + k/q + k*k;
+
+            high_pass_.b0 = 1.0;
+            high_pass_.b1 = -2.0;
+            high_pass_.b2 = 1.0;
+            high_pass_.a1 = 2.0 * (k*k - 1.0) / a0;
+            high_pass_.a2 = (1.0 - k/q + k*k) / a0;
+        }
+    }
+
+    // returns the sum of the squares of the filtered s[i*channels]
+    template<class CharT>
+    double accumulate(const CharT* s, std::size_t frames, unsigned channels)
+    {
+        const double scale = level_traits<CharT>::scale();
+        double sum = 0.0;
+        for (std::size_t i = 0; i < frames; ++i)
+        {
+            double y = high_pass_(shelf_(static_cast<double>(s[i*channels])));
+            sum += y * y;
+        }
+        return sum * scale * scale;
+    }
+
+private:
+    biquad shelf_;
+    biquad high_pass_;
+};
+
+// the loudness (LUFS) of the mean square "energy"
+inline double energy_to_loudness(double energy)
+{
+    if (energy <= 0.0)
+        return -std::numeric_limits<double>::infinity();
+    return -0.691 + 10.0 * std::log10(energy);
+}
+
+inline double loudness_to_energy(double lufs)
+{
+    return std::pow(10.0, (lufs + 0.691) / 10.0);
+}
+
+} } } // End namespaces detail, audio, hamigaki.
+
+#endif // HAMIGAKI_AUDIO_DETAIL_METER_HPP
@@ -0,0 +1,164 @@
+// mix.hpp: gain and mixing kernels
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+#ifndef HAMIGAKI_AUDIO_DETAIL_MIX_HPP
+#define HAMIGAKI_AUDIO_DETAIL_MIX_HPP
+
+#include <boost/mpl/if.hpp>
+#include <cstddef>
+#include <limits>
+
+namespace hamigaki { namespace audio { namespace detail {
+
+// The kernels of the interleaved samples. The integer samples are
+// mixed in accumulator_type and saturated only once at the end.
+
+template<class CharT, bool IsInteger=std::numeric_limits<CharT>::is_integer>
+struct mix_traits
+{
+    // the floating point samples are not clipped
+    typedef CharT accumulator_type;
+
+    static CharT saturate(accumulator_type x)
+    {
+        return x;
+    }
+};
+
+template<class CharT>
+struct mix_traits<CharT,true>
+{
+    // float has enough precision for the samples up to 16 bits
+    typedef typename boost::mpl::if_c<
+        (sizeof(CharT) <= 2), float, double
+    >::type accumulator_type;
+
+    static CharT saturate(accumulator_type x)
+    {
+        const accumulator_type max_value =
+            static_cast<accumulator_type>((std::numeric_limits<CharT>::max)());
+        const accumulator_type min_value =
+            static_cast<accumulator_type>((std::numeric_limits<CharT>::min)());
+
+        if (x > max_value)
+            x = max_value;
+        else if (x < min_value)
+            x = min_value;
+        return static_cast<CharT>(x);
+    }
+};
+
+// s[i] *= gain
+template<class CharT>
+inline void apply_gain(CharT* s, std::size_t n, float gain)
+{
+    typedef mix_traits<CharT> traits;
+    typedef typename traits::accumulator_type acc_type;
+
+    const acc_type g = static_cast<acc_type>(gain);
+    for (std::size_t i = 0; i < n; ++i)
+        s[i] = traits::saturate(static_cast<acc_type>(s[i]) * g);
+}
+
+// acc[i] += s[i] * gain
+template<class AccT, class CharT>
+inline void accumulate(AccT* acc, const CharT* s, std::size_t n, float gain)
+{
+    const AccT g = static_cast<AccT>(gain);
+    for (std::size_t i = 0; i < n; ++i)
+        acc[i] += static_cast<AccT>(s[i]) * g;
+}
+
+// the gain changes linearly by "step" per frame
+// returns the gain after the last frame
+template<class AccT, class CharT>
+inline float accumulate_ramp(
+    AccT* acc, const CharT* s, std::size_t frames, unsigned channels,
+    float gain, float step)
+{
+    for (std::size_t i = 0; i < frames; ++i)
+    {
+        const AccT g = static_cast<AccT>(gain);
+        for (unsigned j = 0; j < channels; ++j)
+            acc[j] += static_cast<AccT>(s[j]) * g;
+
+        acc += channels;
+        s += channels;
+        gain += step;
+    }
+    return gain;
+}
+
+// The kernels of the channel buffers (planes).
+// Each plane is read sequentially to interleave only once.
+
+// s[i*channels+c] = planes[c][i]
+template<class CharT>
+inline void interleave(
+    CharT* s, const CharT* const* planes,
+    std::size_t frames, unsigned channels)
+{
+    for (unsigned c = 0; c < channels; ++c)
+    {
+        const CharT* p = planes[c];
+        CharT* d = s + c;
+        for (std::size_t i = 0; i < frames; ++i)
+            d[i*channels] = p[i];
+    }
+}
+
+// acc[i*channels+c] += planes[c][offset+i] * gain
+template<class AccT, class CharT>
+inline void accumulate_planar(
+    AccT* acc, const CharT* const* planes, std::size_t offset,
+    std::size_t frames, unsigned channels, float gain)
+{
+    const AccT g = static_cast<AccT>(gain);
+    for (unsigned c = 0; c < channels; ++c)
+    {
+        const CharT* p = planes[c] + offset;
+        AccT* d = acc + c;
+        for (std::size_t i = 0; i < frames; ++i)
+            d[i*channels] += static_cast<AccT>(p[i]) * g;
+    }
+}
+
+// the planar version of accumulate_ramp()
+template<class AccT, class CharT>
+inline float accumulate_planar_ramp(
+    AccT* acc, const CharT* const* planes, std::size_t offset,
+    std::size_t frames, unsigned channels, float gain, float step)
+{
+    // every channel has the same gain sequence as accumulate_ramp()
+    float g = gain;
+    for (unsigned c = 0; c < channels; ++c)
+    {
+        const CharT* p = planes[c] + offset;
+        AccT* d = acc + c;
+        g = gain;
+        for (std::size_t i = 0; i < frames; ++i)
+        {
+            d[i*channels] += static_cast<AccT>(p[i]) * static_cast<AccT>(g);
+            g += step;
+        }
+    }
+    return g;
+}
+
+// s[i] = saturate(acc[i])
+template<class CharT, class AccT>
+inline void store_mixed(CharT* s, const AccT* acc, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        s[i] = mix_traits<CharT>::saturate(acc[i]);
+}
+
+} } } // End namespaces detail, audio, hamigaki.
+
+#endif // HAMIGAKI_AUDIO_DETAIL_MIX_HPP
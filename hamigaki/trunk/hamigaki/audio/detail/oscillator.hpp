@@ -0,0 +1,293 @@
+// oscillator.hpp: phase-accumulator oscillators
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+#ifndef HAMIGAKI_AUDIO_DETAIL_OSCILLATOR_HPP
+#define HAMIGAKI_AUDIO_DETAIL_OSCILLATOR_HPP
+
+#include <boost/cstdint.hpp>
+#include <cmath>
+#include <cstddef>
+#include <deque>
+
+namespace hamigaki { namespace audio { namespace detail {
+
+template<class T> struct pi;
+
+template<> struct pi<float>
+{
+    static inline float value()
+    {
+        return 3.1415927f;
+    }
+};
+
+template<> struct pi<double>
+{
+    static inline double value()
+    {
+        return 3.14159265358979323846;
+    }
+};
+
+// The phase is a 32bit fixed point fraction of the period,
+// so that it wraps around without any branch and never drifts.
+
+template<class T>
+inline boost::uint32_t phase_increment(long rate, T freq)
+{
+    const double scale = 4294967296.0; // 2^32
+    double inc = std::floor(
+        static_cast<double>(freq) / static_cast<double>(rate) * scale + 0.5);
+
+    // reduce modulo 2^32 before the cast,
+    // since the rounding may reach 2^32 itself
+    inc = std::fmod(inc, scale);
+    if (inc < 0.0)
+        inc += scale;
+    return static_cast<boost::uint32_t>(inc);
+}
+
+// the phase increment per a unit of the frequency
+inline double phase_increment_scale(long rate)
+{
+    return 4294967296.0 / static_cast<double>(rate);
+}
+
+// the sine table of one period with a guard point for the interpolation
+template<class T>
+class sine_table
+{
+public:
+    static const int bits = 12;
+    static const std::size_t size = 1u << bits;
+
+    static const sine_table& instance()
+    {
+        static const sine_table table;
+        return table;
+    }
+
+    T values[size+1];
+
+private:
+    // constructs the table before main() to avoid the race
+    // on the first call of instance()
+    static const sine_table& initializer_;
+
+    sine_table()
+    {
+        // touch the initializer for the instantiation
+        (void)&initializer_;
+
+        const double w = 2.0 * pi<double>::value() / static_cast<double>(size);
+        for (std::size_t i = 0; i < size; ++i)
+            values[i] = static_cast<T>(std::sin(w * static_cast<double>(i)));
+        values[size] = values[0];
+    }
+};
+
+template<class T>
+const sine_table<T>& sine_table<T>::initializer_ = sine_table<T>::instance();
+
+// the shapes of the waves starting from zero (except the square wave)
+struct sine_shape
+{
+    template<class T>
+    static T value(const T* table, boost::uint32_t phase)
+    {
+        const int shift = 32 - sine_table<T>::bits;
+        const T scale = static_cast<T>(1.0 / static_cast<double>(1ul << shift));
+
+        std::size_t index = phase >> shift;
+        T frac = static_cast<T>(phase & ((1ul << shift) - 1)) * scale;
+        T x = table[index];
+        return x + (table[index+1] - x) * frac;
+    }
+};
+
+struct square_shape
+{
+    template<class T>
+    static T value(const T*, boost::uint32_t phase)
+    {
+        return (phase < 0x80000000ul) ? T(1) : T(-1);
+    }
+};
+
+struct sawtooth_shape
+{
+    template<class T>
+    static T value(const T*, boost::uint32_t phase)
+    {
+        const T scale = static_cast<T>(1.0 / 2147483648.0);
+        return static_cast<T>(static_cast<boost::int32_t>(phase)) * scale;
+    }
+};
+
+struct triangle_shape
+{
+    template<class T>
+    static T value(const T*, boost::uint32_t phase)
+    {
+        const T scale = static_cast<T>(1.0 / 1073741824.0);
+        boost::int32_t d = static_cast<boost::int32_t>(phase + 0xC0000000ul);
+        return T(1) - std::abs(static_cast<T>(d)) * scale;
+    }
+};
+
+// acc[i] += amp * Shape(phase) where amp and the phase increment
+// change linearly; returns the phase after the last sample
+template<class Shape, class T>
+inline boost::uint32_t oscillate(
+    T* acc, std::size_t n,
+    boost::uint32_t phase, boost::uint32_t inc, boost::int32_t inc_step,
+    T amp, T amp_step)
+{
+    const T* table = sine_table<T>::instance().values;
+    if ((inc_step == 0) && (amp_step == T()))
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            acc[i] += amp * Shape::value(table, phase);
+            phase += inc;
+        }
+    }
+    else
+    {
+        const boost::uint32_t step = static_cast<boost::uint32_t>(inc_step);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            acc[i] += amp * Shape::value(table, phase);
+            phase += inc;
+            inc += step;
+            amp += amp_step;
+        }
+    }
+    return phase;
+}
+
+// the phase after "n" samples without rendering
+inline boost::uint32_t skip_phase(
+    std::size_t n,
+    boost::uint32_t phase, boost::uint32_t inc, boost::int32_t inc_step)
+{
+    // sum of (inc + i*inc_step) for i in [0, n) modulo 2^32
+    boost::uint32_t un = static_cast<boost::uint32_t>(n);
+    boost::uint32_t tri = (n % 2 == 0)
+        ? (un / 2) * (un - 1)
+        : un * ((un - 1) / 2);
+    return phase + inc*un + static_cast<boost::uint32_t>(inc_step)*tri;
+}
+
+// A piecewise linear envelope of the breakpoints.
+// Each segment reaches the target after the specified samples exactly.
+template<class T>
+class linear_envelope
+{
+public:
+    explicit linear_envelope(T value=T())
+        : value_(value), target_(value), step_(), rest_(0)
+    {
+    }
+
+    T value() const
+    {
+        return value_;
+    }
+
+    T step() const
+    {
+        return step_;
+    }
+
+    bool steady() const
+    {
+        return rest_ == 0;
+    }
+
+    // jumps to "target" if "frames" is zero
+    void append(T target, std::size_t frames)
+    {
+        segment seg;
+        seg.target = target;
+        seg.frames = frames;
+        queue_.push_back(seg);
+        if (rest_ == 0)
+            next();
+    }
+
+    void reset(T value)
+    {
+        queue_.clear();
+        value_ = value;
+        target_ = value;
+        step_ = T();
+        rest_ = 0;
+    }
+
+    // the number of the samples until the next breakpoint
+    std::size_t span(std::size_t n) const
+    {
+        return (rest_ != 0 && rest_ < n) ? rest_ : n;
+    }
+
+    // "n" must not be beyond span()
+    void advance(std::size_t n)
+    {
+        if (rest_ == 0)
+            return;
+
+        rest_ -= n;
+        if (rest_ == 0)
+        {
+            // avoids the accumulated error
+            value_ = target_;
+            step_ = T();
+            next();
+        }
+        else
+            value_ += step_ * static_cast<T>(n);
+    }
+
+private:
+    struct segment
+    {
+        T target;
+        std::size_t frames;
+    };
+
+    T value_;
+    T target_;
+    T step_;
+    std::size_t rest_;
+    std::deque<segment> queue_;
+
+    void next()
+    {
+        while (!queue_.empty())
+        {
+            segment seg = queue_.front();
+            queue_.pop_front();
+
+            if (seg.frames == 0)
+                value_ = target_ = seg.target;
+            else
+            {
+                target_ = seg.target;
+                step_ = (target_ - value_) / static_cast<T>(seg.frames);
+                rest_ = seg.frames;
+                break;
+            }
+        }
+    }
+};
+
+} } } // End namespaces detail, audio, hamigaki.
+
+#endif // HAMIGAKI_AUDIO_DETAIL_OSCILLATOR_HPP
@@ -0,0 +1,351 @@
+// polyphase.hpp: polyphase windowed-sinc resampling engine
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+#ifndef HAMIGAKI_AUDIO_DETAIL_POLYPHASE_HPP
+#define HAMIGAKI_AUDIO_DETAIL_POLYPHASE_HPP
+
+#include <hamigaki/audio/detail/mix.hpp>
+#include <hamigaki/audio/detail/oscillator.hpp>
+#include <boost/iostreams/detail/ios.hpp>
+#include <boost/iostreams/positioning.hpp>
+#include <boost/assert.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace hamigaki { namespace audio {
+
+struct resample_quality
+{
+    enum values
+    {
+        fast, medium, best
+    };
+};
+
+namespace detail
+{
+
+struct polyphase_params
+{
+    // the zero crossings of the sinc in each side
+    double zero_crossings;
+
+    // the shape parameter of the Kaiser window
+    double beta;
+
+    // the cutoff frequency relative to the Nyquist frequency
+    double rolloff;
+};
+
+inline polyphase_params get_polyphase_params(resample_quality::values q)
+{
+    static const polyphase_params table[] =
+    {
+        {  8.0,  6.0, 0.90 },
+        { 16.0,  8.5, 0.94 },
+        { 32.0, 10.0, 0.96 }
+    };
+
+    if ((q < resample_quality::fast) || (q > resample_quality::best))
+        throw BOOST_IOSTREAMS_FAILURE("unsupported resample quality");
+    return table[q];
+}
+
+// the modified Bessel function of the first kind
+inline double bessel_i0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 64; ++k)
+    {
+        double t = x / (2.0 * k);
+        term *= t * t;
+        sum += term;
+        if (term < sum * 1e-17)
+            break;
+    }
+    return sum;
+}
+
+inline long gcd(long a, long b)
+{
+    while (b != 0)
+    {
+        long t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// The output sample "j" is at the input time j * down / up.
+// Each row of the table is the filter for a fractional position,
+// and is applied to the input samples in [base-half+1, base+half].
+template<class T>
+class polyphase_table
+{
+public:
+    // the rows are interpolated when "up" exceeds this
+    static const long max_phases = 512;
+
+    polyphase_table(long up, long down, resample_quality::values q)
+        : phases_((std::min)(up, max_phases)), exact_(up <= max_phases)
+    {
+        const polyphase_params params = get_polyphase_params(q);
+
+        // lowers the cutoff for downsampling
+        double fc = params.rolloff;
+        if (down > up)
+            fc *= static_cast<double>(up) / static_cast<double>(down);
+
+        half_ = static_cast<std::size_t>(
+            std::ceil(params.zero_crossings / fc));
+        taps_ = half_ * 2;
+
+        const double pi = detail::pi<double>::value();
+        const double i0_beta = bessel_i0(params.beta);
+
+        coefs_.resize(taps_ * (phases_ + 1));
+        for (long p = 0; p <= phases_; ++p)
+        {
+            const double phase =
+                static_cast<double>(p) / static_cast<double>(phases_);
+
+            T* row = &coefs_[static_cast<std::size_t>(p) * taps_];
+            double sum = 0.0;
+            std::vector<double> tmp(taps_);
+            for (std::size_t k = 0; k < taps_; ++k)
+            {
+                double d = static_cast<double>(k) -
+                    static_cast<double>(half_) + 1.0 - phase;
+
+                double x = d / static_cast<double>(half_);
+                double w = 0.0;
+                if (x*x < 1.0)
+                    w = bessel_i0(params.beta*std::sqrt(1.0 - x*x)) / i0_beta;
+
+                double s = (d == 0.0) ? 1.0 : std::sin(pi*fc*d) / (pi*fc*d);
+                tmp[k] = fc * s * w;
+                sum += tmp[k];
+            }
+
+            // the gain of DC is exactly one
+            for (std::size_t k = 0; k < taps_; ++k)
+                row[k] = static_cast<T>(tmp[k] / sum);
+        }
+    }
+
+    std::size_t half() const
+    {
+        return half_;
+    }
+
+    std::size_t taps() const
+    {
+        return taps_;
+    }
+
+    // returns the filter for the fractional position "frac / up"
+    const T* row(long frac, long up, T* work) const
+    {
+        if (exact_)
+            return &coefs_[static_cast<std::size_t>(frac) * taps_];
+
+        double x = static_cast<double>(frac) *
+            static_cast<double>(phases_) / static_cast<double>(up);
+        std::size_t i = static_cast<std::size_t>(x);
+        T a = static_cast<T>(x - static_cast<double>(i));
+
+        const T* r0 = &coefs_[i * taps_];
+        const T* r1 = r0 + taps_;
+        for (std::size_t k = 0; k < taps_; ++k)
+            work[k] = r0[k] + (r1[k] - r0[k]) * a;
+        return work;
+    }
+
+private:
+    long phases_;
+    bool exact_;
+    std::size_t half_;
+    std::size_t taps_;
+    std::vector<T> coefs_;
+};
+
+// acc[c] = sum of x[k*channels+c] * h[k]
+template<class AccT, class CharT>
+inline void polyphase_dot(
+    AccT* acc, const CharT* x, const AccT* h,
+    std::size_t taps, unsigned channels)
+{
+    if (channels == 1)
+    {
+        // two partial sums break the dependency chain
+        AccT sum0 = AccT();
+        AccT sum1 = AccT();
+        std::size_t k = 0;
+        for ( ; k + 1 < taps; k += 2)
+        {
+            sum0 += static_cast<AccT>(x[k]) * h[k];
+            sum1 += static_cast<AccT>(x[k+1]) * h[k+1];
+        }
+        if (k < taps)
+            sum0 += static_cast<AccT>(x[k]) * h[k];
+        acc[0] = sum0 + sum1;
+        return;
+    }
+
+    std::fill_n(acc, channels, AccT());
+    for (std::size_t k = 0; k < taps; ++k, x += channels)
+    {
+        const AccT hk = h[k];
+        for (unsigned c = 0; c < channels; ++c)
+            acc[c] += static_cast<AccT>(x[c]) * hk;
+    }
+}
+
+// The streaming resampler of the interleaved frames.
+// The output is aligned with the input without any delay,
+// and has ceil(input frames * out_rate / in_rate) frames.
+template<class CharT>
+class polyphase_resampler
+{
+private:
+    typedef typename mix_traits<CharT>::accumulator_type accumulator_type;
+    typedef polyphase_table<accumulator_type> table_type;
+
+public:
+    polyphase_resampler(
+            unsigned channels, long in_rate, long out_rate,
+            resample_quality::values q)
+        : channels_(channels)
+        , up_(out_rate / gcd(in_rate, out_rate))
+        , down_(in_rate / gcd(in_rate, out_rate))
+        , table_(up_, down_, q)
+        , work_(table_.taps()), acc_(channels)
+        , pos_(0), frac_(0), in_frames_(0), out_frames_(0), limit_(0)
+        , finished_(false)
+    {
+        BOOST_ASSERT(channels != 0);
+
+        // the history before the first sample
+        buffer_.resize((table_.half() - 1) * channels_);
+    }
+
+    unsigned channels() const
+    {
+        return channels_;
+    }
+
+    // the number of the buffered frames needed for an output
+    std::size_t taps() const
+    {
+        return table_.taps();
+    }
+
+    void push(const CharT* s, std::size_t frames)
+    {
+        BOOST_ASSERT(!finished_);
+
+        discard_used();
+        buffer_.insert(buffer_.end(), s, s + frames*channels_);
+        in_frames_ += static_cast<boost::iostreams::stream_offset>(frames);
+    }
+
+    // interleaves the channel buffers into the history directly
+    void push_planar(const CharT* const* planes, std::size_t frames)
+    {
+        BOOST_ASSERT(!finished_);
+
+        discard_used();
+        std::size_t size = buffer_.size();
+        buffer_.resize(size + frames*channels_);
+        detail::interleave(&buffer_[size], planes, frames, channels_);
+        in_frames_ += static_cast<boost::iostreams::stream_offset>(frames);
+    }
+
+    // notifies the end of the input
+    void finish()
+    {
+        if (finished_)
+            return;
+
+        discard_used();
+        buffer_.resize(buffer_.size() + table_.taps()*channels_);
+        limit_ = (in_frames_ * up_ + down_ - 1) / down_;
+        finished_ = true;
+    }
+
+    // returns the number of the frames written to "s"
+    std::size_t pull(CharT* s, std::size_t frames)
+    {
+        const std::size_t taps = table_.taps();
+        const std::size_t buffered = buffer_.size() / channels_;
+
+        std::size_t count = 0;
+        for ( ; count < frames; ++count)
+        {
+            if (finished_ && (out_frames_ >= limit_))
+                break;
+            if (pos_ + taps > buffered)
+                break;
+
+            const accumulator_type* h = table_.row(frac_, up_, &work_[0]);
+            polyphase_dot(
+                &acc_[0], &buffer_[pos_*channels_], h, taps, channels_);
+            for (unsigned c = 0; c < channels_; ++c)
+                *(s++) = mix_traits<CharT>::saturate(acc_[c]);
+
+            frac_ += down_;
+            pos_ += static_cast<std::size_t>(frac_ / up_);
+            frac_ %= up_;
+            ++out_frames_;
+        }
+        return count;
+    }
+
+    // true if all frames are pulled after finish()
+    bool done() const
+    {
+        return finished_ && (out_frames_ >= limit_);
+    }
+
+private:
+    unsigned channels_;
+    long up_;
+    long down_;
+    table_type table_;
+    std::vector<accumulator_type> work_;
+    std::vector<accumulator_type> acc_;
+    std::vector<CharT> buffer_;
+    std::size_t pos_;
+    long frac_;
+    boost::iostreams::stream_offset in_frames_;
+    boost::iostreams::stream_offset out_frames_;
+    boost::iostreams::stream_offset limit_;
+    bool finished_;
+
+    void discard_used()
+    {
+        // "pos_" can be beyond the buffer in downsampling
+        std::size_t frames = (std::min)(pos_, buffer_.size() / channels_);
+        if (frames == 0)
+            return;
+
+        buffer_.erase(buffer_.begin(), buffer_.begin() + frames*channels_);
+        pos_ -= frames;
+    }
+};
+
+} // namespace detail
+
+} } // End namespaces audio, hamigaki.
+
+#endif // HAMIGAKI_AUDIO_DETAIL_POLYPHASE_HPP
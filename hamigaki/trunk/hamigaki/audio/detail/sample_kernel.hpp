@@ -0,0 +1,378 @@
+// sample_kernel.hpp: batch converters between the samples and the bytes
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+#ifndef HAMIGAKI_AUDIO_DETAIL_SAMPLE_KERNEL_HPP
+#define HAMIGAKI_AUDIO_DETAIL_SAMPLE_KERNEL_HPP
+
+#include <hamigaki/audio/detail/a_law.hpp>
+#include <hamigaki/audio/detail/cvt_int32.hpp>
+#include <hamigaki/audio/detail/float.hpp>
+#include <hamigaki/audio/detail/mu_law.hpp>
+#include <hamigaki/audio/sample_format.hpp>
+#include <hamigaki/binary/endian.hpp>
+#include <boost/iostreams/detail/ios.hpp>
+#include <boost/cstdint.hpp>
+#include <cstddef>
+
+namespace hamigaki { namespace audio { namespace detail {
+
+// Interface of the codecs:
+//   typedef ... char_type;
+//
+//   // the conversions from/to the 32bit integer samples
+//   static char_type from_int32(boost::int32_t n);
+//   static boost::int32_t to_int32(char_type x);
+//
+//   // the conversions from/to the floating point samples
+//   template<class F> static char_type from_float(F x);
+//   template<class F> static F to_float(char_type x);
+//
+//   // the kernel for mu_law and a_law
+//   template<sample_format_type Type> struct companding_kernel;
+
+// The kernels convert a whole block per call. The sample format is
+// a template argument, so the byte order and the sample size are
+// resolved once by the adaptor instead of per sample.
+
+template<sample_format_type Type, class Codec>
+struct int_sample_kernel
+{
+    typedef typename Codec::char_type char_type;
+
+    static void decode(char_type* s, const char* p, std::size_t count)
+    {
+        const std::size_t size = static_cast<std::size_t>(sample_size(Type));
+        for (std::size_t i = 0; i < count; ++i, p += size)
+            s[i] = Codec::from_int32(cvt_int32<Type>::decode(p));
+    }
+
+    static void encode(char* p, const char_type* s, std::size_t count)
+    {
+        const std::size_t size = static_cast<std::size_t>(sample_size(Type));
+        for (std::size_t i = 0; i < count; ++i, p += size)
+            cvt_int32<Type>::encode(p, Codec::to_int32(s[i]));
+    }
+};
+
+template<endianness E, float_format Format, class Codec>
+struct float_sample_kernel
+{
+    typedef typename Codec::char_type char_type;
+    typedef float_traits<Format> traits_type;
+    typedef typename traits_type::value_type value_type;
+    static const std::size_t size = traits_type::bits / 8;
+
+    static void decode(char_type* s, const char* p, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i, p += size)
+        {
+            typename integer_encoding_traits<size>::int_type tmp =
+                hamigaki::decode_uint<E,size>(p);
+            s[i] = Codec::from_float(
+                detail::decode_ieee754<value_type,Format>(tmp));
+        }
+    }
+
+    static void encode(char* p, const char_type* s, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i, p += size)
+        {
+            value_type x = Codec::template to_float<value_type>(s[i]);
+            hamigaki::encode_uint<E,size>(
+                p, detail::encode_ieee754<value_type,Format>(x));
+        }
+    }
+};
+
+template<sample_format_type Type>
+struct companding_traits;
+
+template<>
+struct companding_traits<mu_law>
+{
+    // the code depends on only the upper bits of the 32bit sample
+    static const int encode_shift = 18;
+
+    template<class T>
+    static T decode(boost::uint8_t n)
+    {
+        return detail::decode_mu_law<T>(n);
+    }
+
+    template<class T>
+    static boost::uint8_t encode(T x)
+    {
+        return detail::encode_mu_law<T>(x);
+    }
+};
+
+template<>
+struct companding_traits<a_law>
+{
+    static const int encode_shift = 19;
+
+    template<class T>
+    static T decode(boost::uint8_t n)
+    {
+        return detail::decode_a_law<T>(n);
+    }
+
+    template<class T>
+    static boost::uint8_t encode(T x)
+    {
+        return detail::encode_a_law<T>(x);
+    }
+};
+
+// the decoded values of all 256 codes
+template<sample_format_type Type, class T>
+class companding_table
+{
+public:
+    static const companding_table& instance()
+    {
+        static const companding_table table;
+        return table;
+    }
+
+    T values[256];
+
+private:
+    // constructs the table before main() to avoid the race
+    // on the first call of instance()
+    static const companding_table& initializer_;
+
+    companding_table()
+    {
+        // touch the initializer for the instantiation
+        (void)&initializer_;
+
+        for (unsigned n = 0; n < 256; ++n)
+        {
+            values[n] = companding_traits<Type>::template
+                decode<T>(static_cast<boost::uint8_t>(n));
+        }
+    }
+};
+
+template<sample_format_type Type, class T>
+const companding_table<Type,T>&
+companding_table<Type,T>::initializer_ =
+    companding_table<Type,T>::instance();
+
+// mu_law and a_law to/from the floating point values
+template<sample_format_type Type, class T>
+struct companding_float_kernel
+{
+    static void decode(T* s, const char* p, std::size_t count)
+    {
+        const T* table = companding_table<Type,T>::instance().values;
+        for (std::size_t i = 0; i < count; ++i)
+            s[i] = table[static_cast<unsigned char>(p[i])];
+    }
+
+    static void encode(char* p, const T* s, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            p[i] = static_cast<char>(static_cast<unsigned char>(
+                companding_traits<Type>::template encode<T>(s[i])
+            ));
+        }
+    }
+};
+
+// the codes to/from the 32bit integer samples
+template<sample_format_type Type>
+class companding_int_table
+{
+public:
+    static const int shift = companding_traits<Type>::encode_shift;
+    static const std::size_t encode_size = 1u << (32 - shift);
+
+    static const companding_int_table& instance()
+    {
+        static const companding_int_table table;
+        return table;
+    }
+
+    boost::int32_t decode[256];
+    unsigned char encode[encode_size];
+
+    static std::size_t encode_index(boost::int32_t n)
+    {
+        return static_cast<boost::uint32_t>(n) >> shift;
+    }
+
+private:
+    static const companding_int_table& initializer_;
+
+    companding_int_table()
+    {
+        (void)&initializer_;
+
+        for (unsigned n = 0; n < 256; ++n)
+        {
+            const char c = static_cast<char>(static_cast<unsigned char>(n));
+            decode[n] = cvt_int32<Type>::decode(&c);
+        }
+
+        const boost::int32_t half = static_cast<boost::int32_t>(encode_size/2);
+        for (boost::int32_t i = -half; i < half; ++i)
+        {
+            const boost::int32_t n = i * (1 << shift);
+
+            char c;
+            cvt_int32<Type>::encode(&c, n);
+            encode[encode_index(n)] = static_cast<unsigned char>(c);
+        }
+    }
+};
+
+template<sample_format_type Type>
+const companding_int_table<Type>&
+companding_int_table<Type>::initializer_ =
+    companding_int_table<Type>::instance();
+
+// mu_law and a_law to/from the integer values
+template<sample_format_type Type, class Codec>
+struct companding_int_kernel
+{
+    typedef typename Codec::char_type char_type;
+    typedef companding_int_table<Type> table_type;
+
+    static void decode(char_type* s, const char* p, std::size_t count)
+    {
+        const table_type& table = table_type::instance();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            s[i] = Codec::from_int32(
+                table.decode[static_cast<unsigned char>(p[i])]);
+        }
+    }
+
+    static void encode(char* p, const char_type* s, std::size_t count)
+    {
+        const table_type& table = table_type::instance();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::size_t index =
+                table_type::encode_index(Codec::to_int32(s[i]));
+            p[i] = static_cast<char>(table.encode[index]);
+        }
+    }
+};
+
+// the pair of the kernels selected by the sample format
+template<class Codec>
+class sample_kernel
+{
+public:
+    typedef typename Codec::char_type char_type;
+
+    explicit sample_kernel(sample_format_type type)
+    {
+        switch (type)
+        {
+            case uint8:
+                assign<int_sample_kernel<uint8,Codec> >();
+                break;
+            case int8:
+                assign<int_sample_kernel<int8,Codec> >();
+                break;
+            case int_le16:
+                assign<int_sample_kernel<int_le16,Codec> >();
+                break;
+            case int_be16:
+                assign<int_sample_kernel<int_be16,Codec> >();
+                break;
+            case int_le24:
+                assign<int_sample_kernel<int_le24,Codec> >();
+                break;
+            case int_be24:
+                assign<int_sample_kernel<int_be24,Codec> >();
+                break;
+            case int_le32:
+                assign<int_sample_kernel<int_le32,Codec> >();
+                break;
+            case int_be32:
+                assign<int_sample_kernel<int_be32,Codec> >();
+                break;
+            case int_a4_le16:
+                assign<int_sample_kernel<int_a4_le16,Codec> >();
+                break;
+            case int_a4_be16:
+                assign<int_sample_kernel<int_a4_be16,Codec> >();
+                break;
+            case int_a4_le18:
+                assign<int_sample_kernel<int_a4_le18,Codec> >();
+                break;
+            case int_a4_be18:
+                assign<int_sample_kernel<int_a4_be18,Codec> >();
+                break;
+            case int_a4_le20:
+                assign<int_sample_kernel<int_a4_le20,Codec> >();
+                break;
+            case int_a4_be20:
+                assign<int_sample_kernel<int_a4_be20,Codec> >();
+                break;
+            case int_a4_le24:
+                assign<int_sample_kernel<int_a4_le24,Codec> >();
+                break;
+            case int_a4_be24:
+                assign<int_sample_kernel<int_a4_be24,Codec> >();
+                break;
+            case float_le32:
+                assign<float_sample_kernel<little,ieee754_single,Codec> >();
+                break;
+            case float_be32:
+                assign<float_sample_kernel<big,ieee754_single,Codec> >();
+                break;
+            case float_le64:
+                assign<float_sample_kernel<little,ieee754_double,Codec> >();
+                break;
+            case float_be64:
+                assign<float_sample_kernel<big,ieee754_double,Codec> >();
+                break;
+            case mu_law:
+                assign<typename Codec::template companding_kernel<mu_law> >();
+                break;
+            case a_law:
+                assign<typename Codec::template companding_kernel<a_law> >();
+                break;
+            default:
+                throw BOOST_IOSTREAMS_FAILURE("unsupported format");
+        }
+    }
+
+    void decode(char_type* s, const char* p, std::size_t count) const
+    {
+        decode_(s, p, count);
+    }
+
+    void encode(char* p, const char_type* s, std::size_t count) const
+    {
+        encode_(p, s, count);
+    }
+
+private:
+    void (*decode_)(char_type*, const char*, std::size_t);
+    void (*encode_)(char*, const char_type*, std::size_t);
+
+    template<class Kernel>
+    void assign()
+    {
+        decode_ = &Kernel::decode;
+        encode_ = &Kernel::encode;
+    }
+};
+
+} } } // End namespaces detail, audio, hamigaki.
+
+#endif // HAMIGAKI_AUDIO_DETAIL_SAMPLE_KERNEL_HPP
@@ -10,6 +10,7 @@
 #ifndef HAMIGAKI_AUDIO_DETAIL_WIDE_ADAPTOR_FLOAT_FLOAT_HPP
 #define HAMIGAKI_AUDIO_DETAIL_WIDE_ADAPTOR_FLOAT_FLOAT_HPP
 
+#include <hamigaki/audio/device_delay.hpp>
 #include <hamigaki/iostreams/positioning.hpp>
 #include <boost/iostreams/operations.hpp>
 #include <vector>
@@ -72,6 +73,11 @@ public:
         return buffer_.size();
     }
 
+    std::streamsize delay() const
+    {
+        return audio::device_delay(dev_);
+    }
+
 private:
     Device dev_;
     std::vector<base_char_type> buffer_;
@@ -0,0 +1,69 @@
+// device_delay.hpp: the samples buffered in the audio devices
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+#ifndef HAMIGAKI_AUDIO_DEVICE_DELAY_HPP
+#define HAMIGAKI_AUDIO_DEVICE_DELAY_HPP
+
+#include <boost/iostreams/detail/dispatch.hpp>
+#include <boost/iostreams/detail/wrap_unwrap.hpp>
+#include <boost/iostreams/categories.hpp>
+#include <boost/iostreams/positioning.hpp>
+
+namespace hamigaki { namespace audio {
+
+// The device has the member function
+//   std::streamsize delay() const;
+// which returns the written samples not played yet.
+// The unit is the char_type of the device (i.e. bytes for the PCM
+// devices), and the converting adaptors scale it to their char_type.
+struct delay_tag : virtual boost::iostreams::any_tag {};
+
+namespace detail
+{
+
+template<typename T>
+struct device_delay_impl;
+
+template<>
+struct device_delay_impl<delay_tag>
+{
+    template<typename T>
+    static std::streamsize device_delay(const T& t)
+    {
+        return t.delay();
+    }
+};
+
+template<>
+struct device_delay_impl<boost::iostreams::any_tag>
+{
+    template<typename T>
+    static std::streamsize device_delay(const T&)
+    {
+        return 0;
+    }
+};
+
+} // namespace detail
+
+// returns zero if the device does not know its delay
+template<typename T>
+inline std::streamsize device_delay(const T& t)
+{
+    typedef typename boost::iostreams::detail::dispatch<
+        T, delay_tag, boost::iostreams::any_tag
+    >::type tag;
+
+    return detail::device_delay_impl<tag>::
+        device_delay(boost::iostreams::detail::unwrap(t));
+}
+
+} } // End namespaces audio, hamigaki.
+
+#endif // HAMIGAKI_AUDIO_DEVICE_DELAY_HPP
@@ -12,6 +12,7 @@
 
 #include <hamigaki/audio/detail/config.hpp>
 #include <hamigaki/audio/detail/auto_link/hamigaki_audio.hpp>
+#include <hamigaki/audio/device_delay.hpp>
 #include <hamigaki/audio/pcm_format.hpp>
 #include <boost/iostreams/categories.hpp>
 #include <boost/shared_ptr.hpp>
@@ -32,7 +33,8 @@ public:
         boost::iostreams::closable_tag,
         boost::iostreams::flushable_tag,
         boost::iostreams::optimally_buffered_tag,
-        pcm_format_tag {};
+        pcm_format_tag,
+        delay_tag {};
 
     explicit dsp_sink(const pcm_format& f);
     dsp_sink(const char* ph, const pcm_format& f);
@@ -48,6 +50,9 @@ public:
     bool flush();
     void close();
 
+    // the bytes written but not played yet
+    std::streamsize delay() const;
+
 private:
     class impl;
     boost::shared_ptr<impl> pimpl_;
@@ -0,0 +1,426 @@
+// meter.hpp: level and loudness meters
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+#ifndef HAMIGAKI_AUDIO_METER_HPP
+#define HAMIGAKI_AUDIO_METER_HPP
+
+#include <hamigaki/audio/detail/meter.hpp>
+#include <hamigaki/iostreams/catable.hpp>
+#include <boost/iostreams/categories.hpp>
+#include <boost/iostreams/close.hpp>
+#include <boost/iostreams/detail/adapter/direct_adapter.hpp>
+#include <boost/iostreams/detail/ios.hpp>
+#include <boost/iostreams/detail/select.hpp>
+#include <boost/iostreams/optimal_buffer_size.hpp>
+#include <boost/iostreams/read.hpp>
+#include <boost/iostreams/traits.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <vector>
+
+namespace hamigaki { namespace audio {
+
+// The meters take the interleaved samples of the floating point types
+// and the integer types wider than char. The integer samples are
+// normalized by the full scale of the type (e.g. 32768 for int16_t).
+// The bytes of the PCM devices are rejected at compile time,
+// so use widen<float>() or widen<boost::int16_t>() before the meters.
+// The copies of a meter share the measured values.
+
+// the peak, RMS and the clipped samples of each channel
+class level_meter
+{
+private:
+    struct impl
+    {
+        std::vector<detail::channel_level> levels;
+        boost::uintmax_t frames;
+        unsigned channel;
+
+        explicit impl(unsigned channels)
+            : levels(channels), frames(0), channel(0)
+        {
+        }
+    };
+
+public:
+    explicit level_meter(unsigned channels)
+        : pimpl_(new impl(channels))
+    {
+    }
+
+    unsigned channels() const
+    {
+        return static_cast<unsigned>(pimpl_->levels.size());
+    }
+
+    // the samples may end in the middle of a frame
+    template<class CharT>
+    void process(const CharT* s, std::streamsize n)
+    {
+        impl& m = *pimpl_;
+        const unsigned channels = this->channels();
+
+        while ((n > 0) && (m.channel != 0))
+        {
+            detail::accumulate_level(m.levels[m.channel], s, 1, channels);
+            next_channel();
+            ++s;
+            --n;
+        }
+
+        std::size_t frames = static_cast<std::size_t>(n / channels);
+        if (frames != 0)
+        {
+            for (unsigned c = 0; c < channels; ++c)
+                detail::accumulate_level(m.levels[c], s+c, frames, channels);
+            m.frames += frames;
+            s += frames * channels;
+            n -= static_cast<std::streamsize>(frames * channels);
+        }
+
+        for ( ; n > 0; ++s, --n)
+        {
+            detail::accumulate_level(m.levels[m.channel], s, 1, channels);
+            next_channel();
+        }
+    }
+
+    boost::uintmax_t frames() const
+    {
+        return pimpl_->frames;
+    }
+
+    // the absolute value of the full scale is 1.0
+    double peak(unsigned channel) const
+    {
+        return pimpl_->levels[channel].peak;
+    }
+
+    double rms(unsigned channel) const
+    {
+        if (pimpl_->frames == 0)
+            return 0.0;
+
+        return std::sqrt(
+            pimpl_->levels[channel].sum /
+            static_cast<double>(pimpl_->frames)
+        );
+    }
+
+    // the samples reached the full scale
+    boost::uintmax_t clip_count(unsigned channel) const
+    {
+        return pimpl_->levels[channel].clips;
+    }
+
+    void reset()
+    {
+        impl& m = *pimpl_;
+        std::fill(m.levels.begin(), m.levels.end(), detail::channel_level());
+        m.frames = 0;
+        m.channel = 0;
+    }
+
+private:
+    boost::shared_ptr<impl> pimpl_;
+
+    void next_channel()
+    {
+        impl& m = *pimpl_;
+        if (++m.channel == m.levels.size())
+        {
+            m.channel = 0;
+            ++m.frames;
+        }
+    }
+};
+
+// the loudness of EBU R128 (ITU-R BS.1770)
+// The K-weighted energy is kept every 100msec. The stream is not buffered.
+class loudness_meter
+{
+private:
+    // 3sec of the 100msec blocks
+    static const std::size_t short_term_blocks = 30;
+    static const std::size_t momentary_blocks = 4;
+
+    struct impl
+    {
+        std::vector<detail::k_weighting_filter> filters;
+        std::vector<double> weights;
+        double rate;
+        std::size_t block_frames;
+
+        // the current 100msec block
+        std::size_t frames;
+        unsigned channel;
+        double sum;
+
+        std::deque<double> recent;
+        std::vector<double> gating_blocks; // 400msec, overlapped by 75%
+
+        impl(unsigned channels, double rate)
+            : filters(channels, detail::k_weighting_filter(rate))
+            , weights(channels, 1.0), rate(rate)
+            , block_frames(static_cast<std::size_t>(rate / 10.0 + 0.5))
+            , frames(0), channel(0), sum(0.0)
+        {
+            // L, R, C, LFE, Ls, Rs
+            if (channels == 6)
+            {
+                weights[3] = 0.0;
+                weights[4] = 1.41;
+                weights[5] = 1.41;
+            }
+        }
+    };
+
+public:
+    loudness_meter(unsigned channels, double rate)
+        : pimpl_(new impl(channels, rate))
+    {
+    }
+
+    unsigned channels() const
+    {
+        return static_cast<unsigned>(pimpl_->weights.size());
+    }
+
+    // the default is 1.0 (1.41 for the surround channels of 5.1ch)
+    void channel_weight(unsigned channel, double weight)
+    {
+        pimpl_->weights[channel] = weight;
+    }
+
+    // the samples may end in the middle of a frame
+    template<class CharT>
+    void process(const CharT* s, std::streamsize n)
+    {
+        impl& m = *pimpl_;
+        const unsigned channels = this->channels();
+
+        while ((n > 0) && (m.channel != 0))
+        {
+            process_sample(s);
+            ++s;
+            --n;
+        }
+
+        std::size_t frames = static_cast<std::size_t>(n / channels);
+        while (frames != 0)
+        {
+            std::size_t count = (std::min)(frames, m.block_frames - m.frames);
+            for (unsigned c = 0; c < channels; ++c)
+            {
+                if (m.weights[c] != 0.0)
+                {
+                    m.sum += m.weights[c] *
+                        m.filters[c].accumulate(s+c, count, channels);
+                }
+            }
+
+            m.frames += count;
+            if (m.frames == m.block_frames)
+                end_block();
+
+            s += count * channels;
+            n -= static_cast<std::streamsize>(count * channels);
+            frames -= count;
+        }
+
+        for ( ; n > 0; ++s, --n)
+            process_sample(s);
+    }
+
+    // the loudness of the last 400msec (LUFS)
+    double momentary() const
+    {
+        return window_loudness(momentary_blocks);
+    }
+
+    // the loudness of the last 3sec (LUFS)
+    double short_term() const
+    {
+        return window_loudness(short_term_blocks);
+    }
+
+    // the gated loudness of the whole stream (LUFS)
+    double integrated() const
+    {
+        const std::vector<double>& blocks = pimpl_->gating_blocks;
+
+        const double abs_gate = detail::loudness_to_energy(-70.0);
+        double mean = gated_mean(blocks, abs_gate);
+        if (mean <= 0.0)
+            return -std::numeric_limits<double>::infinity();
+
+        // the relative gate is -10LU
+        const double rel_gate = mean * 0.1;
+        return detail::energy_to_loudness(
+            gated_mean(blocks, (std::max)(abs_gate, rel_gate)));
+    }
+
+    void reset()
+    {
+        impl& m = *pimpl_;
+        std::fill(
+            m.filters.begin(), m.filters.end(),
+            detail::k_weighting_filter(m.rate));
+        m.frames = 0;
+        m.channel = 0;
+        m.sum = 0.0;
+        m.recent.clear();
+        m.gating_blocks.clear();
+    }
+
+private:
+    boost::shared_ptr<impl> pimpl_;
+
+    template<class CharT>
+    void process_sample(const CharT* s)
+    {
+        impl& m = *pimpl_;
+        if (m.weights[m.channel] != 0.0)
+        {
+            m.sum += m.weights[m.channel] *
+                m.filters[m.channel].accumulate(s, 1, channels());
+        }
+
+        if (++m.channel == channels())
+        {
+            m.channel = 0;
+            if (++m.frames == m.block_frames)
+                end_block();
+        }
+    }
+
+    void end_block()
+    {
+        impl& m = *pimpl_;
+
+        m.recent.push_back(m.sum / static_cast<double>(m.block_frames));
+        if (m.recent.size() > short_term_blocks)
+            m.recent.pop_front();
+
+        if (m.recent.size() >= momentary_blocks)
+        {
+            double sum = 0.0;
+            std::deque<double>::reverse_iterator it = m.recent.rbegin();
+            for (std::size_t i = 0; i < momentary_blocks; ++i, ++it)
+                sum += *it;
+            m.gating_blocks.push_back(sum / momentary_blocks);
+        }
+
+        m.frames = 0;
+        m.sum = 0.0;
+    }
+
+    double window_loudness(std::size_t blocks) const
+    {
+        const std::deque<double>& recent = pimpl_->recent;
+        if (recent.size() < blocks)
+            return -std::numeric_limits<double>::infinity();
+
+        double sum = 0.0;
+        std::deque<double>::const_reverse_iterator it = recent.rbegin();
+        for (std::size_t i = 0; i < blocks; ++i, ++it)
+            sum += *it;
+        return detail::energy_to_loudness(sum / static_cast<double>(blocks));
+    }
+
+    static double gated_mean(const std::vector<double>& blocks, double gate)
+    {
+        double sum = 0.0;
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < blocks.size(); ++i)
+        {
+            if (blocks[i] > gate)
+            {
+                sum += blocks[i];
+                ++count;
+            }
+        }
+        return (count != 0) ? sum / static_cast<double>(count) : 0.0;
+    }
+};
+
+// passes the samples through "Meter" (level_meter, loudness_meter or
+// any class with process(s, n))
+template<class Source, class Meter>
+class metered_source
+{
+private:
+    typedef typename
+        boost::iostreams::select<
+            boost::iostreams::is_direct<Source>,
+                boost::iostreams::detail::direct_adapter<Source>,
+            boost::iostreams::else_,
+                Source
+        >::type value_type;
+
+public:
+    typedef typename boost::iostreams::
+        char_type_of<value_type>::type char_type;
+
+    struct category :
+        boost::iostreams::input,
+        boost::iostreams::device_tag,
+        boost::iostreams::closable_tag,
+        boost::iostreams::optimally_buffered_tag {};
+
+    metered_source(const Source& src, const Meter& m)
+        : src_(src), meter_(m)
+    {
+    }
+
+    std::streamsize read(char_type* s, std::streamsize n)
+    {
+        std::streamsize amt = boost::iostreams::read(src_, s, n);
+        if (amt > 0)
+            meter_.process(s, amt);
+        return amt;
+    }
+
+    void close()
+    {
+        boost::iostreams::close(src_, BOOST_IOS::in);
+    }
+
+    std::streamsize optimal_buffer_size() const
+    {
+        return boost::iostreams::optimal_buffer_size(src_);
+    }
+
+    Meter meter() const
+    {
+        return meter_;
+    }
+
+private:
+    value_type src_;
+    Meter meter_;
+};
+
+template<class Source, class Meter>
+inline metered_source<Source, Meter>
+measure(const Source& src, const Meter& m)
+{
+    return metered_source<Source, Meter>(src, m);
+}
+
+} } // End namespaces audio, hamigaki.
+
+HAMIGAKI_IOSTREAMS_CATABLE(hamigaki::audio::metered_source, 2)
+
+#endif // HAMIGAKI_AUDIO_METER_HPP
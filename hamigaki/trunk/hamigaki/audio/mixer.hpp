@@ -0,0 +1,423 @@
+// mixer.hpp: mixer of the audio sources
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+#ifndef HAMIGAKI_AUDIO_MIXER_HPP
+#define HAMIGAKI_AUDIO_MIXER_HPP
+
+#include <hamigaki/audio/detail/mix.hpp>
+#include <hamigaki/audio/planar.hpp>
+#include <hamigaki/iostreams/arbitrary_positional_facade.hpp>
+#include <hamigaki/iostreams/catable.hpp>
+#include <boost/iostreams/categories.hpp>
+#include <boost/iostreams/close.hpp>
+#include <boost/iostreams/detail/adapter/direct_adapter.hpp>
+#include <boost/iostreams/detail/adapter/non_blocking_adapter.hpp>
+#include <boost/iostreams/detail/select.hpp>
+#include <boost/iostreams/read.hpp>
+#include <boost/iostreams/traits.hpp>
+#include <boost/assert.hpp>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace hamigaki { namespace audio {
+
+namespace detail
+{
+
+template<class CharT>
+class mixer_input_base
+{
+public:
+    virtual ~mixer_input_base() {}
+
+    // reads "n" samples unless the end of the source
+    virtual std::streamsize read(CharT* s, std::streamsize n) = 0;
+    virtual void close() = 0;
+
+    // true if read_planar() is available
+    virtual bool planar() const
+    {
+        return false;
+    }
+
+    virtual std::streamsize read_planar(
+        const CharT* const*&, std::streamsize)
+    {
+        return -1;
+    }
+};
+
+template<class CharT, class Source>
+class mixer_input : public mixer_input_base<CharT>
+{
+private:
+    typedef typename
+        boost::iostreams::select<
+            boost::iostreams::is_direct<Source>,
+                boost::iostreams::detail::direct_adapter<Source>,
+            boost::iostreams::else_,
+                Source
+        >::type value_type;
+
+public:
+    explicit mixer_input(const Source& src) : src_(src)
+    {
+    }
+
+    std::streamsize read(CharT* s, std::streamsize n) // virtual
+    {
+        boost::iostreams::non_blocking_adapter<value_type> nb(src_);
+        return boost::iostreams::read(nb, s, n);
+    }
+
+    void close() // virtual
+    {
+        boost::iostreams::close(src_, BOOST_IOS::in);
+    }
+
+private:
+    value_type src_;
+};
+
+template<class CharT, class Source>
+class planar_mixer_input : public mixer_input_base<CharT>
+{
+public:
+    explicit planar_mixer_input(const Source& src) : src_(src)
+    {
+    }
+
+    std::streamsize read(CharT* s, std::streamsize n) // virtual
+    {
+        boost::iostreams::non_blocking_adapter<Source> nb(src_);
+        return boost::iostreams::read(nb, s, n);
+    }
+
+    void close() // virtual
+    {
+        boost::iostreams::close(src_, BOOST_IOS::in);
+    }
+
+    bool planar() const // virtual
+    {
+        return true;
+    }
+
+    std::streamsize read_planar(
+        const CharT* const*& planes, std::streamsize frames) // virtual
+    {
+        return src_.read_planar(planes, frames);
+    }
+
+private:
+    Source src_;
+};
+
+template<class CharT, class Source>
+struct select_mixer_input
+{
+    typedef typename
+        boost::iostreams::select<
+            is_planar_source<Source>,
+                planar_mixer_input<CharT,Source>,
+            boost::iostreams::else_,
+                mixer_input<CharT,Source>
+        >::type type;
+};
+
+} // namespace detail
+
+// Mixes the sources of the same char_type and channels.
+// Each source has its gain, which can be changed linearly (a ramp).
+// The integer samples are saturated after mixing.
+// The output ends when all sources end.
+// The planar sources are mixed from their channel buffers directly.
+// A read retries while the live sources return no frames.
+template<class CharT=float>
+class basic_mixer
+    : public hamigaki::iostreams::
+        arbitrary_positional_facade<basic_mixer<CharT>, CharT, 255>
+{
+    friend class hamigaki::iostreams::core_access;
+
+private:
+    typedef detail::mix_traits<CharT> traits_type;
+    typedef typename traits_type::accumulator_type accumulator_type;
+    typedef detail::mixer_input_base<CharT> input_type;
+
+    struct input_state
+    {
+        boost::shared_ptr<input_type> ptr;
+        float gain;
+        float target;
+        float step;
+        std::streamsize ramp_frames;
+        bool eof;
+    };
+
+public:
+    typedef CharT char_type;
+
+    struct category
+        : public boost::iostreams::input
+        , public boost::iostreams::device_tag
+        , public boost::iostreams::closable_tag
+        , public boost::iostreams::optimally_buffered_tag
+    {};
+
+    explicit basic_mixer(unsigned channels=1, std::streamsize frames=1024)
+        : basic_mixer<CharT>::arbitrary_positional_facade_(channels)
+        , channels_(channels)
+        , buffer_(static_cast<std::size_t>(frames) * channels)
+        , accumulator_(buffer_.size())
+    {
+        BOOST_ASSERT(frames > 0);
+    }
+
+    // returns the index of the source
+    template<class Source>
+    std::size_t add(const Source& src, float gain=1.0f)
+    {
+        input_state in;
+        typedef typename detail::select_mixer_input<CharT,Source>::type
+            input_impl_type;
+
+        in.ptr.reset(new input_impl_type(src));
+        in.gain = gain;
+        in.target = gain;
+        in.step = 0.0f;
+        in.ramp_frames = 0;
+        in.eof = false;
+        inputs_.push_back(in);
+        return inputs_.size() - 1;
+    }
+
+    std::size_t size() const
+    {
+        return inputs_.size();
+    }
+
+    float gain(std::size_t index) const
+    {
+        return inputs_[index].gain;
+    }
+
+    void gain(std::size_t index, float value)
+    {
+        ramp(index, value, 0);
+    }
+
+    // changes the gain to "target" through "frames" frames
+    void ramp(std::size_t index, float target, std::streamsize frames)
+    {
+        input_state& in = inputs_[index];
+        in.target = target;
+        if (frames > 0)
+        {
+            in.step = (target - in.gain) / static_cast<float>(frames);
+            in.ramp_frames = frames;
+        }
+        else
+        {
+            in.gain = target;
+            in.step = 0.0f;
+            in.ramp_frames = 0;
+        }
+    }
+
+    void close()
+    {
+        for (std::size_t i = 0; i < inputs_.size(); ++i)
+            inputs_[i].ptr->close();
+    }
+
+    std::streamsize optimal_buffer_size() const
+    {
+        return static_cast<std::streamsize>(buffer_.size());
+    }
+
+    unsigned channels() const
+    {
+        return channels_;
+    }
+
+private:
+    unsigned channels_;
+    std::vector<input_state> inputs_;
+    std::vector<CharT> buffer_;
+    std::vector<accumulator_type> accumulator_;
+
+    std::streamsize read_blocks(char_type* s, std::streamsize n)
+    {
+        const std::streamsize buffer_frames =
+            static_cast<std::streamsize>(buffer_.size() / channels_);
+
+        std::streamsize total = 0;
+        while (total < n)
+        {
+            std::streamsize frames = (std::min)(n - total, buffer_frames);
+            std::streamsize mixed = mix(frames);
+            if (mixed == 0)
+            {
+                // a planar source may return no frames before its end,
+                // so -1 is returned only after the end of all sources
+                if ((total == 0) && !all_eof())
+                    continue;
+                break;
+            }
+
+            detail::store_mixed(
+                s + total*channels_, &accumulator_[0],
+                static_cast<std::size_t>(mixed)*channels_);
+            total += mixed;
+
+            if (mixed != frames)
+                break;
+        }
+        return (total != 0) ? total*channels_ : -1;
+    }
+
+    bool all_eof() const
+    {
+        for (std::size_t i = 0; i < inputs_.size(); ++i)
+        {
+            if (!inputs_[i].eof)
+                return false;
+        }
+        return true;
+    }
+
+    // returns the number of the frames mixed into accumulator_
+    std::streamsize mix(std::streamsize frames)
+    {
+        std::fill_n(
+            accumulator_.begin(), frames * channels_, accumulator_type());
+
+        std::streamsize max_frames = 0;
+        for (std::size_t i = 0; i < inputs_.size(); ++i)
+        {
+            input_state& in = inputs_[i];
+            if (in.eof)
+                continue;
+
+            std::streamsize count = in.ptr->planar()
+                ? mix_planar(in, frames)
+                : mix_interleaved(in, frames);
+            max_frames = (std::max)(max_frames, count);
+        }
+        return max_frames;
+    }
+
+    std::streamsize mix_interleaved(input_state& in, std::streamsize frames)
+    {
+        const std::streamsize samples = frames * channels_;
+        std::streamsize amt = in.ptr->read(&buffer_[0], samples);
+        if (amt < samples)
+            in.eof = true;
+        if (amt <= 0)
+            return 0;
+
+        // an incomplete frame is dropped
+        std::streamsize count = amt / channels_;
+        add_input(in, static_cast<std::size_t>(count));
+        return count;
+    }
+
+    // the channel buffers are accumulated without the copy to buffer_
+    std::streamsize mix_planar(input_state& in, std::streamsize frames)
+    {
+        std::streamsize total = 0;
+        while (total < frames)
+        {
+            const CharT* const* planes;
+            std::streamsize amt = in.ptr->read_planar(planes, frames - total);
+            if (amt == -1)
+            {
+                in.eof = true;
+                break;
+            }
+            else if (amt == 0)
+                break;
+
+            add_planar(in,
+                static_cast<std::size_t>(total), planes,
+                static_cast<std::size_t>(amt));
+            total += amt;
+        }
+        return total;
+    }
+
+    // returns the frames to be ramped
+    static std::size_t ramp_frames(const input_state& in, std::size_t frames)
+    {
+        return (std::min)(static_cast<std::size_t>(in.ramp_frames), frames);
+    }
+
+    static void end_ramp(input_state& in, std::size_t done)
+    {
+        in.ramp_frames -= static_cast<std::streamsize>(done);
+        if (in.ramp_frames == 0)
+        {
+            // avoids the accumulated error
+            in.gain = in.target;
+            in.step = 0.0f;
+        }
+    }
+
+    void add_input(input_state& in, std::size_t frames)
+    {
+        std::size_t done = ramp_frames(in, frames);
+        if (done != 0)
+        {
+            in.gain = detail::accumulate_ramp(
+                &accumulator_[0], &buffer_[0], done, channels_,
+                in.gain, in.step);
+            end_ramp(in, done);
+        }
+
+        if ((done != frames) && (in.gain != 0.0f))
+        {
+            const std::size_t offset = done * channels_;
+            detail::accumulate(
+                &accumulator_[offset], &buffer_[offset],
+                (frames - done) * channels_, in.gain);
+        }
+    }
+
+    void add_planar(
+        input_state& in, std::size_t pos,
+        const CharT* const* planes, std::size_t frames)
+    {
+        accumulator_type* acc = &accumulator_[pos * channels_];
+
+        std::size_t done = ramp_frames(in, frames);
+        if (done != 0)
+        {
+            in.gain = detail::accumulate_planar_ramp(
+                acc, planes, 0, done, channels_, in.gain, in.step);
+            end_ramp(in, done);
+        }
+
+        if ((done != frames) && (in.gain != 0.0f))
+        {
+            detail::accumulate_planar(
+                acc + done * channels_, planes, done,
+                frames - done, channels_, in.gain);
+        }
+    }
+};
+
+typedef basic_mixer<> mixer;
+
+} } // End namespaces audio, hamigaki.
+
+HAMIGAKI_IOSTREAMS_CATABLE(hamigaki::audio::basic_mixer, 1)
+
+#endif // HAMIGAKI_AUDIO_MIXER_HPP
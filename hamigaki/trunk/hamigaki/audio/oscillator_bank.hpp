@@ -0,0 +1,194 @@
+// oscillator_bank.hpp: bank of the oscillators
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+#ifndef HAMIGAKI_AUDIO_OSCILLATOR_BANK_HPP
+#define HAMIGAKI_AUDIO_OSCILLATOR_BANK_HPP
+
+#include <hamigaki/audio/detail/oscillator.hpp>
+#include <hamigaki/iostreams/catable.hpp>
+#include <boost/iostreams/categories.hpp>
+#include <boost/iostreams/detail/ios.hpp>
+#include <boost/cstdint.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace hamigaki { namespace audio {
+
+struct waveform
+{
+    enum values
+    {
+        sine, square, sawtooth, triangle
+    };
+};
+
+// Renders the sum of the voices (monaural).
+// Each voice has the envelopes of the frequency and the amplitude,
+// which are the linear segments ending at the exact samples.
+template<class CharT=float>
+class basic_oscillator_bank
+{
+private:
+    typedef detail::linear_envelope<CharT> envelope_type;
+
+    typedef boost::uint32_t (*kernel_type)(
+        CharT*, std::size_t,
+        boost::uint32_t, boost::uint32_t, boost::int32_t, CharT, CharT);
+
+    struct voice
+    {
+        kernel_type kernel;
+        boost::uint32_t phase;
+        envelope_type frequency;
+        envelope_type amplitude;
+    };
+
+public:
+    typedef CharT char_type;
+
+    struct category
+        : public boost::iostreams::input
+        , public boost::iostreams::device_tag
+    {};
+
+    explicit basic_oscillator_bank(long rate)
+        : rate_(rate), scale_(detail::phase_increment_scale(rate))
+    {
+    }
+
+    long rate() const
+    {
+        return rate_;
+    }
+
+    std::size_t size() const
+    {
+        return voices_.size();
+    }
+
+    // returns the index of the voice
+    std::size_t add(waveform::values type, CharT freq, CharT amp=1)
+    {
+        voice v;
+        v.kernel = select_kernel(type);
+        v.phase = 0;
+        v.frequency.reset(freq);
+        v.amplitude.reset(amp);
+        voices_.push_back(v);
+        return voices_.size() - 1;
+    }
+
+    void clear()
+    {
+        voices_.clear();
+    }
+
+    // the current values
+    CharT frequency(std::size_t index) const
+    {
+        return voices_[index].frequency.value();
+    }
+
+    CharT amplitude(std::size_t index) const
+    {
+        return voices_[index].amplitude.value();
+    }
+
+    // appends the segment reaching "freq" after "frames" samples
+    // (jumps if "frames" is zero)
+    void frequency(std::size_t index, CharT freq, std::size_t frames=0)
+    {
+        voices_[index].frequency.append(freq, frames);
+    }
+
+    void amplitude(std::size_t index, CharT amp, std::size_t frames=0)
+    {
+        voices_[index].amplitude.append(amp, frames);
+    }
+
+    // discards the pending segments
+    void reset_envelopes(std::size_t index)
+    {
+        voice& v = voices_[index];
+        v.frequency.reset(v.frequency.value());
+        v.amplitude.reset(v.amplitude.value());
+    }
+
+    std::streamsize read(CharT* s, std::streamsize n)
+    {
+        if (n <= 0)
+            return -1;
+
+        std::fill_n(s, n, CharT());
+        for (std::size_t i = 0; i < voices_.size(); ++i)
+            render(voices_[i], s, static_cast<std::size_t>(n));
+        return n;
+    }
+
+private:
+    long rate_;
+    double scale_;
+    std::vector<voice> voices_;
+
+    static kernel_type select_kernel(waveform::values type)
+    {
+        switch (type)
+        {
+            case waveform::sine:
+                return &detail::oscillate<detail::sine_shape,CharT>;
+            case waveform::square:
+                return &detail::oscillate<detail::square_shape,CharT>;
+            case waveform::sawtooth:
+                return &detail::oscillate<detail::sawtooth_shape,CharT>;
+            case waveform::triangle:
+                return &detail::oscillate<detail::triangle_shape,CharT>;
+            default:
+                throw BOOST_IOSTREAMS_FAILURE("unsupported waveform");
+        }
+    }
+
+    // the segments are split at the breakpoints of both envelopes
+    void render(voice& v, CharT* s, std::size_t n)
+    {
+        while (n != 0)
+        {
+            std::size_t count = v.amplitude.span(v.frequency.span(n));
+
+            boost::uint32_t inc =
+                detail::phase_increment(rate_, v.frequency.value());
+            boost::int32_t inc_step = static_cast<boost::int32_t>(
+                static_cast<double>(v.frequency.step()) * scale_);
+
+            CharT amp = v.amplitude.value();
+            CharT amp_step = v.amplitude.step();
+
+            // the silent voice only advances the phase
+            if ((amp == CharT()) && (amp_step == CharT()))
+                v.phase = detail::skip_phase(count, v.phase, inc, inc_step);
+            else
+            {
+                v.phase = (*v.kernel)(
+                    s, count, v.phase, inc, inc_step, amp, amp_step);
+            }
+
+            v.frequency.advance(count);
+            v.amplitude.advance(count);
+            s += count;
+            n -= count;
+        }
+    }
+};
+
+typedef basic_oscillator_bank<> oscillator_bank;
+
+} } // End namespaces audio, hamigaki.
+
+HAMIGAKI_IOSTREAMS_CATABLE(hamigaki::audio::basic_oscillator_bank, 1)
+
+#endif // HAMIGAKI_AUDIO_OSCILLATOR_BANK_HPP
@@ -0,0 +1,546 @@
+// parallel_vorbis_encoder.hpp: vorbisenc on the worker threads
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+#ifndef HAMIGAKI_AUDIO_PARALLEL_VORBIS_ENCODER_HPP
+#define HAMIGAKI_AUDIO_PARALLEL_VORBIS_ENCODER_HPP
+
+#include <boost/config.hpp>
+
+#ifdef BOOST_MSVC
+    #pragma warning(push)
+    #pragma warning(disable : 4251)
+#endif
+
+#include <boost/thread/condition.hpp>
+#include <boost/thread/thread.hpp>
+
+#ifdef BOOST_MSVC
+    #pragma warning(pop)
+#endif
+
+#include <hamigaki/audio/vorbis_encoder.hpp>
+#include <hamigaki/iostreams/blocking.hpp>
+#include <hamigaki/thread/exception_storage.hpp>
+#include <boost/iostreams/categories.hpp>
+#include <boost/iostreams/close.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/detail/ios.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace hamigaki { namespace audio {
+
+namespace detail
+{
+
+class vorbis_job : private boost::noncopyable
+{
+public:
+    vorbis_job() : done_(false)
+    {
+    }
+
+    virtual ~vorbis_job() {}
+
+    void run()
+    {
+        try
+        {
+            do_run();
+        }
+        catch (...)
+        {
+            error_.store();
+        }
+    }
+
+    void rethrow() const
+    {
+        error_.rethrow();
+    }
+
+private:
+    friend class vorbis_job_pool;
+
+    bool done_; // guarded by the mutex of vorbis_job_pool
+    hamigaki::thread::exception_storage error_;
+
+    virtual void do_run() = 0;
+};
+
+// runs the jobs in FIFO order
+class vorbis_job_pool : private boost::noncopyable
+{
+public:
+    typedef boost::shared_ptr<vorbis_job> job_ptr;
+
+    explicit vorbis_job_pool(std::size_t thread_count)
+        : thread_count_(thread_count != 0 ? thread_count : 1), stop_(false)
+    {
+        for (std::size_t i = 0; i < thread_count_; ++i)
+        {
+            threads_.create_thread(
+                boost::bind(&vorbis_job_pool::run, this));
+        }
+    }
+
+    // the queued jobs are finished before the threads exit
+    ~vorbis_job_pool()
+    {
+        {
+            boost::mutex::scoped_lock locking(mutex_);
+            stop_ = true;
+            cond_.notify_all();
+        }
+        threads_.join_all();
+    }
+
+    std::size_t thread_count() const
+    {
+        return thread_count_;
+    }
+
+    void push(const job_ptr& job)
+    {
+        boost::mutex::scoped_lock locking(mutex_);
+        queue_.push_back(job);
+        cond_.notify_all();
+    }
+
+    void wait(const job_ptr& job)
+    {
+        boost::mutex::scoped_lock locking(mutex_);
+        while (!job->done_)
+            cond_.wait(locking);
+    }
+
+    // waits until any of "jobs" is finished,
+    // and moves the finished jobs to "done" in the order of "jobs"
+    void wait_any(std::deque<job_ptr>& jobs, std::vector<job_ptr>& done)
+    {
+        boost::mutex::scoped_lock locking(mutex_);
+        while (true)
+        {
+            std::deque<job_ptr> rest;
+            for (std::size_t i = 0; i < jobs.size(); ++i)
+            {
+                if (jobs[i]->done_)
+                    done.push_back(jobs[i]);
+                else
+                    rest.push_back(jobs[i]);
+            }
+
+            if (!done.empty() || jobs.empty())
+            {
+                jobs.swap(rest);
+                return;
+            }
+            cond_.wait(locking);
+        }
+    }
+
+private:
+    std::size_t thread_count_;
+    boost::mutex mutex_;
+    boost::condition cond_;
+    std::deque<job_ptr> queue_;
+    bool stop_;
+    boost::thread_group threads_;
+
+    void run()
+    {
+        while (true)
+        {
+            job_ptr job;
+            {
+                boost::mutex::scoped_lock locking(mutex_);
+                while (!stop_ && queue_.empty())
+                    cond_.wait(locking);
+                if (queue_.empty())
+                    return;
+                job = queue_.front();
+                queue_.pop_front();
+            }
+
+            job->run();
+
+            boost::mutex::scoped_lock locking(mutex_);
+            job->done_ = true;
+            cond_.notify_all();
+        }
+    }
+};
+
+// basic_vorbis_file_sink requires close()
+class string_sink
+{
+public:
+    typedef char char_type;
+
+    struct category
+        : boost::iostreams::sink_tag
+        , boost::iostreams::closable_tag
+    {};
+
+    explicit string_sink(std::string& str) : str_ptr_(&str)
+    {
+    }
+
+    std::streamsize write(const char* s, std::streamsize n)
+    {
+        str_ptr_->append(s, static_cast<std::size_t>(n));
+        return n;
+    }
+
+    void close()
+    {
+    }
+
+private:
+    std::string* str_ptr_;
+};
+
+// encodes a chunk into an independent logical stream in memory
+class vorbis_chunk_job : public vorbis_job
+{
+public:
+    vorbis_chunk_job(long channels, long rate, float quality, int serialno)
+        : channels_(channels), rate_(rate), quality_(quality)
+        , serialno_(serialno)
+    {
+    }
+
+    std::vector<float>& input()
+    {
+        return input_;
+    }
+
+    const std::string& output() const
+    {
+        return output_;
+    }
+
+private:
+    long channels_;
+    long rate_;
+    float quality_;
+    int serialno_;
+    std::vector<float> input_;
+    std::string output_;
+
+    void do_run() // virtual
+    {
+        basic_vorbis_file_sink<string_sink> vorbis(
+            string_sink(output_), channels_, rate_, quality_, serialno_);
+
+        // limits the analysis buffer of libvorbis
+        const std::size_t block_size =
+            static_cast<std::size_t>(channels_) * 4096;
+        for (std::size_t pos = 0; pos < input_.size(); pos += block_size)
+        {
+            std::size_t n = (std::min)(input_.size() - pos, block_size);
+            vorbis.write(&input_[pos], static_cast<std::streamsize>(n));
+        }
+        vorbis.close();
+
+        std::vector<float>().swap(input_);
+    }
+};
+
+template<class Source, class Sink>
+class vorbis_copy_job : public vorbis_job
+{
+public:
+    vorbis_copy_job(
+            const Source& src, const Sink& sink,
+            long channels, long rate, float quality)
+        : src_(src), sink_(sink)
+        , channels_(channels), rate_(rate), quality_(quality)
+    {
+    }
+
+private:
+    Source src_;
+    Sink sink_;
+    long channels_;
+    long rate_;
+    float quality_;
+
+    void do_run() // virtual
+    {
+        boost::iostreams::copy(
+            src_,
+            basic_vorbis_file_sink<Sink>(sink_, channels_, rate_, quality_)
+        );
+    }
+};
+
+template<class Sink>
+class parallel_vorbis_file_sink_impl : private boost::noncopyable
+{
+private:
+    typedef vorbis_job_pool::job_ptr job_ptr;
+    typedef boost::shared_ptr<vorbis_chunk_job> chunk_ptr;
+
+public:
+    parallel_vorbis_file_sink_impl(
+            const Sink& sink, long channels, long rate, float quality,
+            std::size_t thread_count, std::size_t chunk_frames)
+        : sink_(sink), channels_(channels), rate_(rate), quality_(quality)
+        , chunk_size_(chunk_frames * static_cast<std::size_t>(channels))
+        , serialno_(static_cast<boost::uint32_t>(random_serial_no()))
+        , chunks_(0), pool_(thread_count)
+    {
+        // the empty chunks would never fill
+        if ((channels <= 0) || (chunk_frames == 0))
+            throw BOOST_IOSTREAMS_FAILURE("invalid vorbis chunk size");
+
+        new_chunk();
+    }
+
+    long channels() const
+    {
+        return channels_;
+    }
+
+    long rate() const
+    {
+        return rate_;
+    }
+
+    std::streamsize write(const float* s, std::streamsize n)
+    {
+        std::streamsize total = 0;
+        while (total < n)
+        {
+            std::vector<float>& buf = current_->input();
+            std::size_t amt = (std::min)(
+                static_cast<std::size_t>(n - total),
+                chunk_size_ - buf.size());
+            buf.insert(buf.end(), s + total, s + total + amt);
+            total += static_cast<std::streamsize>(amt);
+
+            if (buf.size() == chunk_size_)
+            {
+                submit();
+                new_chunk();
+            }
+        }
+        return total;
+    }
+
+    void close()
+    {
+        // an empty input is also a valid stream
+        if (!current_->input().empty() || (chunks_ == 0))
+            submit();
+        current_.reset();
+
+        while (!pending_.empty())
+            write_front();
+
+        boost::iostreams::close(sink_, BOOST_IOS::out);
+    }
+
+private:
+    Sink sink_;
+    long channels_;
+    long rate_;
+    float quality_;
+    std::size_t chunk_size_;
+    boost::uint32_t serialno_;
+    std::size_t chunks_;
+    chunk_ptr current_;
+    std::deque<chunk_ptr> pending_;
+    vorbis_job_pool pool_;
+
+    void new_chunk()
+    {
+        // the serial numbers in a chain must differ from each other
+        // (the unsigned arithmetic wraps around like the 32bit field)
+        const boost::uint32_t serialno =
+            serialno_ + static_cast<boost::uint32_t>(chunks_);
+        current_.reset(new vorbis_chunk_job(
+            channels_, rate_, quality_, static_cast<int>(serialno)));
+        current_->input().reserve(chunk_size_);
+    }
+
+    void submit()
+    {
+        // limit the number of the chunks in memory
+        while (pending_.size() >= pool_.thread_count()*2)
+            write_front();
+
+        pending_.push_back(current_);
+        pool_.push(current_);
+        ++chunks_;
+    }
+
+    void write_front()
+    {
+        chunk_ptr chunk = pending_.front();
+        pool_.wait(chunk);
+        pending_.pop_front();
+        chunk->rethrow();
+
+        iostreams::blocking_write(sink_, chunk->output());
+    }
+};
+
+} // namespace detail
+
+// Splits the input into the chunks and encodes them on the worker threads.
+// Each chunk is an independent logical stream, and the output is
+// a chained Ogg Vorbis stream of the same channels and rate.
+// The boundaries of the chunks are not overlapped,
+// so that the long chunks (30 seconds by default) are recommended.
+template<typename Sink>
+class basic_parallel_vorbis_file_sink
+{
+private:
+    typedef detail::parallel_vorbis_file_sink_impl<Sink> impl_type;
+
+public:
+    typedef float char_type;
+
+    struct category
+        : boost::iostreams::optimally_buffered_tag
+        , boost::iostreams::output
+        , boost::iostreams::device_tag
+        , boost::iostreams::closable_tag
+    {};
+
+    basic_parallel_vorbis_file_sink(
+            const Sink& sink, long channels, long rate,
+            float quality, std::size_t thread_count,
+            std::size_t chunk_seconds=30)
+        : pimpl_(new impl_type(
+            sink, channels, rate, quality, thread_count,
+            chunk_seconds * static_cast<std::size_t>(rate)))
+    {
+    }
+
+    std::streamsize optimal_buffer_size() const
+    {
+        return pimpl_->channels() * (pimpl_->rate() / 5);
+    }
+
+    long channels() const
+    {
+        return pimpl_->channels();
+    }
+
+    long rate() const
+    {
+        return pimpl_->rate();
+    }
+
+    std::streamsize write(const char_type* s, std::streamsize n)
+    {
+        return pimpl_->write(s, n);
+    }
+
+    void close()
+    {
+        pimpl_->close();
+    }
+
+private:
+    boost::shared_ptr<impl_type> pimpl_;
+};
+
+template<typename Sink>
+inline basic_parallel_vorbis_file_sink<Sink>
+make_parallel_vorbis_file_sink(
+    const Sink& sink, long channels, long rate,
+    float quality, std::size_t thread_count, std::size_t chunk_seconds=30)
+{
+    return basic_parallel_vorbis_file_sink<Sink>(
+        sink, channels, rate, quality, thread_count, chunk_seconds);
+}
+
+// Encodes many streams concurrently.
+// Each job copies a float Source to an Ogg Vorbis Sink.
+// add() blocks while 2 * thread_count jobs are not finished,
+// so that the number of the devices in memory is bounded.
+// A slow job does not block add() while the other jobs are finished,
+// and add() rethrows the first error of the finished jobs.
+class vorbis_batch_encoder : private boost::noncopyable
+{
+private:
+    typedef detail::vorbis_job_pool::job_ptr job_ptr;
+
+public:
+    explicit vorbis_batch_encoder(std::size_t thread_count)
+        : pool_(thread_count)
+    {
+    }
+
+    ~vorbis_batch_encoder()
+    {
+        try
+        {
+            wait();
+        }
+        catch (...)
+        {
+        }
+    }
+
+    template<class Source, class Sink>
+    void add(const Source& src, const Sink& sink,
+        long channels, long rate, float quality=0.1f)
+    {
+        while (pending_.size() >= pool_.thread_count()*2)
+            pop_finished();
+
+        job_ptr job(new detail::vorbis_copy_job<Source,Sink>(
+            src, sink, channels, rate, quality));
+        pending_.push_back(job);
+        pool_.push(job);
+    }
+
+    // waits for all jobs and rethrows the first error
+    void wait()
+    {
+        while (!pending_.empty())
+            pop_front();
+    }
+
+private:
+    std::deque<job_ptr> pending_;
+    detail::vorbis_job_pool pool_;
+
+    void pop_front()
+    {
+        job_ptr job = pending_.front();
+        pool_.wait(job);
+        pending_.pop_front();
+        job->rethrow();
+    }
+
+    void pop_finished()
+    {
+        std::vector<job_ptr> done;
+        pool_.wait_any(pending_, done);
+        for (std::size_t i = 0; i < done.size(); ++i)
+            done[i]->rethrow();
+    }
+};
+
+} } // End namespaces audio, hamigaki.
+
+#endif // HAMIGAKI_AUDIO_PARALLEL_VORBIS_ENCODER_HPP
@@ -0,0 +1,109 @@
+// planar.hpp: sources of the separated channel buffers
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+#ifndef HAMIGAKI_AUDIO_PLANAR_HPP
+#define HAMIGAKI_AUDIO_PLANAR_HPP
+
+#include <hamigaki/audio/detail/mix.hpp>
+#include <hamigaki/iostreams/catable.hpp>
+#include <boost/iostreams/categories.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace hamigaki { namespace audio {
+
+// A planar source has the member function
+//
+//   std::streamsize read_planar(
+//       const char_type* const*& planes, std::streamsize frames);
+//
+// which returns at most "frames" frames as the pointers to the channel
+// buffers owned by the source, or -1 at the end of the stream.
+// The buffers are valid until the next call.
+// The consumers (mixer, resampler) read them without interleaving.
+template<class Source>
+struct is_planar_source : boost::false_type {};
+
+// The source of the channel buffers owned by the caller.
+// "block_frames" limits the frames returned by read_planar().
+template<class CharT>
+class basic_planar_array_source
+{
+public:
+    typedef CharT char_type;
+
+    struct category
+        : public boost::iostreams::input
+        , public boost::iostreams::device_tag
+    {};
+
+    basic_planar_array_source(
+            const CharT* const* planes, unsigned channels,
+            std::streamsize frames, std::streamsize block_frames=0)
+        : planes_(planes, planes+channels), work_(channels)
+        , frames_(frames), pos_(0)
+        , block_frames_(block_frames != 0 ? block_frames : frames)
+    {
+    }
+
+    unsigned channels() const
+    {
+        return static_cast<unsigned>(planes_.size());
+    }
+
+    // an incomplete frame is not read
+    std::streamsize read(CharT* s, std::streamsize n)
+    {
+        const CharT* const* planes;
+        std::streamsize count = read_planar(planes, n / channels());
+        if (count == -1)
+            return -1;
+
+        detail::interleave(
+            s, planes, static_cast<std::size_t>(count), channels());
+        return count * channels();
+    }
+
+    std::streamsize read_planar(
+        const CharT* const*& planes, std::streamsize frames)
+    {
+        if (pos_ >= frames_)
+            return -1;
+
+        std::streamsize count =
+            (std::min)((std::min)(frames, frames_ - pos_), block_frames_);
+
+        for (std::size_t i = 0; i < planes_.size(); ++i)
+            work_[i] = planes_[i] + pos_;
+        planes = &work_[0];
+
+        pos_ += count;
+        return count;
+    }
+
+private:
+    std::vector<const CharT*> planes_;
+    std::vector<const CharT*> work_;
+    std::streamsize frames_;
+    std::streamsize pos_;
+    std::streamsize block_frames_;
+};
+
+template<class CharT>
+struct is_planar_source<basic_planar_array_source<CharT> >
+    : boost::true_type {};
+
+typedef basic_planar_array_source<float> planar_array_source;
+
+} } // End namespaces audio, hamigaki.
+
+HAMIGAKI_IOSTREAMS_CATABLE(hamigaki::audio::basic_planar_array_source, 1)
+
+#endif // HAMIGAKI_AUDIO_PLANAR_HPP
@@ -12,6 +12,7 @@
 
 #include <hamigaki/audio/detail/config.hpp>
 #include <hamigaki/audio/detail/auto_link/hamigaki_audio.hpp>
+#include <hamigaki/audio/device_delay.hpp>
 #include <hamigaki/audio/pcm_format.hpp>
 #include <boost/iostreams/categories.hpp>
 #include <boost/shared_ptr.hpp>
@@ -37,6 +38,7 @@ public:
         , boost::iostreams::closable_tag
         , boost::iostreams::optimally_buffered_tag
         , pcm_format_tag
+        , delay_tag
     {};
 
     pulse_audio_sink(const char* app, const char* name, const pcm_format& fmt);
@@ -44,6 +46,9 @@ public:
     pcm_format format() const;
     void close();
 
+    // the bytes written but not played yet
+    std::streamsize delay() const;
+
     std::streamsize optimal_buffer_size() const
     {
         return this->format().optimal_buffer_size();
@@ -0,0 +1,279 @@
+// resample.hpp: sample rate converters
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+#ifndef HAMIGAKI_AUDIO_RESAMPLE_HPP
+#define HAMIGAKI_AUDIO_RESAMPLE_HPP
+
+#include <hamigaki/audio/detail/polyphase.hpp>
+#include <hamigaki/audio/device_delay.hpp>
+#include <hamigaki/audio/planar.hpp>
+#include <hamigaki/iostreams/arbitrary_positional_facade.hpp>
+#include <hamigaki/iostreams/catable.hpp>
+#include <boost/iostreams/categories.hpp>
+#include <boost/iostreams/close.hpp>
+#include <boost/iostreams/constants.hpp>
+#include <boost/iostreams/detail/adapter/direct_adapter.hpp>
+#include <boost/iostreams/detail/select.hpp>
+#include <boost/iostreams/read.hpp>
+#include <boost/iostreams/traits.hpp>
+#include <boost/iostreams/write.hpp>
+#include <boost/assert.hpp>
+#include <boost/cstdint.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace hamigaki { namespace audio {
+
+// Converts the sample rate of the interleaved frames of "Source"
+// from "in_rate" to "out_rate" (any ratio of the integers).
+// The channel buffers of a planar source are read directly.
+template<class Source>
+class resampler
+    : public hamigaki::iostreams::
+        arbitrary_positional_facade<
+            resampler<Source>,
+            typename boost::iostreams::char_type_of<Source>::type,
+            255
+        >
+{
+    friend class hamigaki::iostreams::core_access;
+
+private:
+    typedef typename
+        boost::iostreams::select<
+            boost::iostreams::is_direct<Source>,
+                boost::iostreams::detail::direct_adapter<Source>,
+            boost::iostreams::else_,
+                Source
+        >::type value_type;
+
+public:
+    typedef typename boost::iostreams::
+        char_type_of<Source>::type char_type;
+
+    struct category
+        : public boost::iostreams::input
+        , public boost::iostreams::device_tag
+        , public boost::iostreams::closable_tag
+    {};
+
+    resampler(
+            const Source& src, unsigned channels, long in_rate, long out_rate,
+            resample_quality::values q = resample_quality::medium,
+            std::streamsize buffer_size =
+                boost::iostreams::default_device_buffer_size)
+        : resampler<Source>::arbitrary_positional_facade_(channels)
+        , src_(src), impl_(channels, in_rate, out_rate, q)
+        , buffer_(static_cast<std::size_t>(buffer_size) * channels)
+        , count_(0), eof_(false)
+    {
+    }
+
+    void close()
+    {
+        boost::iostreams::close(src_, BOOST_IOS::in);
+    }
+
+    unsigned channels() const
+    {
+        return impl_.channels();
+    }
+
+private:
+    value_type src_;
+    detail::polyphase_resampler<char_type> impl_;
+    std::vector<char_type> buffer_;
+    std::size_t count_; // the samples of an incomplete frame
+    bool eof_;
+
+    std::streamsize read_blocks(char_type* s, std::streamsize n)
+    {
+        const unsigned channels = impl_.channels();
+        const std::size_t frames = static_cast<std::size_t>(n);
+
+        std::size_t total = 0;
+        while (total < frames)
+        {
+            total += impl_.pull(s + total*channels, frames - total);
+            if ((total == frames) || impl_.done())
+                break;
+
+            if (eof_)
+            {
+                impl_.finish();
+                continue;
+            }
+
+            std::streamsize amt = fill(is_planar_source<Source>());
+            if (amt == -1)
+            {
+                eof_ = true;
+                continue;
+            }
+            else if (amt == 0)
+                break;
+        }
+
+        if ((total == 0) && eof_)
+            return -1;
+        return static_cast<std::streamsize>(total * channels);
+    }
+
+    // pushes the samples of "src_" to "impl_"
+    std::streamsize fill(boost::false_type)
+    {
+        const unsigned channels = impl_.channels();
+
+        std::streamsize amt = boost::iostreams::read(
+            src_, &buffer_[count_],
+            static_cast<std::streamsize>(buffer_.size() - count_));
+        if (amt <= 0)
+            return amt;
+
+        count_ += static_cast<std::size_t>(amt);
+        std::size_t in_frames = count_ / channels;
+        impl_.push(&buffer_[0], in_frames);
+
+        std::size_t used = in_frames * channels;
+        std::copy(buffer_.begin()+used, buffer_.begin()+count_,
+            buffer_.begin());
+        count_ -= used;
+
+        return amt;
+    }
+
+    // the channel buffers are interleaved into the history directly
+    std::streamsize fill(boost::true_type)
+    {
+        const char_type* const* planes;
+        std::streamsize frames = src_.read_planar(planes,
+            static_cast<std::streamsize>(buffer_.size() / impl_.channels()));
+        if (frames > 0)
+            impl_.push_planar(planes, static_cast<std::size_t>(frames));
+        return frames;
+    }
+};
+
+template<class Source>
+inline resampler<Source> resample(
+    const Source& src, unsigned channels, long in_rate, long out_rate,
+    resample_quality::values q = resample_quality::medium)
+{
+    return resampler<Source>(src, channels, in_rate, out_rate, q);
+}
+
+// Converts the sample rate of the frames written to "Sink".
+// The rest of the frames are written when closed.
+template<class Sink>
+class resampler_sink
+    : public hamigaki::iostreams::
+        arbitrary_positional_facade<
+            resampler_sink<Sink>,
+            typename boost::iostreams::char_type_of<Sink>::type,
+            255
+        >
+{
+    friend class hamigaki::iostreams::core_access;
+
+public:
+    typedef typename boost::iostreams::
+        char_type_of<Sink>::type char_type;
+
+    struct category
+        : public boost::iostreams::output
+        , public boost::iostreams::device_tag
+        , public boost::iostreams::closable_tag
+        , public delay_tag
+    {};
+
+    resampler_sink(
+            const Sink& sink, unsigned channels, long in_rate, long out_rate,
+            resample_quality::values q = resample_quality::medium,
+            std::streamsize buffer_size =
+                boost::iostreams::default_device_buffer_size)
+        : resampler_sink<Sink>::arbitrary_positional_facade_(channels)
+        , sink_(sink), impl_(channels, in_rate, out_rate, q)
+        , in_rate_(in_rate), out_rate_(out_rate)
+        , buffer_(static_cast<std::size_t>(buffer_size) * channels)
+    {
+    }
+
+    // an incomplete frame is discarded
+    void close()
+    {
+        impl_.finish();
+        flush_frames();
+        boost::iostreams::close(sink_, BOOST_IOS::out);
+    }
+
+    unsigned channels() const
+    {
+        return impl_.channels();
+    }
+
+    // the delay of "Sink" in the samples of the input rate
+    std::streamsize delay() const
+    {
+        const std::streamsize channels =
+            static_cast<std::streamsize>(impl_.channels());
+        const std::streamsize out_frames =
+            audio::device_delay(sink_) / channels;
+        boost::uint64_t frames = static_cast<boost::uint64_t>(out_frames);
+        frames = frames * static_cast<boost::uint64_t>(in_rate_)
+            / static_cast<boost::uint64_t>(out_rate_);
+        return static_cast<std::streamsize>(frames) * channels;
+    }
+
+private:
+    Sink sink_;
+    detail::polyphase_resampler<char_type> impl_;
+    long in_rate_;
+    long out_rate_;
+    std::vector<char_type> buffer_;
+
+    std::streamsize write_blocks(const char_type* s, std::streamsize n)
+    {
+        impl_.push(s, static_cast<std::size_t>(n));
+        flush_frames();
+        return n * static_cast<std::streamsize>(impl_.channels());
+    }
+
+    void flush_frames()
+    {
+        const unsigned channels = impl_.channels();
+        const std::size_t frames = buffer_.size() / channels;
+
+        while (std::size_t count = impl_.pull(&buffer_[0], frames))
+        {
+            const char_type* p = &buffer_[0];
+            std::streamsize rest = static_cast<std::streamsize>(count*channels);
+            while (rest > 0)
+            {
+                std::streamsize amt = boost::iostreams::write(sink_, p, rest);
+                p += amt;
+                rest -= amt;
+            }
+        }
+    }
+};
+
+template<class Sink>
+inline resampler_sink<Sink> make_resampler_sink(
+    const Sink& sink, unsigned channels, long in_rate, long out_rate,
+    resample_quality::values q = resample_quality::medium)
+{
+    return resampler_sink<Sink>(sink, channels, in_rate, out_rate, q);
+}
+
+} } // End namespaces audio, hamigaki.
+
+HAMIGAKI_IOSTREAMS_CATABLE(hamigaki::audio::resampler, 1)
+HAMIGAKI_IOSTREAMS_CATABLE(hamigaki::audio::resampler_sink, 1)
+
+#endif // HAMIGAKI_AUDIO_RESAMPLE_HPP
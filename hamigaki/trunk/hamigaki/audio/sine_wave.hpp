@@ -10,36 +10,15 @@
 #ifndef HAMIGAKI_AUDIO_SINE_WAVE_HPP
 #define HAMIGAKI_AUDIO_SINE_WAVE_HPP
 
+#include <hamigaki/audio/detail/oscillator.hpp>
 #include <hamigaki/iostreams/catable.hpp>
 #include <boost/iostreams/categories.hpp>
 #include <boost/iostreams/positioning.hpp>
-#include <cmath>
+#include <boost/cstdint.hpp>
+#include <algorithm>
 
 namespace hamigaki { namespace audio {
 
-namespace detail
-{
-
-template<class T> struct pi;
-
-template<> struct pi<float>
-{
-    static inline float value()
-    {
-        return 3.1415927f;
-    }
-};
-
-template<> struct pi<double>
-{
-    static inline double value()
-    {
-        return 3.14159265358979323846;
-    }
-};
-
-} // namespace detail
-
 template<class CharT=float>
 class basic_sine_wave_source
 {
@@ -52,7 +31,8 @@ public:
     {};
 
     basic_sine_wave_source(long rate, CharT freq)
-        : rate_(rate), freq_(freq), sum_()
+        : rate_(rate), freq_(freq), phase_(0)
+        , inc_(detail::phase_increment(rate, freq))
     {
     }
 
@@ -61,17 +41,9 @@ public:
         if (n <= 0)
             return -1;
 
-        const CharT pi = detail::pi<CharT>::value();
-        const CharT twice_pi = 2*pi;
-        const CharT w = twice_pi * freq_ / static_cast<CharT>(rate_);
-
-        for (std::streamsize i = 0; i < n; ++i)
-        {
-            *(s++) = std::sin(sum_);
-            sum_ += w;
-            if (sum_ >= twice_pi)
-                sum_ -= twice_pi;
-        }
+        std::fill_n(s, n, CharT());
+        phase_ = detail::oscillate<detail::sine_shape>(
+            s, static_cast<std::size_t>(n), phase_, inc_, 0, CharT(1), CharT());
         return n;
     }
 
@@ -88,7 +60,8 @@ public:
 private:
     long rate_;
     CharT freq_;
-    CharT sum_;
+    boost::uint32_t phase_;
+    boost::uint32_t inc_;
 };
 
 typedef basic_sine_wave_source<> sine_wave_source;
@@ -10,10 +10,12 @@
 #ifndef HAMIGAKI_AUDIO_SQUARE_WAVE_HPP
 #define HAMIGAKI_AUDIO_SQUARE_WAVE_HPP
 
+#include <hamigaki/audio/detail/oscillator.hpp>
 #include <hamigaki/iostreams/catable.hpp>
 #include <boost/iostreams/categories.hpp>
 #include <boost/iostreams/positioning.hpp>
-#include <cmath>
+#include <boost/cstdint.hpp>
+#include <algorithm>
 
 namespace hamigaki { namespace audio {
 
@@ -29,7 +31,8 @@ public:
     {};
 
     basic_square_wave_source(long rate, CharT freq)
-        : rate_(rate), freq_(freq), sum_()
+        : rate_(rate), freq_(freq), phase_(0)
+        , inc_(detail::phase_increment(rate, freq))
     {
     }
 
@@ -38,15 +41,9 @@ public:
         if (n <= 0)
             return -1;
 
-        const CharT v = freq_ / static_cast<CharT>(rate_);
-
-        for (std::streamsize i = 0; i < n; ++i)
-        {
-            *(s++) = (sum_ < 0.5f) ? 1.0f : -1.0f;
-            sum_ += v;
-            if (sum_ >= 1.0f)
-                sum_ -= 1.0f;
-        }
+        std::fill_n(s, n, CharT());
+        phase_ = detail::oscillate<detail::square_shape>(
+            s, static_cast<std::size_t>(n), phase_, inc_, 0, CharT(1), CharT());
         return n;
     }
 
@@ -63,7 +60,8 @@ public:
 private:
     long rate_;
     CharT freq_;
-    CharT sum_;
+    boost::uint32_t phase_;
+    boost::uint32_t inc_;
 };
 
 typedef basic_square_wave_source<> square_wave_source;
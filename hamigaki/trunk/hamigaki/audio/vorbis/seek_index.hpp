@@ -0,0 +1,307 @@
+// seek_index.hpp: granule position index of Ogg Vorbis streams
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+#ifndef HAMIGAKI_AUDIO_VORBIS_SEEK_INDEX_HPP
+#define HAMIGAKI_AUDIO_VORBIS_SEEK_INDEX_HPP
+
+#include <hamigaki/binary/endian.hpp>
+#include <hamigaki/iostreams/blocking.hpp>
+#include <boost/iostreams/detail/ios.hpp>
+#include <boost/iostreams/positioning.hpp>
+#include <boost/iostreams/seek.hpp>
+#include <boost/cstdint.hpp>
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <vector>
+
+namespace hamigaki { namespace audio { namespace vorbis {
+
+struct seek_point
+{
+    // the PCM position (in frames) at the end of the page,
+    // which is accumulated over the chained streams
+    boost::int64_t position;
+
+    // the byte offset of the beginning of the page
+    boost::int64_t offset;
+};
+
+namespace detail
+{
+
+struct seek_point_position_less
+{
+    bool operator()(boost::int64_t lhs, const seek_point& rhs) const
+    {
+        return lhs < rhs.position;
+    }
+};
+
+} // namespace detail
+
+// The index of the Ogg pages which have the granule positions.
+// It is built by scanning the page headers only,
+// and can be saved to and loaded from the other files.
+class seek_index
+{
+public:
+    typedef std::vector<seek_point>::const_iterator const_iterator;
+
+    seek_index() : file_size_(0)
+    {
+    }
+
+    bool empty() const
+    {
+        return points_.empty();
+    }
+
+    std::size_t size() const
+    {
+        return points_.size();
+    }
+
+    const_iterator begin() const
+    {
+        return points_.begin();
+    }
+
+    const_iterator end() const
+    {
+        return points_.end();
+    }
+
+    const seek_point& operator[](std::size_t i) const
+    {
+        return points_[i];
+    }
+
+    // the size of the indexed file for detecting the stale index
+    boost::int64_t file_size() const
+    {
+        return file_size_;
+    }
+
+    void clear()
+    {
+        points_.clear();
+        file_size_ = 0;
+    }
+
+    // Returns the offset of the page where the decoding should start
+    // to reach "pos", or -1 if the index cannot help.
+    // The page before the page containing "pos" is returned,
+    // since the first packet after a seek only primes the decoder.
+    boost::int64_t find(boost::int64_t pos) const
+    {
+        const_iterator i = std::upper_bound(
+            points_.begin(), points_.end(), pos,
+            detail::seek_point_position_less());
+
+        if ((i == points_.begin()) || (i == points_.end()))
+            return -1;
+
+        return (i-1)->offset;
+    }
+
+    // scans all pages of the seekable "src" from the beginning
+    // Each link is assumed to start at the granule position zero.
+    template<class Source>
+    void build(Source& src)
+    {
+        this->build(src, std::vector<boost::int64_t>());
+    }
+
+    // "lengths" are the PCM lengths of the links (e.g. ov_pcm_total()).
+    // The granule position where a link starts is the last granule
+    // position of the link minus its length, as libvorbisfile does.
+    template<class Source>
+    void build(Source& src, const std::vector<boost::int64_t>& lengths)
+    {
+        boost::iostreams::seek(src, 0, BOOST_IOS::beg, BOOST_IOS::in);
+
+        std::vector<seek_point> points;
+        boost::int64_t offset = 0;
+        boost::int64_t base = 0;
+        boost::int64_t last = 0;
+        std::size_t link = 0;
+        std::size_t link_head = 0;
+        boost::uint32_t serialno = 0;
+        bool in_headers = false;
+        bool has_link = false;
+
+        char head[27];
+        char lacing[255];
+        while (iostreams::blocking_read(src, head, 27, std::nothrow))
+        {
+            if (std::memcmp(head, "OggS", 4) != 0)
+                throw BOOST_IOSTREAMS_FAILURE("invalid Ogg page");
+
+            unsigned char type = static_cast<unsigned char>(head[5]);
+            boost::int64_t granule = static_cast<boost::int64_t>(
+                hamigaki::decode_uint<little,8>(head+6));
+            boost::uint32_t serial = hamigaki::decode_uint<little,4>(head+14);
+            std::size_t segments = static_cast<unsigned char>(head[26]);
+
+            // a page may have no segments (e.g. an empty EOS page)
+            if ((segments != 0) &&
+                !iostreams::blocking_read(
+                    src, lacing, static_cast<std::streamsize>(segments),
+                    std::nothrow) )
+            {
+                break;
+            }
+
+            std::streamsize body = 0;
+            for (std::size_t i = 0; i < segments; ++i)
+                body += static_cast<unsigned char>(lacing[i]);
+
+            // the first BOS page after the data pages starts a new link
+            if ((type & 0x02) != 0)
+            {
+                if (!in_headers)
+                {
+                    if (has_link)
+                    {
+                        base = end_link(
+                            points, link_head, base, last, lengths, link++);
+                        link_head = points.size();
+                    }
+                    last = 0;
+                    serialno = serial;
+                    has_link = true;
+                    in_headers = true;
+                }
+            }
+            else if (serial == serialno)
+            {
+                in_headers = false;
+
+                // the header pages have zero and
+                // the pages without any packet end have -1
+                if (granule > 0)
+                {
+                    // the granule position is rebased by end_link()
+                    seek_point pt;
+                    pt.position = granule;
+                    pt.offset = offset;
+                    points.push_back(pt);
+                    last = granule;
+                }
+            }
+
+            offset += 27 + static_cast<boost::int64_t>(segments) + body;
+            boost::iostreams::seek(src, body, BOOST_IOS::cur, BOOST_IOS::in);
+        }
+        if (has_link)
+            end_link(points, link_head, base, last, lengths, link);
+
+        points_.swap(points);
+        file_size_ = offset;
+    }
+
+    template<class Source>
+    void load(Source& src)
+    {
+        char head[20];
+        if (!iostreams::blocking_read(src, head, 20, std::nothrow) ||
+            (std::memcmp(head, "HVSI", 4) != 0) ||
+            (hamigaki::decode_uint<little,4>(head+4) != 1) )
+        {
+            throw BOOST_IOSTREAMS_FAILURE("invalid vorbis seek index");
+        }
+
+        boost::int64_t file_size = static_cast<boost::int64_t>(
+            hamigaki::decode_uint<little,8>(head+8));
+        boost::uint32_t count = hamigaki::decode_uint<little,4>(head+16);
+
+        // each indexed page has 28 bytes at least
+        if ((file_size < 0) ||
+            (static_cast<boost::uint64_t>(count) >
+                static_cast<boost::uint64_t>(file_size) / 28) )
+        {
+            throw BOOST_IOSTREAMS_FAILURE("invalid vorbis seek index");
+        }
+
+        // the points are read before the memory for all is allocated
+        std::vector<seek_point> points;
+        points.reserve((std::min)(count, static_cast<boost::uint32_t>(4096)));
+        char buf[16];
+        for (boost::uint32_t i = 0; i < count; ++i)
+        {
+            iostreams::blocking_read(src, buf, 16);
+
+            seek_point pt;
+            pt.position = static_cast<boost::int64_t>(
+                hamigaki::decode_uint<little,8>(buf));
+            pt.offset = static_cast<boost::int64_t>(
+                hamigaki::decode_uint<little,8>(buf+8));
+
+            if ((pt.offset < 0) || (pt.offset >= file_size) ||
+                (!points.empty() &&
+                    ((pt.position < points.back().position) ||
+                     (pt.offset <= points.back().offset)) ) )
+            {
+                throw BOOST_IOSTREAMS_FAILURE("invalid vorbis seek index");
+            }
+            points.push_back(pt);
+        }
+
+        points_.swap(points);
+        file_size_ = file_size;
+    }
+
+    template<class Sink>
+    void save(Sink& sink) const
+    {
+        char head[20];
+        std::memcpy(head, "HVSI", 4);
+        hamigaki::encode_uint<little,4>(head+4, 1);
+        hamigaki::encode_uint<little,8>(
+            head+8, static_cast<boost::uint64_t>(file_size_));
+        hamigaki::encode_uint<little,4>(
+            head+16, static_cast<boost::uint32_t>(points_.size()));
+        iostreams::blocking_write(sink, head);
+
+        char buf[16];
+        for (std::size_t i = 0; i < points_.size(); ++i)
+        {
+            hamigaki::encode_uint<little,8>(
+                buf, static_cast<boost::uint64_t>(points_[i].position));
+            hamigaki::encode_uint<little,8>(
+                buf+8, static_cast<boost::uint64_t>(points_[i].offset));
+            iostreams::blocking_write(sink, buf);
+        }
+    }
+
+private:
+    std::vector<seek_point> points_;
+    boost::int64_t file_size_;
+
+    // converts the granule positions of the points from "head" to
+    // the accumulated positions, and returns the base of the next link
+    static boost::int64_t end_link(
+        std::vector<seek_point>& points, std::size_t head,
+        boost::int64_t base, boost::int64_t last,
+        const std::vector<boost::int64_t>& lengths, std::size_t link)
+    {
+        boost::int64_t first = 0;
+        if ((link < lengths.size()) && (lengths[link] <= last))
+            first = last - lengths[link];
+
+        for (std::size_t i = head; i < points.size(); ++i)
+            points[i].position += base - first;
+        return base + last - first;
+    }
+};
+
+} } } // End namespaces vorbis, audio, hamigaki.
+
+#endif // HAMIGAKI_AUDIO_VORBIS_SEEK_INDEX_HPP
@@ -15,9 +15,13 @@
 #include <hamigaki/audio/detail/auto_link/ogg.hpp>
 #include <hamigaki/audio/detail/auto_link/vorbis.hpp>
 #include <hamigaki/audio/detail/auto_link/vorbisfile.hpp>
+#include <hamigaki/audio/detail/mix.hpp>
+#include <hamigaki/audio/planar.hpp>
+#include <hamigaki/audio/vorbis/seek_index.hpp>
 #include <hamigaki/iostreams/device/file.hpp>
 #include <hamigaki/iostreams/arbitrary_positional_facade.hpp>
 #include <hamigaki/iostreams/catable.hpp>
+#include <hamigaki/iostreams/positioning.hpp>
 #include <hamigaki/iostreams/traits.hpp>
 #include <boost/iostreams/detail/adapter/direct_adapter.hpp>
 #include <boost/iostreams/detail/ios.hpp>
@@ -29,10 +33,12 @@
 #include <boost/cstdint.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/static_assert.hpp>
+#include <algorithm>
 #include <cstddef>
 #include <cstring>
 #include <limits>
 #include <utility>
+#include <vector>
 
 #ifdef BOOST_HAS_ABI_HEADERS
     #include BOOST_ABI_PREFIX
@@ -98,9 +104,14 @@ public:
     void close();
     long read_samples(float**& buffer, int samples);
     void seek(boost::int64_t pos);
+    void raw_seek(boost::int64_t offset);
     boost::int64_t tell();
     boost::int64_t total();
 
+    // the chained streams
+    int links();
+    boost::int64_t total(int link);
+
     std::pair<const char**,const char**> comments() const;
     const char* vendor() const;
     vorbis_info info() const;
@@ -299,16 +310,69 @@ public:
         return base_.info();
     }
 
+    const vorbis::seek_index& index() const
+    {
+        return index_;
+    }
+
+    // the index of the other file (or the old one) is rejected
+    void index(const vorbis::seek_index& x)
+    {
+        boost::iostreams::stream_offset pos = iostreams::to_offset(
+            boost::iostreams::seek(src_, 0, BOOST_IOS::cur, BOOST_IOS::in));
+        boost::iostreams::stream_offset size = iostreams::to_offset(
+            boost::iostreams::seek(src_, 0, BOOST_IOS::end, BOOST_IOS::in));
+        boost::iostreams::seek(src_, pos, BOOST_IOS::beg, BOOST_IOS::in);
+
+        if (!x.empty() && (x.file_size() != size))
+            throw BOOST_IOSTREAMS_FAILURE("stale vorbis seek index");
+        index_ = x;
+    }
+
+    // scans the source without disturbing the decoder
+    void build_index()
+    {
+        boost::iostreams::stream_offset pos = iostreams::to_offset(
+            boost::iostreams::seek(src_, 0, BOOST_IOS::cur, BOOST_IOS::in));
+
+        std::vector<boost::int64_t> lengths;
+        const int links = base_.links();
+        for (int i = 0; i < links; ++i)
+            lengths.push_back(base_.total(i));
+        index_.build(src_, lengths);
+
+        boost::iostreams::seek(src_, pos, BOOST_IOS::beg, BOOST_IOS::in);
+    }
+
+    // returns the channel buffers of libvorbis without interleaving
+    // (must not be mixed with the reads of the incomplete frames)
+    std::streamsize read_planar(
+        const float* const*& planes, std::streamsize frames)
+    {
+        float** buffer;
+        long res = base_.read_samples(buffer, static_cast<int>(
+            (std::min)(frames,
+                static_cast<std::streamsize>((std::numeric_limits<int>::max)())
+            )
+        ));
+        if (res == 0)
+            return -1;
+
+        planes = buffer;
+        return res;
+    }
+
     using facade_type::read;
     using facade_type::seek;
 
 private:
     vorbis_file_base base_;
     value_type src_;
+    vorbis::seek_index index_;
 
     std::streamsize read_blocks(float* s, std::streamsize n)
     {
-        std::streamsize channels = base_.info().channels;
+        const unsigned channels = static_cast<unsigned>(base_.info().channels);
         std::streamsize total = 0;
         while (n > 0)
         {
@@ -317,12 +381,10 @@ private:
             if (res == 0)
                 break;
 
-            for (std::streamsize j = 0; j < res; ++j)
-            {
-                for (std::streamsize i = 0; i < channels; ++i)
-                    *(s++) = buffer[i][j];
-            }
+            detail::interleave(
+                s, buffer, static_cast<std::size_t>(res), channels);
 
+            s += res*channels;
             total += res*channels;
             n -= res;
         }
@@ -335,22 +397,55 @@ private:
     {
         if (way == BOOST_IOS::beg)
         {
-            base_.seek(off);
+            seek_frame(off);
             return off;
         }
         else if (way == BOOST_IOS::cur)
         {
             boost::int64_t cur = base_.tell();
-            base_.seek(cur + off);
+            seek_frame(cur + off);
             return cur + off;
         }
         else
         {
             boost::int64_t end = base_.total();
-            base_.seek(end + off);
+            seek_frame(end + off);
             return end + off;
         }
     }
+
+    // jumps to the page of the index and decodes the rest of the frames
+    // instead of the bisection search of libvorbisfile
+    void seek_frame(boost::int64_t pos)
+    {
+        boost::int64_t offset = index_.find(pos);
+        if (offset != -1)
+        {
+            base_.raw_seek(offset);
+
+            boost::int64_t cur = base_.tell();
+            if (cur <= pos)
+            {
+                skip_frames(pos - cur);
+                return;
+            }
+        }
+        base_.seek(pos);
+    }
+
+    void skip_frames(boost::int64_t n)
+    {
+        while (n > 0)
+        {
+            float** buffer;
+            int amt = static_cast<int>(
+                (std::min)(n, static_cast<boost::int64_t>(4096)));
+            long res = base_.read_samples(buffer, amt);
+            if (res == 0)
+                break;
+            n -= res;
+        }
+    }
 };
 
 } // namespace detail
@@ -386,6 +481,12 @@ public:
         return pimpl_->read(s, n);
     }
 
+    std::streamsize read_planar(
+        const char_type* const*& planes, std::streamsize frames)
+    {
+        return pimpl_->read_planar(planes, frames);
+    }
+
     void close()
     {
         pimpl_->close();
@@ -417,6 +518,29 @@ public:
         return pimpl_->total();
     }
 
+    // reads from the sample position "pos"
+    std::streamsize read_at(
+        boost::iostreams::stream_offset pos, char_type* s, std::streamsize n)
+    {
+        pimpl_->seek(pos, BOOST_IOS::beg);
+        return pimpl_->read(s, n);
+    }
+
+    const vorbis::seek_index& index() const
+    {
+        return pimpl_->index();
+    }
+
+    void index(const vorbis::seek_index& x)
+    {
+        pimpl_->index(x);
+    }
+
+    void build_index()
+    {
+        pimpl_->build_index();
+    }
+
 private:
     boost::shared_ptr<impl_type> pimpl_;
 };
@@ -445,6 +569,12 @@ public:
         return impl_.read(s, n);
     }
 
+    std::streamsize read_planar(
+        const char_type* const*& planes, std::streamsize frames)
+    {
+        return impl_.read_planar(planes, frames);
+    }
+
     void close()
     {
         impl_.close();
@@ -476,6 +606,27 @@ public:
         return impl_.total();
     }
 
+    std::streamsize read_at(
+        boost::iostreams::stream_offset pos, char_type* s, std::streamsize n)
+    {
+        return impl_.read_at(pos, s, n);
+    }
+
+    const vorbis::seek_index& index() const
+    {
+        return impl_.index();
+    }
+
+    void index(const vorbis::seek_index& x)
+    {
+        impl_.index(x);
+    }
+
+    void build_index()
+    {
+        impl_.build_index();
+    }
+
 private:
     impl_type impl_;
 };
@@ -487,6 +638,13 @@ make_vorbis_file_source(const Source& src)
     return basic_vorbis_file_source<Source>(src);
 }
 
+template<typename Source>
+struct is_planar_source<basic_vorbis_file_source<Source> >
+    : boost::true_type {};
+
+template<>
+struct is_planar_source<vorbis_file_source> : boost::true_type {};
+
 } } // End namespaces audio, hamigaki.
 
 HAMIGAKI_IOSTREAMS_CATABLE(hamigaki::audio::basic_vorbis_file_source, 1)
@@ -13,6 +13,7 @@
 #include <hamigaki/audio/detail/wide_adaptor_char_float.hpp>
 #include <hamigaki/audio/detail/wide_adaptor_char_int.hpp>
 #include <hamigaki/audio/detail/wide_adaptor_float_float.hpp>
+#include <hamigaki/audio/device_delay.hpp>
 #include <hamigaki/iostreams/traits.hpp>
 #include <boost/iostreams/detail/select.hpp>
 #include <boost/iostreams/categories.hpp>
@@ -76,6 +77,7 @@ public:
         , boost::iostreams::device_tag
         , boost::iostreams::closable_tag
         , boost::iostreams::optimally_buffered_tag
+        , delay_tag
     {};
 
     explicit wide_adaptor(const Device& dev)
@@ -129,6 +131,12 @@ public:
         return pimpl_->optimal_buffer_size();
     }
 
+    // in the samples of char_type
+    std::streamsize delay() const
+    {
+        return pimpl_->delay();
+    }
+
 private:
     boost::shared_ptr<impl_type> pimpl_;
 
@@ -0,0 +1,203 @@
+// crc.hpp: table-driven CRC (slice-by-8)
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/checksum for library home page.
+
+#ifndef HAMIGAKI_CHECKSUM_CRC_HPP
+#define HAMIGAKI_CHECKSUM_CRC_HPP
+
+#include <boost/cstdint.hpp>
+#include <boost/integer.hpp>
+#include <boost/static_assert.hpp>
+#include <cstddef>
+
+namespace hamigaki { namespace checksum {
+
+namespace crc_detail
+{
+
+typedef boost::uint32_t word;
+
+// eight tables for the reflected CRC of "Bits" bits:
+//   table[0][n] is the CRC of the byte n,
+//   table[k][n] is the CRC of the byte n followed by k zero bytes
+template<std::size_t Bits, word TruncPoly>
+class slice8_table
+{
+public:
+    static const slice8_table& instance()
+    {
+        static const slice8_table table;
+        return table;
+    }
+
+    word table[8][256];
+
+private:
+    // constructs the tables before main() to avoid the race
+    // on the first call of instance()
+    static const slice8_table& initializer_;
+
+    slice8_table()
+    {
+        // touch the initializer for the instantiation
+        (void)&initializer_;
+
+        word poly = 0;
+        for (std::size_t i = 0; i < Bits; ++i)
+        {
+            if ((TruncPoly & (static_cast<word>(1) << i)) != 0)
+                poly |= static_cast<word>(1) << (Bits-1-i);
+        }
+
+        for (word n = 0; n < 256; ++n)
+        {
+            word crc = n;
+            for (int i = 0; i < 8; ++i)
+                crc = (crc & 1) ? (crc >> 1) ^ poly : (crc >> 1);
+            table[0][n] = crc;
+        }
+
+        for (std::size_t k = 1; k < 8; ++k)
+        {
+            for (word n = 0; n < 256; ++n)
+            {
+                word crc = table[k-1][n];
+                table[k][n] = (crc >> 8) ^ table[0][crc & 0xFF];
+            }
+        }
+    }
+};
+
+template<std::size_t Bits, word TruncPoly>
+const slice8_table<Bits,TruncPoly>&
+slice8_table<Bits,TruncPoly>::initializer_ =
+    slice8_table<Bits,TruncPoly>::instance();
+
+inline word load_le32(const unsigned char* p)
+{
+    return
+        static_cast<word>(p[0])         |
+        (static_cast<word>(p[1]) <<  8) |
+        (static_cast<word>(p[2]) << 16) |
+        (static_cast<word>(p[3]) << 24) ;
+}
+
+} // namespace crc_detail
+
+// A drop-in replacement of boost::crc_optimal for the reflected CRCs.
+// The input is processed eight bytes at a time (Intel's slice-by-8).
+template<
+    std::size_t Bits, boost::uint32_t TruncPoly,
+    boost::uint32_t InitRem, boost::uint32_t FinalXor
+>
+class reflected_crc
+{
+    BOOST_STATIC_ASSERT((Bits >= 8) && (Bits <= 32));
+
+private:
+    typedef crc_detail::word word;
+    typedef crc_detail::slice8_table<Bits,TruncPoly> table_type;
+
+public:
+    typedef typename boost::uint_t<Bits>::least value_type;
+
+    explicit reflected_crc(value_type init_rem = InitRem)
+        : rem_(reflect(init_rem))
+        , table_(table_type::instance().table)
+    {
+    }
+
+    void reset(value_type new_rem = InitRem)
+    {
+        rem_ = reflect(new_rem);
+    }
+
+    void process_byte(unsigned char byte)
+    {
+        rem_ = (rem_ >> 8) ^ table_[0][(rem_ ^ byte) & 0xFF];
+    }
+
+    void process_block(const void* bytes_begin, const void* bytes_end)
+    {
+        const unsigned char* first =
+            static_cast<const unsigned char*>(bytes_begin);
+        const unsigned char* last =
+            static_cast<const unsigned char*>(bytes_end);
+        process_bytes(first, static_cast<std::size_t>(last - first));
+    }
+
+    void process_bytes(const void* buffer, std::size_t byte_count)
+    {
+        const unsigned char* p = static_cast<const unsigned char*>(buffer);
+
+        word rem = rem_;
+        for ( ; byte_count >= 8; byte_count -= 8, p += 8)
+        {
+            // the remainder has no bits beyond "Bits",
+            // so that it can be merged into the first four bytes
+            word x = rem ^ crc_detail::load_le32(p);
+            rem =
+                table_[7][ x        & 0xFF] ^
+                table_[6][(x >>  8) & 0xFF] ^
+                table_[5][(x >> 16) & 0xFF] ^
+                table_[4][ x >> 24        ] ^
+                table_[3][p[4]] ^
+                table_[2][p[5]] ^
+                table_[1][p[6]] ^
+                table_[0][p[7]] ;
+        }
+
+        for ( ; byte_count != 0; --byte_count, ++p)
+            rem = (rem >> 8) ^ table_[0][(rem ^ *p) & 0xFF];
+
+        rem_ = rem;
+    }
+
+    value_type checksum() const
+    {
+        return static_cast<value_type>((rem_ ^ FinalXor) & mask());
+    }
+
+    void operator()(unsigned char byte)
+    {
+        process_byte(byte);
+    }
+
+    value_type operator()() const
+    {
+        return checksum();
+    }
+
+private:
+    word rem_;
+    const word (*table_)[256];
+
+    static word mask()
+    {
+        return ~static_cast<word>(0) >> (32 - Bits);
+    }
+
+    static word reflect(word x)
+    {
+        word y = 0;
+        for (std::size_t i = 0; i < Bits; ++i)
+        {
+            if ((x & (static_cast<word>(1) << i)) != 0)
+                y |= static_cast<word>(1) << (Bits-1-i);
+        }
+        return y;
+    }
+};
+
+// the same parameters as boost::crc_16_type and boost::crc_32_type
+typedef reflected_crc<16, 0x8005, 0, 0> crc_16_type;
+typedef reflected_crc<32, 0x04C11DB7, 0xFFFFFFFF, 0xFFFFFFFF> crc_32_type;
+
+} } // End namespaces checksum, hamigaki.
+
+#endif // HAMIGAKI_CHECKSUM_CRC_HPP
@@ -161,6 +161,18 @@ inline void round4(word& a, word& b, word& c, word& d, const block& x)
     b = round4_op(b, c, d, a, x[ 9], 0xEB86D391, 21);
 }
 
+inline void load_little_block(block& x, const unsigned char* p)
+{
+    for (std::size_t i = 0; i < 16; ++i, p += 4)
+    {
+        x[i] =
+            (static_cast<word>(p[0])      ) |
+            (static_cast<word>(p[1]) <<  8) |
+            (static_cast<word>(p[2]) << 16) |
+            (static_cast<word>(p[3]) << 24) ;
+    }
+}
+
 class md5_impl
 {
 public:
@@ -264,7 +276,21 @@ public:
 
     void process_byte(unsigned char byte)
     {
-        process_bits(byte, 8);
+        if ((bit_ % 8) != 0)
+        {
+            process_bits(byte, 8);
+            return;
+        }
+
+        std::size_t index = static_cast<std::size_t>((bit_ % 512) / 32);
+        std::size_t offset = static_cast<std::size_t>(bit_ % 32);
+        buffer_[index] |= static_cast<word>(byte) << offset;
+        bit_ += 8;
+        if ((bit_ % 512) == 0)
+        {
+            impl_.process_block(buffer_);
+            buffer_.assign(0);
+        }
     }
 
     void process_block(const void* bytes_begin, const void* bytes_end)
@@ -273,7 +299,24 @@ public:
         const uchar* beg = static_cast<const uchar*>(bytes_begin);
         const uchar* end = static_cast<const uchar*>(bytes_end);
         while (beg != end)
+        {
+            // processes the whole blocks without the buffering
+            if (((bit_ % 512) == 0) && (end - beg >= 64))
+            {
+                do
+                {
+                    md5_detail::load_little_block(buffer_, beg);
+                    impl_.process_block(buffer_);
+                    beg += 64;
+                    bit_ += 512;
+                } while (end - beg >= 64);
+
+                buffer_.assign(0);
+                continue;
+            }
+
             process_byte(*(beg++));
+        }
     }
 
     void process_bytes(const void* buffer, std::size_t byte_count)
@@ -39,6 +39,18 @@ inline void copy_word(boost::uint8_t* dst, word n)
 #endif
 }
 
+inline void load_big_block(block& x, const unsigned char* p)
+{
+    for (std::size_t i = 0; i < 16; ++i, p += 4)
+    {
+        x[i] =
+            (static_cast<word>(p[0]) << 24) |
+            (static_cast<word>(p[1]) << 16) |
+            (static_cast<word>(p[2]) <<  8) |
+            (static_cast<word>(p[3])      ) ;
+    }
+}
+
 class sha1_impl
 {
 public:
@@ -72,14 +84,39 @@ public:
         word d = h_[3];
         word e = h_[4];
 
-        for (word t = 0; t < 80; ++t)
+        // the rounds are split by the functions to avoid the branches,
+        // and the variables are renamed instead of shifting them
+        for (word t = 0; t < 20; t += 5)
+        {
+            round<f1>(a, b, c, d, e, 0x5A827999 + w[t+0]);
+            round<f1>(e, a, b, c, d, 0x5A827999 + w[t+1]);
+            round<f1>(d, e, a, b, c, 0x5A827999 + w[t+2]);
+            round<f1>(c, d, e, a, b, 0x5A827999 + w[t+3]);
+            round<f1>(b, c, d, e, a, 0x5A827999 + w[t+4]);
+        }
+        for (word t = 20; t < 40; t += 5)
+        {
+            round<f2>(a, b, c, d, e, 0x6ED9EBA1 + w[t+0]);
+            round<f2>(e, a, b, c, d, 0x6ED9EBA1 + w[t+1]);
+            round<f2>(d, e, a, b, c, 0x6ED9EBA1 + w[t+2]);
+            round<f2>(c, d, e, a, b, 0x6ED9EBA1 + w[t+3]);
+            round<f2>(b, c, d, e, a, 0x6ED9EBA1 + w[t+4]);
+        }
+        for (word t = 40; t < 60; t += 5)
         {
-            word temp = rotate_left(a, 5) + f(t, b, c, d) + e + w[t] + k(t);
-            e = d;
-            d = c;
-            c = rotate_left(b, 30);
-            b = a;
-            a = temp;
+            round<f3>(a, b, c, d, e, 0x8F1BBCDC + w[t+0]);
+            round<f3>(e, a, b, c, d, 0x8F1BBCDC + w[t+1]);
+            round<f3>(d, e, a, b, c, 0x8F1BBCDC + w[t+2]);
+            round<f3>(c, d, e, a, b, 0x8F1BBCDC + w[t+3]);
+            round<f3>(b, c, d, e, a, 0x8F1BBCDC + w[t+4]);
+        }
+        for (word t = 60; t < 80; t += 5)
+        {
+            round<f2>(a, b, c, d, e, 0xCA62C1D6 + w[t+0]);
+            round<f2>(e, a, b, c, d, 0xCA62C1D6 + w[t+1]);
+            round<f2>(d, e, a, b, c, 0xCA62C1D6 + w[t+2]);
+            round<f2>(c, d, e, a, b, 0xCA62C1D6 + w[t+3]);
+            round<f2>(b, c, d, e, a, 0xCA62C1D6 + w[t+4]);
         }
 
         h_[0] += a;
@@ -103,28 +140,27 @@ public:
 private:
     word h_[5];
 
-    static word f(word t, word b, word c, word d)
+    static word f1(word b, word c, word d)
     {
-        if (t < 20)
-            return (b & c) | (~b & d);
-        else if (t < 40)
-            return b ^ c ^ d;
-        else if (t < 60)
-            return (b & c) | (b & d) | (c & d);
-        else
-            return b ^ c ^ d;
+        return (b & c) | (~b & d);
     }
 
-    static word k(word t)
+    static word f2(word b, word c, word d)
     {
-        if (t < 20)
-            return 0x5A827999;
-        else if (t < 40)
-            return 0x6ED9EBA1;
-        else if (t < 60)
-            return 0x8F1BBCDC;
-        else
-            return 0xCA62C1D6;
+        return b ^ c ^ d;
+    }
+
+    static word f3(word b, word c, word d)
+    {
+        return (b & c) | (b & d) | (c & d);
+    }
+
+    // "x" is k(t) + w[t]
+    template<word (*F)(word, word, word)>
+    static void round(word a, word& b, word c, word d, word& e, word x)
+    {
+        e += rotate_left(a, 5) + F(b, c, d) + x;
+        b = rotate_left(b, 30);
     }
 };
 
@@ -266,6 +302,20 @@ public:
         bytes_ += (end - beg);
         while (beg != end)
         {
+            // processes the whole blocks without the buffering
+            if ((index == 0) && (offset == 24) && (end - beg >= 64))
+            {
+                do
+                {
+                    sha1_detail::load_big_block(buffer_, beg);
+                    impl_.process_block(buffer_);
+                    beg += 64;
+                } while (end - beg >= 64);
+
+                buffer_.assign(0);
+                continue;
+            }
+
             boost::uint32_t b = *(beg++);
             buffer_[index] |= b << offset;
             if (offset == 0)
@@ -58,6 +58,18 @@ inline void to_big64(boost::uint8_t* dst, boost::uint64_t n)
 #endif
 }
 
+template<class Word>
+inline void load_big_block(boost::array<Word,16>& x, const unsigned char* p)
+{
+    for (std::size_t i = 0; i < 16; ++i)
+    {
+        Word n = 0;
+        for (std::size_t j = 0; j < sizeof(Word); ++j)
+            n = (n << 8) | *(p++);
+        x[i] = n;
+    }
+}
+
 template<std::size_t Size>
 struct sha2_traits;
 
@@ -346,6 +358,16 @@ public:
     }
 
     void process_block(const block& x)
+    {
+        compress(h_, x);
+    }
+
+    value_type output()
+    {
+        return Traits::output(h_);
+    }
+
+    static void compress(word (&hash)[8], const block& x)
     {
         word w[rounds];
         std::copy(x.begin(), x.end(), &w[0]);
@@ -353,47 +375,52 @@ public:
         for (word t = 16; t < rounds; ++t)
             w[t] = ssig1(w[t-2]) + w[t-7] + ssig0(w[t-15]) + w[t-16];
 
-        word a = h_[0];
-        word b = h_[1];
-        word c = h_[2];
-        word d = h_[3];
-        word e = h_[4];
-        word f = h_[5];
-        word g = h_[6];
-        word h = h_[7];
-
-        for (word t = 0; t < rounds; ++t)
+        word a = hash[0];
+        word b = hash[1];
+        word c = hash[2];
+        word d = hash[3];
+        word e = hash[4];
+        word f = hash[5];
+        word g = hash[6];
+        word h = hash[7];
+
+        // renames the variables instead of shifting them
+        for (word t = 0; t < rounds; t += 8)
         {
-            word t1 = h + bsig1(e) + ch(e, f, g) + k(t) + w[t];
-            word t2 = bsig0(a) + maj(a, b, c);
-            h = g;
-            g = f;
-            f = e;
-            e = d + t1;
-            d = c;
-            c = b;
-            b = a;
-            a = t1 + t2;
+            round(a, b, c, d, e, f, g, h, k(t+0) + w[t+0]);
+            round(h, a, b, c, d, e, f, g, k(t+1) + w[t+1]);
+            round(g, h, a, b, c, d, e, f, k(t+2) + w[t+2]);
+            round(f, g, h, a, b, c, d, e, k(t+3) + w[t+3]);
+            round(e, f, g, h, a, b, c, d, k(t+4) + w[t+4]);
+            round(d, e, f, g, h, a, b, c, k(t+5) + w[t+5]);
+            round(c, d, e, f, g, h, a, b, k(t+6) + w[t+6]);
+            round(b, c, d, e, f, g, h, a, k(t+7) + w[t+7]);
         }
 
-        h_[0] += a;
-        h_[1] += b;
-        h_[2] += c;
-        h_[3] += d;
-        h_[4] += e;
-        h_[5] += f;
-        h_[6] += g;
-        h_[7] += h;
-    }
-
-    value_type output()
-    {
-        return Traits::output(h_);
+        hash[0] += a;
+        hash[1] += b;
+        hash[2] += c;
+        hash[3] += d;
+        hash[4] += e;
+        hash[5] += f;
+        hash[6] += g;
+        hash[7] += h;
     }
 
 private:
     word h_[8];
 
+    // "x" is k(t) + w[t]
+    static void round(
+        word a, word b, word c, word& d,
+        word e, word f, word g, word& h, word x)
+    {
+        word t1 = h + bsig1(e) + ch(e, f, g) + x;
+        word t2 = bsig0(a) + maj(a, b, c);
+        d += t1;
+        h = t1 + t2;
+    }
+
     static word ch(word x, word y, word z)
     {
         return (x & y) ^ ((~x) & z);
@@ -607,6 +634,21 @@ public:
 
         while (beg != end)
         {
+            // processes the whole blocks without the buffering
+            if ((index == 0) && (offset == word_bits-8) &&
+                (static_cast<std::size_t>(end - beg) >= block_bytes) )
+            {
+                do
+                {
+                    sha2_detail::load_big_block(buffer_, beg);
+                    impl_.process_block(buffer_);
+                    beg += block_bytes;
+                } while (static_cast<std::size_t>(end - beg) >= block_bytes);
+
+                buffer_.assign(0);
+                continue;
+            }
+
             word b = *(beg++);
             buffer_[index] |= b << offset;
             if (offset == 0)
@@ -0,0 +1,307 @@
+// sha2_multi_buffer.hpp: SHA-2 checksum of the multiple streams
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/checksum for library home page.
+
+#ifndef HAMIGAKI_CHECKSUM_SHA2_MULTI_BUFFER_HPP
+#define HAMIGAKI_CHECKSUM_SHA2_MULTI_BUFFER_HPP
+
+#include <hamigaki/checksum/sha2.hpp>
+#include <boost/array.hpp>
+#include <boost/assert.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/static_assert.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace hamigaki { namespace checksum {
+
+namespace sha2_detail
+{
+
+// The compression function of "Lanes" independent streams.
+// Each variable of SHA-2 is a lane_word (word[Lanes]) indexed by the lane
+// last, so a round is the same operation on "Lanes" adjacent words.
+template<class Traits, std::size_t Lanes>
+class sha2_lanes
+{
+public:
+    typedef typename Traits::word word;
+    typedef sha2_word_traits<word> word_traits;
+    typedef word lane_word[Lanes];
+
+    static const std::size_t rounds = word_traits::rounds;
+    static const std::size_t block_bytes = sizeof(word) * 16;
+
+    void reset(std::size_t lane)
+    {
+        word h[8];
+        Traits::reset(h);
+        set_hash(lane, h);
+    }
+
+    void get_hash(std::size_t lane, word (&h)[8]) const
+    {
+        for (std::size_t i = 0; i < 8; ++i)
+            h[i] = h_[i][lane];
+    }
+
+    void set_hash(std::size_t lane, const word (&h)[8])
+    {
+        for (std::size_t i = 0; i < 8; ++i)
+            h_[i][lane] = h[i];
+    }
+
+    // processes a block of every lane
+    void process_blocks(const unsigned char* const (&blocks)[Lanes])
+    {
+        lane_word w[rounds];
+        for (std::size_t t = 0; t < 16; ++t)
+        {
+            for (std::size_t l = 0; l < Lanes; ++l)
+            {
+                const unsigned char* p = blocks[l] + t*sizeof(word);
+                word n = 0;
+                for (std::size_t j = 0; j < sizeof(word); ++j)
+                    n = (n << 8) | p[j];
+                w[t][l] = n;
+            }
+        }
+
+        for (std::size_t t = 16; t < rounds; ++t)
+        {
+            for (std::size_t l = 0; l < Lanes; ++l)
+            {
+                w[t][l] =
+                    word_traits::ssig1(w[t-2][l]) + w[t-7][l] +
+                    word_traits::ssig0(w[t-15][l]) + w[t-16][l];
+            }
+        }
+
+        lane_word v[8];
+        for (std::size_t i = 0; i < 8; ++i)
+        {
+            for (std::size_t l = 0; l < Lanes; ++l)
+                v[i][l] = h_[i][l];
+        }
+
+        // renames the variables instead of shifting them
+        for (std::size_t t = 0; t < rounds; t += 8)
+        {
+            round<0>(v, w[t+0], t+0);
+            round<1>(v, w[t+1], t+1);
+            round<2>(v, w[t+2], t+2);
+            round<3>(v, w[t+3], t+3);
+            round<4>(v, w[t+4], t+4);
+            round<5>(v, w[t+5], t+5);
+            round<6>(v, w[t+6], t+6);
+            round<7>(v, w[t+7], t+7);
+        }
+
+        for (std::size_t i = 0; i < 8; ++i)
+        {
+            for (std::size_t l = 0; l < Lanes; ++l)
+                h_[i][l] += v[i][l];
+        }
+    }
+
+private:
+    lane_word h_[8];
+
+    // the variables (a, b, ..., h) of the round "t" are
+    // (v[-N], v[1-N], ..., v[7-N]) where N = t % 8
+    template<std::size_t N>
+    static void round(
+        lane_word (&v)[8], const lane_word& w, std::size_t t)
+    {
+        lane_word& a = v[(8-N)%8];
+        lane_word& b = v[(9-N)%8];
+        lane_word& c = v[(10-N)%8];
+        lane_word& d = v[(11-N)%8];
+        lane_word& e = v[(12-N)%8];
+        lane_word& f = v[(13-N)%8];
+        lane_word& g = v[(14-N)%8];
+        lane_word& h = v[(15-N)%8];
+
+        const word k = word_traits::k(static_cast<word>(t));
+        for (std::size_t l = 0; l < Lanes; ++l)
+        {
+            word t1 =
+                h[l] + word_traits::bsig1(e[l]) +
+                ((e[l] & f[l]) ^ (~e[l] & g[l])) + k + w[l];
+            word t2 =
+                word_traits::bsig0(a[l]) +
+                ((a[l] & b[l]) ^ (a[l] & c[l]) ^ (b[l] & c[l]));
+            d[l] += t1;
+            h[l] = t1 + t2;
+        }
+    }
+};
+
+} // namespace sha2_detail
+
+// Computes SHA-2 of "Lanes" streams at once.
+// The blocks are queued per stream and compressed in lockstep
+// when every stream has a block, so the streams should be fed
+// in similar sized chunks by turns. A stream running ahead of the others
+// by more than "max_pending_bytes" is compressed alone.
+template<std::size_t Size, std::size_t Lanes>
+class sha2_multi_buffer
+{
+    BOOST_STATIC_ASSERT(Lanes != 0);
+
+    typedef sha2_detail::sha2_traits<Size> traits_type;
+    typedef sha2_detail::sha2_impl<traits_type> impl_type;
+    typedef sha2_detail::sha2_lanes<traits_type,Lanes> lanes_type;
+    typedef typename traits_type::word word;
+    typedef typename impl_type::block block;
+
+public:
+    typedef typename impl_type::value_type value_type;
+
+    static const std::size_t lanes = Lanes;
+    static const std::size_t word_bytes = sizeof(word);
+    static const std::size_t block_bytes = word_bytes * block::static_size;
+    static const std::size_t max_pending_bytes = block_bytes * 256;
+
+    sha2_multi_buffer()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        for (std::size_t i = 0; i < Lanes; ++i)
+            reset(i);
+    }
+
+    void reset(std::size_t lane)
+    {
+        BOOST_ASSERT(lane < Lanes);
+
+        buffers_[lane].clear();
+        bytes_[lane] = 0;
+        impl_.reset(lane);
+    }
+
+    void process_byte(std::size_t lane, unsigned char byte)
+    {
+        process_bytes(lane, &byte, 1);
+    }
+
+    void process_block(
+        std::size_t lane, const void* bytes_begin, const void* bytes_end)
+    {
+        typedef unsigned char uchar;
+        const uchar* beg = static_cast<const uchar*>(bytes_begin);
+        const uchar* end = static_cast<const uchar*>(bytes_end);
+        process_bytes(lane, beg, static_cast<std::size_t>(end - beg));
+    }
+
+    void process_bytes(
+        std::size_t lane, const void* buffer, std::size_t byte_count)
+    {
+        BOOST_ASSERT(lane < Lanes);
+
+        typedef unsigned char uchar;
+        const uchar* beg = static_cast<const uchar*>(buffer);
+        buffers_[lane].insert(buffers_[lane].end(), beg, beg+byte_count);
+        bytes_[lane] += byte_count;
+
+        process_queued_blocks();
+    }
+
+    // finishes the stream of "lane"; reset(lane) is needed to reuse it
+    value_type checksum(std::size_t lane)
+    {
+        BOOST_ASSERT(lane < Lanes);
+
+        std::vector<unsigned char>& buf = buffers_[lane];
+        std::size_t pos = 0;
+        for ( ; buf.size() - pos >= block_bytes; pos += block_bytes)
+            process_lane(lane, &buf[pos]);
+
+        // the padding and the length in bits
+        unsigned char tail[block_bytes*2] = {};
+        std::size_t rest = buf.size() - pos;
+        std::copy(buf.begin() + pos, buf.end(), &tail[0]);
+        tail[rest] = 0x80;
+
+        std::size_t size = (rest + 1 + word_bytes*2 <= block_bytes)
+            ? block_bytes : block_bytes*2;
+
+        // the big endian integer of two words
+        boost::uint64_t bits = bytes_[lane] << 3;
+        for (std::size_t i = 0; i < 8; ++i)
+            tail[size-1-i] = static_cast<unsigned char>(bits >> (8*i));
+        if (word_bytes == 8)
+            tail[size-9] = static_cast<unsigned char>(bytes_[lane] >> 61);
+
+        for (std::size_t i = 0; i < size; i += block_bytes)
+            process_lane(lane, &tail[i]);
+        buf.clear();
+
+        word h[8];
+        impl_.get_hash(lane, h);
+        return traits_type::output(h);
+    }
+
+private:
+    lanes_type impl_;
+    std::vector<unsigned char> buffers_[Lanes];
+    boost::uint64_t bytes_[Lanes];
+
+    void process_lane(std::size_t lane, const unsigned char* p)
+    {
+        block x;
+        sha2_detail::load_big_block(x, p);
+
+        word h[8];
+        impl_.get_hash(lane, h);
+        impl_type::compress(h, x);
+        impl_.set_hash(lane, h);
+    }
+
+    void process_queued_blocks()
+    {
+        std::size_t pos[Lanes];
+        std::size_t min_size = buffers_[0].size();
+        for (std::size_t i = 0; i < Lanes; ++i)
+        {
+            pos[i] = 0;
+            if (buffers_[i].size() < min_size)
+                min_size = buffers_[i].size();
+        }
+
+        for ( ; min_size >= block_bytes; min_size -= block_bytes)
+        {
+            const unsigned char* blocks[Lanes];
+            for (std::size_t i = 0; i < Lanes; ++i)
+            {
+                blocks[i] = &buffers_[i][pos[i]];
+                pos[i] += block_bytes;
+            }
+            impl_.process_blocks(blocks);
+        }
+
+        for (std::size_t i = 0; i < Lanes; ++i)
+        {
+            std::vector<unsigned char>& buf = buffers_[i];
+            for ( ; buf.size() - pos[i] > max_pending_bytes; )
+            {
+                process_lane(i, &buf[pos[i]]);
+                pos[i] += block_bytes;
+            }
+            buf.erase(buf.begin(), buf.begin() + pos[i]);
+        }
+    }
+};
+
+} } // End namespaces checksum, hamigaki.
+
+#endif // HAMIGAKI_CHECKSUM_SHA2_MULTI_BUFFER_HPP
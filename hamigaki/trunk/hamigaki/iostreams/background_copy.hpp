@@ -28,7 +28,9 @@
     #pragma warning(pop)
 #endif
 
+#include <hamigaki/iostreams/detail/spsc_ring.hpp>
 #include <hamigaki/thread/exception_storage.hpp>
+#include <boost/detail/atomic_count.hpp>
 #include <boost/iostreams/detail/buffer.hpp>
 #include <boost/iostreams/close.hpp>
 #include <boost/iostreams/constants.hpp>
@@ -43,6 +45,32 @@
 
 namespace hamigaki { namespace iostreams {
 
+struct background_copy_statistics
+{
+    // the bytes read from the source
+    std::streamsize read_total;
+
+    // the bytes written to the sink
+    std::streamsize write_total;
+
+    // the number of times the reader waited for a free buffer
+    // (the sink is slower than the source)
+    unsigned long reader_waits;
+
+    // the number of times the writer waited for a filled buffer
+    // (the source is slower than the sink)
+    unsigned long writer_waits;
+
+    // the maximum number of the filled buffers
+    std::size_t max_filled_buffers;
+
+    background_copy_statistics()
+        : read_total(0), write_total(0)
+        , reader_waits(0), writer_waits(0), max_filled_buffers(0)
+    {
+    }
+};
+
 namespace detail
 {
 
@@ -66,6 +94,11 @@ public:
         return do_total();
     }
 
+    background_copy_statistics statistics()
+    {
+        return do_statistics();
+    }
+
     void stop()
     {
         return do_stop();
@@ -75,6 +108,7 @@ private:
     virtual void do_run() = 0;
     virtual bool do_done() = 0;
     virtual std::streamsize do_total() = 0;
+    virtual background_copy_statistics do_statistics() = 0;
     virtual void do_stop() = 0;
 };
 
@@ -89,7 +123,8 @@ public:
             const Source& src, const Sink& sink,
             std::streamsize buffer_size, ExceptionStorage& storage)
         : src_(src), sink_(sink), buffer_(buffer_size), total_(0)
-        , done_(false), interrupted_(false), except_ptr_(&storage)
+        , read_total_(0), done_(false), interrupted_(false)
+        , except_ptr_(&storage)
     {
         buffer_.set(0, 0);
     }
@@ -100,6 +135,7 @@ private:
     Sink sink_;
     buffer_type buffer_;
     volatile std::streamsize total_;
+    volatile std::streamsize read_total_;
     volatile bool done_;
     volatile bool interrupted_;
     ExceptionStorage* except_ptr_;
@@ -112,6 +148,9 @@ private:
 
             while (!interrupted())
             {
+                // counted with the first write of the buffer
+                std::streamsize read_amt = 0;
+
                 if (buf.ptr() == buf.eptr())
                 {
                     std::streamsize amt =
@@ -125,6 +164,7 @@ private:
                     }
 
                     buf.set(0, amt);
+                    read_amt = amt;
                 }
 
                 while (buf.ptr() != buf.eptr())
@@ -136,6 +176,8 @@ private:
                     buf.ptr() += amt;
 
                     boost::mutex::scoped_lock locking(mutex_);
+                    read_total_ += read_amt;
+                    read_amt = 0;
                     total_ += amt;
                 }
             }
@@ -161,6 +203,16 @@ private:
         return total_;
     }
 
+    background_copy_statistics do_statistics() // virtual
+    {
+        boost::mutex::scoped_lock locking(mutex_);
+        background_copy_statistics stat;
+        stat.read_total = read_total_;
+        stat.write_total = total_;
+        stat.max_filled_buffers = 1;
+        return stat;
+    }
+
     void do_stop() // virtual
     {
         boost::mutex::scoped_lock locking(mutex_);
@@ -174,6 +226,214 @@ private:
     }
 };
 
+// The reader thread and the writer thread share a ring of the buffers,
+// so that reading the source overlaps writing the sink.
+// The ring is lock-free, and a thread waits on state_event only when
+// the ring is full or empty.
+template<class Source, class Sink, class ExceptionStorage>
+class bg_pipelined_copy_impl : public bg_copy_base
+{
+    typedef typename boost::iostreams::char_type_of<Source>::type char_type;
+
+public:
+    bg_pipelined_copy_impl(
+            const Source& src, const Sink& sink,
+            std::streamsize buffer_size, std::size_t buffer_count,
+            ExceptionStorage& storage)
+        : src_(src), sink_(sink), ring_(buffer_size, buffer_count)
+        , reader_waits_(0), writer_waits_(0), max_filled_(0)
+        , stored_(false), except_ptr_(&storage)
+    {
+        BOOST_ASSERT(buffer_count >= 2);
+    }
+
+private:
+    boost::mutex except_mutex_; // used only when an exception is thrown
+    Source src_;
+    Sink sink_;
+    spsc_ring<char_type> ring_;
+    state_event event_;
+    single_writer_flag eof_;         // written by the reader thread
+    single_writer_flag read_failed_; // by the reader thread
+    single_writer_flag write_failed_; // by the writer thread
+    single_writer_flag done_;        // by the writer thread
+    single_writer_flag interrupted_;
+    shared_offset read_total_;       // by the reader thread
+    shared_offset write_total_;      // by the writer thread
+    boost::detail::atomic_count reader_waits_;
+    boost::detail::atomic_count writer_waits_;
+    boost::detail::atomic_count max_filled_;
+    bool stored_;
+    ExceptionStorage* except_ptr_;
+
+    void do_run() // virtual
+    {
+        boost::thread reader(
+            boost::bind(&bg_pipelined_copy_impl::read_loop, this));
+
+        write_loop();
+        reader.join();
+
+        done_.set();
+    }
+
+    bool do_done() // virtual
+    {
+        return done_.get();
+    }
+
+    std::streamsize do_total() // virtual
+    {
+        return static_cast<std::streamsize>(write_total_.load());
+    }
+
+    background_copy_statistics do_statistics() // virtual
+    {
+        background_copy_statistics stat;
+        stat.read_total = static_cast<std::streamsize>(read_total_.load());
+        stat.write_total = static_cast<std::streamsize>(write_total_.load());
+        stat.reader_waits = static_cast<long>(reader_waits_);
+        stat.writer_waits = static_cast<long>(writer_waits_);
+        stat.max_filled_buffers =
+            static_cast<std::size_t>(static_cast<long>(max_filled_));
+        return stat;
+    }
+
+    void do_stop() // virtual
+    {
+        interrupted_.set();
+        event_.notify();
+    }
+
+    // the first exception stops both threads
+    bool stopped()
+    {
+        return interrupted_.get() || read_failed_.get() || write_failed_.get();
+    }
+
+    bool can_read()
+    {
+        return (ring_.size() != ring_.slot_count()) || stopped();
+    }
+
+    bool can_write()
+    {
+        return (ring_.size() != 0) || eof_.get() || stopped();
+    }
+
+    void store_exception()
+    {
+        boost::mutex::scoped_lock locking(except_mutex_);
+        if (!stored_)
+        {
+            except_ptr_->store();
+            stored_ = true;
+        }
+    }
+
+    void read_loop()
+    {
+        try
+        {
+            boost::iostreams::stream_offset total = 0;
+            while (!stopped())
+            {
+                char_type* s = ring_.write_slot();
+                if (!s)
+                {
+                    ++reader_waits_;
+                    event_.wait(
+                        boost::bind(&bg_pipelined_copy_impl::can_read, this));
+                    continue;
+                }
+
+                // only the reader touches the slot until commit()
+                std::streamsize amt =
+                    boost::iostreams::read(src_, s, ring_.slot_size());
+
+                if (amt == -1)
+                {
+                    boost::iostreams::close(src_, BOOST_IOS::in);
+                    eof_.set();
+                    break;
+                }
+                else if (amt == 0)
+                    continue;
+
+                ring_.commit(amt);
+                total += amt;
+                read_total_.store(total);
+
+                long filled = static_cast<long>(ring_.size());
+                while (static_cast<long>(max_filled_) < filled)
+                    ++max_filled_;
+
+                event_.notify();
+            }
+        }
+        catch (...)
+        {
+            store_exception();
+            read_failed_.set();
+        }
+        event_.notify();
+    }
+
+    void write_loop()
+    {
+        try
+        {
+            boost::iostreams::stream_offset total = 0;
+            while (!stopped())
+            {
+                std::streamsize size;
+                const char_type* s = ring_.read_slot(size);
+                if (!s)
+                {
+                    // the last slot is committed before eof_ is set
+                    if (eof_.get())
+                    {
+                        if (ring_.size() == 0)
+                        {
+                            boost::iostreams::close(sink_, BOOST_IOS::out);
+                            break;
+                        }
+                        continue;
+                    }
+
+                    ++writer_waits_;
+                    event_.wait(
+                        boost::bind(&bg_pipelined_copy_impl::can_write, this));
+                    continue;
+                }
+
+                // only the writer touches the slot until release()
+                while (size > 0)
+                {
+                    std::streamsize amt =
+                        boost::iostreams::write(sink_, s, size);
+                    s += amt;
+                    size -= amt;
+
+                    total += amt;
+                    write_total_.store(total);
+                    if (interrupted_.get())
+                        return;
+                }
+
+                ring_.release();
+                event_.notify();
+            }
+        }
+        catch (...)
+        {
+            store_exception();
+            write_failed_.set();
+            event_.notify();
+        }
+    }
+};
+
 } // namespace detail
 
 template<class ExceptionStorage=hamigaki::thread::exception_storage>
@@ -195,11 +455,32 @@ public:
         pimpl_.reset(new impl_type(
             src, sink, buffer_size, except()));
 
-        thread_ptr_.reset(
-            new boost::thread(
-                boost::bind(&detail::bg_copy_base::run, pimpl_.get())
-            )
-        );
+        start();
+    }
+
+    // reads and writes concurrently with a ring of "buffer_count" buffers
+    template<typename Source, typename Sink>
+    basic_background_copy(const Source& src, const Sink& sink,
+        std::streamsize buffer_size, std::size_t buffer_count)
+    {
+        if (buffer_count >= 2)
+        {
+            typedef detail::bg_pipelined_copy_impl<
+                Source,Sink,ExceptionStorage> impl_type;
+
+            pimpl_.reset(new impl_type(
+                src, sink, buffer_size, buffer_count, except()));
+        }
+        else
+        {
+            typedef detail::bg_copy_impl<
+                Source,Sink,ExceptionStorage> impl_type;
+
+            pimpl_.reset(new impl_type(
+                src, sink, buffer_size, except()));
+        }
+
+        start();
     }
 
     ~basic_background_copy()
@@ -248,6 +529,11 @@ public:
         return pimpl_->total();
     }
 
+    background_copy_statistics statistics()
+    {
+        return pimpl_->statistics();
+    }
+
     const ExceptionStorage& exception() const
     {
 #if BOOST_WORKAROUND(__BORLANDC__, BOOST_TESTED_AT(0x582))
@@ -264,6 +550,15 @@ private:
     ExceptionStorage except_;
 #endif
 
+    void start()
+    {
+        thread_ptr_.reset(
+            new boost::thread(
+                boost::bind(&detail::bg_copy_base::run, pimpl_.get())
+            )
+        );
+    }
+
     ExceptionStorage& except()
     {
 #if BOOST_WORKAROUND(__BORLANDC__, BOOST_TESTED_AT(0x582))
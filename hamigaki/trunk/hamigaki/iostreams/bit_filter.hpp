@@ -11,9 +11,13 @@
 #define HAMIGAKI_IOSTREAMS_BIT_FILTER_HPP
 
 #include <boost/iostreams/detail/error.hpp>
+#include <boost/assert.hpp>
 #include <boost/iostreams/read.hpp>
 #include <boost/iostreams/write.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/shared_array.hpp>
+#include <algorithm>
+#include <cstring>
 
 namespace hamigaki { namespace iostreams {
 
@@ -26,6 +30,9 @@ enum bit_flow
 template<bit_flow Flow>
 struct bit_stream_traits;
 
+// The first bit in the stream is the most significant bit of
+// the reservoir and of the values of read_bits()/write_bits().
+// order() converts a byte between the stream order and that order.
 template<>
 struct bit_stream_traits<left_to_right>
 {
@@ -37,6 +44,11 @@ struct bit_stream_traits<left_to_right>
         };
         return m[bit];
     }
+
+    static unsigned char order(unsigned char c)
+    {
+        return c;
+    }
 };
 
 template<>
@@ -50,8 +62,22 @@ struct bit_stream_traits<right_to_left>
         };
         return m[bit];
     }
+
+    // reverses the bits
+    static unsigned char order(unsigned char c)
+    {
+        static const unsigned char table[] =
+        {
+            0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE,
+            0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF
+        };
+        return static_cast<unsigned char>(
+            (table[c & 0x0F] << 4) | table[c >> 4]);
+    }
 };
 
+// The reservoir of 64 bits is refilled from the buffer a byte at a time,
+// so that read_bits(), peek_bits() and skip_bits() do not loop per bit.
 template<bit_flow Flow>
 class input_bit_filter
 {
@@ -60,55 +86,161 @@ public:
 
     static const std::size_t buffer_size = 4096;
 
+    // the maximum number of bits for read_bits() and peek_bits()
+    static const std::size_t max_peek_bits = 32;
+
     input_bit_filter()
-        : buffer_(new char[buffer_size]), size_(0), index_(0), bit_(0)
+        : buffer_(new char[buffer_size])
+        , size_(0), index_(0), bits_(0), count_(0), eof_(false)
     {
     }
 
     template<class Source>
     bool get_bit(Source& src)
     {
-        if (index_ == size_)
+        return this->read_bits(src, 1) != 0;
+    }
+
+    template<class Source>
+    unsigned read_bits(Source& src, std::size_t bit_count)
+    {
+        BOOST_ASSERT(bit_count <= max_peek_bits);
+
+        if (bit_count == 0)
+            return 0;
+
+        if (count_ < bit_count)
         {
-            while (true)
-            {
-                std::streamsize amt =
-                    boost::iostreams::read(src, buffer_.get(), buffer_size);
-                if (amt == -1)
-                    throw boost::iostreams::detail::bad_read();
-                else if (amt)
-                {
-                    size_ = amt;
-                    index_ = 0;
-                    bit_ = 0;
-                    break;
-                }
-            }
+            this->fill(src);
+            if (count_ < bit_count)
+                throw boost::iostreams::detail::bad_read();
         }
 
-        bool result = (buffer_[index_] & traits_type::mask(bit_)) != 0;
-        if (++bit_ == 8)
+        unsigned result = static_cast<unsigned>(bits_ >> (64 - bit_count));
+        bits_ <<= bit_count;
+        count_ -= bit_count;
+        return result;
+    }
+
+    // returns the next bit_count bits without consuming them
+    // the bits after the end of the stream are read as zero
+    template<class Source>
+    unsigned peek_bits(Source& src, std::size_t bit_count)
+    {
+        BOOST_ASSERT(bit_count <= max_peek_bits);
+
+        if (bit_count == 0)
+            return 0;
+
+        if (count_ < bit_count)
+            this->fill(src);
+
+        return static_cast<unsigned>(bits_ >> (64 - bit_count));
+    }
+
+    template<class Source>
+    void skip_bits(Source& src, std::size_t bit_count)
+    {
+        while (bit_count > max_peek_bits)
         {
-            bit_ = 0;
-            ++index_;
+            this->read_bits(src, max_peek_bits);
+            bit_count -= max_peek_bits;
         }
-        return result;
+        this->read_bits(src, bit_count);
+    }
+
+    // discards the bits up to the next byte boundary
+    void align()
+    {
+        std::size_t n = count_ % 8;
+        bits_ <<= n;
+        count_ -= n;
     }
 
+    // reads the bytes after align()
+    // returns -1 at the end of the stream like boost::iostreams::read()
     template<class Source>
-    unsigned read_bits(Source& src, std::size_t bit_count)
+    std::streamsize read_bytes(Source& src, char* s, std::streamsize n)
     {
-        unsigned tmp = 0;
-        while (bit_count--)
-            tmp |= (static_cast<unsigned>(this->get_bit(src)) << bit_count);
-        return tmp;
+        BOOST_ASSERT(count_ % 8 == 0);
+
+        std::streamsize total = 0;
+        while ((total < n) && (count_ != 0))
+        {
+            s[total++] = static_cast<char>(traits_type::order(
+                static_cast<unsigned char>(bits_ >> 56)));
+            bits_ <<= 8;
+            count_ -= 8;
+        }
+
+        std::streamsize amt = (std::min)(
+            n - total, static_cast<std::streamsize>(size_ - index_));
+        std::memcpy(s + total, buffer_.get() + index_, amt);
+        index_ += static_cast<std::size_t>(amt);
+        total += amt;
+
+        while ((total < n) && !eof_)
+        {
+            amt = boost::iostreams::read(src, s + total, n - total);
+            if (amt == -1)
+                eof_ = true;
+            else
+                total += amt;
+        }
+
+        return (total != 0 || n == 0) ? total : -1;
     }
 
 private:
     boost::shared_array<char> buffer_;
     std::size_t size_;
     std::size_t index_;
-    std::size_t bit_;
+
+    // the bits after the first count_ bits are zero
+    boost::uint64_t bits_;
+    std::size_t count_;
+    bool eof_;
+
+    // makes more than 56 bits available unless the end of the stream
+    template<class Source>
+    void fill(Source& src)
+    {
+        while (count_ <= 56)
+        {
+            if (index_ == size_)
+            {
+                if (eof_ || !this->read_buffer(src))
+                    break;
+            }
+
+            unsigned char c = static_cast<unsigned char>(buffer_[index_++]);
+            bits_ |=
+                static_cast<boost::uint64_t>(traits_type::order(c)) <<
+                (56 - count_);
+            count_ += 8;
+        }
+    }
+
+    template<class Source>
+    bool read_buffer(Source& src)
+    {
+        while (true)
+        {
+            std::streamsize amt =
+                boost::iostreams::read(src, buffer_.get(), buffer_size);
+            if (amt == -1)
+            {
+                eof_ = true;
+                return false;
+            }
+            else if (amt)
+            {
+                size_ = static_cast<std::size_t>(amt);
+                index_ = 0;
+                return true;
+            }
+        }
+    }
 };
 
 
@@ -121,24 +253,26 @@ public:
     static const std::size_t buffer_size = 4096;
 
     output_bit_filter()
-        : buffer_(new char[buffer_size]), index_(0), bit_(0)
+        : buffer_(new char[buffer_size]), index_(0), bits_(0), count_(0)
     {
-        std::memset(buffer_.get(), 0, buffer_size);
     }
 
+    // the last byte is padded with zero bits
     template<class Sink>
     void flush(Sink& sink)
     {
-        if (bit_ != 0)
+        this->drain(sink);
+
+        if (count_ != 0)
         {
-            bit_ = 0;
-            ++index_;
+            this->put_byte(sink, static_cast<unsigned char>(bits_ >> 56));
+            bits_ = 0;
+            count_ = 0;
         }
 
         if (index_ != 0)
         {
             boost::iostreams::write(sink, buffer_.get(), index_);
-            std::memset(buffer_.get(), 0, index_);
             index_ = 0;
         }
     }
@@ -146,32 +280,77 @@ public:
     template<class Sink>
     void put_bit(Sink& sink, bool bit)
     {
-        if (bit)
-            buffer_[index_] |= traits_type::mask(bit_);
-
-        if (++bit_ == 8)
-        {
-            bit_ = 0;
-            if (++index_ == buffer_size)
-            {
-                boost::iostreams::write(sink, buffer_.get(), buffer_size);
-                std::memset(buffer_.get(), 0, buffer_size);
-                index_ = 0;
-            }
-        }
+        this->write_bits(sink, bit ? 1u : 0u, 1);
     }
 
     template<class Sink>
     void write_bits(Sink& sink, unsigned bits, std::size_t bit_count)
     {
-        while (bit_count--)
-            this->put_bit(sink, ((bits >> bit_count) & 1) != 0);
+        BOOST_ASSERT(bit_count <= 32);
+
+        if (bit_count == 0)
+            return;
+
+        if (count_ + bit_count > 64)
+            this->drain(sink);
+
+        boost::uint64_t mask =
+            (static_cast<boost::uint64_t>(1) << bit_count) - 1;
+        bits_ |= (static_cast<boost::uint64_t>(bits) & mask) <<
+            (64 - count_ - bit_count);
+        count_ += bit_count;
+    }
+
+    // writes the bytes on a byte boundary
+    template<class Sink>
+    void write_bytes(Sink& sink, const char* s, std::streamsize n)
+    {
+        BOOST_ASSERT(count_ % 8 == 0);
+
+        this->drain(sink);
+
+        std::streamsize amt = (std::min)(
+            n, static_cast<std::streamsize>(buffer_size - index_));
+        std::memcpy(buffer_.get() + index_, s, amt);
+        index_ += static_cast<std::size_t>(amt);
+        if (amt == n)
+            return;
+
+        boost::iostreams::write(sink, buffer_.get(), buffer_size);
+        index_ = 0;
+        boost::iostreams::write(sink, s + amt, n - amt);
     }
 
 private:
     boost::shared_array<char> buffer_;
     std::size_t index_;
-    std::size_t bit_;
+
+    // the bits after the first count_ bits are zero
+    boost::uint64_t bits_;
+    std::size_t count_;
+
+    template<class Sink>
+    void put_byte(Sink& sink, unsigned char c)
+    {
+        buffer_[index_] = static_cast<char>(traits_type::order(c));
+        if (++index_ == buffer_size)
+        {
+            boost::iostreams::write(sink, buffer_.get(), buffer_size);
+            index_ = 0;
+        }
+    }
+
+    // moves the whole bytes in the reservoir to the buffer
+    template<class Sink>
+    void drain(Sink& sink)
+    {
+        while (count_ >= 8)
+        {
+            this->put_byte(sink, static_cast<unsigned char>(bits_ >> 56));
+            bits_ <<= 8;
+            count_ -= 8;
+        }
+    }
 };
 
 } } // End namespaces iostreams, hamigaki.
@@ -33,6 +33,16 @@ public:
         return filter_.read_bits(src_, bit_count);
     }
 
+    unsigned peek_bits(std::size_t bit_count)
+    {
+        return filter_.peek_bits(src_, bit_count);
+    }
+
+    void skip_bits(std::size_t bit_count)
+    {
+        filter_.skip_bits(src_, bit_count);
+    }
+
 private:
     input_bit_filter<Flow>& filter_;
     Source& src_;
@@ -0,0 +1,291 @@
+// bzip2_block.hpp: utilities for the independent bzip2 blocks
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/iostreams for library home page.
+
+#ifndef HAMIGAKI_IOSTREAMS_DETAIL_BZIP2_BLOCK_HPP
+#define HAMIGAKI_IOSTREAMS_DETAIL_BZIP2_BLOCK_HPP
+
+#include <boost/iostreams/detail/ios.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+#include <bzlib.h>
+
+namespace hamigaki { namespace iostreams { namespace detail {
+
+// The bzip2 stream is "BZh" + the block size ('1'-'9'),
+// the blocks which begin with the 48bit magic 0x314159265359 and
+// the end of stream marker 0x177245385090 + the combined CRC.
+// The blocks are not aligned to the byte boundary.
+
+const boost::uint64_t bzip2_magic_mask =
+    (static_cast<boost::uint64_t>(0xFFFFu) << 32) | 0xFFFFFFFFu;
+
+const boost::uint64_t bzip2_block_magic =
+    (static_cast<boost::uint64_t>(0x3141u) << 32) | 0x59265359u;
+
+const boost::uint64_t bzip2_end_magic =
+    (static_cast<boost::uint64_t>(0x1772u) << 32) | 0x45385090u;
+
+struct bzip2_marker
+{
+    enum kind_type { block, end_of_stream };
+
+    kind_type kind;
+
+    // the position of the magic in bits
+    boost::uint64_t bit_offset;
+
+    // the block size of the stream ('1'-'9')
+    char level;
+};
+
+// finds the block magics and the end of stream markers
+class bzip2_marker_scanner
+{
+public:
+    bzip2_marker_scanner() : window_(0), prev_(0), bytes_(0), level_('9')
+    {
+    }
+
+    void scan(
+        const char* s, std::size_t n, std::vector<bzip2_marker>& markers)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            prev_ = (prev_ << 8) |
+                static_cast<boost::uint32_t>(window_ >> 56);
+            window_ = (window_ << 8) | static_cast<unsigned char>(s[i]);
+            ++bytes_;
+
+            if (bytes_ < 6)
+                continue;
+
+            for (unsigned shift = 0; shift < 8; ++shift)
+            {
+                if (bytes_*8 < 48 + shift)
+                    break;
+
+                boost::uint64_t w = (window_ >> shift) & bzip2_magic_mask;
+                if (w == bzip2_block_magic)
+                {
+                    if (shift == 0)
+                        check_stream_header();
+                    push(markers, bzip2_marker::block, shift);
+                }
+                else if (w == bzip2_end_magic)
+                    push(markers, bzip2_marker::end_of_stream, shift);
+            }
+        }
+    }
+
+    // the number of the scanned bytes
+    boost::uint64_t position() const
+    {
+        return bytes_;
+    }
+
+private:
+    boost::uint64_t window_;
+    boost::uint32_t prev_;
+    boost::uint64_t bytes_;
+    char level_;
+
+    // the stream header just precedes the first block
+    void check_stream_header()
+    {
+        if (bytes_ < 10)
+            return;
+
+        boost::uint32_t head =
+            ((prev_ & 0xFFFFu) << 16) |
+            static_cast<boost::uint32_t>(window_ >> 48);
+
+        char level = static_cast<char>(head & 0xFFu);
+        if (((head >> 8) == 0x425A68u) && (level >= '1') && (level <= '9'))
+            level_ = level;
+    }
+
+    void push(
+        std::vector<bzip2_marker>& markers,
+        bzip2_marker::kind_type kind, unsigned shift)
+    {
+        bzip2_marker m;
+        m.kind = kind;
+        m.bit_offset = bytes_*8 - shift - 48;
+        m.level = level_;
+        markers.push_back(m);
+    }
+};
+
+// reads the bits [pos, pos+n) in MSB-first order (n <= 32)
+inline boost::uint32_t read_bzip2_bits(
+    const char* data, boost::uint64_t pos, unsigned n)
+{
+    boost::uint32_t value = 0;
+    for (unsigned i = 0; i < n; ++i, ++pos)
+    {
+        unsigned char c = static_cast<unsigned char>(data[pos/8]);
+        value = (value << 1) | ((c >> (7 - pos%8)) & 1u);
+    }
+    return value;
+}
+
+inline boost::uint32_t bzip2_combine_crc(
+    boost::uint32_t combined, boost::uint32_t block_crc)
+{
+    return ((combined << 1) | (combined >> 31)) ^ block_crc;
+}
+
+class bzip2_bit_writer
+{
+public:
+    explicit bzip2_bit_writer(std::string& out)
+        : out_(out), bits_(0), count_(0)
+    {
+    }
+
+    void put_bits(boost::uint32_t value, unsigned n)
+    {
+        while (n--)
+        {
+            bits_ = (bits_ << 1) | ((value >> n) & 1u);
+            if (++count_ == 8)
+            {
+                out_ += static_cast<char>(static_cast<unsigned char>(bits_));
+                bits_ = 0;
+                count_ = 0;
+            }
+        }
+    }
+
+    // copies the bits [first, last) of data
+    void copy_bits(
+        const char* data, boost::uint64_t first, boost::uint64_t last)
+    {
+        const unsigned char* s = reinterpret_cast<const unsigned char*>(data);
+
+        if (count_ == 0)
+        {
+            out_.reserve(out_.size() + static_cast<std::size_t>(last-first)/8);
+
+            unsigned shift = static_cast<unsigned>(first % 8);
+            while (last - first >= 8)
+            {
+                std::size_t i = static_cast<std::size_t>(first / 8);
+                unsigned c = s[i];
+                if (shift != 0)
+                    c = ((c << shift) | (s[i+1] >> (8 - shift))) & 0xFFu;
+                out_ += static_cast<char>(static_cast<unsigned char>(c));
+                first += 8;
+            }
+        }
+
+        for ( ; first < last; ++first)
+            put_bits((s[first/8] >> (7 - first%8)) & 1u, 1);
+    }
+
+    void flush()
+    {
+        if (count_ != 0)
+            put_bits(0, 8 - count_);
+    }
+
+private:
+    std::string& out_;
+    unsigned bits_;
+    unsigned count_;
+};
+
+class bzip2_block_decoder : private boost::noncopyable
+{
+public:
+    bzip2_block_decoder()
+    {
+    }
+
+    // decodes the block [first, last) of data as a single block stream
+    // returns false if the block is broken
+    bool decode(
+        const char* data, boost::uint64_t first, boost::uint64_t last,
+        char level, std::string& out, boost::uint32_t& crc)
+    {
+        if (last - first < 80)
+            return false;
+
+        crc = read_bzip2_bits(data, first + 48, 32);
+
+        stream_.clear();
+        stream_ += "BZh";
+        stream_ += level;
+
+        bzip2_bit_writer writer(stream_);
+        writer.copy_bits(data, first, last);
+        writer.put_bits(
+            static_cast<boost::uint32_t>(bzip2_end_magic >> 32), 16);
+        writer.put_bits(static_cast<boost::uint32_t>(bzip2_end_magic), 32);
+        writer.put_bits(crc, 32);
+        writer.flush();
+
+        return decompress(level, out);
+    }
+
+private:
+    std::string stream_;
+
+    bool decompress(char level, std::string& out)
+    {
+        ::bz_stream bs;
+        std::memset(&bs, 0, sizeof(bs));
+        if (::BZ2_bzDecompressInit(&bs, 0, 0) != BZ_OK)
+            throw BOOST_IOSTREAMS_FAILURE("failed to initialize bzip2");
+
+        out.resize(static_cast<std::size_t>(level - '0') * 100000 + 1024);
+
+        bs.next_in = const_cast<char*>(stream_.data());
+        bs.avail_in = static_cast<unsigned>(stream_.size());
+        bs.next_out = &out[0];
+        bs.avail_out = static_cast<unsigned>(out.size());
+
+        int ret;
+        while (true)
+        {
+            ret = ::BZ2_bzDecompress(&bs);
+            if (ret != BZ_OK)
+                break;
+
+            if (bs.avail_out == 0)
+            {
+                std::size_t size = out.size();
+                out.resize(size*2);
+                bs.next_out = &out[size];
+                bs.avail_out = static_cast<unsigned>(out.size() - size);
+            }
+            else if (bs.avail_in == 0)
+                break;
+        }
+
+        std::size_t total = out.size() - bs.avail_out;
+        ::BZ2_bzDecompressEnd(&bs);
+
+        if (ret == BZ_MEM_ERROR)
+            throw std::bad_alloc();
+        else if (ret != BZ_STREAM_END)
+            return false;
+
+        out.resize(total);
+        return true;
+    }
+};
+
+} } } // End namespaces detail, iostreams, hamigaki.
+
+#endif // HAMIGAKI_IOSTREAMS_DETAIL_BZIP2_BLOCK_HPP
@@ -0,0 +1,226 @@
+// spsc_ring.hpp: single-producer single-consumer ring of buffers
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/iostreams for library home page.
+
+#ifndef HAMIGAKI_IOSTREAMS_DETAIL_SPSC_RING_HPP
+#define HAMIGAKI_IOSTREAMS_DETAIL_SPSC_RING_HPP
+
+#include <boost/config.hpp>
+
+#ifdef BOOST_MSVC
+    #pragma warning(push)
+    #pragma warning(disable : 4251)
+#endif
+
+#include <boost/thread/condition.hpp>
+
+#ifdef BOOST_MSVC
+    #pragma warning(pop)
+#endif
+
+#include <boost/detail/atomic_count.hpp>
+#include <boost/iostreams/positioning.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/assert.hpp>
+#include <boost/noncopyable.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace hamigaki { namespace iostreams { namespace detail {
+
+// a flag changed by one thread and polled by the other threads
+// (boost::detail::atomic_count is a lock-free counter on the major
+// platforms, and the value of this counter is always 0 or 1)
+class single_writer_flag : boost::noncopyable
+{
+public:
+    single_writer_flag() : value_(0)
+    {
+    }
+
+    void set()
+    {
+        if (!get())
+            ++value_;
+    }
+
+    void clear()
+    {
+        if (get())
+            --value_;
+    }
+
+    bool get() const
+    {
+        return static_cast<long>(value_) != 0;
+    }
+
+private:
+    boost::detail::atomic_count value_;
+};
+
+// a stream offset shared by the threads
+class shared_offset : boost::noncopyable
+{
+public:
+    shared_offset() : value_(0)
+    {
+    }
+
+    void store(boost::iostreams::stream_offset n)
+    {
+        boost::mutex::scoped_lock locking(mutex_);
+        value_ = n;
+    }
+
+    boost::iostreams::stream_offset load() const
+    {
+        boost::mutex::scoped_lock locking(mutex_);
+        return value_;
+    }
+
+private:
+    mutable boost::mutex mutex_;
+    boost::iostreams::stream_offset value_;
+};
+
+// wakes the threads waiting for the shared state;
+// no wakeup is lost if the state is changed before notify()
+class state_event : boost::noncopyable
+{
+public:
+    void notify()
+    {
+        boost::mutex::scoped_lock locking(mutex_);
+        cond_.notify_all();
+    }
+
+    template<class Predicate>
+    void wait(Predicate pred)
+    {
+        boost::mutex::scoped_lock locking(mutex_);
+        while (!pred())
+            cond_.wait(locking);
+    }
+
+private:
+    boost::mutex mutex_;
+    boost::condition cond_;
+};
+
+// A ring of the fixed size slots shared by a producer and a consumer.
+// Only the slot counters are shared, so that neither side takes a lock:
+// write_slot() returns 0 if the ring is full, and read_slot() returns 0
+// if the ring is empty. Use state_event to wait for the other side.
+template<class CharT>
+class spsc_ring : boost::noncopyable
+{
+public:
+    // the storage is rounded up to a power of two slots,
+    // so that the wrap-around of the counters keeps the slot indices
+    spsc_ring(std::streamsize slot_size, std::size_t slot_count)
+        : slot_size_(slot_size), slot_count_(slot_count)
+        , mask_(round_up(slot_count) - 1)
+        , buffer_(static_cast<std::size_t>(slot_size) * (mask_ + 1))
+        , sizes_(mask_ + 1), written_(0), read_(0)
+    {
+        BOOST_ASSERT(slot_size > 0);
+        BOOST_ASSERT(slot_count > 0);
+    }
+
+    std::streamsize slot_size() const
+    {
+        return slot_size_;
+    }
+
+    std::size_t slot_count() const
+    {
+        return slot_count_;
+    }
+
+    // the number of the filled slots
+    std::size_t size() const
+    {
+        return static_cast<std::size_t>(
+            static_cast<unsigned long>(static_cast<long>(written_)) -
+            static_cast<unsigned long>(static_cast<long>(read_)));
+    }
+
+    // the producer side
+    CharT* write_slot()
+    {
+        if (size() == slot_count())
+            return 0;
+        return slot(static_cast<long>(written_));
+    }
+
+    void commit(std::streamsize n)
+    {
+        BOOST_ASSERT((n > 0) && (n <= slot_size_));
+        BOOST_ASSERT(size() != slot_count());
+
+        sizes_[index(static_cast<long>(written_))] = n;
+        ++written_;
+    }
+
+    // the consumer side
+    const CharT* read_slot(std::streamsize& n)
+    {
+        if (size() == 0)
+            return 0;
+
+        long pos = read_;
+        n = sizes_[index(pos)];
+        return slot(pos);
+    }
+
+    void release()
+    {
+        BOOST_ASSERT(size() != 0);
+        ++read_;
+    }
+
+    // discards all slots; neither side may access the ring
+    void clear()
+    {
+        while (size() != 0)
+            ++read_;
+    }
+
+private:
+    std::streamsize slot_size_;
+    std::size_t slot_count_;
+    std::size_t mask_;
+    std::vector<CharT> buffer_;
+    std::vector<std::streamsize> sizes_;
+    boost::detail::atomic_count written_;
+    boost::detail::atomic_count read_;
+
+    static std::size_t round_up(std::size_t n)
+    {
+        std::size_t result = 1;
+        while (result < n)
+            result <<= 1;
+        return result;
+    }
+
+    std::size_t index(long pos) const
+    {
+        return static_cast<std::size_t>(
+            static_cast<unsigned long>(pos)) & mask_;
+    }
+
+    CharT* slot(long pos)
+    {
+        return &buffer_[index(pos) * static_cast<std::size_t>(slot_size_)];
+    }
+};
+
+} } } // End namespaces detail, iostreams, hamigaki.
+
+#endif // HAMIGAKI_IOSTREAMS_DETAIL_SPSC_RING_HPP
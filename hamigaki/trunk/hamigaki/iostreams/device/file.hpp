@@ -11,6 +11,7 @@
 #define HAMIGAKI_IOSTREAMS_DEVICE_FILE_HPP
 
 #include <hamigaki/iostreams/catable.hpp>
+#include <hamigaki/iostreams/skip.hpp>
 #include <boost/iostreams/categories.hpp>
 #include <boost/iostreams/positioning.hpp>
 #include <boost/shared_ptr.hpp>
@@ -19,6 +20,13 @@
 #include <cstring>
 #include <limits>
 #include <string>
+#include <vector>
+
+#if defined(BOOST_WINDOWS)
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
 
 namespace hamigaki { namespace iostreams {
 
@@ -101,8 +109,54 @@ public:
         return boost::iostreams::offset_to_position(std::ftell(fp_));
     }
 
+    // reads and discards the data if the file cannot seek (e.g. pipe)
+    void skip(boost::iostreams::stream_offset off)
+    {
+        typedef boost::iostreams::stream_offset off_t;
+        const off_t max_step = (std::numeric_limits<long>::max)();
+
+        while (off > 0)
+        {
+            long step = static_cast<long>((std::min)(off, max_step));
+            if (std::fseek(fp_, step, SEEK_CUR) != 0)
+                break;
+            off -= step;
+        }
+
+        if (off > 0)
+            read_through(off);
+    }
+
+    // the file position is not changed
+    void truncate(boost::iostreams::stream_offset size)
+    {
+        if (std::fflush(fp_) != 0)
+            throw BOOST_IOSTREAMS_FAILURE("bad truncate");
+
+#if defined(BOOST_WINDOWS)
+        if (::_chsize_s(::_fileno(fp_), static_cast<__int64>(size)) != 0)
+#else
+        if (::ftruncate(::fileno(fp_), static_cast< ::off_t>(size)) != 0)
+#endif
+            throw BOOST_IOSTREAMS_FAILURE("bad truncate");
+    }
+
 private:
     std::FILE* fp_;
+    std::vector<char> skip_buffer_;
+
+    void read_through(boost::iostreams::stream_offset off)
+    {
+        detail::resize_skip_buffer(skip_buffer_, off);
+        while (off > 0)
+        {
+            std::size_t size = hamigaki::auto_min(skip_buffer_.size(), off);
+            std::size_t amt = std::fread(&skip_buffer_[0], 1, size, fp_);
+            if (amt == 0)
+                throw BOOST_IOSTREAMS_FAILURE("bad skip offset");
+            off -= static_cast<boost::iostreams::stream_offset>(amt);
+        }
+    }
 };
 
 } // namespace detail
@@ -119,6 +173,7 @@ public:
         : public boost::iostreams::input_seekable
         , public boost::iostreams::device_tag
         , public boost::iostreams::closable_tag
+        , public skippable_tag
     {};
 
     file_source()
@@ -153,6 +208,11 @@ public:
         return pimpl_->seek(off, way);
     }
 
+    void skip(boost::iostreams::stream_offset off)
+    {
+        pimpl_->skip(off);
+    }
+
     void close()
     {
         pimpl_.reset();
@@ -229,6 +289,7 @@ public:
         : public boost::iostreams::seekable
         , public boost::iostreams::device_tag
         , public boost::iostreams::closable_tag
+        , public skippable_tag
     {};
 
     file()
@@ -271,6 +332,16 @@ public:
         return pimpl_->seek(off, way);
     }
 
+    void skip(boost::iostreams::stream_offset off)
+    {
+        pimpl_->skip(off);
+    }
+
+    void truncate(boost::iostreams::stream_offset size)
+    {
+        pimpl_->truncate(size);
+    }
+
     void close()
     {
         pimpl_.reset();
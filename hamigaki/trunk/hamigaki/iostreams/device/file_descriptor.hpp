@@ -13,6 +13,7 @@
 #include <hamigaki/iostreams/detail/config.hpp>
 #include <hamigaki/iostreams/detail/auto_link.hpp>
 #include <hamigaki/iostreams/catable.hpp>
+#include <hamigaki/iostreams/skip.hpp>
 #include <boost/iostreams/detail/ios.hpp>
 #include <boost/iostreams/categories.hpp>
 #include <boost/iostreams/positioning.hpp>
@@ -49,6 +50,7 @@ public:
         : public boost::iostreams::device_tag
         , public boost::iostreams::input_seekable
         , public boost::iostreams::closable_tag
+        , public skippable_tag
     {};
 
     file_descriptor_source()
@@ -74,6 +76,9 @@ public:
     std::streampos seek(
         boost::iostreams::stream_offset off, BOOST_IOS::seekdir way);
 
+    // discards the data without copying if the file cannot seek (e.g. pipe)
+    void skip(boost::iostreams::stream_offset off);
+
     void close()
     {
         pimpl_.reset();
@@ -141,6 +146,7 @@ public:
         : public boost::iostreams::device_tag
         , public boost::iostreams::seekable
         , public boost::iostreams::closable_tag
+        , public skippable_tag
     {};
 
     file_descriptor()
@@ -169,6 +175,12 @@ public:
     std::streampos seek(
         boost::iostreams::stream_offset off, BOOST_IOS::seekdir way);
 
+    // discards the data without copying if the file cannot seek (e.g. pipe)
+    void skip(boost::iostreams::stream_offset off);
+
+    // the file position is not changed
+    void truncate(boost::iostreams::stream_offset size);
+
     void close()
     {
         pimpl_.reset();
@@ -0,0 +1,128 @@
+// mapped_file.hpp: read-only memory-mapped file device
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/iostreams for library home page.
+
+#ifndef HAMIGAKI_IOSTREAMS_DEVICE_MAPPED_FILE_HPP
+#define HAMIGAKI_IOSTREAMS_DEVICE_MAPPED_FILE_HPP
+
+#include <hamigaki/iostreams/detail/config.hpp>
+#include <hamigaki/iostreams/detail/auto_link.hpp>
+#include <hamigaki/iostreams/catable.hpp>
+#include <boost/iostreams/detail/ios.hpp>
+#include <boost/iostreams/categories.hpp>
+#include <boost/iostreams/positioning.hpp>
+#include <boost/shared_ptr.hpp>
+#include <cstddef>
+#include <string>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+    #include BOOST_ABI_PREFIX
+#endif
+
+#ifdef BOOST_MSVC
+    #pragma warning(push)
+    #pragma warning(disable : 4251)
+#endif
+
+namespace hamigaki { namespace iostreams {
+
+namespace detail
+{
+
+class HAMIGAKI_IOSTREAMS_DECL mapped_file_impl;
+
+} // namespace detail
+
+// the expected access pattern of the mapped pages
+struct map_advice
+{
+    enum values
+    {
+        normal,
+        sequential,
+        random,
+        will_need
+    };
+};
+
+// A seekable Source reading the whole file through a read-only mapping.
+// The copies share the mapping and the position like file_descriptor_source.
+// data() is valid until the last copy is closed, so that the archive readers
+// can take the contents of the stored entries without copying.
+class HAMIGAKI_IOSTREAMS_DECL mapped_file_source
+{
+private:
+    typedef detail::mapped_file_impl impl_type;
+
+public:
+    typedef char char_type;
+
+    struct category
+        : public boost::iostreams::device_tag
+        , public boost::iostreams::input_seekable
+        , public boost::iostreams::closable_tag
+    {};
+
+    mapped_file_source()
+    {
+    }
+
+    explicit mapped_file_source(
+        const std::string& filename,
+        map_advice::values advice=map_advice::normal)
+    {
+        this->open(filename, advice);
+    }
+
+    void open(
+        const std::string& filename,
+        map_advice::values advice=map_advice::normal);
+
+    bool is_open() const
+    {
+        return pimpl_.get() != 0;
+    }
+
+    std::streamsize read(char* s, std::streamsize n);
+
+    std::streampos seek(
+        boost::iostreams::stream_offset off, BOOST_IOS::seekdir way);
+
+    void close()
+    {
+        pimpl_.reset();
+    }
+
+    // the hint for the whole file
+    void advise(map_advice::values advice);
+
+    // the hint for the range [off, off+n)
+    void advise(
+        boost::iostreams::stream_offset off, std::size_t n,
+        map_advice::values advice);
+
+    const char* data() const;
+    std::size_t size() const;
+
+private:
+    boost::shared_ptr<impl_type> pimpl_;
+};
+
+} } // End namespaces iostreams, hamigaki.
+
+HAMIGAKI_IOSTREAMS_CATABLE(hamigaki::iostreams::mapped_file_source, 0)
+
+#ifdef BOOST_MSVC
+    #pragma warning(pop)
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+    #include BOOST_ABI_SUFFIX
+#endif
+
+#endif // HAMIGAKI_IOSTREAMS_DEVICE_MAPPED_FILE_HPP
@@ -49,6 +49,9 @@ public:
     std::streampos seek(
         boost::iostreams::stream_offset off, BOOST_IOS::seekdir way);
 
+    // the file position is not changed
+    void truncate(boost::iostreams::stream_offset size);
+
     void close();
 
 private:
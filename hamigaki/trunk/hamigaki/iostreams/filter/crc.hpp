@@ -10,6 +10,7 @@
 #ifndef HAMIGAKI_IOSTREAMS_FILTER_CRC_HPP
 #define HAMIGAKI_IOSTREAMS_FILTER_CRC_HPP
 
+#include <hamigaki/checksum/crc.hpp>
 #include <boost/iostreams/categories.hpp>
 #include <boost/iostreams/pipeline.hpp>
 #include <boost/iostreams/read.hpp>
@@ -70,10 +71,10 @@ private:
 };
 BOOST_IOSTREAMS_PIPABLE(crc_filter, 1)
 
-typedef crc_filter<boost::crc_16_type> crc_16_filter;
+typedef crc_filter<hamigaki::checksum::crc_16_type> crc_16_filter;
 typedef crc_filter<boost::crc_ccitt_type> crc_ccitt_filter;
 typedef crc_filter<boost::crc_xmodem_type> crc_xmodem_filter;
-typedef crc_filter<boost::crc_32_type> crc_32_filter;
+typedef crc_filter<hamigaki::checksum::crc_32_type> crc_32_filter;
 
 } } // End namespaces iostreams, hamigaki.
 
@@ -620,24 +620,29 @@ public:
     }
 };
 
-class lzhuf_compressor
-    : public sliding_window_compress<lha_detail::lzhuf_output>
+template<class MatchFinder>
+class basic_lzhuf_compressor
+    : public sliding_window_compress<lha_detail::lzhuf_output,MatchFinder>
 {
-    typedef sliding_window_compress<lha_detail::lzhuf_output> base_type;
+    typedef sliding_window_compress<
+        lha_detail::lzhuf_output,MatchFinder> base_type;
 
 public:
-    explicit lzhuf_compressor(std::size_t window_bits)
+    explicit basic_lzhuf_compressor(std::size_t window_bits)
         : base_type(lha_detail::lzhuf_output(window_bits), window_bits)
     {
     }
 
-    lzhuf_compressor(std::size_t window_bits, std::size_t buffer_size)
+    basic_lzhuf_compressor(std::size_t window_bits, std::size_t buffer_size,
+            int level=compression_level::default_compression)
         : base_type(lha_detail::lzhuf_output(window_bits, buffer_size)
-        , window_bits)
+        , window_bits, level)
     {
     }
 };
 
+typedef basic_lzhuf_compressor<default_match_finder> lzhuf_compressor;
+
 } } // End namespaces iostreams, hamigaki.
 
 #endif // HAMIGAKI_IOSTREAMS_FILTER_LZHUF_HPP
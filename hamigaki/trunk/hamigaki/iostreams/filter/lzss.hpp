@@ -117,18 +117,21 @@ public:
     }
 };
 
-template<bit_flow Flow, std::size_t OffsetBits, std::size_t LengthBits>
+template<
+    bit_flow Flow, std::size_t OffsetBits, std::size_t LengthBits,
+    class MatchFinder=default_match_finder>
 class lzss_compressor
     : public sliding_window_compress<
-        detail::lzss_output<Flow,OffsetBits,LengthBits>
+        detail::lzss_output<Flow,OffsetBits,LengthBits>, MatchFinder
     >
 {
     typedef detail::lzss_output<Flow,OffsetBits,LengthBits> output_type;
-    typedef sliding_window_compress<output_type> base_type;
+    typedef sliding_window_compress<output_type,MatchFinder> base_type;
 
 public:
-    explicit lzss_compressor(std::size_t window_bits)
-        : base_type(output_type(), window_bits)
+    explicit lzss_compressor(std::size_t window_bits,
+            int level=compression_level::default_compression)
+        : base_type(output_type(), window_bits, level)
     {
     }
 };
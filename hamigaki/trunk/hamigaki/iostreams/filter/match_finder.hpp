@@ -0,0 +1,360 @@
+// match_finder.hpp: match finders for sliding window compression
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/iostreams for library home page.
+
+#ifndef HAMIGAKI_IOSTREAMS_FILTER_MATCH_FINDER_HPP
+#define HAMIGAKI_IOSTREAMS_FILTER_MATCH_FINDER_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace hamigaki { namespace iostreams {
+
+namespace compression_level
+{
+
+const int best_speed = 1;
+const int default_compression = 6;
+const int best_compression = 9;
+
+} // namespace compression_level
+
+// Interface of the match finders:
+//   MatchFinder(std::size_t window_size, std::size_t buffer_size, int level);
+//
+//   // returns the longest match (distance-1, length) for the string
+//   // at "pos", and registers the string
+//   std::pair<std::size_t,std::size_t>
+//   find(const char* window, std::size_t pos, std::size_t max_len);
+//
+//   // registers the string at "pos" only
+//   void skip(const char* window, std::size_t pos, std::size_t max_len);
+//
+//   // the window has been moved by "n" bytes
+//   void slide(std::size_t n);
+
+namespace detail
+{
+
+struct match_finder_params
+{
+    std::size_t max_depth;
+    std::size_t nice_length;
+};
+
+inline match_finder_params make_match_finder_params(int level)
+{
+    static const match_finder_params table[] =
+    {
+        {    4,   8 },
+        {    8,  16 },
+        {   16,  32 },
+        {   32,  64 },
+        {   64, 128 },
+        {  128, 128 },
+        {  256, 256 },
+        { 1024, ~static_cast<std::size_t>(0) },
+        { 4096, ~static_cast<std::size_t>(0) }
+    };
+
+    if (level < compression_level::best_speed)
+        level = compression_level::best_speed;
+    else if (level > compression_level::best_compression)
+        level = compression_level::best_compression;
+
+    return table[level-1];
+}
+
+class match_finder_hash
+{
+public:
+    static const std::size_t table_size = 0x10000;
+    static const std::size_t nil = ~static_cast<std::size_t>(0);
+
+    static std::size_t hash(const char* s)
+    {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(s);
+        return ((p[0] << 8) ^ (p[1] << 4) ^ p[2]) & (table_size-1);
+    }
+
+    static void slide(std::size_t* p, std::size_t size, std::size_t n)
+    {
+        for (std::size_t i = 0; i < size; ++i)
+            p[i] = ((p[i] != nil) && (p[i] >= n)) ? p[i] - n : nil;
+    }
+};
+
+} // namespace detail
+
+// searches the whole window
+class brute_force_match_finder
+{
+public:
+    brute_force_match_finder(std::size_t window_size, std::size_t, int)
+        : window_size_(window_size)
+    {
+    }
+
+    std::pair<std::size_t,std::size_t>
+    find(const char* window, std::size_t pos, std::size_t max_len)
+    {
+        const char* last = window + pos;
+        const char* start =
+            (pos >= window_size_) ? last - window_size_ : window;
+
+        std::size_t length = 0;
+        std::size_t offset = 0;
+        while (const void* p = std::memchr(start, *last, last-start))
+        {
+            const char* cur = static_cast<const char*>(p);
+
+            const char* end = std::mismatch(cur, cur+max_len, last).first;
+
+            std::size_t len = static_cast<std::size_t>(end - cur);
+            if (len >= length)
+            {
+                length = len;
+                offset = last-cur - 1;
+            }
+            start = cur + 1;
+        }
+        return std::make_pair(offset, length);
+    }
+
+    void skip(const char*, std::size_t, std::size_t)
+    {
+    }
+
+    void slide(std::size_t)
+    {
+    }
+
+private:
+    std::size_t window_size_;
+};
+
+// hash chains limited by the compression level
+class hash_chain_match_finder
+{
+private:
+    typedef detail::match_finder_hash hash_type;
+
+    static std::size_t nil()
+    {
+        return hash_type::nil;
+    }
+
+public:
+    hash_chain_match_finder(
+            std::size_t window_size, std::size_t buffer_size, int level)
+        : window_size_(window_size)
+        , params_(detail::make_match_finder_params(level))
+        , head_(hash_type::table_size, nil())
+        , chain_(buffer_size, nil())
+    {
+    }
+
+    std::pair<std::size_t,std::size_t>
+    find(const char* window, std::size_t pos, std::size_t max_len)
+    {
+        if (max_len < 3)
+            return std::pair<std::size_t,std::size_t>(0, 0);
+
+        const char* str = window + pos;
+        std::size_t cur = insert(str, pos);
+
+        const std::size_t nice_len = (std::min)(params_.nice_length, max_len);
+        std::size_t length = 0;
+        std::size_t offset = 0;
+        for (std::size_t depth = params_.max_depth; depth != 0; --depth)
+        {
+            if ((cur == hash_type::nil) || (pos - cur > window_size_))
+                break;
+
+            const char* s = window + cur;
+            if (s[length] == str[length])
+            {
+                const char* end = std::mismatch(s, s+max_len, str).first;
+                std::size_t len = static_cast<std::size_t>(end - s);
+                if (len > length)
+                {
+                    length = len;
+                    offset = pos - cur - 1;
+                    if (length >= nice_len)
+                        break;
+                }
+            }
+            cur = chain_[cur];
+        }
+        return std::make_pair(offset, length);
+    }
+
+    void skip(const char* window, std::size_t pos, std::size_t max_len)
+    {
+        if (max_len >= 3)
+            insert(window + pos, pos);
+    }
+
+    void slide(std::size_t n)
+    {
+        std::size_t size = chain_.size() - n;
+        std::memmove(&chain_[0], &chain_[n], size*sizeof(chain_[0]));
+        hash_type::slide(&head_[0], head_.size(), n);
+        hash_type::slide(&chain_[0], size, n);
+    }
+
+private:
+    std::size_t window_size_;
+    detail::match_finder_params params_;
+    std::vector<std::size_t> head_;
+    std::vector<std::size_t> chain_;
+
+    std::size_t insert(const char* str, std::size_t pos)
+    {
+        std::size_t& head = head_[hash_type::hash(str)];
+        std::size_t prev = head;
+        chain_[pos] = prev;
+        head = pos;
+        return prev;
+    }
+};
+
+// binary search trees sorted by the strings, like LZMA's BT3
+class binary_tree_match_finder
+{
+private:
+    typedef detail::match_finder_hash hash_type;
+
+    static std::size_t nil()
+    {
+        return hash_type::nil;
+    }
+
+public:
+    binary_tree_match_finder(
+            std::size_t window_size, std::size_t buffer_size, int level)
+        : window_size_(window_size)
+        , params_(detail::make_match_finder_params(level))
+        , head_(hash_type::table_size, nil())
+        , left_(buffer_size, nil())
+        , right_(buffer_size, nil())
+    {
+    }
+
+    std::pair<std::size_t,std::size_t>
+    find(const char* window, std::size_t pos, std::size_t max_len)
+    {
+        return insert(window, pos, max_len);
+    }
+
+    void skip(const char* window, std::size_t pos, std::size_t max_len)
+    {
+        insert(window, pos, max_len);
+    }
+
+    void slide(std::size_t n)
+    {
+        std::size_t size = left_.size() - n;
+        std::memmove(&left_[0], &left_[n], size*sizeof(left_[0]));
+        std::memmove(&right_[0], &right_[n], size*sizeof(right_[0]));
+        hash_type::slide(&head_[0], head_.size(), n);
+        hash_type::slide(&left_[0], size, n);
+        hash_type::slide(&right_[0], size, n);
+    }
+
+private:
+    std::size_t window_size_;
+    detail::match_finder_params params_;
+    std::vector<std::size_t> head_;
+    std::vector<std::size_t> left_;
+    std::vector<std::size_t> right_;
+
+    std::pair<std::size_t,std::size_t>
+    insert(const char* window, std::size_t pos, std::size_t max_len)
+    {
+        if (max_len < 3)
+            return std::pair<std::size_t,std::size_t>(0, 0);
+
+        const unsigned char* str =
+            reinterpret_cast<const unsigned char*>(window + pos);
+
+        std::size_t& head = head_[hash_type::hash(window + pos)];
+        std::size_t cur = head;
+        head = pos;
+
+        // the subtrees of the new node
+        std::size_t* smaller = &left_[pos];
+        std::size_t* larger = &right_[pos];
+        std::size_t smaller_len = 0;
+        std::size_t larger_len = 0;
+
+        const std::size_t nice_len = (std::min)(params_.nice_length, max_len);
+        std::size_t length = 0;
+        std::size_t offset = 0;
+        for (std::size_t depth = params_.max_depth; ; --depth)
+        {
+            if ((depth == 0) ||
+                (cur == hash_type::nil) || (pos - cur > window_size_) )
+            {
+                *smaller = hash_type::nil;
+                *larger = hash_type::nil;
+                break;
+            }
+
+            const unsigned char* s =
+                reinterpret_cast<const unsigned char*>(window + cur);
+
+            // the common prefix with both bounds is known to match
+            std::size_t len = (std::min)(smaller_len, larger_len);
+            while ((len < max_len) && (s[len] == str[len]))
+                ++len;
+
+            if (len > length)
+            {
+                length = len;
+                offset = pos - cur - 1;
+            }
+
+            if (len >= nice_len)
+            {
+                // replace the node "cur" by the new node
+                *smaller = left_[cur];
+                *larger = right_[cur];
+                break;
+            }
+
+            if (s[len] < str[len])
+            {
+                *smaller = cur;
+                smaller = &right_[cur];
+                cur = *smaller;
+                smaller_len = len;
+            }
+            else
+            {
+                *larger = cur;
+                larger = &left_[cur];
+                cur = *larger;
+                larger_len = len;
+            }
+        }
+        return std::make_pair(offset, length);
+    }
+};
+
+#if defined(HAMIGAKI_IOSTREAMS_USE_HASH)
+typedef hash_chain_match_finder default_match_finder;
+#else
+typedef brute_force_match_finder default_match_finder;
+#endif
+
+} } // End namespaces iostreams, hamigaki.
+
+#endif // HAMIGAKI_IOSTREAMS_FILTER_MATCH_FINDER_HPP
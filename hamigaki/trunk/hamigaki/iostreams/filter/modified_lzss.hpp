@@ -205,15 +205,17 @@ public:
 
 template<
     bit_flow Flow, endianness E,
-    std::size_t OffsetBits, std::size_t LengthBits>
+    std::size_t OffsetBits, std::size_t LengthBits,
+    class MatchFinder=default_match_finder>
 class modified_lzss_compressor
     : public sliding_window_compress<
-        detail::modified_lzss_output<Flow,E,OffsetBits,LengthBits>
+        detail::modified_lzss_output<Flow,E,OffsetBits,LengthBits>,
+        MatchFinder
     >
 {
     typedef detail::modified_lzss_output<
         Flow,E,OffsetBits,LengthBits> output_type;
-    typedef sliding_window_compress<output_type> base_type;
+    typedef sliding_window_compress<output_type,MatchFinder> base_type;
 
 public:
     explicit modified_lzss_compressor(std::size_t window_bits)
@@ -221,8 +223,10 @@ public:
     {
     }
 
-    modified_lzss_compressor(std::size_t buffer_size, std::size_t window_bits)
-        : base_type(output_type(buffer_size), window_bits)
+    modified_lzss_compressor(
+            std::size_t buffer_size, std::size_t window_bits,
+            int level=compression_level::default_compression)
+        : base_type(output_type(buffer_size), window_bits, level)
     {
     }
 };
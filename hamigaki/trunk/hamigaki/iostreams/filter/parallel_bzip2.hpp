@@ -0,0 +1,448 @@
+// parallel_bzip2.hpp: bzip2 decompressor which decodes blocks concurrently
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/iostreams for library home page.
+
+#ifndef HAMIGAKI_IOSTREAMS_FILTER_PARALLEL_BZIP2_HPP
+#define HAMIGAKI_IOSTREAMS_FILTER_PARALLEL_BZIP2_HPP
+
+#include <boost/config.hpp>
+
+#ifdef BOOST_MSVC
+    #pragma warning(push)
+    #pragma warning(disable : 4251)
+#endif
+
+#include <boost/thread/condition.hpp>
+#include <boost/thread/thread.hpp>
+
+#ifdef BOOST_MSVC
+    #pragma warning(pop)
+#endif
+
+#include <hamigaki/iostreams/detail/bzip2_block.hpp>
+#include <hamigaki/thread/exception_storage.hpp>
+#include <boost/iostreams/categories.hpp>
+#include <boost/iostreams/detail/ios.hpp>
+#include <boost/iostreams/pipeline.hpp>
+#include <boost/iostreams/read.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace hamigaki { namespace iostreams {
+
+namespace detail
+{
+
+struct parallel_bzip2_job
+{
+    bzip2_marker marker;
+
+    // the end of the block (or the stream trailer) in bits
+    boost::uint64_t end_bit;
+
+    // the compressed block and its range in bits
+    std::string input;
+    boost::uint64_t first;
+    boost::uint64_t last;
+
+    std::string output;
+
+    // the block CRC or the combined CRC of the end of stream marker
+    boost::uint32_t crc;
+
+    bool valid;
+    bool done;
+    hamigaki::thread::exception_storage error;
+};
+
+class parallel_bzip2_decompressor_impl : private boost::noncopyable
+{
+private:
+    typedef boost::shared_ptr<parallel_bzip2_job> job_ptr;
+
+    // the number of the fake magics in a block which can be merged
+    static const std::size_t max_merge_count = 16;
+
+public:
+    parallel_bzip2_decompressor_impl(
+            std::size_t thread_count, std::size_t buffer_size)
+        : thread_count_(thread_count != 0 ? thread_count : 1)
+        , buffer_(buffer_size != 0 ? buffer_size : 4096)
+        , base_(0), eof_(false), header_checked_(false), crc_(0)
+        , out_pos_(0), stop_(false)
+    {
+        for (std::size_t i = 0; i < thread_count_; ++i)
+        {
+            threads_.create_thread(
+                boost::bind(&parallel_bzip2_decompressor_impl::run, this));
+        }
+    }
+
+    ~parallel_bzip2_decompressor_impl()
+    {
+        {
+            boost::mutex::scoped_lock locking(mutex_);
+            stop_ = true;
+            cond_.notify_all();
+        }
+        threads_.join_all();
+    }
+
+    template<class Source>
+    std::streamsize read(Source& src, char* s, std::streamsize n)
+    {
+        std::streamsize total = 0;
+        while (total < n)
+        {
+            if (!current_ || (out_pos_ == current_->output.size()))
+            {
+                if (!next_block(src))
+                    break;
+                continue;
+            }
+
+            std::size_t amt = (std::min)(
+                current_->output.size() - out_pos_,
+                static_cast<std::size_t>(n - total));
+            std::memcpy(s + total, current_->output.data() + out_pos_, amt);
+            out_pos_ += amt;
+            total += static_cast<std::streamsize>(amt);
+        }
+        return total != 0 ? total : -1;
+    }
+
+    void close()
+    {
+        {
+            boost::mutex::scoped_lock locking(mutex_);
+            queue_.clear();
+        }
+        pending_.clear();
+        current_.reset();
+        out_pos_ = 0;
+
+        scanner_ = bzip2_marker_scanner();
+        markers_.clear();
+        data_.clear();
+        base_ = 0;
+        eof_ = false;
+        header_checked_ = false;
+        crc_ = 0;
+    }
+
+private:
+    std::size_t thread_count_;
+    std::vector<char> buffer_;
+    bzip2_marker_scanner scanner_;
+    std::vector<bzip2_marker> found_;
+    std::deque<bzip2_marker> markers_;
+
+    // the compressed data from the byte offset base_
+    std::string data_;
+    boost::uint64_t base_;
+    bool eof_;
+    bool header_checked_;
+
+    boost::uint32_t crc_;
+    job_ptr current_;
+    std::size_t out_pos_;
+    std::deque<job_ptr> pending_;
+    bzip2_block_decoder decoder_;
+
+    boost::mutex mutex_;
+    boost::condition cond_;
+    std::deque<job_ptr> queue_;
+    bool stop_;
+    boost::thread_group threads_;
+
+    template<class Source>
+    bool read_more(Source& src)
+    {
+        if (eof_)
+            return false;
+
+        std::streamsize amt = boost::iostreams::read(
+            src, &buffer_[0], static_cast<std::streamsize>(buffer_.size()));
+        if (amt <= 0)
+        {
+            eof_ = true;
+            return false;
+        }
+
+        data_.append(&buffer_[0], static_cast<std::size_t>(amt));
+        if (!header_checked_ && (data_.size() >= 3))
+        {
+            if (data_.compare(0, 3, "BZh") != 0)
+                throw BOOST_IOSTREAMS_FAILURE("bad bzip2 header");
+            header_checked_ = true;
+        }
+
+        found_.clear();
+        scanner_.scan(&buffer_[0], static_cast<std::size_t>(amt), found_);
+        markers_.insert(markers_.end(), found_.begin(), found_.end());
+        return true;
+    }
+
+    template<class Source>
+    bool has_markers(Source& src, std::size_t n)
+    {
+        while (markers_.size() < n)
+        {
+            if (!read_more(src))
+                return false;
+        }
+        return true;
+    }
+
+    template<class Source>
+    void require_bits(Source& src, boost::uint64_t bit)
+    {
+        while ((base_ + data_.size()) * 8 < bit)
+        {
+            if (!read_more(src))
+                throw BOOST_IOSTREAMS_FAILURE("unexpected end of bzip2 data");
+        }
+    }
+
+    void discard_data(boost::uint64_t bit)
+    {
+        boost::uint64_t byte = bit / 8;
+        data_.erase(0, static_cast<std::size_t>(byte - base_));
+        base_ = byte;
+    }
+
+    void copy_input(parallel_bzip2_job& job)
+    {
+        boost::uint64_t first = job.marker.bit_offset / 8;
+        boost::uint64_t last = (job.end_bit + 7) / 8;
+
+        job.input.assign(
+            data_,
+            static_cast<std::size_t>(first - base_),
+            static_cast<std::size_t>(last - first));
+        job.first = job.marker.bit_offset - first*8;
+        job.last = job.end_bit - first*8;
+    }
+
+    template<class Source>
+    bool submit(Source& src)
+    {
+        if (!has_markers(src, 1))
+            return false;
+
+        job_ptr job(new parallel_bzip2_job);
+        job->marker = markers_.front();
+        job->crc = 0;
+        job->valid = true;
+
+        if (job->marker.kind == bzip2_marker::end_of_stream)
+        {
+            job->end_bit = job->marker.bit_offset + 80;
+            require_bits(src, job->end_bit);
+            job->crc = read_bzip2_bits(
+                data_.data(), job->marker.bit_offset + 48 - base_*8, 32);
+            job->done = true;
+
+            markers_.pop_front();
+            pending_.push_back(job);
+            return true;
+        }
+
+        // the block ends at the next marker
+        if (!has_markers(src, 2))
+            throw BOOST_IOSTREAMS_FAILURE("unexpected end of bzip2 data");
+        job->end_bit = markers_[1].bit_offset;
+        copy_input(*job);
+        job->done = false;
+
+        markers_.pop_front();
+        pending_.push_back(job);
+
+        boost::mutex::scoped_lock locking(mutex_);
+        queue_.push_back(job);
+        cond_.notify_all();
+        return true;
+    }
+
+    // the magic may appear in the compressed data by chance
+    template<class Source>
+    void merge_block(Source& src)
+    {
+        {
+            boost::mutex::scoped_lock locking(mutex_);
+            queue_.clear();
+        }
+
+        // put back the markers of the pending blocks
+        for (std::size_t i = pending_.size(); i-- != 0; )
+            markers_.push_front(pending_[i]->marker);
+        pending_.clear();
+
+        for (std::size_t k = 2; k <= max_merge_count; ++k)
+        {
+            if (!has_markers(src, k+1))
+                break;
+
+            job_ptr job(new parallel_bzip2_job);
+            job->marker = markers_.front();
+            job->end_bit = markers_[k].bit_offset;
+            copy_input(*job);
+
+            if (decoder_.decode(
+                job->input.data(), job->first, job->last,
+                job->marker.level, job->output, job->crc) )
+            {
+                job->valid = true;
+                job->done = true;
+
+                markers_.erase(markers_.begin(), markers_.begin() + k);
+                pending_.push_front(job);
+                return;
+            }
+        }
+        throw BOOST_IOSTREAMS_FAILURE("bzip2 data error");
+    }
+
+    template<class Source>
+    bool next_block(Source& src)
+    {
+        while (true)
+        {
+            // limit the number of the blocks in memory
+            while (pending_.size() < thread_count_*2)
+            {
+                if (!submit(src))
+                    break;
+            }
+
+            if (pending_.empty())
+            {
+                current_.reset();
+                return false;
+            }
+
+            job_ptr job = pending_.front();
+            {
+                boost::mutex::scoped_lock locking(mutex_);
+                while (!job->done)
+                    cond_.wait(locking);
+            }
+            job->error.rethrow();
+
+            if (!job->valid)
+            {
+                merge_block(src);
+                continue;
+            }
+
+            pending_.pop_front();
+            discard_data(job->end_bit);
+
+            if (job->marker.kind == bzip2_marker::end_of_stream)
+            {
+                if (job->crc != crc_)
+                    throw BOOST_IOSTREAMS_FAILURE("bzip2 CRC error");
+                crc_ = 0;
+                continue;
+            }
+
+            crc_ = bzip2_combine_crc(crc_, job->crc);
+            current_ = job;
+            out_pos_ = 0;
+            return true;
+        }
+    }
+
+    void run()
+    {
+        bzip2_block_decoder decoder;
+        while (true)
+        {
+            job_ptr job;
+            {
+                boost::mutex::scoped_lock locking(mutex_);
+                while (!stop_ && queue_.empty())
+                    cond_.wait(locking);
+                if (stop_)
+                    return;
+                job = queue_.front();
+                queue_.pop_front();
+            }
+
+            try
+            {
+                job->valid = decoder.decode(
+                    job->input.data(), job->first, job->last,
+                    job->marker.level, job->output, job->crc);
+            }
+            catch (...)
+            {
+                job->error.store();
+            }
+
+            boost::mutex::scoped_lock locking(mutex_);
+            job->done = true;
+            cond_.notify_all();
+        }
+    }
+};
+
+} // namespace detail
+
+// Finds the block magics of bzip2 and decodes the blocks on the worker
+// threads like pbzip2. Each block is decoded as a single block stream,
+// and the combined CRC of the stream is verified.
+class parallel_bzip2_decompressor
+{
+private:
+    typedef detail::parallel_bzip2_decompressor_impl impl_type;
+
+public:
+    typedef char char_type;
+
+    struct category
+        : public boost::iostreams::input
+        , public boost::iostreams::filter_tag
+        , public boost::iostreams::multichar_tag
+        , public boost::iostreams::closable_tag
+    {};
+
+    explicit parallel_bzip2_decompressor(
+            std::size_t thread_count, std::size_t buffer_size = 64*1024)
+        : pimpl_(new impl_type(thread_count, buffer_size))
+    {
+    }
+
+    template<class Source>
+    std::streamsize read(Source& src, char* s, std::streamsize n)
+    {
+        return pimpl_->read(src, s, n);
+    }
+
+    template<class Source>
+    void close(Source&)
+    {
+        pimpl_->close();
+    }
+
+private:
+    boost::shared_ptr<impl_type> pimpl_;
+};
+BOOST_IOSTREAMS_PIPABLE(parallel_bzip2_decompressor, 0)
+
+} } // End namespaces iostreams, hamigaki.
+
+#endif // HAMIGAKI_IOSTREAMS_FILTER_PARALLEL_BZIP2_HPP
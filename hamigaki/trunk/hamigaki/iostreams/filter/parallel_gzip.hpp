@@ -0,0 +1,385 @@
+// parallel_gzip.hpp: gzip compressor which deflates blocks concurrently
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/iostreams for library home page.
+
+#ifndef HAMIGAKI_IOSTREAMS_FILTER_PARALLEL_GZIP_HPP
+#define HAMIGAKI_IOSTREAMS_FILTER_PARALLEL_GZIP_HPP
+
+#include <boost/config.hpp>
+
+#ifdef BOOST_MSVC
+    #pragma warning(push)
+    #pragma warning(disable : 4251)
+#endif
+
+#include <boost/thread/condition.hpp>
+#include <boost/thread/thread.hpp>
+
+#ifdef BOOST_MSVC
+    #pragma warning(pop)
+#endif
+
+#include <hamigaki/binary/endian.hpp>
+#include <hamigaki/iostreams/blocking.hpp>
+#include <hamigaki/thread/exception_storage.hpp>
+#include <boost/iostreams/categories.hpp>
+#include <boost/iostreams/detail/ios.hpp>
+#include <boost/iostreams/pipeline.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <zlib.h>
+
+namespace hamigaki { namespace iostreams {
+
+namespace detail
+{
+
+class deflate_stream : private boost::noncopyable
+{
+public:
+    explicit deflate_stream(int level)
+    {
+        std::memset(&zs_, 0, sizeof(zs_));
+        int ret = ::deflateInit2(
+            &zs_, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+        if (ret != Z_OK)
+        {
+            throw BOOST_IOSTREAMS_FAILURE("failed to initialize deflate");
+        }
+    }
+
+    ~deflate_stream()
+    {
+        ::deflateEnd(&zs_);
+    }
+
+    void set_dictionary(const std::string& dict)
+    {
+        if (dict.empty())
+            return;
+
+        if (::deflateSetDictionary(&zs_,
+            reinterpret_cast<const Bytef*>(dict.data()),
+            static_cast<uInt>(dict.size())) != Z_OK)
+        {
+            throw BOOST_IOSTREAMS_FAILURE("failed to set deflate dictionary");
+        }
+    }
+
+    void compress(const std::string& in, std::string& out, bool last)
+    {
+        out.resize(::deflateBound(&zs_, static_cast<uLong>(in.size())) + 16);
+
+        zs_.next_in =
+            reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+        zs_.avail_in = static_cast<uInt>(in.size());
+        zs_.next_out = reinterpret_cast<Bytef*>(&out[0]);
+        zs_.avail_out = static_cast<uInt>(out.size());
+
+        // Z_SYNC_FLUSH ends the block at a byte boundary without BFINAL,
+        // so that the outputs can be concatenated into one deflate stream
+        const int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+        while (true)
+        {
+            int ret = ::deflate(&zs_, flush);
+            if ((ret != Z_OK) && (ret != Z_STREAM_END) &&
+                (ret != Z_BUF_ERROR) )
+            {
+                throw BOOST_IOSTREAMS_FAILURE("deflate error");
+            }
+
+            if (last ? (ret == Z_STREAM_END) : (zs_.avail_out != 0))
+                break;
+
+            std::size_t size = out.size();
+            out.resize(size*2);
+            zs_.next_out = reinterpret_cast<Bytef*>(&out[size]);
+            zs_.avail_out = static_cast<uInt>(out.size() - size);
+        }
+        out.resize(zs_.total_out);
+    }
+
+private:
+    ::z_stream zs_;
+};
+
+struct parallel_gzip_job
+{
+    std::string input;
+    std::string dictionary;
+    std::string output;
+    boost::uint32_t crc;
+    bool last;
+    bool done;
+    hamigaki::thread::exception_storage error;
+};
+
+class parallel_gzip_compressor_impl : private boost::noncopyable
+{
+private:
+    typedef boost::shared_ptr<parallel_gzip_job> job_ptr;
+
+    static const std::size_t dictionary_size = 32*1024;
+
+public:
+    parallel_gzip_compressor_impl(
+            std::size_t thread_count, std::size_t block_size, int level)
+        : thread_count_(thread_count != 0 ? thread_count : 1)
+        , block_size_(
+            block_size > dictionary_size ? block_size : dictionary_size)
+        , level_(level), header_written_(false), crc_(0), size_(0)
+        , stop_(false)
+    {
+        buffer_.reserve(block_size_);
+        for (std::size_t i = 0; i < thread_count_; ++i)
+        {
+            threads_.create_thread(
+                boost::bind(&parallel_gzip_compressor_impl::run, this));
+        }
+    }
+
+    ~parallel_gzip_compressor_impl()
+    {
+        {
+            boost::mutex::scoped_lock locking(mutex_);
+            stop_ = true;
+            cond_.notify_all();
+        }
+        threads_.join_all();
+    }
+
+    template<class Sink>
+    std::streamsize write(Sink& sink, const char* s, std::streamsize n)
+    {
+        if (!header_written_)
+            write_header(sink);
+
+        std::streamsize total = 0;
+        while (total < n)
+        {
+            std::size_t amt = (std::min)(
+                static_cast<std::size_t>(n - total),
+                block_size_ - buffer_.size());
+            buffer_.append(s + total, amt);
+            total += amt;
+
+            if (buffer_.size() == block_size_)
+                submit(sink, false);
+        }
+        return total;
+    }
+
+    template<class Sink>
+    void close(Sink& sink)
+    {
+        if (!header_written_)
+            write_header(sink);
+
+        submit(sink, true);
+        while (!pending_.empty())
+            write_front(sink);
+
+        char buf[8];
+        hamigaki::encode_uint<little,4>(buf, crc_);
+        hamigaki::encode_uint<little,4>(
+            buf+4, static_cast<boost::uint32_t>(size_));
+        iostreams::blocking_write(sink, buf);
+
+        header_written_ = false;
+        crc_ = 0;
+        size_ = 0;
+        dictionary_.clear();
+    }
+
+private:
+    std::size_t thread_count_;
+    std::size_t block_size_;
+    int level_;
+    bool header_written_;
+    std::string buffer_;
+    std::string dictionary_;
+    uLong crc_;
+    boost::uint64_t size_;
+    std::deque<job_ptr> pending_;
+
+    boost::mutex mutex_;
+    boost::condition cond_;
+    std::deque<job_ptr> queue_;
+    bool stop_;
+    boost::thread_group threads_;
+
+    template<class Sink>
+    void write_header(Sink& sink)
+    {
+        char buf[10] =
+        {
+            '\x1F', '\x8B', 8, 0, // ID1, ID2, CM, FLG
+            0, 0, 0, 0,           // MTIME
+            0, '\xFF'             // XFL, OS
+        };
+        if (level_ == Z_BEST_COMPRESSION)
+            buf[8] = 2;
+        else if (level_ == Z_BEST_SPEED)
+            buf[8] = 4;
+
+        iostreams::blocking_write(sink, buf);
+        header_written_ = true;
+    }
+
+    template<class Sink>
+    void submit(Sink& sink, bool last)
+    {
+        job_ptr job(new parallel_gzip_job);
+        job->input.swap(buffer_);
+        job->dictionary = dictionary_;
+        job->crc = 0;
+        job->last = last;
+        job->done = false;
+
+        // the next block refers to the last 32KiB of the input
+        const std::string& in = job->input;
+        if (in.size() >= dictionary_size)
+            dictionary_.assign(in.end() - dictionary_size, in.end());
+        else
+        {
+            dictionary_ += in;
+            if (dictionary_.size() > dictionary_size)
+            {
+                dictionary_.erase(
+                    0, dictionary_.size() - dictionary_size);
+            }
+        }
+        buffer_.reserve(block_size_);
+
+        // limit the number of the blocks in memory
+        while (pending_.size() >= thread_count_*2)
+            write_front(sink);
+
+        boost::mutex::scoped_lock locking(mutex_);
+        pending_.push_back(job);
+        queue_.push_back(job);
+        cond_.notify_all();
+    }
+
+    template<class Sink>
+    void write_front(Sink& sink)
+    {
+        job_ptr job = pending_.front();
+        {
+            boost::mutex::scoped_lock locking(mutex_);
+            while (!job->done)
+                cond_.wait(locking);
+        }
+        pending_.pop_front();
+        job->error.rethrow();
+
+        crc_ = ::crc32_combine(
+            crc_, job->crc, static_cast<z_off_t>(job->input.size()));
+        size_ += job->input.size();
+
+        iostreams::blocking_write(sink, job->output);
+    }
+
+    void run()
+    {
+        while (true)
+        {
+            job_ptr job;
+            {
+                boost::mutex::scoped_lock locking(mutex_);
+                while (!stop_ && queue_.empty())
+                    cond_.wait(locking);
+                if (queue_.empty())
+                    return;
+                job = queue_.front();
+                queue_.pop_front();
+            }
+
+            try
+            {
+                compress(*job);
+            }
+            catch (...)
+            {
+                job->error.store();
+            }
+
+            boost::mutex::scoped_lock locking(mutex_);
+            job->done = true;
+            cond_.notify_all();
+        }
+    }
+
+    void compress(parallel_gzip_job& job)
+    {
+        const std::string& in = job.input;
+        job.crc = static_cast<boost::uint32_t>(::crc32(0,
+            reinterpret_cast<const Bytef*>(in.data()),
+            static_cast<uInt>(in.size())));
+
+        deflate_stream zs(level_);
+        zs.set_dictionary(job.dictionary);
+        zs.compress(in, job.output, job.last);
+    }
+};
+
+} // namespace detail
+
+// Splits the input into the blocks and deflates them on the worker threads
+// like pigz. Each block is primed with the last 32KiB of the previous block,
+// and the output is a single gzip member.
+class parallel_gzip_compressor
+{
+private:
+    typedef detail::parallel_gzip_compressor_impl impl_type;
+
+public:
+    typedef char char_type;
+
+    struct category
+        : public boost::iostreams::output
+        , public boost::iostreams::filter_tag
+        , public boost::iostreams::multichar_tag
+        , public boost::iostreams::closable_tag
+    {};
+
+    explicit parallel_gzip_compressor(
+            std::size_t thread_count,
+            std::size_t block_size = 128*1024,
+            int level = Z_DEFAULT_COMPRESSION)
+        : pimpl_(new impl_type(thread_count, block_size, level))
+    {
+    }
+
+    template<class Sink>
+    std::streamsize write(Sink& sink, const char* s, std::streamsize n)
+    {
+        return pimpl_->write(sink, s, n);
+    }
+
+    template<class Sink>
+    void close(Sink& sink)
+    {
+        pimpl_->close(sink);
+    }
+
+private:
+    boost::shared_ptr<impl_type> pimpl_;
+};
+BOOST_IOSTREAMS_PIPABLE(parallel_gzip_compressor, 0)
+
+} } // End namespaces iostreams, hamigaki.
+
+#endif // HAMIGAKI_IOSTREAMS_FILTER_PARALLEL_GZIP_HPP
@@ -10,6 +10,7 @@
 #ifndef HAMIGAKI_IOSTREAMS_FILTER_SLIDING_WINDOW_HPP
 #define HAMIGAKI_IOSTREAMS_FILTER_SLIDING_WINDOW_HPP
 
+#include <hamigaki/iostreams/filter/match_finder.hpp>
 #include <boost/iostreams/categories.hpp>
 #include <boost/iostreams/traits.hpp>
 #include <boost/tuple/tuple.hpp>
@@ -148,7 +149,7 @@ private:
     }
 };
 
-template<class Output>
+template<class Output, class MatchFinder>
 class sliding_window_compress_impl
 {
     typedef typename Output::length_type length_type;
@@ -158,14 +159,9 @@ class sliding_window_compress_impl
     static const length_type min_match_length = Output::min_match_length;
     static const length_type max_match_length = Output::max_match_length;
 
-#if defined(HAMIGAKI_IOSTREAMS_USE_HASH)
-    static const std::size_t hash_table_size = 0x8000;
-    static const std::size_t hash_table_mask = 0x7FFF;
-    static const std::size_t nil = ~static_cast<std::size_t>(0);
-#endif
-
 public:
-    sliding_window_compress_impl(const Output& output, std::size_t window_bits)
+    sliding_window_compress_impl(
+            const Output& output, std::size_t window_bits, int level)
         : output_(output)
         , window_size_(1 << window_bits)
         , window_size2_(window_size_ <<1 )
@@ -173,11 +169,7 @@ public:
         , pos_(0)
         , end_(0)
         , last_(0, 0)
-#if defined(HAMIGAKI_IOSTREAMS_USE_HASH)
-        , hash_chain_(window_size2_ + max_match_length)
-        , hash_table_(hash_table_size, nil)
-        , hash_value_(0)
-#endif
+        , finder_(window_size_, window_.size(), level)
     {
     }
 
@@ -189,51 +181,7 @@ public:
         while (true)
         {
             while (end_ - pos_ >= max_match_length)
-            {
-                pair_type res = search(max_match_length);
-                if (res.second < min_match_length)
-                    res.second = 1;
-
-                if (!last_.second)
-                {
-                    ++pos_;
-                    last_ = res;
-                }
-                else if (
-                    (last_.second >= min_match_length) &&
-                    (last_.second >= res.second))
-                {
-                    output_.put(sink, last_.first, last_.second);
-#if defined(HAMIGAKI_IOSTREAMS_USE_HASH)
-                    --last_.second;
-                    while (--last_.second)
-                    {
-                        ++pos_;
-                        const unsigned char uc =
-                            static_cast<unsigned char>(window_[pos_ + 2]);
-                        hash_value_ =
-                            ((hash_value_ << 5) ^ uc) & hash_table_mask;
-
-                        std::size_t prev = hash_table_[hash_value_];
-                        hash_table_[hash_value_] = pos_;
-                        hash_chain_[pos_] = prev;
-                    }
-                    ++pos_;
-#else
-                    pos_ += (last_.second - 1);
-#endif
-                    last_.second = 0;
-                }
-                else
-                {
-                    output_.put(sink, window_[pos_-1]);
-                    ++pos_;
-                    last_ = res;
-                }
-
-                if (pos_ >= window_size2_)
-                    slide();
-            }
+                step(sink, max_match_length);
 
             if (total < n)
             {
@@ -242,16 +190,6 @@ public:
                 std::memcpy(&window_[end_], s+total, amt);
                 end_ += amt;
                 total += amt;
-#if defined(HAMIGAKI_IOSTREAMS_USE_HASH)
-                if (pos_ == 0)
-                {
-                    hash_value_ =
-                        (
-                            (static_cast<unsigned char>(window_[0]) << 5) ^
-                            (static_cast<unsigned char>(window_[1])     )
-                        ) & hash_table_mask;
-                }
-#endif
             }
             else
                 break;
@@ -264,53 +202,7 @@ public:
     bool flush(Sink& sink)
     {
         while (pos_ < end_)
-        {
-            length_type max_len = end_-pos_;
-
-            pair_type res = search(max_len);
-            if (res.second < min_match_length)
-                res.second = 1;
-
-            if (!last_.second)
-            {
-                ++pos_;
-                last_ = res;
-            }
-            else if (
-                (last_.second >= min_match_length) &&
-                (last_.second >= res.second))
-            {
-                output_.put(sink, last_.first, last_.second);
-#if defined(HAMIGAKI_IOSTREAMS_USE_HASH)
-                --last_.second;
-                while (--last_.second)
-                {
-                    ++pos_;
-                    const unsigned char uc =
-                        static_cast<unsigned char>(window_[pos_ + 2]);
-                    hash_value_ =
-                        ((hash_value_ << 5) ^ uc) & hash_table_mask;
-
-                    std::size_t prev = hash_table_[hash_value_];
-                    hash_table_[hash_value_] = pos_;
-                    hash_chain_[pos_] = prev;
-                }
-                ++pos_;
-#else
-                pos_ += (last_.second - 1);
-#endif
-                last_.second = 0;
-            }
-            else
-            {
-                output_.put(sink, window_[pos_-1]);
-                ++pos_;
-                last_ = res;
-            }
-
-            if (pos_ >= window_size2_)
-                slide();
-        }
+            step(sink, end_-pos_);
 
         if (last_.second && (pos_ == end_))
             output_.put(sink, window_[pos_-1]);
@@ -326,68 +218,56 @@ private:
     std::size_t pos_;
     std::size_t end_;
     pair_type last_;
-#if defined(HAMIGAKI_IOSTREAMS_USE_HASH)
-    std::vector<std::size_t> hash_chain_;
-    std::vector<std::size_t> hash_table_;
-    std::size_t hash_value_;
-#endif
+    MatchFinder finder_;
 
-    // Note: too slow
-    pair_type search(length_type max_len)
+    // lazy matching: emits the previous match
+    // unless the match at the next position is longer
+    template<class Sink>
+    void step(Sink& sink, length_type max_len)
     {
-#if defined(HAMIGAKI_IOSTREAMS_USE_HASH)
-        const char* str = &window_[pos_];
-        const unsigned char uc = static_cast<unsigned char>(str[2]);
-        hash_value_ = ((hash_value_ << 5) ^ uc) & hash_table_mask;
-        std::size_t index = hash_table_[hash_value_];
-        length_type length = 0;
-        offset_type offset = 0;
-        while (index != nil)
+        pair_type res = search(max_len);
+        if (res.second < min_match_length)
+            res.second = 1;
+
+        if (!last_.second)
         {
-            if (pos_ - index >= window_size_)
-                break;
+            ++pos_;
+            last_ = res;
+        }
+        else if (
+            (last_.second >= min_match_length) &&
+            (last_.second >= res.second))
+        {
+            output_.put(sink, last_.first, last_.second);
 
-            const char* cur = &window_[index];
-            const char* end = std::mismatch(cur, cur+max_len, str).first;
-            length_type len = static_cast<length_type>(end - cur);
-            if (len > length)
+            // register the strings in the match
+            for (length_type i = 2; i < last_.second; ++i)
             {
-                length = len;
-                offset = str-cur - 1;
+                ++pos_;
+                finder_.skip(&window_[0], pos_, (std::min)(
+                    static_cast<std::size_t>(max_match_length), end_-pos_));
             }
-            index = hash_chain_[index];
+            ++pos_;
+            last_.second = 0;
         }
-
-        std::size_t prev = hash_table_[hash_value_];
-        hash_table_[hash_value_] = pos_;
-        hash_chain_[pos_] = prev;
-
-        return pair_type(offset, length);
-#else
-        const char* last = &window_[pos_];
-        const char* start =
-            (pos_ >= window_size_)
-            ? last - window_size_ : &window_[0];
-
-        length_type length = 0;
-        offset_type offset = 0;
-        while (const void* p = std::memchr(start, *last, last-start))
+        else
         {
-            const char* cur = static_cast<const char*>(p);
+            output_.put(sink, window_[pos_-1]);
+            ++pos_;
+            last_ = res;
+        }
 
-            const char* end =
-                std::mismatch(cur, cur+max_len, last).first;
+        if (pos_ >= window_size2_)
+            slide();
+    }
 
-            length_type len = static_cast<length_type>(end - cur);
-            if (len >= length)
-            {
-                length = len;
-                offset = last-cur - 1;
-            }
-            start = cur + 1;
-        }
-        return pair_type(offset, length);
-#endif
+    pair_type search(length_type max_len)
+    {
+        std::pair<std::size_t,std::size_t> res =
+            finder_.find(&window_[0], pos_, max_len);
+        return pair_type(
+            static_cast<offset_type>(res.first),
+            static_cast<length_type>(res.second));
     }
 
     void slide()
@@ -399,28 +279,7 @@ private:
         );
         pos_ -= window_size_;
         end_ -= window_size_;
-#if defined(HAMIGAKI_IOSTREAMS_USE_HASH)
-        for (std::size_t i = 0; i < hash_table_size; ++i)
-        {
-            std::size_t* ptr = &hash_table_[i];
-            std::size_t index = *ptr;
-            while (index != nil)
-            {
-                if (index < window_size_)
-                {
-                    *ptr = nil;
-                    break;
-                }
-                else
-                {
-                    *ptr = index - window_size_;
-                    index = hash_chain_[index];
-                    ptr = &hash_chain_[*ptr];
-                }
-            }
-            *ptr = nil;
-        }
-#endif
+        finder_.slide(window_size_);
     }
 };
 
@@ -455,11 +314,11 @@ private:
     boost::shared_ptr<impl_type> pimpl_;
 };
 
-template<class Output>
+template<class Output, class MatchFinder=default_match_finder>
 class sliding_window_compress
 {
 private:
-    typedef detail::sliding_window_compress_impl<Output> impl_type;
+    typedef detail::sliding_window_compress_impl<Output,MatchFinder> impl_type;
 
 public:
     typedef char char_type;
@@ -470,8 +329,9 @@ public:
         , public boost::iostreams::flushable_tag
     {};
 
-    sliding_window_compress(const Output& output, std::size_t window_bits)
-        : pimpl_(new impl_type(output, window_bits))
+    sliding_window_compress(const Output& output, std::size_t window_bits,
+            int level=compression_level::default_compression)
+        : pimpl_(new impl_type(output, window_bits, level))
     {
     }
 
@@ -20,99 +20,190 @@
 #define HAMIGAKI_IOSTREAMS_SKIP_HPP
 
 #include <hamigaki/integer/auto_min.hpp>
+#include <boost/iostreams/detail/dispatch.hpp>
 #include <boost/iostreams/detail/ios.hpp>
+#include <boost/iostreams/detail/wrap_unwrap.hpp>
+#include <boost/iostreams/categories.hpp>
 #include <boost/iostreams/read.hpp>
 #include <boost/iostreams/seek.hpp>
 #include <boost/iostreams/traits.hpp>
 #include <boost/mpl/and.hpp>
 #include <boost/mpl/bool.hpp>
+#include <boost/mpl/if.hpp>
 #include <boost/type_traits/is_convertible.hpp>
+#include <vector>
 
 namespace hamigaki { namespace iostreams {
 
+// The device has the member function
+//   void skip(boost::iostreams::stream_offset off);
+// and the filter has the member function
+//   template<class Source>
+//   void skip(Source& src, boost::iostreams::stream_offset off);
+// which discard the next off characters faster than reading them.
+struct skippable_tag : virtual boost::iostreams::any_tag {};
+
+// the maximum size of the buffer used by skip() for the non-seekable devices
+const std::size_t skip_buffer_size = 64*1024;
+
 namespace detail
 {
 
-template<typename Device>
-void skip_impl(
-    Device& dev, boost::iostreams::stream_offset off, boost::mpl::true_)
+inline void resize_skip_buffer(
+    std::vector<char>& buffer, boost::iostreams::stream_offset off)
 {
-    boost::iostreams::seek(dev, off, BOOST_IOS::cur);
+    std::size_t size = hamigaki::auto_min(skip_buffer_size, off);
+    if (buffer.size() < size)
+        buffer.resize(size);
 }
 
-template<typename Device>
-void skip_impl(
-    Device& dev, boost::iostreams::stream_offset off, boost::mpl::false_)
-{
-    char buf[256];
+template<typename T>
+struct skip_impl;
 
-    while (off > 0)
+template<>
+struct skip_impl<skippable_tag>
+{
+    template<typename Device>
+    static void skip(
+        Device& dev, boost::iostreams::stream_offset off, std::vector<char>&)
     {
-        std::streamsize size = static_cast<std::streamsize>(sizeof(buf));
-        size = auto_min(size, off);
+        boost::iostreams::detail::unwrap(dev).skip(off);
+    }
 
-        std::streamsize amt = boost::iostreams::read(dev, buf, size);
-        if (amt == -1)
-            throw BOOST_IOSTREAMS_FAILURE("bad skip offset");
-        off -= amt;
+    template<typename Filter, typename Device>
+    static void skip(
+        Filter& flt, Device& dev,
+        boost::iostreams::stream_offset off, std::vector<char>&)
+    {
+        boost::iostreams::detail::unwrap(flt).skip(dev, off);
     }
-}
+};
 
-template<typename Filter, typename Device>
-void skip_impl(
-    Filter& flt, Device& dev,
-    boost::iostreams::stream_offset off, boost::mpl::true_)
+template<>
+struct skip_impl<boost::iostreams::input_seekable>
 {
-    boost::iostreams::seek(flt, dev, off, BOOST_IOS::cur);
-}
+    template<typename Device>
+    static void skip(
+        Device& dev, boost::iostreams::stream_offset off, std::vector<char>&)
+    {
+        boost::iostreams::seek(dev, off, BOOST_IOS::cur);
+    }
 
-template<typename Filter, typename Device>
-void skip_impl(
-    Filter& flt, Device& dev,
-    boost::iostreams::stream_offset off, boost::mpl::false_)
-{
-    char buf[256];
+    template<typename Filter, typename Device>
+    static void skip(
+        Filter& flt, Device& dev,
+        boost::iostreams::stream_offset off, std::vector<char>&)
+    {
+        boost::iostreams::seek(flt, dev, off, BOOST_IOS::cur);
+    }
+};
 
-    while (off > 0)
+template<>
+struct skip_impl<boost::iostreams::any_tag>
+{
+    template<typename Device>
+    static void skip(
+        Device& dev, boost::iostreams::stream_offset off,
+        std::vector<char>& buffer)
     {
-        std::streamsize size = static_cast<std::streamsize>(sizeof(buf));
-        size = auto_min(size, off);
+        detail::resize_skip_buffer(buffer, off);
+        while (off > 0)
+        {
+            std::streamsize size = static_cast<std::streamsize>(buffer.size());
+            size = auto_min(size, off);
+
+            std::streamsize amt = boost::iostreams::read(dev, &buffer[0], size);
+            if (amt == -1)
+                throw BOOST_IOSTREAMS_FAILURE("bad skip offset");
+            off -= amt;
+        }
+    }
 
-        std::streamsize amt = boost::iostreams::read(flt, dev, buf, size);
-        if (amt == -1)
-            throw BOOST_IOSTREAMS_FAILURE("bad skip offset");
-        off -= amt;
+    template<typename Filter, typename Device>
+    static void skip(
+        Filter& flt, Device& dev,
+        boost::iostreams::stream_offset off, std::vector<char>& buffer)
+    {
+        detail::resize_skip_buffer(buffer, off);
+        while (off > 0)
+        {
+            std::streamsize size = static_cast<std::streamsize>(buffer.size());
+            size = auto_min(size, off);
+
+            std::streamsize amt =
+                boost::iostreams::read(flt, dev, &buffer[0], size);
+            if (amt == -1)
+                throw BOOST_IOSTREAMS_FAILURE("bad skip offset");
+            off -= amt;
+        }
     }
-}
+};
 
+template<typename Filter, typename Device>
+struct filter_skip_tag
+{
+    typedef typename boost::iostreams::mode_of<Filter>::type filter_mode;
+    typedef typename boost::iostreams::mode_of<Device>::type device_mode;
+
+    typedef boost::mpl::and_<
+        boost::is_convertible<filter_mode, boost::iostreams::input_seekable>,
+        boost::is_convertible<device_mode, boost::iostreams::input_seekable>
+    > can_seek;
+
+    typedef typename boost::mpl::if_<
+        boost::is_convertible<
+            typename boost::iostreams::category_of<Filter>::type,
+            skippable_tag
+        >,
+        skippable_tag,
+        typename boost::mpl::if_<
+            can_seek,
+            boost::iostreams::input_seekable,
+            boost::iostreams::any_tag
+        >::type
+    >::type type;
+};
 
 } // namespace detail
 
+// the buffer is reused by the following calls if the device cannot seek
+template<typename Device>
+void skip(
+    Device& dev, boost::iostreams::stream_offset off,
+    std::vector<char>& buffer)
+{
+    typedef typename boost::iostreams::detail::dispatch<
+        Device,
+        skippable_tag,
+        boost::iostreams::input_seekable,
+        boost::iostreams::any_tag
+    >::type tag;
+
+    detail::skip_impl<tag>::skip(dev, off, buffer);
+}
+
 template<typename Device>
 void skip(Device& dev, boost::iostreams::stream_offset off)
-{ 
-    typedef typename boost::iostreams::mode_of<Device>::type mode;
+{
+    std::vector<char> buffer;
+    iostreams::skip(dev, off, buffer);
+}
 
-    typedef boost::is_convertible<
-        mode,
-        boost::iostreams::input_seekable
-    > can_seek;
+template<typename Filter, typename Device>
+void skip(
+    Filter& flt, Device& dev, boost::iostreams::stream_offset off,
+    std::vector<char>& buffer)
+{
+    typedef typename detail::filter_skip_tag<Filter,Device>::type tag;
 
-    detail::skip_impl(dev, off, can_seek());
+    detail::skip_impl<tag>::skip(flt, dev, off, buffer);
 }
 
 template<typename Filter, typename Device>
 void skip(Filter& flt, Device& dev, boost::iostreams::stream_offset off)
-{ 
-    typedef typename boost::iostreams::mode_of<Filter>::type filter_mode;
-    typedef typename boost::iostreams::mode_of<Device>::type device_mode;
-
-    typedef boost::mpl::and_<
-        boost::is_convertible<filter_mode, boost::iostreams::input_seekable>,
-        boost::is_convertible<device_mode, boost::iostreams::input_seekable>
-    > can_seek;
-
-    detail::skip_impl(flt, dev, off, can_seek());
+{
+    std::vector<char> buffer;
+    iostreams::skip(flt, dev, off, buffer);
 }
 
 } } // End namespaces iostreams, hamigaki.
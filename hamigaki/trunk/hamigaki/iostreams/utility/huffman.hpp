@@ -126,76 +126,125 @@ public:
     typedef typename boost::uint_t<Bits>::least code_type;
     typedef Value value_type;
 
+    // the number of bits looked up by the first level table
+    static const std::size_t table_bits = Bits < 10 ? Bits : 10;
+
 private:
+    static const std::size_t sub_table_bits = Bits - table_bits;
+    static const std::size_t link_mark = Bits + 1;
+
+    // bits == 0         : unused code
+    // bits == link_mark : the code continues into the table at "next"
     struct node
     {
-        value_type next[2];
+        value_type value;
+        std::size_t bits;
+        std::size_t next;
 
-        node()
+        node() : value(), bits(0), next(0)
         {
-            next[0] = value_type();
-            next[1] = value_type();
         }
     };
 
-    typedef std::vector<node> tree_type;
+    typedef std::vector<node> table_type;
 
 public:
-    huffman_decoder()
+    huffman_decoder() : table_(1), max_bits_(0)
     {
-        tree_.push_back(node());
     }
 
     void clear()
     {
-        tree_.clear();
-        tree_.push_back(node());
+        table_.clear();
+        table_.resize(1);
+        max_bits_ = 0;
     }
 
     void reserve(std::size_t n)
     {
-        tree_.reserve(n);
+        table_.reserve(n);
     }
 
     void assign(const value_type& x)
     {
-        tree_.clear();
-        tree_.push_back(node());
-        tree_.back().next[0] = x;
+        this->clear();
+        table_[0].value = x;
     }
 
     void insert(code_type code, std::size_t bits, const value_type& value)
     {
-        value_type pos = 0;
-        std::size_t bits1 = bits-1;
-        for (std::size_t i = 0; i < bits; ++i)
+        BOOST_ASSERT((bits != 0) && (bits <= Bits));
+
+        if (max_bits_ == 0)
+            table_.resize(static_cast<std::size_t>(1) << table_bits);
+        if (bits > max_bits_)
+            max_bits_ = bits;
+
+        node x;
+        x.value = value;
+        x.bits = bits;
+
+        if (bits <= table_bits)
         {
-            bool b = (code & (1 << (bits1-i))) != 0;
-            value_type next = tree_[pos].next[b];
-            if (!next)
+            std::size_t shift = table_bits - bits;
+            std::size_t first = static_cast<std::size_t>(code) << shift;
+            std::fill_n(
+                table_.begin() + first,
+                static_cast<std::size_t>(1) << shift, x);
+        }
+        else
+        {
+            std::size_t long_bits = bits - table_bits;
+            std::size_t prefix = static_cast<std::size_t>(code) >> long_bits;
+
+            if (table_[prefix].bits != link_mark)
             {
-                if (tree_.size() >= (std::numeric_limits<value_type>::max)())
-                    throw std::runtime_error("huffman tree overflow");
-                next = static_cast<value_type>(tree_.size());
-                tree_[pos].next[b] = next;
-                tree_.push_back(node());
+                if (table_[prefix].bits != 0)
+                    throw std::runtime_error("bad huffman code");
+
+                table_[prefix].bits = link_mark;
+                table_[prefix].next = table_.size();
+                table_.resize(
+                    table_.size() +
+                    (static_cast<std::size_t>(1) << sub_table_bits));
             }
-            pos = next;
+
+            std::size_t shift = sub_table_bits - long_bits;
+            std::size_t mask = (static_cast<std::size_t>(1) << long_bits) - 1;
+            std::size_t first =
+                table_[prefix].next +
+                ((static_cast<std::size_t>(code) & mask) << shift);
+            std::fill_n(
+                table_.begin() + first,
+                static_cast<std::size_t>(1) << shift, x);
         }
-        tree_[pos].next[0] = value;
     }
 
     template<class InputBitStream>
     value_type decode(InputBitStream& bs) const
     {
-        value_type pos = 0;
-        while (tree_[pos].next[1])
-            pos = tree_[pos].next[bs.get_bit()];
-        return tree_[pos].next[0];
+        if (max_bits_ == 0)
+            return table_[0].value;
+
+        std::size_t code = bs.peek_bits(Bits);
+        const node* x = &table_[code >> sub_table_bits];
+        if (x->bits == link_mark)
+        {
+            std::size_t mask =
+                (static_cast<std::size_t>(1) << sub_table_bits) - 1;
+            x = &table_[x->next + (code & mask)];
+        }
+
+        if (x->bits == 0)
+            throw std::runtime_error("bad huffman code");
+
+        bs.skip_bits(x->bits);
+        return x->value;
     }
 
 private:
-    tree_type tree_;
+    table_type table_;
+    std::size_t max_bits_;
 };
 
 template<class Length>
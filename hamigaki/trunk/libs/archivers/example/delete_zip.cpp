@@ -8,16 +8,14 @@
 // See http://hamigaki.sourceforge.jp/libs/archivers for library home page.
 
 #include <hamigaki/archivers/raw_zip_file.hpp>
-#include <boost/filesystem/convenience.hpp>
-#include <boost/filesystem/operations.hpp>
-#include <boost/iostreams/copy.hpp>
+#include <boost/filesystem/path.hpp>
 #include <clocale>
 #include <exception>
 #include <iostream>
+#include <vector>
 
 namespace ar = hamigaki::archivers;
 namespace fs = boost::filesystem;
-namespace io = boost::iostreams;
 
 bool is_parent_of(const fs::path& parent, const fs::path& child)
 {
@@ -53,32 +51,23 @@ int main(int argc, char* argv[])
 
         std::setlocale(LC_ALL, "");
 
-        fs::path zip_name(argv[1]);
-        const fs::path& bak_name = change_extension(zip_name, ".bak");
-        rename(zip_name, bak_name);
-
         fs::path del_name(argv[2]);
 
-        {
-            ar::raw_zip_file_source src(bak_name.file_string());
-            ar::raw_zip_file_sink sink(zip_name.file_string());
-
-            while (src.next_entry())
-            {
-                const ar::zip::header& head = src.header();
-
-                if ((head.path == del_name) || is_parent_of(del_name,head.path))
-                    continue;
+        // the entries are erased in place without copying the whole archive
+        ar::raw_zip_file_updater updater(argv[1]);
 
-                sink.create_entry(head);
-
-                if (head.compressed_size != 0)
-                    io::copy(src, sink);
-            }
-            sink.close_archive();
+        std::vector<fs::path> erased;
+        for (std::size_t i = 0; i < updater.entries(); ++i)
+        {
+            fs::path ph = updater.header(i).path;
+            if ((ph == del_name) || is_parent_of(del_name, ph))
+                erased.push_back(ph);
         }
 
-        remove(bak_name);
+        for (std::size_t i = 0; i < erased.size(); ++i)
+            updater.erase_entry(erased[i]);
+
+        updater.close_archive();
         return 0;
     }
     catch (const std::exception& e)
@@ -0,0 +1,113 @@
+// zip_lookup_benchmark.cpp: measures the lookup of ZIP entries by path
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/archivers for library home page.
+
+// Usage: zip_lookup_benchmark [(number of entries)]
+// Makes a ZIP archive in a temporary file and selects every entry by path
+// in the reverse order. More than 65535 entries need the ZIP64 end of
+// central directory record.
+
+#include <hamigaki/archivers/zip_file.hpp>
+#include <hamigaki/iostreams/device/tmp_file.hpp>
+#include <hamigaki/iostreams/dont_close.hpp>
+#include <boost/lexical_cast.hpp>
+#include <ctime>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace ar = hamigaki::archivers;
+namespace io_ex = hamigaki::iostreams;
+namespace io = boost::iostreams;
+
+std::string entry_name(std::size_t i)
+{
+    std::ostringstream os;
+    os << "dir" << (i % 10) << '/' << i << ".dat";
+    return os.str();
+}
+
+double elapsed(std::clock_t start)
+{
+    return static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+}
+
+void print_time(const char* name, double sec)
+{
+    std::cout
+        << std::setw(8) << name
+        << std::setw(10) << std::fixed << std::setprecision(3)
+        << sec << " sec"
+        << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        std::size_t count = 100000;
+        if (argc > 1)
+            count = boost::lexical_cast<std::size_t>(argv[1]);
+
+        io_ex::tmp_file archive;
+
+        std::clock_t start = std::clock();
+        {
+            ar::basic_zip_file_sink<
+                io_ex::dont_close_device<io_ex::tmp_file>
+            > sink(io_ex::dont_close(archive));
+
+            ar::zip::header head;
+            head.method = ar::zip::method::store;
+            head.update_time = std::time(0);
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                head.path = entry_name(i);
+                head.file_size = 1;
+                sink.create_entry(head);
+                char c = static_cast<char>(i);
+                io_ex::blocking_write(sink, &c, 1);
+                sink.close();
+            }
+            sink.close_archive();
+        }
+        print_time("create", elapsed(start));
+
+        io::seek(archive, 0, BOOST_IOS::beg);
+
+        start = std::clock();
+        ar::basic_zip_file_source<io_ex::tmp_file> src(archive);
+        print_time("open", elapsed(start));
+
+        start = std::clock();
+        for (std::size_t i = count; i-- != 0; )
+        {
+            const std::string& name = entry_name(i);
+            src.select_entry(name);
+
+            char c = 0;
+            io_ex::blocking_read(src, &c, 1);
+            if ((src.header().path.string() != name) ||
+                (c != static_cast<char>(i)) )
+            {
+                throw std::runtime_error("bad entry: " + name);
+            }
+        }
+        print_time("lookup", elapsed(start));
+
+        return 0;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+    return 1;
+}
@@ -0,0 +1,204 @@
+// tar_index_test.cpp: test case for the indexed tar.gz/tar.bz2
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/archivers for library home page.
+
+#include <hamigaki/archivers/indexed_tar_file.hpp>
+#include <hamigaki/archivers/tar_file.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/bzip2.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/compose.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ar = hamigaki::archivers;
+namespace io_ex = hamigaki::iostreams;
+namespace io = boost::iostreams;
+namespace ut = boost::unit_test;
+
+typedef io::back_insert_device<std::string> string_sink;
+
+// the lines which are not compressed too well
+std::string make_data(std::size_t i)
+{
+    std::ostringstream os;
+    unsigned long x = static_cast<unsigned long>(i) + 1;
+    for (std::size_t j = 0; j < (i%7)*600; ++j)
+    {
+        x = (x * 1103515245ul + 12345ul) & 0x7FFFFFFFul;
+        os << "line " << j << ' ' << x << '\n';
+    }
+    return os.str();
+}
+
+std::string entry_name(std::size_t i)
+{
+    std::ostringstream os;
+    os << "dir" << i%3 << "/entry" << i << ".txt";
+    return os.str();
+}
+
+void make_tar(std::string& tar, std::vector<std::string>& contents)
+{
+    ar::basic_tar_file_sink<string_sink> sink((string_sink(tar)));
+
+    ar::tar::header head;
+    head.type_flag = ar::tar::type_flag::directory;
+    head.path = "dir0";
+    head.permissions = 0755;
+    sink.create_entry(head);
+    sink.close();
+
+    for (std::size_t i = 0; i < 60; ++i)
+    {
+        const std::string& data = make_data(i);
+        contents.push_back(data);
+
+        ar::tar::header head;
+        head.type_flag = ar::tar::type_flag::regular;
+        head.path = entry_name(i);
+        head.file_size = data.size();
+        head.permissions = 0644;
+
+        sink.create_entry(head);
+        if (!data.empty())
+            io_ex::blocking_write(sink, &data[0], data.size());
+        sink.close();
+    }
+    sink.close_archive();
+}
+
+// compresses the data as two members (streams) like "cat a.gz b.gz"
+template<class Compressor>
+void append_compressed(
+    std::string& out, const std::string& data, const Compressor& comp)
+{
+    std::size_t half = data.size() / 2;
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+        std::size_t first = i == 0 ? 0 : half;
+        std::size_t last = i == 0 ? half : data.size();
+
+        io::copy(
+            io::array_source(data.data() + first, last - first),
+            io::compose(comp, string_sink(out)));
+    }
+}
+
+void write_file(const std::string& filename, const std::string& data)
+{
+    io_ex::file_sink sink(filename, BOOST_IOS::binary);
+    io_ex::blocking_write(sink, &data[0], data.size());
+}
+
+void check_index(
+    const std::string& filename, const ar::tar::archive_index& index,
+    const std::vector<std::string>& contents)
+{
+    BOOST_REQUIRE_EQUAL(index.entries.size(), contents.size() + 1);
+    BOOST_CHECK(index.checkpoints.size() > 2);
+
+    const std::string& idx_name = filename + ".idx";
+    ar::tar::save_index(index, idx_name);
+    const ar::tar::archive_index& loaded = ar::tar::load_index(idx_name);
+    std::remove(idx_name.c_str());
+
+    BOOST_CHECK_EQUAL(loaded.checkpoints.size(), index.checkpoints.size());
+
+    ar::indexed_tar_file_source src(filename, loaded);
+
+    // the random order
+    std::vector<std::size_t> order;
+    for (std::size_t i = 0; i < contents.size(); ++i)
+        order.push_back((i * 37) % contents.size());
+    order.push_back(contents.size() - 1);
+    order.push_back(0);
+
+    for (std::size_t i = 0; i < order.size(); ++i)
+    {
+        std::size_t n = order[i];
+        BOOST_REQUIRE(src.select_entry(entry_name(n)));
+        BOOST_CHECK_EQUAL(src.header().path.string(), entry_name(n));
+
+        std::string data;
+        io::copy(src, io::back_inserter(data));
+        BOOST_CHECK(data == contents[n]);
+    }
+
+    BOOST_CHECK(!src.select_entry("not_found.txt"));
+
+    // the sequential access after the selection
+    BOOST_REQUIRE(src.select_entry("dir0"));
+    BOOST_CHECK(src.header().is_directory());
+    for (std::size_t i = 0; i < contents.size(); ++i)
+    {
+        BOOST_REQUIRE(src.next_entry());
+        BOOST_CHECK_EQUAL(src.header().path.string(), entry_name(i));
+
+        std::string data;
+        io::copy(src, io::back_inserter(data));
+        BOOST_CHECK(data == contents[i]);
+    }
+    BOOST_CHECK(!src.next_entry());
+}
+
+void tgz_index_test()
+{
+    std::string tar;
+    std::vector<std::string> contents;
+    make_tar(tar, contents);
+    BOOST_REQUIRE(tar.size() > 1024*1024);
+
+    std::string tgz;
+    append_compressed(tgz, tar, io::gzip_compressor());
+
+    const std::string filename("tar_index_test.tar.gz");
+    write_file(filename, tgz);
+
+    const ar::tar::archive_index& index =
+        ar::make_tgz_index(io_ex::file_source(filename, BOOST_IOS::binary),
+        32*1024);
+    BOOST_CHECK(index.compression == ar::tar::index_compression::gzip);
+    check_index(filename, index, contents);
+
+    std::remove(filename.c_str());
+}
+
+void tbz2_index_test()
+{
+    std::string tar;
+    std::vector<std::string> contents;
+    make_tar(tar, contents);
+
+    std::string tbz2;
+    append_compressed(tbz2, tar, io::bzip2_compressor(io::bzip2_params(1)));
+
+    const std::string filename("tar_index_test.tar.bz2");
+    write_file(filename, tbz2);
+
+    const ar::tar::archive_index& index =
+        ar::make_tbz2_index(io_ex::file_source(filename, BOOST_IOS::binary));
+    BOOST_CHECK(index.compression == ar::tar::index_compression::bzip2);
+    check_index(filename, index, contents);
+
+    std::remove(filename.c_str());
+}
+
+ut::test_suite* init_unit_test_suite(int, char* [])
+{
+    ut::test_suite* test = BOOST_TEST_SUITE("tar index test");
+    test->add(BOOST_TEST_CASE(&tgz_index_test));
+    test->add(BOOST_TEST_CASE(&tbz2_index_test));
+    return test;
+}
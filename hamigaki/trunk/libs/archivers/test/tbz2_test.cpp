@@ -0,0 +1,96 @@
+// tbz2_test.cpp: test case for tar.bz2
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/archivers for library home page.
+
+#include <hamigaki/archivers/tbz2_file.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ar = hamigaki::archivers;
+namespace fs_ex = hamigaki::filesystem;
+namespace io_ex = hamigaki::iostreams;
+namespace io = boost::iostreams;
+namespace ut = boost::unit_test;
+
+std::string make_data(std::size_t i)
+{
+    std::ostringstream os;
+    for (std::size_t j = 0; j < i*i*150; ++j)
+        os << "line " << j % (i+1) << '\n';
+    return os.str();
+}
+
+void tbz2_test_aux(std::size_t thread_count)
+{
+    std::vector<std::string> contents;
+
+    const std::string filename("tbz2_test.tar.bz2");
+    {
+        ar::tbz2_file_sink sink(filename);
+
+        for (std::size_t i = 0; i < 20; ++i)
+        {
+            std::ostringstream os;
+            os << "entry" << i << ".txt";
+
+            const std::string& data = make_data(i);
+            contents.push_back(data);
+
+            ar::tar::header head;
+            head.type_flag = ar::tar::type_flag::regular;
+            head.path = os.str();
+            head.modified_time = fs_ex::timestamp::from_time_t(std::time(0));
+            head.file_size = data.size();
+            head.permissions = 0644;
+
+            sink.create_entry(head);
+            if (!data.empty())
+                io_ex::blocking_write(sink, &data[0], data.size());
+            sink.close();
+        }
+        sink.close_archive();
+    }
+
+    // the archive consists of some bzip2 blocks
+    ar::tbz2_file_source src(filename, thread_count);
+    for (std::size_t i = 0; i < contents.size(); ++i)
+    {
+        BOOST_REQUIRE(src.next_entry());
+
+        std::string data;
+        io::copy(src, io::back_inserter(data));
+        BOOST_CHECK(data == contents[i]);
+    }
+    BOOST_CHECK(!src.next_entry());
+
+    std::remove(filename.c_str());
+}
+
+void tbz2_test()
+{
+    tbz2_test_aux(0);
+}
+
+void parallel_tbz2_test()
+{
+    tbz2_test_aux(1);
+    tbz2_test_aux(4);
+}
+
+ut::test_suite* init_unit_test_suite(int, char* [])
+{
+    ut::test_suite* test = BOOST_TEST_SUITE("tar.bz2 test");
+    test->add(BOOST_TEST_CASE(&tbz2_test));
+    test->add(BOOST_TEST_CASE(&parallel_tbz2_test));
+    return test;
+}
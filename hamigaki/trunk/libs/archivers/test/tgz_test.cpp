@@ -0,0 +1,98 @@
+// tgz_test.cpp: test case for tar.gz
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/archivers for library home page.
+
+#include <hamigaki/archivers/tgz_file.hpp>
+#include <hamigaki/iostreams/device/tmp_file.hpp>
+#include <hamigaki/iostreams/dont_close.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/test/unit_test.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ar = hamigaki::archivers;
+namespace fs_ex = hamigaki::filesystem;
+namespace io_ex = hamigaki::iostreams;
+namespace io = boost::iostreams;
+namespace ut = boost::unit_test;
+
+std::string make_data(std::size_t i)
+{
+    std::ostringstream os;
+    for (std::size_t j = 0; j < i*i*37; ++j)
+        os << "line " << j % (i+1) << '\n';
+    return os.str();
+}
+
+void tgz_test_aux(std::size_t thread_count)
+{
+    std::vector<std::string> contents;
+
+    io_ex::tmp_file archive;
+    {
+        ar::basic_tgz_file_sink<
+            io_ex::dont_close_device<io_ex::tmp_file>
+        > sink(io_ex::dont_close(archive), thread_count);
+
+        for (std::size_t i = 0; i < 20; ++i)
+        {
+            std::ostringstream os;
+            os << "entry" << i << ".txt";
+
+            const std::string& data = make_data(i);
+            contents.push_back(data);
+
+            ar::tar::header head;
+            head.type_flag = ar::tar::type_flag::regular;
+            head.path = os.str();
+            head.modified_time = fs_ex::timestamp::from_time_t(std::time(0));
+            head.file_size = data.size();
+            head.permissions = 0644;
+
+            sink.create_entry(head);
+            if (!data.empty())
+                io_ex::blocking_write(sink, &data[0], data.size());
+            sink.close();
+        }
+        sink.close_archive();
+    }
+
+    io::seek(archive, 0, BOOST_IOS::beg);
+
+    ar::basic_tgz_file_source<io_ex::tmp_file> src(archive);
+    for (std::size_t i = 0; i < contents.size(); ++i)
+    {
+        BOOST_REQUIRE(src.next_entry());
+
+        std::string data;
+        io::copy(src, io::back_inserter(data));
+        BOOST_CHECK(data == contents[i]);
+    }
+    BOOST_CHECK(!src.next_entry());
+}
+
+void tgz_test()
+{
+    tgz_test_aux(0);
+}
+
+void parallel_tgz_test()
+{
+    tgz_test_aux(1);
+    tgz_test_aux(4);
+}
+
+ut::test_suite* init_unit_test_suite(int, char* [])
+{
+    ut::test_suite* test = BOOST_TEST_SUITE("tar.gz test");
+    test->add(BOOST_TEST_CASE(&tgz_test));
+    test->add(BOOST_TEST_CASE(&parallel_tgz_test));
+    return test;
+}
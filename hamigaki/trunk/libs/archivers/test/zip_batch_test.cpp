@@ -0,0 +1,175 @@
+// zip_batch_test.cpp: test case for zip_file_batch_sink
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/archivers for library home page.
+
+#include <hamigaki/archivers/zip_file.hpp>
+#include <hamigaki/archivers/zip_file_batch_sink.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ar = hamigaki::archivers;
+namespace io = boost::iostreams;
+namespace ut = boost::unit_test;
+
+class string_source
+{
+public:
+    typedef char char_type;
+    typedef io::source_tag category;
+
+    explicit string_source(const std::string& s) : data_(s), pos_(0)
+    {
+    }
+
+    std::streamsize read(char* s, std::streamsize n)
+    {
+        std::streamsize rest =
+            static_cast<std::streamsize>(data_.size() - pos_);
+        if (rest == 0)
+            return -1;
+
+        std::streamsize amt = (std::min)(n, rest);
+        data_.copy(s, static_cast<std::size_t>(amt), pos_);
+        pos_ += static_cast<std::size_t>(amt);
+        return amt;
+    }
+
+private:
+    std::string data_;
+    std::size_t pos_;
+};
+
+std::string make_data(std::size_t i)
+{
+    std::ostringstream os;
+    for (std::size_t j = 0; j < i*37; ++j)
+        os << "line " << j % (i+1) << '\n';
+    return os.str();
+}
+
+std::string make_random_data(std::size_t size)
+{
+    std::string data;
+    boost::uint32_t x = 12345;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        x = x * 1103515245u + 12345u;
+        data += static_cast<char>(x >> 24);
+    }
+    return data;
+}
+
+void zip_batch_test_aux(std::size_t thread_count, bool encrypted)
+{
+    const char filename[] = "zip_batch_test.zip";
+    std::vector<ar::zip::header> headers;
+    std::vector<std::string> contents;
+
+    ar::zip::header dir;
+    dir.path = "dir";
+    dir.update_time = std::time(0);
+    dir.attributes = ar::msdos::attributes::directory;
+    headers.push_back(dir);
+    contents.push_back(std::string());
+
+    for (std::size_t i = 0; i < 40; ++i)
+    {
+        std::ostringstream os;
+        os << "dir/entry" << i << ".txt";
+
+        ar::zip::header head;
+        head.path = os.str();
+        head.update_time = std::time(0);
+        head.encrypted = encrypted && (i % 2 == 0);
+        if (i % 5 == 0)
+            head.method = ar::zip::method::store;
+        headers.push_back(head);
+
+        if (i % 7 == 3)
+            contents.push_back(make_random_data(i*100));
+        else
+            contents.push_back(make_data(i));
+    }
+
+    // larger than the in-memory buffer
+    std::string large_data;
+    while (large_data.size() < 5*1024*1024)
+        large_data += make_data(40);
+
+    ar::zip::header large;
+    large.path = "large.txt";
+    large.update_time = std::time(0);
+    headers.push_back(large);
+    contents.push_back(large_data);
+
+    // the compressed data of the random data is larger
+    large.path = "large.dat";
+    large.encrypted = encrypted;
+    headers.push_back(large);
+    contents.push_back(make_random_data(5*1024*1024));
+
+    {
+        ar::zip_file_batch_sink zip(filename, thread_count);
+        zip.password("password");
+        for (std::size_t i = 0; i < headers.size(); ++i)
+        {
+            if (headers[i].is_directory())
+                zip.add_entry(headers[i]);
+            else
+                zip.add_entry(headers[i], string_source(contents[i]));
+
+            if (i == headers.size() / 2)
+                zip.flush();
+        }
+        zip.close_archive();
+    }
+
+    ar::zip_file_source zip(filename);
+    zip.password("password");
+    for (std::size_t i = 0; i < headers.size(); ++i)
+    {
+        BOOST_REQUIRE(zip.next_entry());
+
+        const ar::zip::header& head = zip.header();
+        BOOST_CHECK_EQUAL(head.path.string(), headers[i].path.string());
+        BOOST_CHECK_EQUAL(head.is_directory(), headers[i].is_directory());
+        BOOST_CHECK_EQUAL(head.encrypted, headers[i].encrypted);
+
+        if (head.is_directory())
+            continue;
+
+        BOOST_CHECK_EQUAL(head.file_size, contents[i].size());
+
+        std::string data;
+        io::copy(zip, io::back_inserter(data));
+        BOOST_CHECK(data == contents[i]);
+    }
+    BOOST_CHECK(!zip.next_entry());
+
+    std::remove(filename);
+}
+
+void zip_batch_test()
+{
+    zip_batch_test_aux(1, false);
+    zip_batch_test_aux(4, false);
+    zip_batch_test_aux(4, true);
+}
+
+ut::test_suite* init_unit_test_suite(int, char* [])
+{
+    ut::test_suite* test = BOOST_TEST_SUITE("ZIP batch sink test");
+    test->add(BOOST_TEST_CASE(&zip_batch_test));
+    return test;
+}
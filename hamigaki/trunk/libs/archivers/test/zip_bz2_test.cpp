@@ -13,6 +13,7 @@
 #include <boost/iostreams/device/back_inserter.hpp>
 #include <boost/iostreams/copy.hpp>
 #include <boost/test/unit_test.hpp>
+#include <sstream>
 #include <string>
 
 namespace ar = hamigaki::archivers;
@@ -76,9 +77,62 @@ void bz2_test()
     BOOST_CHECK(!src.next_entry());
 }
 
+std::string make_data(std::size_t size)
+{
+    std::ostringstream os;
+    boost::uint32_t x = 1;
+    while (os.tellp() < static_cast<std::streamoff>(size))
+    {
+        x = x * 1103515245u + 12345u;
+        os << "line " << ((x >> 16) % 10000) << '\n';
+    }
+    return os.str();
+}
+
+void parallel_bz2_test()
+{
+    // the large entry consists of some bzip2 blocks
+    std::string data[2] = { make_data(2*1024*1024), make_data(1000) };
+
+    io_ex::tmp_file archive;
+    ar::basic_zip_file_sink<
+        io_ex::dont_close_device<io_ex::tmp_file>
+    > sink(io_ex::dont_close(archive));
+
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+        ar::zip::header head;
+        head.path = i == 0 ? "large.dat" : "small.dat";
+        head.method = ar::zip::method::bzip2;
+        head.update_time = std::time(0);
+        head.file_size = static_cast<boost::uint32_t>(data[i].size());
+
+        sink.create_entry(head);
+        io_ex::blocking_write(sink, &data[i][0], data[i].size());
+        sink.close();
+    }
+    sink.close_archive();
+
+    io::seek(archive, 0, BOOST_IOS::beg);
+
+    ar::basic_zip_file_source<io_ex::tmp_file> src(archive);
+    src.thread_count(3);
+
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+        BOOST_REQUIRE(src.next_entry());
+
+        std::string data2;
+        io::copy(src, io::back_inserter(data2));
+        BOOST_CHECK(data2 == data[i]);
+    }
+    BOOST_CHECK(!src.next_entry());
+}
+
 ut::test_suite* init_unit_test_suite(int, char* [])
 {
     ut::test_suite* test = BOOST_TEST_SUITE("ZIP test");
     test->add(BOOST_TEST_CASE(&bz2_test));
+    test->add(BOOST_TEST_CASE(&parallel_bz2_test));
     return test;
 }
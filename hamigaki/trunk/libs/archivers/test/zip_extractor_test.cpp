@@ -0,0 +1,109 @@
+// zip_extractor_test.cpp: test case for zip_file_extractor
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/archivers for library home page.
+
+#include <hamigaki/archivers/zip_file.hpp>
+#include <hamigaki/archivers/zip_file_extractor.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace ar = hamigaki::archivers;
+namespace io_ex = hamigaki::iostreams;
+namespace io = boost::iostreams;
+namespace ut = boost::unit_test;
+
+typedef std::map<std::string,std::string> entry_map;
+
+class entry_collector
+{
+public:
+    entry_collector(boost::mutex& mutex, entry_map& entries)
+        : mutex_(&mutex), entries_(&entries)
+    {
+    }
+
+    void operator()(ar::zip_file_extractor::reader_type& src) const
+    {
+        std::string data;
+        io::copy(src, io::back_inserter(data));
+
+        boost::mutex::scoped_lock locking(*mutex_);
+        (*entries_)[src.header().path.string()] = data;
+    }
+
+private:
+    boost::mutex* mutex_;
+    entry_map* entries_;
+};
+
+std::string make_data(std::size_t i)
+{
+    std::ostringstream os;
+    for (std::size_t j = 0; j < i*37; ++j)
+        os << "line " << j % (i+1) << '\n';
+    return os.str();
+}
+
+void zip_extractor_test()
+{
+    const char filename[] = "zip_extractor_test.zip";
+    const std::size_t count = 64;
+
+    entry_map expected;
+    {
+        ar::zip_file_sink sink(filename);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::ostringstream os;
+            os << "entry" << i << ".txt";
+
+            const std::string& data = make_data(i);
+            expected[os.str()] = data;
+
+            ar::zip::header head;
+            head.path = os.str();
+            head.update_time = std::time(0);
+            head.file_size = static_cast<boost::uint32_t>(data.size());
+            if (i % 3 == 0)
+                head.method = ar::zip::method::store;
+
+            sink.create_entry(head);
+            if (!data.empty())
+                io_ex::blocking_write(sink, &data[0], data.size());
+            sink.close();
+        }
+        sink.close_archive();
+    }
+
+    const std::size_t threads[] = { 1, 4 };
+    for (std::size_t i = 0; i < sizeof(threads)/sizeof(threads[0]); ++i)
+    {
+        ar::zip_file_extractor extractor(filename);
+        BOOST_CHECK_EQUAL(extractor.entries(), count);
+
+        boost::mutex mutex;
+        entry_map entries;
+        extractor.extract(entry_collector(mutex, entries), threads[i]);
+
+        BOOST_CHECK(entries == expected);
+    }
+
+    std::remove(filename);
+}
+
+ut::test_suite* init_unit_test_suite(int, char* [])
+{
+    ut::test_suite* test = BOOST_TEST_SUITE("ZIP extractor test");
+    test->add(BOOST_TEST_CASE(&zip_extractor_test));
+    return test;
+}
@@ -0,0 +1,95 @@
+// zip_mapped_test.cpp: test case for ZIP on memory-mapped file
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/archivers for library home page.
+
+#include <hamigaki/archivers/zip_file.hpp>
+#include <hamigaki/iostreams/device/mapped_file.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ar = hamigaki::archivers;
+namespace io_ex = hamigaki::iostreams;
+namespace io = boost::iostreams;
+namespace ut = boost::unit_test;
+
+std::string make_data(std::size_t i)
+{
+    std::ostringstream os;
+    for (std::size_t j = 0; j < i*i*37; ++j)
+        os << "line " << j % (i+1) << '\n';
+    return os.str();
+}
+
+void zip_mapped_test()
+{
+    const std::string filename("zip_mapped_test.zip");
+
+    std::vector<std::string> contents;
+    {
+        ar::zip_file_sink sink(filename);
+        for (std::size_t i = 0; i < 10; ++i)
+        {
+            std::ostringstream os;
+            os << "entry" << i << ".txt";
+
+            const std::string& data = make_data(i);
+            contents.push_back(data);
+
+            ar::zip::header head;
+            head.path = os.str();
+            head.method = (i % 2 == 0)
+                ? ar::zip::method::store : ar::zip::method::deflate;
+            head.update_time = std::time(0);
+            head.file_size = static_cast<boost::uint32_t>(data.size());
+
+            sink.create_entry(head);
+            if (!data.empty())
+                io_ex::blocking_write(sink, &data[0], data.size());
+            sink.close();
+        }
+        sink.close_archive();
+    }
+
+    io_ex::mapped_file_source archive(filename, io_ex::map_advice::random);
+    ar::basic_zip_file_source<io_ex::mapped_file_source> src(archive);
+    for (std::size_t i = 0; i < contents.size(); ++i)
+    {
+        BOOST_REQUIRE(src.next_entry());
+
+        const ar::zip::header& head = src.header();
+        if (head.method == ar::zip::method::store)
+        {
+            // reads the stored entry without copying
+            BOOST_REQUIRE(
+                src.data_offset() + head.compressed_size <= archive.size());
+            const char* p =
+                archive.data() + static_cast<std::size_t>(src.data_offset());
+            BOOST_CHECK(std::string(p, p+head.file_size) == contents[i]);
+        }
+
+        std::string data;
+        io::copy(src, io::back_inserter(data));
+        BOOST_CHECK(data == contents[i]);
+    }
+    BOOST_CHECK(!src.next_entry());
+
+    archive.close();
+    std::remove(filename.c_str());
+}
+
+ut::test_suite* init_unit_test_suite(int, char* [])
+{
+    ut::test_suite* test = BOOST_TEST_SUITE("ZIP mapped file test");
+    test->add(BOOST_TEST_CASE(&zip_mapped_test));
+    return test;
+}
@@ -13,6 +13,7 @@
 #include <boost/iostreams/device/back_inserter.hpp>
 #include <boost/iostreams/copy.hpp>
 #include <boost/test/unit_test.hpp>
+#include <sstream>
 #include <string>
 
 namespace ar = hamigaki::archivers;
@@ -197,6 +198,51 @@ void unix_test()
     BOOST_CHECK(!src.next_entry());
 }
 
+void select_entry_test()
+{
+    // see example/zip_lookup_benchmark.cpp for the large archive
+    const std::size_t count = 100;
+
+    io_ex::tmp_file archive;
+    ar::basic_zip_file_sink<
+        io_ex::dont_close_device<io_ex::tmp_file>
+    > sink(io_ex::dont_close(archive));
+
+    ar::zip::header head;
+    head.method = ar::zip::method::store;
+    head.update_time = std::time(0);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        std::ostringstream os;
+        os << "dir" << (i % 10) << '/' << i << ".dat";
+        head.path = os.str();
+        head.file_size = 1;
+        sink.create_entry(head);
+        char c = static_cast<char>(i);
+        io_ex::blocking_write(sink, &c, 1);
+        sink.close();
+    }
+    sink.close_archive();
+
+    io::seek(archive, 0, BOOST_IOS::beg);
+
+    ar::basic_zip_file_source<io_ex::tmp_file> src(archive);
+
+    for (std::size_t i = count; i-- != 0; )
+    {
+        std::ostringstream os;
+        os << "dir" << (i % 10) << '/' << i << ".dat";
+        src.select_entry(os.str());
+        BOOST_REQUIRE_EQUAL(src.header().path.string(), os.str());
+
+        char c = 0;
+        io_ex::blocking_read(src, &c, 1);
+        BOOST_REQUIRE_EQUAL(c, static_cast<char>(i));
+    }
+
+    BOOST_CHECK_THROW(src.select_entry("dir0/1.dat"), std::runtime_error);
+}
+
 ut::test_suite* init_unit_test_suite(int, char* [])
 {
     ut::test_suite* test = BOOST_TEST_SUITE("ZIP test");
@@ -204,5 +250,6 @@ ut::test_suite* init_unit_test_suite(int, char* [])
     test->add(BOOST_TEST_CASE(&dir_test));
     test->add(BOOST_TEST_CASE(&symlink_test));
     test->add(BOOST_TEST_CASE(&unix_test));
+    test->add(BOOST_TEST_CASE(&select_entry_test));
     return test;
 }
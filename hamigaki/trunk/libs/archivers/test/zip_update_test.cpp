@@ -0,0 +1,269 @@
+// zip_update_test.cpp: test case for ZIP in-place update
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/archivers for library home page.
+
+#include <hamigaki/archivers/raw_zip_file.hpp>
+#include <hamigaki/archivers/zip_file.hpp>
+#include <hamigaki/iostreams/device/tmp_file.hpp>
+#include <hamigaki/iostreams/dont_close.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/test/unit_test.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ar = hamigaki::archivers;
+namespace io_ex = hamigaki::iostreams;
+namespace fs = boost::filesystem;
+namespace io = boost::iostreams;
+namespace ut = boost::unit_test;
+
+struct entry
+{
+    std::string path;
+    std::string data;
+
+    entry(const std::string& path, const std::string& data)
+        : path(path), data(data)
+    {
+    }
+};
+
+std::string make_data(std::size_t size, char c)
+{
+    std::string s;
+    for (std::size_t i = 0; i < size; ++i)
+        s += static_cast<char>(c + (i*i) % 7);
+    return s;
+}
+
+void make_archive(io_ex::tmp_file& archive, const std::vector<entry>& entries)
+{
+    ar::basic_zip_file_sink<
+        io_ex::dont_close_device<io_ex::tmp_file>
+    > sink(io_ex::dont_close(archive));
+
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        ar::zip::header head;
+        head.path = entries[i].path;
+        head.update_time = std::time(0);
+        head.file_size = entries[i].data.size();
+
+        sink.create_entry(head);
+        io_ex::blocking_write(sink, entries[i].data);
+        sink.close();
+    }
+    sink.close_archive();
+}
+
+void check_archive(io_ex::tmp_file& archive, const std::vector<entry>& entries)
+{
+    io::seek(archive, 0, BOOST_IOS::beg);
+    ar::basic_zip_file_source<io_ex::tmp_file> src(archive);
+
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        BOOST_REQUIRE(src.next_entry());
+        BOOST_CHECK_EQUAL(src.header().path.string(), entries[i].path);
+
+        std::string buf;
+        io::copy(src, io::back_inserter(buf));
+        BOOST_CHECK(buf == entries[i].data);
+    }
+    BOOST_CHECK(!src.next_entry());
+}
+
+io::stream_offset file_size(io_ex::tmp_file& archive)
+{
+    return io_ex::to_offset(io::seek(archive, 0, BOOST_IOS::end));
+}
+
+std::string read_all(io_ex::tmp_file& archive)
+{
+    io::seek(archive, 0, BOOST_IOS::beg);
+    std::string s;
+    io::copy(io_ex::dont_close(archive), io::back_inserter(s));
+    return s;
+}
+
+void write_all(io_ex::tmp_file& archive, const std::string& s)
+{
+    io::seek(archive, 0, BOOST_IOS::beg);
+    io_ex::blocking_write(archive, s);
+}
+
+boost::uint16_t get_uint16(const std::string& s, std::size_t pos)
+{
+    return static_cast<boost::uint16_t>(
+        static_cast<unsigned char>(s[pos]) |
+        (static_cast<unsigned char>(s[pos+1]) << 8) );
+}
+
+void set_uint16(std::string& s, std::size_t pos, boost::uint16_t n)
+{
+    s[pos] = static_cast<char>(n & 0xFF);
+    s[pos+1] = static_cast<char>(n >> 8);
+}
+
+// the offset of the first entry of the central directory
+std::size_t central_dir_offset(const std::string& s, std::size_t footer)
+{
+    return
+        get_uint16(s, footer + 16) |
+        (static_cast<std::size_t>(get_uint16(s, footer + 18)) << 16);
+}
+
+void erase_test()
+{
+    std::vector<entry> entries;
+    entries.push_back(entry("a.txt", make_data(3000, 'a')));
+    entries.push_back(entry("b.txt", make_data(5000, 'b')));
+    entries.push_back(entry("c.txt", make_data(7000, 'c')));
+    entries.push_back(entry("d.txt", make_data(1000, 'd')));
+
+    io_ex::tmp_file archive;
+    make_archive(archive, entries);
+    io::stream_offset old_size = file_size(archive);
+
+    {
+        ar::basic_raw_zip_file_updater<io_ex::tmp_file> updater(archive);
+        BOOST_CHECK_EQUAL(updater.entries(), 4u);
+        BOOST_CHECK(updater.erase_entry("b.txt"));
+        BOOST_CHECK(updater.erase_entry("d.txt"));
+        BOOST_CHECK(!updater.erase_entry("x.txt"));
+        updater.close_archive();
+    }
+
+    entries.erase(entries.begin()+3);
+    entries.erase(entries.begin()+1);
+    check_archive(archive, entries);
+
+    BOOST_CHECK(file_size(archive) < old_size);
+}
+
+void append_test()
+{
+    std::vector<entry> entries;
+    entries.push_back(entry("a.txt", make_data(3000, 'a')));
+    entries.push_back(entry("b.txt", make_data(5000, 'b')));
+
+    std::vector<entry> new_entries;
+    new_entries.push_back(entry("c.txt", make_data(7000, 'c')));
+    new_entries.push_back(entry("dir/d.txt", make_data(100, 'd')));
+
+    io_ex::tmp_file archive;
+    make_archive(archive, entries);
+
+    io_ex::tmp_file archive2;
+    make_archive(archive2, new_entries);
+    io::seek(archive2, 0, BOOST_IOS::beg);
+
+    {
+        ar::basic_raw_zip_file_source<io_ex::tmp_file> src(archive2);
+        ar::basic_raw_zip_file_updater<io_ex::tmp_file> updater(archive);
+
+        BOOST_CHECK(updater.erase_entry("a.txt"));
+
+        while (src.next_entry())
+        {
+            updater.create_entry(src.header());
+            io::copy(src, updater);
+        }
+
+        // the entries are erased before appending
+        BOOST_CHECK_THROW(updater.erase_entry("b.txt"), std::runtime_error);
+
+        updater.close_archive();
+    }
+
+    entries.erase(entries.begin());
+    entries.insert(entries.end(), new_entries.begin(), new_entries.end());
+    check_archive(archive, entries);
+}
+
+void append_only_test()
+{
+    std::vector<entry> entries;
+    entries.push_back(entry("a.txt", make_data(3000, 'a')));
+
+    std::vector<entry> new_entries;
+    new_entries.push_back(entry("b.txt", make_data(2000, 'b')));
+
+    io_ex::tmp_file archive;
+    make_archive(archive, entries);
+
+    io_ex::tmp_file archive2;
+    make_archive(archive2, new_entries);
+    io::seek(archive2, 0, BOOST_IOS::beg);
+
+    {
+        ar::basic_raw_zip_file_source<io_ex::tmp_file> src(archive2);
+        ar::basic_raw_zip_file_updater<io_ex::tmp_file> updater(archive);
+
+        BOOST_REQUIRE(src.next_entry());
+        updater.create_entry(src.header());
+        io::copy(src, updater);
+        updater.close_archive();
+    }
+
+    entries.insert(entries.end(), new_entries.begin(), new_entries.end());
+    check_archive(archive, entries);
+}
+
+void keep_central_dir_test()
+{
+    std::vector<entry> entries;
+    entries.push_back(entry("a.txt", make_data(3000, 'a')));
+    entries.push_back(entry("b.txt", make_data(5000, 'b')));
+
+    io_ex::tmp_file archive;
+    make_archive(archive, entries);
+
+    // made by UNIX, a text file, and the archive comment
+    const std::string comment("archive comment");
+    std::string data = read_all(archive);
+    std::size_t footer = data.size() - 22;
+    std::size_t cent = central_dir_offset(data, footer);
+    set_uint16(data, cent + 4, 0x031E);
+    set_uint16(data, cent + 36, 1);
+    set_uint16(
+        data, footer + 20, static_cast<boost::uint16_t>(comment.size()));
+    data += comment;
+    write_all(archive, data);
+
+    {
+        ar::basic_raw_zip_file_updater<io_ex::tmp_file> updater(archive);
+        BOOST_CHECK(updater.erase_entry("b.txt"));
+        updater.close_archive();
+    }
+
+    data = read_all(archive);
+    BOOST_REQUIRE(data.size() > comment.size() + 22);
+    BOOST_CHECK(data.substr(data.size() - comment.size()) == comment);
+
+    footer = data.size() - comment.size() - 22;
+    BOOST_CHECK_EQUAL(get_uint16(data, footer + 20), comment.size());
+    cent = central_dir_offset(data, footer);
+    BOOST_CHECK_EQUAL(get_uint16(data, cent + 4), 0x031Eu);
+    BOOST_CHECK_EQUAL(get_uint16(data, cent + 36), 1u);
+
+    entries.pop_back();
+    check_archive(archive, entries);
+}
+
+ut::test_suite* init_unit_test_suite(int, char* [])
+{
+    ut::test_suite* test = BOOST_TEST_SUITE("ZIP update test");
+    test->add(BOOST_TEST_CASE(&erase_test));
+    test->add(BOOST_TEST_CASE(&append_test));
+    test->add(BOOST_TEST_CASE(&append_only_test));
+    test->add(BOOST_TEST_CASE(&keep_central_dir_test));
+    return test;
+}
@@ -0,0 +1,93 @@
+// resample_benchmark.cpp: measures the throughput of the resampler
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+// Usage: resample_benchmark [seconds]
+// Converts the stereo sine wave of the given length (60 seconds by default)
+// and prints the speed relative to the real time for each quality.
+
+#include <hamigaki/audio/resample.hpp>
+#include <hamigaki/audio/sine_wave.hpp>
+#include <hamigaki/audio/stereo.hpp>
+#include <hamigaki/iostreams/tiny_restrict.hpp>
+#include <boost/iostreams/read.hpp>
+#include <boost/lexical_cast.hpp>
+#include <ctime>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace audio = hamigaki::audio;
+namespace io_ex = hamigaki::iostreams;
+namespace io = boost::iostreams;
+
+// prevents the optimizer from removing the computation
+volatile float result_sink;
+
+void benchmark(
+    const char* name, long in_rate, long out_rate,
+    audio::resample_quality::values q, long seconds)
+{
+    typedef io_ex::tiny_restriction<audio::sine_wave_source> sine_source;
+    typedef audio::stereophony<sine_source> source_type;
+
+    std::clock_t start = std::clock();
+
+    audio::resampler<source_type> rs(
+        audio::stereo(
+            io_ex::tiny_restrict(
+                audio::sine_wave_source(in_rate, 440.0f), in_rate*seconds)
+        ),
+        2, in_rate, out_rate, q
+    );
+
+    std::vector<float> buf(8192);
+    std::streamsize n;
+    while ((n = io::read(rs, &buf[0], 8192)) > 0)
+        result_sink = result_sink + buf[0];
+
+    double sec =
+        static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+
+    std::cout
+        << std::setw(28) << std::left << name << std::right
+        << std::setw(10) << std::fixed << std::setprecision(1)
+        << (sec != 0.0 ? static_cast<double>(seconds) / sec : 0.0)
+        << " x real time" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        long seconds = 60;
+        if (argc >= 2)
+            seconds = boost::lexical_cast<long>(argv[1]);
+
+        benchmark("44100->48000 fast", 44100, 48000,
+            audio::resample_quality::fast, seconds);
+        benchmark("44100->48000 medium", 44100, 48000,
+            audio::resample_quality::medium, seconds);
+        benchmark("44100->48000 best", 44100, 48000,
+            audio::resample_quality::best, seconds);
+        benchmark("48000->44100 medium", 48000, 44100,
+            audio::resample_quality::medium, seconds);
+        benchmark("22050->44100 medium", 22050, 44100,
+            audio::resample_quality::medium, seconds);
+        benchmark("44100->48001 medium", 44100, 48001,
+            audio::resample_quality::medium, seconds);
+
+        return 0;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+    return 1;
+}
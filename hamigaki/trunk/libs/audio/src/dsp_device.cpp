@@ -86,6 +86,15 @@ public:
         return true;
     }
 
+    // the ioctl() can be called while the other thread is in write()
+    std::streamsize delay() const
+    {
+        int bytes = 0;
+        if (::ioctl(fd_, SNDCTL_DSP_GETODELAY, &bytes) == -1)
+            throw BOOST_IOSTREAMS_FAILURE("cannot get DSP delay");
+        return bytes;
+    }
+
     void format(int value)
     {
         int tmp = value;
@@ -202,6 +211,11 @@ bool dsp_sink::flush()
     return pimpl_->flush();
 }
 
+std::streamsize dsp_sink::delay() const
+{
+    return pimpl_->delay();
+}
+
 void dsp_sink::close()
 {
     pimpl_->close();
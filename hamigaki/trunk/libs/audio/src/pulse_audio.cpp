@@ -10,6 +10,8 @@
 #define HAMIGAKI_AUDIO_SOURCE
 #include <hamigaki/audio/pulse_audio.hpp>
 #include <boost/iostreams/detail/ios.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/cstdint.hpp>
 #include <pulse/simple.h>
 
 namespace
@@ -38,7 +40,8 @@ namespace hamigaki { namespace audio {
 class pulse_audio_sink::impl
 {
 public:
-    impl(const char* app, const char* name, const pcm_format& fmt) : fmt_(fmt)
+    impl(const char* app, const char* name, const pcm_format& fmt)
+        : fmt_(fmt), delay_(0)
     {
         pa_sample_spec ss = {};
         ss.format = type_to_format(fmt.type);
@@ -63,6 +66,7 @@ public:
         if (::pa_simple_write(handle_, s, n, &error) < 0)
             throw BOOST_IOSTREAMS_FAILURE("pa_simple_write() failed");
 
+        publish_delay(get_latency());
         return n;
     }
 
@@ -76,11 +80,41 @@ public:
         int error;
         if (::pa_simple_drain(handle_, &error) < 0)
             throw BOOST_IOSTREAMS_FAILURE("pa_simple_write() failed");
+
+        publish_delay(0);
+    }
+
+    // pa_simple is not thread-safe, so the latency is sampled by write()
+    // and other threads read the last sample
+    std::streamsize delay() const
+    {
+        boost::mutex::scoped_lock locking(mutex_);
+        return delay_;
     }
 
 private:
     pa_simple* handle_;
     pcm_format fmt_;
+    mutable boost::mutex mutex_;
+    std::streamsize delay_;
+
+    std::streamsize get_latency()
+    {
+        int error;
+        ::pa_usec_t usec = ::pa_simple_get_latency(handle_, &error);
+        if (usec == static_cast< ::pa_usec_t>(-1))
+            throw BOOST_IOSTREAMS_FAILURE("pa_simple_get_latency() failed");
+
+        boost::uint64_t frames =
+            static_cast<boost::uint64_t>(usec) * fmt_.rate / 1000000u;
+        return static_cast<std::streamsize>(frames * fmt_.block_size());
+    }
+
+    void publish_delay(std::streamsize bytes)
+    {
+        boost::mutex::scoped_lock locking(mutex_);
+        delay_ = bytes;
+    }
 };
 
 pulse_audio_sink::pulse_audio_sink(
@@ -104,6 +138,11 @@ void pulse_audio_sink::close()
     pimpl_->close();
 }
 
+std::streamsize pulse_audio_sink::delay() const
+{
+    return pimpl_->delay();
+}
+
 
 class pulse_audio_source::impl
 {
@@ -95,6 +95,12 @@ void vorbis_file_base::seek(boost::int64_t pos)
         ::ov_pcm_seek(static_cast<OggVorbis_File*>(file_ptr_), pos));
 }
 
+void vorbis_file_base::raw_seek(boost::int64_t offset)
+{
+    vorbis_error::check(
+        ::ov_raw_seek(static_cast<OggVorbis_File*>(file_ptr_), offset));
+}
+
 boost::int64_t vorbis_file_base::tell()
 {
     boost::int64_t pos =
@@ -105,9 +111,20 @@ boost::int64_t vorbis_file_base::tell()
 }
 
 boost::int64_t vorbis_file_base::total()
+{
+    return this->total(-1);
+}
+
+int vorbis_file_base::links()
+{
+    long n = ::ov_streams(static_cast<OggVorbis_File*>(file_ptr_));
+    return static_cast<int>(n);
+}
+
+boost::int64_t vorbis_file_base::total(int link)
 {
     boost::int64_t pos =
-        ::ov_pcm_total(static_cast<OggVorbis_File*>(file_ptr_), -1);
+        ::ov_pcm_total(static_cast<OggVorbis_File*>(file_ptr_), link);
     if (pos < 0)
         throw vorbis_error(static_cast<int>(pos));
     return pos;
@@ -0,0 +1,201 @@
+// async_sink_test.cpp: test case for async_sink
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+#include <hamigaki/audio/async_sink.hpp>
+#include <boost/iostreams/write.hpp>
+#include <boost/detail/atomic_count.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/test/unit_test.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace audio = hamigaki::audio;
+namespace io = boost::iostreams;
+namespace ut = boost::unit_test;
+
+class gate : boost::noncopyable
+{
+public:
+    gate() : open_(true)
+    {
+    }
+
+    void close()
+    {
+        boost::mutex::scoped_lock locking(mutex_);
+        open_ = false;
+    }
+
+    void open()
+    {
+        boost::mutex::scoped_lock locking(mutex_);
+        open_ = true;
+        cond_.notify_all();
+    }
+
+    void wait()
+    {
+        boost::mutex::scoped_lock locking(mutex_);
+        while (!open_)
+            cond_.wait(locking);
+    }
+
+private:
+    boost::mutex mutex_;
+    boost::condition cond_;
+    bool open_;
+};
+
+bool device_closed = false;
+
+// the device appends to the string after the gate is opened
+class fake_device
+{
+public:
+    typedef char char_type;
+
+    struct category
+        : io::sink_tag
+        , io::closable_tag
+        , audio::delay_tag
+    {};
+
+    fake_device(
+            const boost::shared_ptr<std::string>& data, gate& g,
+            std::streamsize delay)
+        : data_(data), gate_(&g), delay_(delay), fail_(false)
+    {
+    }
+
+    std::streamsize write(const char* s, std::streamsize n)
+    {
+        gate_->wait();
+        if (fail_)
+            throw std::runtime_error("device error");
+        data_->append(s, n);
+        return n;
+    }
+
+    void close()
+    {
+        device_closed = true;
+    }
+
+    std::streamsize delay() const
+    {
+        return delay_;
+    }
+
+    void fail()
+    {
+        fail_ = true;
+    }
+
+private:
+    boost::shared_ptr<std::string> data_;
+    gate* gate_;
+    std::streamsize delay_;
+    bool fail_;
+};
+
+void data_test()
+{
+    std::string data;
+    for (int i = 0; i < 100000; ++i)
+        data += static_cast<char>(i * 7 + i / 251);
+
+    boost::shared_ptr<std::string> out(new std::string);
+    gate g;
+    {
+        audio::async_sink<fake_device> sink(fake_device(out, g, 0), 1000, 3);
+        BOOST_CHECK_EQUAL(sink.optimal_buffer_size(), 1000);
+
+        // the odd sized writes
+        for (std::size_t pos = 0; pos < data.size(); pos += 777)
+        {
+            std::size_t n = (std::min)(data.size() - pos, std::size_t(777));
+            BOOST_CHECK_EQUAL(
+                io::write(sink, data.c_str() + pos,
+                    static_cast<std::streamsize>(n)),
+                static_cast<std::streamsize>(n));
+        }
+        sink.flush();
+        BOOST_CHECK_EQUAL(sink.queued(), 0);
+        BOOST_CHECK_EQUAL(sink.position(),
+            static_cast<io::stream_offset>(data.size()));
+
+        // the rest of a buffer is written when closed
+        io::write(sink, "abc", 3);
+        device_closed = false;
+        sink.close();
+        BOOST_CHECK(device_closed);
+    }
+
+    BOOST_CHECK(*out == data + "abc");
+}
+
+boost::detail::atomic_count notified(0);
+
+void on_notify()
+{
+    ++notified;
+}
+
+void queue_test()
+{
+    boost::shared_ptr<std::string> out(new std::string);
+    gate g;
+    g.close();
+
+    audio::async_sink<fake_device> sink(fake_device(out, g, 50), 100, 4);
+    sink.notify(&on_notify);
+
+    // the device is blocked, but the caller is not
+    std::vector<char> buf(1000, 'x');
+    std::streamsize n = sink.write_some(&buf[0], 1000);
+    BOOST_CHECK_EQUAL(n, 400);
+    BOOST_CHECK_EQUAL(sink.write_some(&buf[0], 1000), 0);
+    BOOST_CHECK_EQUAL(sink.queued(), 400);
+    BOOST_CHECK_EQUAL(sink.delay(), 450);
+    BOOST_CHECK_EQUAL(sink.position(), 0);
+    BOOST_CHECK_EQUAL(static_cast<long>(notified), 0);
+
+    g.open();
+    sink.flush();
+    BOOST_CHECK_EQUAL(sink.queued(), 0);
+    BOOST_CHECK_EQUAL(sink.delay(), 50);
+    BOOST_CHECK_EQUAL(sink.position(), 350);
+    BOOST_CHECK_EQUAL(static_cast<long>(notified), 4);
+
+    sink.close();
+    BOOST_CHECK_EQUAL(out->size(), 400u);
+}
+
+void error_test()
+{
+    boost::shared_ptr<std::string> out(new std::string);
+    gate g;
+    fake_device dev(out, g, 0);
+    dev.fail();
+
+    audio::async_sink<fake_device> sink(dev, 10, 2);
+    io::write(sink, "0123456789", 10);
+    BOOST_CHECK_THROW(sink.flush(), std::exception);
+    BOOST_CHECK_THROW(io::write(sink, "0123456789", 10), std::exception);
+}
+
+ut::test_suite* init_unit_test_suite(int, char* [])
+{
+    ut::test_suite* test = BOOST_TEST_SUITE("async sink test");
+    test->add(BOOST_TEST_CASE(&data_test));
+    test->add(BOOST_TEST_CASE(&queue_test));
+    test->add(BOOST_TEST_CASE(&error_test));
+    return test;
+}
@@ -0,0 +1,292 @@
+// background_player_test.cpp: test case for background_player
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+#include <hamigaki/audio/background_player.hpp>
+#include <hamigaki/audio/wave_file.hpp>
+#include <hamigaki/iostreams/device/tmp_file.hpp>
+#include <hamigaki/iostreams/dont_close.hpp>
+#include <hamigaki/thread/utc_time.hpp>
+#include <boost/iostreams/categories.hpp>
+#include <boost/iostreams/positioning.hpp>
+#include <boost/iostreams/read.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <string>
+
+namespace audio = hamigaki::audio;
+namespace io_ex = hamigaki::iostreams;
+namespace io = boost::iostreams;
+namespace ut = boost::unit_test;
+
+std::string make_data(std::size_t size)
+{
+    std::string s;
+    s.reserve(size);
+    for (std::size_t i = 0; i < size; ++i)
+        s += static_cast<char>(i * 31 + (i >> 10));
+    return s;
+}
+
+void sleep_msec(int msec)
+{
+    hamigaki::thread::utc_time t;
+    t += hamigaki::thread::milliseconds(msec);
+    boost::thread::sleep(t);
+}
+
+template<class Player>
+void wait_end(Player& player)
+{
+    while (player.playing())
+        sleep_msec(10);
+}
+
+class string_source
+{
+public:
+    typedef char char_type;
+    typedef io::seekable_device_tag category;
+
+    explicit string_source(const std::string& str) : str_(&str), pos_(0)
+    {
+    }
+
+    std::streamsize read(char* s, std::streamsize n)
+    {
+        std::size_t rest = str_->size() - pos_;
+        if (rest == 0)
+            return -1;
+
+        std::size_t amt = (std::min)(static_cast<std::size_t>(n), rest);
+        str_->copy(s, amt, pos_);
+        pos_ += amt;
+        return static_cast<std::streamsize>(amt);
+    }
+
+    std::streamsize write(const char*, std::streamsize)
+    {
+        throw BOOST_IOSTREAMS_FAILURE("bad write");
+    }
+
+    std::streampos seek(io::stream_offset off, BOOST_IOS::seekdir way)
+    {
+        if (way == BOOST_IOS::cur)
+            off += static_cast<io::stream_offset>(pos_);
+        else if (way == BOOST_IOS::end)
+            off += static_cast<io::stream_offset>(str_->size());
+
+        if ((off < 0) || (off > static_cast<io::stream_offset>(str_->size())))
+            throw BOOST_IOSTREAMS_FAILURE("bad seek");
+
+        pos_ = static_cast<std::size_t>(off);
+        return io::offset_to_position(off);
+    }
+
+private:
+    const std::string* str_;
+    std::size_t pos_;
+};
+
+// the sink which blocks until the test permits the writes
+class gate_sink
+{
+public:
+    typedef char char_type;
+    typedef io::sink_tag category;
+
+    gate_sink() : state_(new state)
+    {
+    }
+
+    std::streamsize write(const char* s, std::streamsize n)
+    {
+        boost::mutex::scoped_lock locking(state_->mutex);
+        while (!state_->opened && (state_->permits == 0))
+            state_->cond.wait(locking);
+        if (!state_->opened)
+            --state_->permits;
+
+        state_->data.append(s, static_cast<std::size_t>(n));
+        ++state_->writes;
+        state_->cond.notify_all();
+        return n;
+    }
+
+    void permit(std::size_t n)
+    {
+        boost::mutex::scoped_lock locking(state_->mutex);
+        state_->permits += n;
+        state_->cond.notify_all();
+    }
+
+    // permits all writes
+    void open()
+    {
+        boost::mutex::scoped_lock locking(state_->mutex);
+        state_->opened = true;
+        state_->cond.notify_all();
+    }
+
+    void wait_writes(std::size_t n)
+    {
+        boost::mutex::scoped_lock locking(state_->mutex);
+        while (state_->writes < n)
+            state_->cond.wait(locking);
+    }
+
+    std::string data() const
+    {
+        boost::mutex::scoped_lock locking(state_->mutex);
+        return state_->data;
+    }
+
+    void clear()
+    {
+        boost::mutex::scoped_lock locking(state_->mutex);
+        state_->data.clear();
+    }
+
+private:
+    struct state
+    {
+        boost::mutex mutex;
+        boost::condition cond;
+        std::string data;
+        std::size_t permits;
+        std::size_t writes;
+        bool opened;
+
+        state() : permits(0), writes(0), opened(false)
+        {
+        }
+    };
+
+    boost::shared_ptr<state> state_;
+};
+
+void wave_file_test()
+{
+    audio::pcm_format fmt;
+    fmt.type = audio::int_le16;
+    fmt.channels = 2;
+    fmt.rate = 8000;
+
+    const std::string data = make_data(40000);
+
+    io_ex::tmp_file tmp;
+    {
+        audio::basic_wave_file_sink<
+            io_ex::dont_close_device<io_ex::tmp_file>
+        > wav(io_ex::dont_close(tmp), fmt);
+
+        audio::background_player player(string_source(data), wav, 512, 4);
+        BOOST_CHECK_EQUAL(player.latency(), 512*4);
+
+        player.play();
+        wait_end(player);
+
+        BOOST_CHECK_EQUAL(player.tell(), std::streampos(40000));
+        BOOST_CHECK_EQUAL(player.statistics().buffered, 0u);
+        player.close();
+
+        // the player does not close the sink
+        wav.close();
+    }
+
+    io::seek(tmp, 0, BOOST_IOS::beg);
+    audio::basic_wave_file_source<io_ex::tmp_file> wav(tmp);
+    BOOST_CHECK_EQUAL(wav.format().rate, fmt.rate);
+
+    std::string result(data.size(), '\0');
+    io::read(wav, &result[0], static_cast<std::streamsize>(result.size()));
+    BOOST_CHECK(result == data);
+}
+
+void stop_test()
+{
+    const std::string data = make_data(20000);
+
+    gate_sink sink;
+    audio::background_player player(string_source(data), sink, 100, 8);
+
+    player.play();
+    sink.permit(3);
+    sink.wait_writes(3);
+
+    // the device thread stops at the boundary of the buffers
+    player.pause();
+    sink.permit(1);
+    sink.wait_writes(4);
+    player.stop();
+    BOOST_CHECK(!player.playing());
+
+    BOOST_CHECK_EQUAL(player.tell(), std::streampos(400));
+    BOOST_CHECK(sink.data() == data.substr(0, 400));
+
+    // the buffered samples are played after restart
+    sink.open();
+    player.play();
+    wait_end(player);
+    BOOST_CHECK_EQUAL(player.tell(), std::streampos(20000));
+    BOOST_CHECK(sink.data() == data);
+
+    // the seek discards the buffered samples
+    sink.clear();
+    player.seek(10000, BOOST_IOS::beg);
+    player.play();
+    wait_end(player);
+    BOOST_CHECK(sink.data() == data.substr(10000));
+}
+
+void pause_test()
+{
+    const std::string data = make_data(8000);
+
+    gate_sink sink;
+    audio::background_player player(string_source(data), sink, 400, 4);
+
+    player.play();
+    sink.permit(2);
+    sink.wait_writes(2);
+
+    player.pause();
+    BOOST_CHECK(player.paused());
+    BOOST_CHECK(player.playing());
+
+    // the device thread may be waiting in the third write
+    sink.permit(1);
+    sink.wait_writes(3);
+
+    // the decoder fills the ring during the pause
+    while (player.statistics().buffered != 4)
+        sleep_msec(1);
+    while (player.tell() != std::streampos(1200))
+        sleep_msec(1);
+    BOOST_CHECK(sink.data() == data.substr(0, 1200));
+
+    sink.open();
+    player.resume();
+    BOOST_CHECK(!player.paused());
+    wait_end(player);
+
+    BOOST_CHECK_EQUAL(player.tell(), std::streampos(8000));
+    BOOST_CHECK(sink.data() == data);
+}
+
+ut::test_suite* init_unit_test_suite(int, char* [])
+{
+    ut::test_suite* test = BOOST_TEST_SUITE("background player test");
+    test->add(BOOST_TEST_CASE(&wave_file_test));
+    test->add(BOOST_TEST_CASE(&stop_test));
+    test->add(BOOST_TEST_CASE(&pause_test));
+    return test;
+}
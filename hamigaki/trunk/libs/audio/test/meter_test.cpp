@@ -0,0 +1,147 @@
+// meter_test.cpp: test case for level_meter and loudness_meter
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+#include <hamigaki/audio/meter.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/read.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <vector>
+
+namespace audio = hamigaki::audio;
+namespace io = boost::iostreams;
+namespace ut = boost::unit_test;
+
+typedef io::basic_array_source<float> float_source;
+typedef io::basic_array_source<boost::int16_t> int16_source;
+
+// the stereo sine wave
+std::vector<float> make_sine(double freq, double rate, float amp, double sec)
+{
+    const double pi = 3.14159265358979323846;
+    std::size_t frames = static_cast<std::size_t>(rate * sec);
+
+    std::vector<float> result(frames*2);
+    for (std::size_t i = 0; i < frames; ++i)
+    {
+        float x = amp * static_cast<float>(std::sin(2.0*pi*freq*i/rate));
+        result[i*2] = x;
+        result[i*2+1] = x;
+    }
+    return result;
+}
+
+template<class Source>
+void read_all(Source& src)
+{
+    typedef typename io::char_type_of<Source>::type char_type;
+    char_type buf[7];
+    while (io::read(src, buf, 7) > 0)
+        ;
+}
+
+void level_test()
+{
+    boost::int16_t data[] =
+    {
+        16384, -8192,
+        -16384, 8192,
+        32767, 0,
+        -32768, 0
+    };
+    const std::size_t size = sizeof(data)/sizeof(data[0]);
+
+    // the odd sized reads split the frames
+    audio::level_meter meter(2);
+    audio::metered_source<int16_source,audio::level_meter> src =
+        audio::measure(int16_source(data, size), meter);
+    read_all(src);
+
+    BOOST_CHECK_EQUAL(meter.frames(), 4u);
+
+    BOOST_CHECK_CLOSE(meter.peak(0), 1.0, 0.001);
+    BOOST_CHECK_CLOSE(meter.peak(1), 0.25, 0.001);
+
+    double rms0 = std::sqrt((0.25 + 0.25 + 1.0 + 1.0) / 4.0);
+    BOOST_CHECK_CLOSE(meter.rms(0), rms0, 0.01);
+    BOOST_CHECK_CLOSE(meter.rms(1), std::sqrt(0.0625*2 / 4.0), 0.001);
+
+    BOOST_CHECK_EQUAL(meter.clip_count(0), 2u);
+    BOOST_CHECK_EQUAL(meter.clip_count(1), 0u);
+
+    meter.reset();
+    BOOST_CHECK_EQUAL(meter.frames(), 0u);
+    BOOST_CHECK_EQUAL(meter.peak(0), 0.0);
+}
+
+void float_level_test()
+{
+    float data[] = { 0.5f, -1.5f, -0.25f, 0.75f, 1.0f, 0.0f };
+    audio::level_meter meter(2);
+
+    // the copies share the values
+    audio::level_meter copy(meter);
+    meter.process(data, 1);
+    meter.process(data+1, 5);
+
+    BOOST_CHECK_EQUAL(copy.frames(), 3u);
+    BOOST_CHECK_CLOSE(copy.peak(0), 1.0, 0.001);
+    BOOST_CHECK_CLOSE(copy.peak(1), 1.5, 0.001);
+    BOOST_CHECK_EQUAL(copy.clip_count(0), 1u);
+    BOOST_CHECK_EQUAL(copy.clip_count(1), 1u);
+}
+
+void loudness_test()
+{
+    // -20dBFS at 1kHz is -20LUFS
+    std::vector<float> data = make_sine(1000.0, 48000.0, 0.1f, 5.0);
+
+    audio::loudness_meter meter(2, 48000.0);
+    audio::metered_source<float_source,audio::loudness_meter> src =
+        audio::measure(float_source(&data[0], data.size()), meter);
+    read_all(src);
+
+    BOOST_CHECK_CLOSE(meter.integrated(), -20.0, 0.5);
+    BOOST_CHECK_CLOSE(meter.momentary(), -20.0, 0.5);
+    BOOST_CHECK_CLOSE(meter.short_term(), -20.0, 0.5);
+
+    // the silence is gated except the blocks on the boundary
+    std::vector<float> silence(48000*2*5);
+    meter.process(&silence[0], static_cast<std::streamsize>(silence.size()));
+    BOOST_CHECK_CLOSE(meter.integrated(), -20.0, 1.0);
+    BOOST_CHECK(meter.momentary() < -100.0);
+
+    meter.reset();
+    BOOST_CHECK(meter.integrated() < -100.0);
+}
+
+void loudness_rate_test()
+{
+    // the K-weighting is derived for any rate
+    std::vector<float> data = make_sine(1000.0, 44100.0, 0.1f, 3.0);
+
+    std::vector<boost::int16_t> pcm(data.size());
+    for (std::size_t i = 0; i < data.size(); ++i)
+        pcm[i] = static_cast<boost::int16_t>(data[i] * 32768.0f);
+
+    audio::loudness_meter meter(2, 44100.0);
+    meter.process(&pcm[0], static_cast<std::streamsize>(pcm.size()));
+    BOOST_CHECK_CLOSE(meter.integrated(), -20.0, 0.5);
+}
+
+ut::test_suite* init_unit_test_suite(int, char* [])
+{
+    ut::test_suite* test = BOOST_TEST_SUITE("meter test");
+    test->add(BOOST_TEST_CASE(&level_test));
+    test->add(BOOST_TEST_CASE(&float_level_test));
+    test->add(BOOST_TEST_CASE(&loudness_test));
+    test->add(BOOST_TEST_CASE(&loudness_rate_test));
+    return test;
+}
@@ -0,0 +1,268 @@
+// mixer_test.cpp: test case for mixer and amplifier
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+#include <hamigaki/audio/amplify.hpp>
+#include <hamigaki/audio/mixer.hpp>
+#include <hamigaki/audio/planar.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/read.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace audio = hamigaki::audio;
+namespace io = boost::iostreams;
+namespace ut = boost::unit_test;
+
+typedef io::basic_array_source<float> float_source;
+typedef io::basic_array_source<boost::int16_t> int16_source;
+
+// the mono planar source which has no data on every other call
+class stalling_source
+{
+public:
+    typedef float char_type;
+
+    struct category
+        : public io::input
+        , public io::device_tag
+    {};
+
+    // returns 0 on every other call, starting with the first one
+    // if "stall_first" is true
+    stalling_source(
+            const float* data, std::streamsize frames, bool stall_first=false)
+        : data_(data), frames_(frames), pos_(0), stall_(stall_first)
+    {
+    }
+
+    std::streamsize read(float* s, std::streamsize n)
+    {
+        const float* const* planes;
+        std::streamsize count = read_planar(planes, n);
+        if (count > 0)
+            std::copy(planes[0], planes[0] + count, s);
+        return count;
+    }
+
+    std::streamsize read_planar(
+        const float* const*& planes, std::streamsize frames)
+    {
+        if (pos_ >= frames_)
+            return -1;
+
+        stall_ = !stall_;
+        if (!stall_)
+            return 0;
+
+        std::streamsize count = (std::min)(frames, frames_ - pos_);
+        count = (std::min)(count, static_cast<std::streamsize>(4));
+        plane_ = data_ + pos_;
+        planes = &plane_;
+        pos_ += count;
+        return count;
+    }
+
+private:
+    const float* data_;
+    const float* plane_;
+    std::streamsize frames_;
+    std::streamsize pos_;
+    bool stall_;
+};
+
+namespace hamigaki { namespace audio {
+
+template<>
+struct is_planar_source<stalling_source> : boost::true_type {};
+
+} } // End namespaces audio, hamigaki.
+
+template<class CharT>
+std::vector<CharT> read_all(audio::basic_mixer<CharT>& mix)
+{
+    std::vector<CharT> result;
+    CharT buf[7];
+    std::streamsize n;
+    while ((n = io::read(mix, buf, 7)) > 0)
+        result.insert(result.end(), buf, buf+n);
+    return result;
+}
+
+void amplify_test()
+{
+    boost::int16_t data[] = { 100, -100, 20000, -20000, 32767, -32768 };
+    const std::size_t size = sizeof(data)/sizeof(data[0]);
+
+    boost::int16_t buf[size];
+    audio::amplifier<int16_source> amp =
+        audio::amplify(int16_source(data, size), 2.0f);
+    std::streamsize n = io::read(amp, buf, static_cast<std::streamsize>(size));
+    BOOST_REQUIRE_EQUAL(n, static_cast<std::streamsize>(size));
+
+    BOOST_CHECK_EQUAL(buf[0], 200);
+    BOOST_CHECK_EQUAL(buf[1], -200);
+    BOOST_CHECK_EQUAL(buf[2], 32767);
+    BOOST_CHECK_EQUAL(buf[3], -32768);
+    BOOST_CHECK_EQUAL(buf[4], 32767);
+    BOOST_CHECK_EQUAL(buf[5], -32768);
+}
+
+void float_test()
+{
+    float a[] = { 0.25f, -0.5f, 0.125f, 1.0f };
+    float b[] = { 0.5f, 0.25f, -0.125f, 1.0f };
+
+    audio::mixer mix(2, 1);
+    BOOST_CHECK_EQUAL(mix.add(float_source(a, 4)), 0u);
+    BOOST_CHECK_EQUAL(mix.add(float_source(b, 4), 0.5f), 1u);
+    BOOST_CHECK_EQUAL(mix.size(), 2u);
+
+    std::vector<float> result = read_all(mix);
+    BOOST_REQUIRE_EQUAL(result.size(), 4u);
+    BOOST_CHECK_EQUAL(result[0], 0.5f);
+    BOOST_CHECK_EQUAL(result[1], -0.375f);
+    BOOST_CHECK_EQUAL(result[2], 0.0625f);
+
+    // the floating point samples are not clipped
+    BOOST_CHECK_EQUAL(result[3], 1.5f);
+}
+
+void saturation_test()
+{
+    boost::int16_t a[] = { 30000, -30000, 1000, -1000 };
+    boost::int16_t b[] = { 30000, -30000, 1000, -1000 };
+
+    audio::basic_mixer<boost::int16_t> mix;
+    mix.add(int16_source(a, 4));
+    mix.add(int16_source(b, 4));
+
+    std::vector<boost::int16_t> result = read_all(mix);
+    BOOST_REQUIRE_EQUAL(result.size(), 4u);
+    BOOST_CHECK_EQUAL(result[0], 32767);
+    BOOST_CHECK_EQUAL(result[1], -32768);
+    BOOST_CHECK_EQUAL(result[2], 2000);
+    BOOST_CHECK_EQUAL(result[3], -2000);
+}
+
+void ramp_test()
+{
+    std::vector<float> data(200, 1.0f);
+
+    // the stereo source of 100 frames
+    audio::mixer mix(2, 16);
+    mix.add(float_source(&data[0], data.size()), 0.0f);
+    mix.ramp(0, 1.0f, 50);
+
+    std::vector<float> result = read_all(mix);
+    BOOST_REQUIRE_EQUAL(result.size(), data.size());
+
+    for (std::size_t i = 0; i < 100; ++i)
+    {
+        float expected = i < 50 ? static_cast<float>(i) / 50.0f : 1.0f;
+        BOOST_CHECK_CLOSE(result[i*2+0] + 1.0f, expected + 1.0f, 0.001f);
+        BOOST_CHECK_EQUAL(result[i*2+0], result[i*2+1]);
+    }
+    BOOST_CHECK_EQUAL(mix.gain(0), 1.0f);
+}
+
+void length_test()
+{
+    float a[] = { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+    float b[] = { 2.0f, 2.0f };
+
+    audio::mixer mix(1, 4);
+    mix.add(float_source(a, 6));
+    mix.add(float_source(b, 2));
+
+    std::vector<float> result = read_all(mix);
+    BOOST_REQUIRE_EQUAL(result.size(), 6u);
+    BOOST_CHECK_EQUAL(result[0], 3.0f);
+    BOOST_CHECK_EQUAL(result[1], 3.0f);
+    for (std::size_t i = 2; i < result.size(); ++i)
+        BOOST_CHECK_EQUAL(result[i], 1.0f);
+
+    // the end of all sources
+    float c;
+    BOOST_CHECK_EQUAL(io::read(mix, &c, 1), -1);
+}
+
+void planar_test()
+{
+    std::vector<float> left(100);
+    std::vector<float> right(100);
+    std::vector<float> interleaved(200);
+    for (std::size_t i = 0; i < 100; ++i)
+    {
+        left[i] = static_cast<float>(i) / 100.0f;
+        right[i] = -0.25f;
+        interleaved[i*2+0] = left[i];
+        interleaved[i*2+1] = right[i];
+    }
+
+    std::vector<float> b(160, 0.5f);
+
+    audio::mixer expected_mix(2, 16);
+    expected_mix.add(float_source(&interleaved[0], interleaved.size()), 0.0f);
+    expected_mix.add(float_source(&b[0], b.size()));
+    expected_mix.ramp(0, 2.0f, 30);
+    std::vector<float> expected = read_all(expected_mix);
+
+    // the blocks are not aligned with the buffer of the mixer
+    const float* planes[] = { &left[0], &right[0] };
+    audio::mixer mix(2, 16);
+    mix.add(audio::planar_array_source(planes, 2, 100, 7), 0.0f);
+    mix.add(float_source(&b[0], b.size()));
+    mix.ramp(0, 2.0f, 30);
+    std::vector<float> result = read_all(mix);
+
+    BOOST_REQUIRE_EQUAL(result.size(), expected.size());
+    for (std::size_t i = 0; i < result.size(); ++i)
+        BOOST_CHECK_CLOSE(result[i] + 4.0f, expected[i] + 4.0f, 0.0001f);
+    BOOST_CHECK_EQUAL(mix.gain(0), 2.0f);
+}
+
+void planar_stall_test()
+{
+    float data[10];
+    for (std::size_t i = 0; i < 10; ++i)
+        data[i] = static_cast<float>(i) / 16.0f;
+
+    // zero frames are not the end of the stream
+    audio::mixer mix(1, 16);
+    mix.add(stalling_source(data, 10));
+    std::vector<float> result = read_all(mix);
+
+    BOOST_REQUIRE_EQUAL(result.size(), 10u);
+    for (std::size_t i = 0; i < 10; ++i)
+        BOOST_CHECK_EQUAL(result[i], data[i]);
+
+    // the stall on the first call of a block
+    audio::mixer mix2(1, 16);
+    mix2.add(stalling_source(data, 10, true));
+    result = read_all(mix2);
+
+    BOOST_REQUIRE_EQUAL(result.size(), 10u);
+    for (std::size_t i = 0; i < 10; ++i)
+        BOOST_CHECK_EQUAL(result[i], data[i]);
+}
+
+ut::test_suite* init_unit_test_suite(int, char* [])
+{
+    ut::test_suite* test = BOOST_TEST_SUITE("mixer test");
+    test->add(BOOST_TEST_CASE(&amplify_test));
+    test->add(BOOST_TEST_CASE(&float_test));
+    test->add(BOOST_TEST_CASE(&saturation_test));
+    test->add(BOOST_TEST_CASE(&ramp_test));
+    test->add(BOOST_TEST_CASE(&length_test));
+    test->add(BOOST_TEST_CASE(&planar_test));
+    test->add(BOOST_TEST_CASE(&planar_stall_test));
+    return test;
+}
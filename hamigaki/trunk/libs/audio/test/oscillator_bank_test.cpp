@@ -0,0 +1,189 @@
+// oscillator_bank_test.cpp: test case for oscillator_bank
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+#include <hamigaki/audio/oscillator_bank.hpp>
+#include <hamigaki/audio/sine_wave.hpp>
+#include <hamigaki/audio/square_wave.hpp>
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <vector>
+
+namespace audio = hamigaki::audio;
+namespace ut = boost::unit_test;
+
+template<class Source>
+std::vector<typename Source::char_type> read_samples(Source& src, std::size_t n)
+{
+    std::vector<typename Source::char_type> buf(n);
+    std::size_t pos = 0;
+    while (pos < n)
+    {
+        // reads in the odd sized chunks
+        std::size_t amt = (std::min)(n - pos, static_cast<std::size_t>(37));
+        src.read(&buf[pos], static_cast<std::streamsize>(amt));
+        pos += amt;
+    }
+    return buf;
+}
+
+template<class T>
+void sine_wave_test_aux(double tolerance)
+{
+    const long rate = 44100;
+    const double freq = 440.0;
+
+    audio::basic_sine_wave_source<T> src(rate, static_cast<T>(freq));
+    std::vector<T> buf = read_samples(src, 10000);
+
+    const double w = 2.0 * 3.14159265358979323846 * freq / rate;
+    for (std::size_t i = 0; i < buf.size(); ++i)
+    {
+        double x = std::sin(w * static_cast<double>(i));
+        BOOST_CHECK_SMALL(static_cast<double>(buf[i]) - x, tolerance);
+    }
+}
+
+void sine_wave_test()
+{
+    sine_wave_test_aux<float>(1e-5);
+    sine_wave_test_aux<double>(1e-5);
+}
+
+void square_wave_test()
+{
+    // eight samples per period
+    audio::square_wave_source src(8000, 1000.0f);
+    std::vector<float> buf = read_samples(src, 80);
+    for (std::size_t i = 0; i < buf.size(); ++i)
+        BOOST_CHECK_EQUAL(buf[i], (i % 8 < 4) ? 1.0f : -1.0f);
+}
+
+void waveform_test()
+{
+    // four samples per period
+    audio::oscillator_bank bank(8000);
+    bank.add(audio::waveform::sawtooth, 2000.0f);
+    std::vector<float> saw = read_samples(bank, 8);
+
+    bank.clear();
+    bank.add(audio::waveform::triangle, 2000.0f);
+    std::vector<float> tri = read_samples(bank, 8);
+
+    const float saw_values[] = { 0.0f, 0.5f, -1.0f, -0.5f };
+    const float tri_values[] = { 0.0f, 1.0f, 0.0f, -1.0f };
+    for (std::size_t i = 0; i < 8; ++i)
+    {
+        BOOST_CHECK_EQUAL(saw[i], saw_values[i%4]);
+        BOOST_CHECK_EQUAL(tri[i], tri_values[i%4]);
+    }
+}
+
+void sum_test()
+{
+    audio::oscillator_bank bank(44100);
+    BOOST_CHECK_EQUAL(bank.add(audio::waveform::sine, 440.0f, 0.5f), 0u);
+    BOOST_CHECK_EQUAL(bank.add(audio::waveform::sine, 660.0f, 0.25f), 1u);
+    BOOST_CHECK_EQUAL(bank.size(), 2u);
+    std::vector<float> mixed = read_samples(bank, 1000);
+
+    audio::sine_wave_source a(44100, 440.0f);
+    audio::sine_wave_source b(44100, 660.0f);
+    std::vector<float> va = read_samples(a, 1000);
+    std::vector<float> vb = read_samples(b, 1000);
+
+    for (std::size_t i = 0; i < mixed.size(); ++i)
+        BOOST_CHECK_SMALL(mixed[i] - (va[i]*0.5f + vb[i]*0.25f), 1e-6f);
+}
+
+void amplitude_envelope_test()
+{
+    // the square wave of 1.0 for the first 4000 samples
+    audio::oscillator_bank bank(8000);
+    bank.add(audio::waveform::square, 1.0f, 0.0f);
+    bank.amplitude(0, 1.0f, 100);
+    bank.amplitude(0, 1.0f, 50);
+    bank.amplitude(0, 0.0f, 0);
+
+    std::vector<float> buf = read_samples(bank, 200);
+    for (std::size_t i = 0; i < 100; ++i)
+        BOOST_CHECK_CLOSE(buf[i] + 1.0f, i / 100.0f + 1.0f, 1e-4f);
+    for (std::size_t i = 100; i < 150; ++i)
+        BOOST_CHECK_EQUAL(buf[i], 1.0f);
+    for (std::size_t i = 150; i < 200; ++i)
+        BOOST_CHECK_EQUAL(buf[i], 0.0f);
+    BOOST_CHECK_EQUAL(bank.amplitude(0), 0.0f);
+}
+
+void frequency_envelope_test()
+{
+    // the jump at the 50th sample in the middle of a read
+    audio::oscillator_bank bank1(8000);
+    bank1.add(audio::waveform::sawtooth, 100.0f);
+    bank1.frequency(0, 100.0f, 50);
+    bank1.frequency(0, 300.0f);
+    std::vector<float> buf1 = read_samples(bank1, 100);
+
+    audio::oscillator_bank bank2(8000);
+    bank2.add(audio::waveform::sawtooth, 100.0f);
+    std::vector<float> buf2(100);
+    bank2.read(&buf2[0], 50);
+    bank2.frequency(0, 300.0f);
+    bank2.read(&buf2[50], 50);
+
+    BOOST_CHECK(buf1 == buf2);
+    BOOST_CHECK_EQUAL(bank1.frequency(0), 300.0f);
+
+    // the silent voice keeps the phase of the glide
+    audio::oscillator_bank bank3(8000);
+    bank3.add(audio::waveform::sine, 100.0f, 1.0f);
+    bank3.frequency(0, 500.0f, 128);
+    std::vector<float> buf3 = read_samples(bank3, 256);
+
+    audio::oscillator_bank bank4(8000);
+    bank4.add(audio::waveform::sine, 100.0f, 0.0f);
+    bank4.frequency(0, 500.0f, 128);
+    bank4.amplitude(0, 0.0f, 64);
+    bank4.amplitude(0, 1.0f);
+    std::vector<float> buf4 = read_samples(bank4, 256);
+
+    for (std::size_t i = 0; i < 64; ++i)
+        BOOST_CHECK_EQUAL(buf4[i], 0.0f);
+    for (std::size_t i = 64; i < 256; ++i)
+        BOOST_CHECK_SMALL(buf3[i] - buf4[i], 1e-6f);
+}
+
+void phase_increment_test()
+{
+    using audio::detail::phase_increment;
+
+    BOOST_CHECK_EQUAL(phase_increment(44100L, 0.0), 0u);
+    BOOST_CHECK_EQUAL(phase_increment(4L, 1.0), 0x40000000u);
+    BOOST_CHECK_EQUAL(phase_increment(4L, -1.0), 0xC0000000u);
+
+    // the multiples of the sampling rate wrap around to zero
+    BOOST_CHECK_EQUAL(phase_increment(44100L, 44100.0), 0u);
+    BOOST_CHECK_EQUAL(phase_increment(44100L, -88200.0), 0u);
+
+    // rounds up to 2^32
+    BOOST_CHECK_EQUAL(phase_increment(1L, 1.0 - 1e-12), 0u);
+    BOOST_CHECK_EQUAL(phase_increment(1L, -1e-12), 0u);
+}
+
+ut::test_suite* init_unit_test_suite(int, char* [])
+{
+    ut::test_suite* test = BOOST_TEST_SUITE("oscillator bank test");
+    test->add(BOOST_TEST_CASE(&sine_wave_test));
+    test->add(BOOST_TEST_CASE(&square_wave_test));
+    test->add(BOOST_TEST_CASE(&waveform_test));
+    test->add(BOOST_TEST_CASE(&sum_test));
+    test->add(BOOST_TEST_CASE(&amplitude_envelope_test));
+    test->add(BOOST_TEST_CASE(&frequency_envelope_test));
+    test->add(BOOST_TEST_CASE(&phase_increment_test));
+    return test;
+}
@@ -0,0 +1,133 @@
+// parallel_vorbis_test.cpp: test case for parallel_vorbis_encoder
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+#include <hamigaki/audio/parallel_vorbis_encoder.hpp>
+#include <hamigaki/audio/amplify.hpp>
+#include <hamigaki/audio/sine_wave.hpp>
+#include <hamigaki/audio/stereo.hpp>
+#include <hamigaki/audio/vorbis_file.hpp>
+#include <hamigaki/iostreams/device/tmp_file.hpp>
+#include <hamigaki/iostreams/dont_close.hpp>
+#include <hamigaki/iostreams/tiny_restrict.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/seek.hpp>
+#include <boost/test/unit_test.hpp>
+#include <vector>
+
+namespace audio = hamigaki::audio;
+namespace io_ex = hamigaki::iostreams;
+namespace io = boost::iostreams;
+namespace ut = boost::unit_test;
+
+const long rate = 11025;
+
+io_ex::tiny_restriction<
+    audio::stereophony<audio::amplifier<audio::sine_wave_source> >
+>
+make_test_source(unsigned channels, float freq, io::stream_offset frames)
+{
+    return io_ex::tiny_restrict(
+        audio::stereo(
+            audio::amplify(audio::sine_wave_source(rate, freq), 0.5f),
+            channels
+        ),
+        frames * channels
+    );
+}
+
+// decodes all links of the chained stream
+io::stream_offset decoded_samples(io_ex::tmp_file& tmp, unsigned channels)
+{
+    io::seek(tmp, 0, BOOST_IOS::beg);
+    audio::basic_vorbis_file_source<io_ex::tmp_file> src(tmp);
+    BOOST_CHECK_EQUAL(src.info().channels, static_cast<long>(channels));
+    BOOST_CHECK_EQUAL(src.info().rate, rate);
+
+    std::vector<float> buf(4096);
+    io::stream_offset total = 0;
+    std::streamsize n;
+    while ((n = src.read(&buf[0], static_cast<std::streamsize>(buf.size())))
+        != -1)
+    {
+        total += n;
+    }
+
+    BOOST_CHECK_EQUAL(src.total(), total);
+    return total;
+}
+
+void parallel_vorbis_test_aux(
+    unsigned channels, std::size_t threads, io::stream_offset frames)
+{
+    io_ex::tmp_file tmp;
+    io::copy(
+        make_test_source(channels, 440.0f, frames),
+        audio::make_parallel_vorbis_file_sink(
+            io_ex::dont_close(tmp), channels, rate, 0.1f, threads, 1)
+    );
+
+    BOOST_CHECK_EQUAL(decoded_samples(tmp, channels), frames*channels);
+}
+
+void parallel_vorbis_file_sink_test()
+{
+    // 3.5 chunks
+    parallel_vorbis_test_aux(1, 2, rate*7/2);
+    parallel_vorbis_test_aux(2, 4, rate*7/2);
+
+    // the exact boundary of the chunks
+    parallel_vorbis_test_aux(2, 3, rate*2);
+
+    // less than a chunk
+    parallel_vorbis_test_aux(1, 1, rate/2);
+
+    // empty
+    parallel_vorbis_test_aux(2, 2, 0);
+
+    // the chunk of zero seconds
+    io_ex::tmp_file tmp;
+    BOOST_CHECK_THROW(
+        audio::make_parallel_vorbis_file_sink(
+            io_ex::dont_close(tmp), 2, rate, 0.1f, 2, 0),
+        BOOST_IOSTREAMS_FAILURE);
+}
+
+void vorbis_batch_encoder_test()
+{
+    const std::size_t count = 5;
+    std::vector<io_ex::tmp_file> files;
+    for (std::size_t i = 0; i < count; ++i)
+        files.push_back(io_ex::tmp_file());
+
+    {
+        audio::vorbis_batch_encoder encoder(2);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            encoder.add(
+                make_test_source(2, 220.0f*(i+1), rate*(i+1)/2),
+                io_ex::dont_close(files[i]), 2, rate);
+        }
+        encoder.wait();
+    }
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        BOOST_CHECK_EQUAL(
+            decoded_samples(files[i], 2),
+            static_cast<io::stream_offset>(rate*(i+1)/2*2));
+    }
+}
+
+ut::test_suite* init_unit_test_suite(int, char* [])
+{
+    ut::test_suite* test = BOOST_TEST_SUITE("parallel vorbis test");
+    test->add(BOOST_TEST_CASE(&parallel_vorbis_file_sink_test));
+    test->add(BOOST_TEST_CASE(&vorbis_batch_encoder_test));
+    return test;
+}
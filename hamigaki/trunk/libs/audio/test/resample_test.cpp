@@ -0,0 +1,177 @@
+// resample_test.cpp: test case for resampler
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+#include <hamigaki/audio/planar.hpp>
+#include <hamigaki/audio/resample.hpp>
+#include <hamigaki/audio/sine_wave.hpp>
+#include <hamigaki/audio/stereo.hpp>
+#include <hamigaki/iostreams/tiny_restrict.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/read.hpp>
+#include <boost/iostreams/write.hpp>
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <vector>
+
+namespace audio = hamigaki::audio;
+namespace io_ex = hamigaki::iostreams;
+namespace io = boost::iostreams;
+namespace ut = boost::unit_test;
+
+typedef io_ex::tiny_restriction<audio::sine_wave_source> sine_source;
+
+// one second of the sine wave
+sine_source make_sine(long rate, float freq)
+{
+    return io_ex::tiny_restrict(audio::sine_wave_source(rate, freq), rate);
+}
+
+template<class Source>
+std::vector<float> read_all(Source& src)
+{
+    std::vector<float> result;
+    float buf[999];
+    std::streamsize n;
+    while ((n = io::read(src, buf, 999)) > 0)
+        result.insert(result.end(), buf, buf+n);
+    return result;
+}
+
+// the total harmonic distortion plus noise in dB
+// (the edges of the signal are excluded)
+double thd_n(const std::vector<float>& y, long rate, double freq)
+{
+    const double w = 2.0 * 3.14159265358979323846 * freq / rate;
+    const std::size_t skip = static_cast<std::size_t>(rate / 10);
+
+    double signal = 0.0;
+    double noise = 0.0;
+    for (std::size_t i = skip; i + skip < y.size(); ++i)
+    {
+        double x = std::sin(w * static_cast<double>(i));
+        double e = static_cast<double>(y[i]) - x;
+        signal += x * x;
+        noise += e * e;
+    }
+    return 10.0 * std::log10(noise / signal);
+}
+
+void thd_n_test_aux(
+    long in_rate, long out_rate, audio::resample_quality::values q,
+    double limit)
+{
+    audio::resampler<sine_source> rs(
+        make_sine(in_rate, 1000.0f), 1, in_rate, out_rate, q);
+    std::vector<float> y = read_all(rs);
+
+    BOOST_CHECK_EQUAL(y.size(), static_cast<std::size_t>(out_rate));
+    BOOST_CHECK_LT(thd_n(y, out_rate, 1000.0), limit);
+}
+
+void thd_n_test()
+{
+    thd_n_test_aux(44100, 48000, audio::resample_quality::fast, -60.0);
+    thd_n_test_aux(44100, 48000, audio::resample_quality::medium, -85.0);
+    thd_n_test_aux(44100, 48000, audio::resample_quality::best, -95.0);
+
+    thd_n_test_aux(48000, 44100, audio::resample_quality::medium, -85.0);
+    thd_n_test_aux(8000, 44100, audio::resample_quality::medium, -85.0);
+    thd_n_test_aux(44100, 8000, audio::resample_quality::medium, -85.0);
+
+    // the phases are interpolated for the large ratio
+    thd_n_test_aux(44100, 48001, audio::resample_quality::medium, -85.0);
+}
+
+void stereo_test()
+{
+    audio::resampler<audio::stereophony<sine_source> > rs(
+        audio::stereo(make_sine(22050, 440.0f)), 2, 22050, 32000);
+    std::vector<float> y = read_all(rs);
+
+    BOOST_REQUIRE_EQUAL(y.size(), 32000u*2);
+
+    std::vector<float> left;
+    for (std::size_t i = 0; i < y.size(); i += 2)
+    {
+        BOOST_CHECK_EQUAL(y[i], y[i+1]);
+        left.push_back(y[i]);
+    }
+    BOOST_CHECK_LT(thd_n(left, 32000, 440.0), -85.0);
+}
+
+void sink_test()
+{
+    sine_source src = make_sine(44100, 1000.0f);
+    std::vector<float> x = read_all(src);
+
+    audio::resampler<sine_source> rs(
+        make_sine(44100, 1000.0f), 1, 44100, 48000);
+    std::vector<float> expected = read_all(rs);
+
+    std::vector<float> y;
+    {
+        audio::resampler_sink<io::back_insert_device<std::vector<float> > >
+            sink = audio::make_resampler_sink(
+                io::back_inserter(y), 1, 44100, 48000);
+
+        // writes in the odd sized chunks
+        for (std::size_t pos = 0; pos < x.size(); pos += 777)
+        {
+            std::size_t n = (std::min)(x.size() - pos, std::size_t(777));
+            io::write(sink, &x[pos], static_cast<std::streamsize>(n));
+        }
+        sink.close();
+    }
+
+    BOOST_CHECK(y == expected);
+}
+
+void planar_test()
+{
+    sine_source src = make_sine(22050, 440.0f);
+    std::vector<float> x = read_all(src);
+
+    std::vector<float> left(x);
+    std::vector<float> right(x.size());
+    for (std::size_t i = 0; i < x.size(); ++i)
+        right[i] = -0.5f * x[i];
+
+    std::vector<float> interleaved(x.size()*2);
+    for (std::size_t i = 0; i < x.size(); ++i)
+    {
+        interleaved[i*2+0] = left[i];
+        interleaved[i*2+1] = right[i];
+    }
+
+    typedef io::basic_array_source<float> float_source;
+    audio::resampler<float_source> rs(
+        float_source(&interleaved[0], interleaved.size()), 2, 22050, 32000);
+    std::vector<float> expected = read_all(rs);
+
+    // the small blocks like the packets of libvorbis
+    const float* planes[] = { &left[0], &right[0] };
+    audio::resampler<audio::planar_array_source> prs(
+        audio::planar_array_source(
+            planes, 2, static_cast<std::streamsize>(x.size()), 256),
+        2, 22050, 32000);
+    std::vector<float> y = read_all(prs);
+
+    BOOST_CHECK(y == expected);
+}
+
+ut::test_suite* init_unit_test_suite(int, char* [])
+{
+    ut::test_suite* test = BOOST_TEST_SUITE("resample test");
+    test->add(BOOST_TEST_CASE(&thd_n_test));
+    test->add(BOOST_TEST_CASE(&stereo_test));
+    test->add(BOOST_TEST_CASE(&sink_test));
+    test->add(BOOST_TEST_CASE(&planar_test));
+    return test;
+}
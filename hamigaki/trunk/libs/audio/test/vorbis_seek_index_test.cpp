@@ -0,0 +1,262 @@
+// vorbis_seek_index_test.cpp: test case for vorbis::seek_index
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+#include <hamigaki/audio/amplify.hpp>
+#include <hamigaki/audio/sine_wave.hpp>
+#include <hamigaki/audio/stereo.hpp>
+#include <hamigaki/audio/vorbis_encoder.hpp>
+#include <hamigaki/audio/vorbis_file.hpp>
+#include <hamigaki/iostreams/device/tmp_file.hpp>
+#include <hamigaki/iostreams/dont_close.hpp>
+#include <hamigaki/iostreams/tiny_restrict.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/seek.hpp>
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace audio = hamigaki::audio;
+namespace io_ex = hamigaki::iostreams;
+namespace io = boost::iostreams;
+namespace ut = boost::unit_test;
+
+const long rate = 44100;
+const unsigned channels = 2;
+
+void encode_tone(io_ex::tmp_file& tmp, float freq, long frames)
+{
+    io::copy(
+        io_ex::tiny_restrict(
+            audio::stereo(
+                audio::amplify(audio::sine_wave_source(rate, freq), 0.5f),
+                channels
+            ),
+            frames * channels
+        ),
+        audio::make_vorbis_file_sink(
+            io_ex::dont_close(tmp), channels, rate)
+    );
+}
+
+std::vector<float> decode_all(io_ex::tmp_file& tmp)
+{
+    io::seek(tmp, 0, BOOST_IOS::beg);
+    audio::basic_vorbis_file_source<io_ex::tmp_file> src(tmp);
+
+    std::vector<float> data;
+    std::vector<float> buf(4096);
+    std::streamsize n;
+    while ((n = src.read(&buf[0], static_cast<std::streamsize>(buf.size())))
+        != -1)
+    {
+        data.insert(data.end(), buf.begin(), buf.begin()+n);
+    }
+    return data;
+}
+
+void check_seek(
+    audio::basic_vorbis_file_source<io_ex::tmp_file>& src,
+    const std::vector<float>& expected, io::stream_offset frame)
+{
+    std::vector<float> buf(channels*1000);
+    std::streamsize n = src.read_at(
+        frame*channels, &buf[0], static_cast<std::streamsize>(buf.size()));
+
+    io::stream_offset rest =
+        static_cast<io::stream_offset>(expected.size()) - frame*channels;
+    BOOST_REQUIRE_EQUAL(n,
+        static_cast<std::streamsize>(
+            (std::min)(rest, static_cast<io::stream_offset>(buf.size()))));
+
+    for (std::streamsize i = 0; i < n; ++i)
+    {
+        if (std::abs(buf[i] - expected[frame*channels+i]) > 1e-6f)
+        {
+            BOOST_ERROR("sample mismatch after seek");
+            break;
+        }
+    }
+}
+
+void seek_index_test()
+{
+    io_ex::tmp_file tmp;
+    encode_tone(tmp, 440.0f, rate*3);
+    encode_tone(tmp, 880.0f, rate*2);
+
+    const std::vector<float> expected = decode_all(tmp);
+    const io::stream_offset frames =
+        static_cast<io::stream_offset>(expected.size() / channels);
+    BOOST_CHECK_EQUAL(frames, rate*5);
+
+    io::seek(tmp, 0, BOOST_IOS::beg);
+    audio::basic_vorbis_file_source<io_ex::tmp_file> src(tmp);
+    src.build_index();
+
+    const audio::vorbis::seek_index& index = src.index();
+    BOOST_REQUIRE(!index.empty());
+    BOOST_CHECK_EQUAL(index[index.size()-1].position, frames);
+    BOOST_CHECK_EQUAL(index.file_size(), io::position_to_offset(
+        io::seek(tmp, 0, BOOST_IOS::end)));
+    for (std::size_t i = 1; i < index.size(); ++i)
+    {
+        BOOST_CHECK(index[i-1].position < index[i].position);
+        BOOST_CHECK(index[i-1].offset < index[i].offset);
+    }
+
+    // building the index must not disturb the decoder
+    std::vector<float> head(channels*100);
+    BOOST_CHECK_EQUAL(
+        src.read(&head[0], static_cast<std::streamsize>(head.size())),
+        static_cast<std::streamsize>(head.size()));
+    BOOST_CHECK(std::equal(head.begin(), head.end(), expected.begin()));
+
+    const io::stream_offset points[] =
+    {
+        rate*4+123, 0, 1, rate/2, rate*3-1, rate*3, rate*3+1, frames-10,
+        rate*2+4567
+    };
+    for (std::size_t i = 0; i < sizeof(points)/sizeof(points[0]); ++i)
+        check_seek(src, expected, points[i]);
+}
+
+// an Ogg page with a body of "size" bytes (the CRC is not checked)
+// The page of zero bytes has no lacing segments.
+void write_page(
+    std::string& s, unsigned char type, boost::int64_t granule,
+    boost::uint32_t serialno, std::size_t size)
+{
+    char head[28];
+    std::memcpy(head, "OggS", 4);
+    head[4] = 0;
+    head[5] = static_cast<char>(type);
+    hamigaki::encode_uint<hamigaki::little,8>(
+        head+6, static_cast<boost::uint64_t>(granule));
+    hamigaki::encode_uint<hamigaki::little,4>(head+14, serialno);
+    hamigaki::encode_uint<hamigaki::little,4>(head+18, 0);
+    hamigaki::encode_uint<hamigaki::little,4>(head+22, 0);
+    head[26] = size != 0 ? 1 : 0;
+    head[27] = static_cast<char>(size);
+    s.append(head, size != 0 ? 28 : 27);
+    s.append(size, '\0');
+}
+
+void chained_link_test()
+{
+    // the second link starts at the granule position 500000
+    std::string data;
+    write_page(data, 0x02, 0, 1, 30);
+    write_page(data, 0x00, 0, 1, 200);
+    write_page(data, 0x00, 1000, 1, 100);
+    write_page(data, 0x04, 2000, 1, 100);
+    write_page(data, 0x02, 0, 2, 30);
+    write_page(data, 0x00, 0, 2, 200);
+    write_page(data, 0x00, 501000, 2, 100);
+    write_page(data, 0x04, 502500, 2, 100);
+
+    std::vector<boost::int64_t> lengths;
+    lengths.push_back(2000);
+    lengths.push_back(2500);
+
+    io_ex::tmp_file tmp;
+    io_ex::blocking_write(tmp, data);
+    audio::vorbis::seek_index index;
+    index.build(tmp, lengths);
+
+    BOOST_REQUIRE_EQUAL(index.size(), 4u);
+    BOOST_CHECK_EQUAL(index[0].position, 1000);
+    BOOST_CHECK_EQUAL(index[1].position, 2000);
+    BOOST_CHECK_EQUAL(index[2].position, 3000);
+    BOOST_CHECK_EQUAL(index[3].position, 4500);
+    BOOST_CHECK_EQUAL(index.file_size(),
+        static_cast<boost::int64_t>(data.size()));
+
+    // the points over the size of the file
+    std::string saved;
+    io::back_insert_device<std::string> sink(saved);
+    index.save(sink);
+    hamigaki::encode_uint<hamigaki::little,8>(&saved[8], 100);
+
+    io_ex::tmp_file bad;
+    io_ex::blocking_write(bad, saved);
+    io::seek(bad, 0, BOOST_IOS::beg);
+    audio::vorbis::seek_index loaded;
+    BOOST_CHECK_THROW(loaded.load(bad), BOOST_IOSTREAMS_FAILURE);
+}
+
+void zero_segment_test()
+{
+    // the first link ends with an empty EOS page
+    std::string data;
+    write_page(data, 0x02, 0, 1, 30);
+    write_page(data, 0x00, 0, 1, 200);
+    write_page(data, 0x00, 1000, 1, 100);
+    write_page(data, 0x00, 2000, 1, 100);
+    write_page(data, 0x04, -1, 1, 0);
+    write_page(data, 0x02, 0, 2, 30);
+    write_page(data, 0x00, 0, 2, 200);
+    write_page(data, 0x00, 1500, 2, 100);
+    write_page(data, 0x04, -1, 2, 0);
+
+    io_ex::tmp_file tmp;
+    io_ex::blocking_write(tmp, data);
+    audio::vorbis::seek_index index;
+    index.build(tmp);
+
+    BOOST_REQUIRE_EQUAL(index.size(), 3u);
+    BOOST_CHECK_EQUAL(index[0].position, 1000);
+    BOOST_CHECK_EQUAL(index[1].position, 2000);
+    BOOST_CHECK_EQUAL(index[2].position, 3500);
+    BOOST_CHECK_EQUAL(index.file_size(),
+        static_cast<boost::int64_t>(data.size()));
+}
+
+void save_load_test()
+{
+    io_ex::tmp_file tmp;
+    encode_tone(tmp, 440.0f, rate*2);
+    const std::vector<float> expected = decode_all(tmp);
+
+    audio::vorbis::seek_index index;
+    index.build(tmp);
+
+    io_ex::tmp_file index_file;
+    index.save(index_file);
+
+    io::seek(index_file, 0, BOOST_IOS::beg);
+    audio::vorbis::seek_index loaded;
+    loaded.load(index_file);
+
+    BOOST_REQUIRE_EQUAL(loaded.size(), index.size());
+    BOOST_CHECK_EQUAL(loaded.file_size(), index.file_size());
+    for (std::size_t i = 0; i < index.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(loaded[i].position, index[i].position);
+        BOOST_CHECK_EQUAL(loaded[i].offset, index[i].offset);
+    }
+
+    io::seek(tmp, 0, BOOST_IOS::beg);
+    audio::basic_vorbis_file_source<io_ex::tmp_file> src(tmp);
+    src.index(loaded);
+    check_seek(src, expected, rate+321);
+    check_seek(src, expected, rate/3);
+}
+
+ut::test_suite* init_unit_test_suite(int, char* [])
+{
+    ut::test_suite* test = BOOST_TEST_SUITE("vorbis seek index test");
+    test->add(BOOST_TEST_CASE(&seek_index_test));
+    test->add(BOOST_TEST_CASE(&save_load_test));
+    test->add(BOOST_TEST_CASE(&chained_link_test));
+    test->add(BOOST_TEST_CASE(&zero_segment_test));
+    return test;
+}
@@ -0,0 +1,300 @@
+// wide_adaptor_test.cpp: test case for wide_adaptor
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/audio for library home page.
+
+#include <hamigaki/audio/wide_adaptor.hpp>
+#include <boost/iostreams/categories.hpp>
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace audio = hamigaki::audio;
+namespace io = boost::iostreams;
+namespace ut = boost::unit_test;
+
+// the memory device with the sample format
+class sample_string
+{
+public:
+    typedef char char_type;
+
+    struct category
+        : io::bidirectional_device_tag
+        , audio::sample_format_tag
+    {};
+
+    sample_string(std::string& str, audio::sample_format_type type)
+        : str_(&str), pos_(0), type_(type)
+    {
+    }
+
+    audio::sample_format_type sample_format() const
+    {
+        return type_;
+    }
+
+    std::streamsize read(char* s, std::streamsize n)
+    {
+        std::size_t rest = str_->size() - pos_;
+        if (rest == 0)
+            return -1;
+
+        std::size_t amt = (std::min)(static_cast<std::size_t>(n), rest);
+        std::memcpy(s, str_->data() + pos_, amt);
+        pos_ += amt;
+        return static_cast<std::streamsize>(amt);
+    }
+
+    std::streamsize write(const char* s, std::streamsize n)
+    {
+        str_->append(s, static_cast<std::size_t>(n));
+        return n;
+    }
+
+private:
+    std::string* str_;
+    std::size_t pos_;
+    audio::sample_format_type type_;
+};
+
+// the sink which has not played the last "played" bytes
+class delayed_sink
+{
+public:
+    typedef char char_type;
+
+    struct category
+        : io::sink_tag
+        , audio::sample_format_tag
+        , audio::delay_tag
+    {};
+
+    delayed_sink(audio::sample_format_type type, std::streamsize played)
+        : type_(type), played_(played), written_(0)
+    {
+    }
+
+    audio::sample_format_type sample_format() const
+    {
+        return type_;
+    }
+
+    std::streamsize write(const char*, std::streamsize n)
+    {
+        written_ += n;
+        return n;
+    }
+
+    std::streamsize delay() const
+    {
+        return written_ - played_;
+    }
+
+private:
+    audio::sample_format_type type_;
+    std::streamsize played_;
+    std::streamsize written_;
+};
+
+template<class CharT>
+std::vector<CharT> round_trip(
+    audio::sample_format_type type, const std::vector<CharT>& data)
+{
+    std::string buf;
+    audio::widen<CharT>(sample_string(buf, type), 64)
+        .write(&data[0], static_cast<std::streamsize>(data.size()));
+
+    BOOST_CHECK_EQUAL(
+        buf.size(), data.size()*audio::sample_size(type));
+
+    std::vector<CharT> result(data.size());
+    std::streamsize n = static_cast<std::streamsize>(result.size());
+    BOOST_CHECK_EQUAL(
+        audio::widen<CharT>(sample_string(buf, type), 64)
+            .read(&result[0], n), n);
+    return result;
+}
+
+void float_test()
+{
+    const audio::sample_format_type types[] =
+    {
+        audio::int_le16, audio::int_be16, audio::int_le24, audio::int_be24,
+        audio::int_le32, audio::int_be32, audio::int_a4_le16,
+        audio::int_a4_be24, audio::float_le32, audio::float_be32,
+        audio::float_le64, audio::float_be64
+    };
+
+    std::vector<float> data;
+    for (int i = -100; i < 100; ++i)
+        data.push_back(static_cast<float>(i) / 128.0f);
+
+    for (std::size_t i = 0; i < sizeof(types)/sizeof(types[0]); ++i)
+    {
+        const std::vector<float>& result = round_trip(types[i], data);
+        BOOST_CHECK_EQUAL_COLLECTIONS(
+            data.begin(), data.end(), result.begin(), result.end());
+    }
+}
+
+void int_test()
+{
+    const audio::sample_format_type types[] =
+    {
+        audio::int_le16, audio::int_be16, audio::int_le24, audio::int_be24,
+        audio::int_le32, audio::int_be32, audio::int_a4_le16,
+        audio::int_a4_be16, audio::int_a4_le24, audio::int_a4_be24,
+        audio::float_le32, audio::float_be32,
+        audio::float_le64, audio::float_be64
+    };
+
+    std::vector<boost::int16_t> data;
+    for (int i = -32768; i < 32768; i += 97)
+        data.push_back(static_cast<boost::int16_t>(i));
+    data.push_back(32767);
+
+    for (std::size_t i = 0; i < sizeof(types)/sizeof(types[0]); ++i)
+    {
+        const std::vector<boost::int16_t>& result = round_trip(types[i], data);
+        BOOST_CHECK_EQUAL_COLLECTIONS(
+            data.begin(), data.end(), result.begin(), result.end());
+    }
+}
+
+void int_float_le32_test()
+{
+    std::vector<boost::int16_t> data;
+    data.push_back(16384);
+    data.push_back(-8192);
+
+    std::string buf;
+    audio::widen<boost::int16_t>(sample_string(buf, audio::float_le32))
+        .write(&data[0], static_cast<std::streamsize>(data.size()));
+
+    BOOST_REQUIRE_EQUAL(buf.size(), 8u);
+
+    boost::uint32_t n1 = hamigaki::decode_uint<hamigaki::little,4>(&buf[0]);
+    boost::uint32_t n2 = hamigaki::decode_uint<hamigaki::little,4>(&buf[4]);
+    BOOST_CHECK_EQUAL(n1, 0x3F000000u);
+    BOOST_CHECK_EQUAL(n2, 0xBE800000u);
+}
+
+std::string all_codes()
+{
+    std::string codes;
+    for (unsigned i = 0; i < 256; ++i)
+        codes += static_cast<char>(static_cast<unsigned char>(i));
+    return codes;
+}
+
+template<audio::sample_format_type Type>
+void companding_float_test_aux()
+{
+    std::string codes = all_codes();
+
+    std::vector<float> values(256);
+    BOOST_CHECK_EQUAL(
+        audio::widen<float>(sample_string(codes, Type))
+            .read(&values[0], 256), 256);
+
+    for (unsigned i = 0; i < 256; ++i)
+    {
+        const boost::uint8_t code = static_cast<boost::uint8_t>(i);
+        BOOST_CHECK_EQUAL(values[i],
+            audio::detail::companding_traits<Type>::
+                template decode<float>(code));
+    }
+}
+
+void companding_int_test_aux(audio::sample_format_type type)
+{
+    std::string codes = all_codes();
+
+    std::vector<boost::int16_t> values(256);
+    BOOST_CHECK_EQUAL(
+        audio::widen<boost::int16_t>(sample_string(codes, type))
+            .read(&values[0], 256), 256);
+
+    std::string buf;
+    audio::widen<boost::int16_t>(sample_string(buf, type))
+        .write(&values[0], 256);
+    BOOST_REQUIRE_EQUAL(buf.size(), 256u);
+
+    // encoding the decoded value is stable
+    std::vector<boost::int16_t> values2(256);
+    BOOST_CHECK_EQUAL(
+        audio::widen<boost::int16_t>(sample_string(buf, type))
+            .read(&values2[0], 256), 256);
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        values.begin(), values.end(), values2.begin(), values2.end());
+
+    // all negative and positive values
+    std::vector<boost::int16_t> data;
+    for (int i = -32768; i < 32768; ++i)
+        data.push_back(static_cast<boost::int16_t>(i));
+
+    std::string encoded;
+    audio::widen<boost::int16_t>(sample_string(encoded, type))
+        .write(&data[0], static_cast<std::streamsize>(data.size()));
+    BOOST_REQUIRE_EQUAL(encoded.size(), data.size());
+
+    for (std::size_t i = 0; i < data.size(); ++i)
+    {
+        char c;
+        if (type == audio::mu_law)
+        {
+            audio::detail::cvt_int32<audio::mu_law>::encode(
+                &c, static_cast<boost::int32_t>(data[i]) << 16);
+        }
+        else
+        {
+            audio::detail::cvt_int32<audio::a_law>::encode(
+                &c, static_cast<boost::int32_t>(data[i]) << 16);
+        }
+        if (c != encoded[i])
+        {
+            BOOST_ERROR("bad encoding");
+            break;
+        }
+    }
+}
+
+void companding_test()
+{
+    companding_float_test_aux<audio::mu_law>();
+    companding_float_test_aux<audio::a_law>();
+    companding_int_test_aux(audio::mu_law);
+    companding_int_test_aux(audio::a_law);
+}
+
+void delay_test()
+{
+    const std::vector<float> fdata(100);
+    audio::wide_adaptor<float,delayed_sink> f(
+        delayed_sink(audio::int_le24, 30), 64);
+    f.write(&fdata[0], static_cast<std::streamsize>(fdata.size()));
+    BOOST_CHECK_EQUAL(audio::device_delay(f), 90);
+
+    const std::vector<boost::int16_t> idata(100);
+    audio::wide_adaptor<boost::int16_t,delayed_sink> i(
+        delayed_sink(audio::int_le16, 40), 64);
+    i.write(&idata[0], static_cast<std::streamsize>(idata.size()));
+    BOOST_CHECK_EQUAL(audio::device_delay(i), 80);
+}
+
+ut::test_suite* init_unit_test_suite(int, char* [])
+{
+    ut::test_suite* test = BOOST_TEST_SUITE("wide adaptor test");
+    test->add(BOOST_TEST_CASE(&float_test));
+    test->add(BOOST_TEST_CASE(&int_test));
+    test->add(BOOST_TEST_CASE(&int_float_le32_test));
+    test->add(BOOST_TEST_CASE(&companding_test));
+    test->add(BOOST_TEST_CASE(&delay_test));
+    return test;
+}
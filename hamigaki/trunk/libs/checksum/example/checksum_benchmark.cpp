@@ -0,0 +1,122 @@
+// checksum_benchmark.cpp: measures the throughput of the checksums
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/checksum for library home page.
+
+// Usage: checksum_benchmark [size in MiB]
+// Hashes the buffers of the given size (16MiB by default) and
+// prints the throughput of each algorithm.
+
+#include <hamigaki/checksum/crc.hpp>
+#include <hamigaki/checksum/md5.hpp>
+#include <hamigaki/checksum/sha1.hpp>
+#include <hamigaki/checksum/sha2.hpp>
+#include <hamigaki/checksum/sha2_multi_buffer.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/lexical_cast.hpp>
+#include <ctime>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace cksum = hamigaki::checksum;
+
+// prevents the optimizer from removing the computation
+volatile unsigned long result_sink;
+
+template<class T>
+void use_result(const T& value)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(&value);
+    for (std::size_t i = 0; i < sizeof(value); ++i)
+        result_sink = result_sink + p[i];
+}
+
+void print_result(const char* name, double bytes, std::clock_t start)
+{
+    double sec =
+        static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+
+    std::cout
+        << std::setw(28) << std::left << name << std::right
+        << std::setw(10) << std::fixed << std::setprecision(1)
+        << (sec != 0.0 ? bytes / sec / (1024.0*1024.0) : 0.0)
+        << " MB/s" << std::endl;
+}
+
+template<class Checksum>
+void benchmark(const char* name, const std::vector<unsigned char>& data)
+{
+    std::clock_t start = std::clock();
+
+    Checksum cs;
+    cs.process_bytes(&data[0], data.size());
+    use_result(cs.checksum());
+
+    print_result(name, static_cast<double>(data.size()), start);
+}
+
+// hashes "Lanes" copies of the data like the independent files
+template<std::size_t Size, std::size_t Lanes>
+void multi_buffer_benchmark(
+    const char* name, const std::vector<unsigned char>& data)
+{
+    const std::size_t chunk_size = 64*1024;
+
+    std::clock_t start = std::clock();
+
+    cksum::sha2_multi_buffer<Size,Lanes> cs;
+    for (std::size_t pos = 0; pos < data.size(); pos += chunk_size)
+    {
+        std::size_t n = data.size() - pos;
+        if (n > chunk_size)
+            n = chunk_size;
+
+        for (std::size_t i = 0; i < Lanes; ++i)
+            cs.process_bytes(i, &data[pos], n);
+    }
+    for (std::size_t i = 0; i < Lanes; ++i)
+        use_result(cs.checksum(i));
+
+    print_result(name, static_cast<double>(data.size()) * Lanes, start);
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        std::size_t mega_bytes = 16;
+        if (argc >= 2)
+            mega_bytes = boost::lexical_cast<std::size_t>(argv[1]);
+
+        std::vector<unsigned char> data(mega_bytes*1024*1024);
+        boost::uint32_t x = 1;
+        for (std::size_t i = 0; i < data.size(); ++i)
+        {
+            x = x * 1103515245u + 12345u;
+            data[i] = static_cast<unsigned char>(x >> 16);
+        }
+
+        benchmark<cksum::crc_32_type>("crc_32_type", data);
+        benchmark<cksum::md5>("md5", data);
+        benchmark<cksum::sha1_optimal>("sha1_optimal", data);
+        benchmark<cksum::sha256>("sha256", data);
+        multi_buffer_benchmark<256,4>("sha2_multi_buffer<256,4>", data);
+        multi_buffer_benchmark<256,8>("sha2_multi_buffer<256,8>", data);
+        benchmark<cksum::sha512>("sha512", data);
+        multi_buffer_benchmark<512,2>("sha2_multi_buffer<512,2>", data);
+        multi_buffer_benchmark<512,4>("sha2_multi_buffer<512,4>", data);
+
+        return 0;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+    return 1;
+}
@@ -0,0 +1,95 @@
+// crc_test.cpp: test case for CRC
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/checksum for library home page.
+
+#include <hamigaki/checksum/crc.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/crc.hpp>
+#include <cstring>
+#include <vector>
+
+namespace cksum = hamigaki::checksum;
+namespace ut = boost::unit_test;
+
+void check_value_test()
+{
+    const char data[] = "123456789";
+    const std::size_t size = std::strlen(data);
+
+    cksum::crc_16_type crc16;
+    crc16.process_bytes(data, size);
+    BOOST_CHECK_EQUAL(crc16.checksum(), 0xBB3Du);
+
+    cksum::crc_32_type crc32;
+    crc32.process_bytes(data, size);
+    BOOST_CHECK_EQUAL(crc32.checksum(), 0xCBF43926u);
+}
+
+template<class Crc, class BoostCrc>
+void compare_test_aux(const std::vector<unsigned char>& data)
+{
+    // all offsets and lengths around the 8 bytes boundary
+    for (std::size_t off = 0; off < 16; ++off)
+    {
+        for (std::size_t size = 0; off + size <= data.size(); size += 7)
+        {
+            Crc crc;
+            crc.process_bytes(&data[0] + off, size);
+
+            BoostCrc expected;
+            expected.process_bytes(&data[0] + off, size);
+
+            BOOST_CHECK_EQUAL(crc.checksum(), expected.checksum());
+        }
+    }
+}
+
+void compare_test()
+{
+    std::vector<unsigned char> data(1000);
+    boost::uint32_t x = 1;
+    for (std::size_t i = 0; i < data.size(); ++i)
+    {
+        x = x * 1103515245u + 12345u;
+        data[i] = static_cast<unsigned char>(x >> 16);
+    }
+
+    compare_test_aux<cksum::crc_16_type,boost::crc_16_type>(data);
+    compare_test_aux<cksum::crc_32_type,boost::crc_32_type>(data);
+}
+
+void incremental_test()
+{
+    const char data[] = "The quick brown fox jumps over the lazy dog";
+    const std::size_t size = std::strlen(data);
+
+    cksum::crc_32_type whole;
+    whole.process_block(data, data + size);
+
+    cksum::crc_32_type parts;
+    parts.process_bytes(data, 3);
+    parts.process_byte(static_cast<unsigned char>(data[3]));
+    parts.process_bytes(data + 4, 20);
+    for (std::size_t i = 24; i < size; ++i)
+        parts(static_cast<unsigned char>(data[i]));
+
+    BOOST_CHECK_EQUAL(parts(), whole());
+    BOOST_CHECK_EQUAL(whole.checksum(), 0x414FA339u);
+
+    parts.reset();
+    BOOST_CHECK_EQUAL(parts.checksum(), 0u);
+}
+
+ut::test_suite* init_unit_test_suite(int, char* [])
+{
+    ut::test_suite* test = BOOST_TEST_SUITE("CRC test");
+    test->add(BOOST_TEST_CASE(&check_value_test));
+    test->add(BOOST_TEST_CASE(&compare_test));
+    test->add(BOOST_TEST_CASE(&incremental_test));
+    return test;
+}
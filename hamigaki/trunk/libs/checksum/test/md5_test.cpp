@@ -64,9 +64,40 @@ void md5_test()
     );
 }
 
+void bits_test()
+{
+    std::string data;
+    for (std::size_t i = 0; i < 300; ++i)
+        data += static_cast<char>(i * 7);
+
+    // the bit-by-bit input is the reference
+    cksum::md5 expected;
+    expected.process_bits(0x05, 3);
+    for (std::size_t i = 0; i < data.size(); ++i)
+        expected.process_bits(static_cast<unsigned char>(data[i]), 8);
+
+    cksum::md5 cs;
+    cs.process_bits(0x05, 3);
+    cs.process_bytes(data.c_str(), data.size());
+
+    BOOST_CHECK(cs.checksum() == expected.checksum());
+
+    // the unaligned bits after the bytes
+    cksum::md5 cs2;
+    cs2.process_bytes(data.c_str(), 130);
+    cs2.process_bits(0x01, 1);
+    cksum::md5 expected2;
+    for (std::size_t i = 0; i < 130; ++i)
+        expected2.process_bits(static_cast<unsigned char>(data[i]), 8);
+    expected2.process_bit(true);
+
+    BOOST_CHECK(cs2.checksum() == expected2.checksum());
+}
+
 ut::test_suite* init_unit_test_suite(int, char* [])
 {
     ut::test_suite* test = BOOST_TEST_SUITE("md5 test");
     test->add(BOOST_TEST_CASE(&md5_test));
+    test->add(BOOST_TEST_CASE(&bits_test));
     return test;
 }
@@ -0,0 +1,148 @@
+// sha2_multi_buffer_test.cpp: test case for sha2_multi_buffer
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/checksum for library home page.
+
+#include <hamigaki/checksum/sha2_multi_buffer.hpp>
+#include <hamigaki/hex_format.hpp>
+#include <boost/test/unit_test.hpp>
+#include <string>
+#include <vector>
+
+namespace cksum = hamigaki::checksum;
+namespace ut = boost::unit_test;
+
+std::string make_data(std::size_t size, boost::uint32_t seed)
+{
+    std::string s;
+    boost::uint32_t x = seed;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        x = x * 1103515245u + 12345u;
+        s += static_cast<char>(x >> 16);
+    }
+    return s;
+}
+
+template<std::size_t Size, std::size_t Lanes>
+void compare_test_aux(std::size_t chunk_size)
+{
+    typedef cksum::sha2_multi_buffer<Size,Lanes> multi_type;
+    typedef cksum::sha2_optimal<Size> single_type;
+
+    // the streams of the different lengths around the block boundaries
+    std::vector<std::string> data;
+    std::size_t max_size = 0;
+    for (std::size_t i = 0; i < Lanes; ++i)
+    {
+        data.push_back(make_data(1000 + i*61 + (i%3)*2000, i+1));
+        max_size = (std::max)(max_size, data.back().size());
+    }
+
+    multi_type multi;
+    for (std::size_t pos = 0; pos < max_size; pos += chunk_size)
+    {
+        for (std::size_t i = 0; i < Lanes; ++i)
+        {
+            const std::string& s = data[i];
+            if (pos < s.size())
+            {
+                std::size_t n = (std::min)(chunk_size, s.size() - pos);
+                multi.process_bytes(i, s.data() + pos, n);
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < Lanes; ++i)
+    {
+        single_type single;
+        single.process_bytes(data[i].data(), data[i].size());
+
+        BOOST_CHECK_EQUAL(
+            hamigaki::to_hex<char>(multi.checksum(i), false),
+            hamigaki::to_hex<char>(single.checksum(), false));
+    }
+}
+
+void compare_test()
+{
+    compare_test_aux<256,4>(1);
+    compare_test_aux<256,4>(64);
+    compare_test_aux<256,8>(333);
+    compare_test_aux<224,4>(100);
+    compare_test_aux<384,2>(128);
+    compare_test_aux<512,4>(1000);
+}
+
+void known_value_test()
+{
+    cksum::sha2_multi_buffer<256,4> multi;
+    multi.process_bytes(0, "abc", 3);
+    multi.process_bytes(2,
+        "abcdbcdecdefdefgefghfghighijhi"
+        "jkijkljklmklmnlmnomnopnopq", 56);
+
+    BOOST_CHECK_EQUAL(
+        hamigaki::to_hex<char>(multi.checksum(0), false),
+        std::string(
+            "ba7816bf8f01cfea414140de5dae2223"
+            "b00361a396177a9cb410ff61f20015ad")
+    );
+
+    BOOST_CHECK_EQUAL(
+        hamigaki::to_hex<char>(multi.checksum(1), false),
+        std::string(
+            "e3b0c44298fc1c149afbf4c8996fb924"
+            "27ae41e4649b934ca495991b7852b855")
+    );
+
+    BOOST_CHECK_EQUAL(
+        hamigaki::to_hex<char>(multi.checksum(2), false),
+        std::string(
+            "248d6a61d20638b8e5c026930c3e6039"
+            "a33ce45964ff2167f6ecedd419db06c1")
+    );
+}
+
+void unbalanced_test()
+{
+    // only one stream is fed
+    const std::string& data = make_data(100000, 7);
+
+    cksum::sha2_multi_buffer<256,4> multi;
+    for (std::size_t pos = 0; pos < data.size(); pos += 4096)
+    {
+        std::size_t n = (std::min)(
+            static_cast<std::size_t>(4096), data.size() - pos);
+        multi.process_bytes(3, data.data() + pos, n);
+    }
+
+    cksum::sha256 single;
+    single.process_bytes(data.data(), data.size());
+
+    BOOST_CHECK_EQUAL(
+        hamigaki::to_hex<char>(multi.checksum(3), false),
+        hamigaki::to_hex<char>(single.checksum(), false));
+
+    multi.reset(3);
+    multi.process_bytes(3, "abc", 3);
+    BOOST_CHECK_EQUAL(
+        hamigaki::to_hex<char>(multi.checksum(3), false),
+        std::string(
+            "ba7816bf8f01cfea414140de5dae2223"
+            "b00361a396177a9cb410ff61f20015ad")
+    );
+}
+
+ut::test_suite* init_unit_test_suite(int, char* [])
+{
+    ut::test_suite* test = BOOST_TEST_SUITE("SHA-2 multi-buffer test");
+    test->add(BOOST_TEST_CASE(&compare_test));
+    test->add(BOOST_TEST_CASE(&known_value_test));
+    test->add(BOOST_TEST_CASE(&unbalanced_test));
+    return test;
+}
@@ -0,0 +1,156 @@
+// bit_filter_benchmark.cpp: compares the bit readers
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/iostreams for library home page.
+
+// Usage: bit_filter_benchmark [(size in MB)]
+// Prints the throughput of read_bits() of input_bit_filter and
+// the reader which extracts one bit at a time.
+
+#include <hamigaki/iostreams/bit_filter.hpp>
+#include <boost/iostreams/detail/adapter/direct_adapter.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/lexical_cast.hpp>
+#include <ctime>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace io_ex = hamigaki::iostreams;
+namespace io = boost::iostreams;
+
+typedef io::detail::direct_adapter<io::array_source> source_type;
+
+// the reader of the previous version
+template<io_ex::bit_flow Flow>
+class per_bit_reader
+{
+public:
+    typedef io_ex::bit_stream_traits<Flow> traits_type;
+
+    static const std::size_t buffer_size = 4096;
+
+    per_bit_reader() : buffer_(buffer_size), size_(0), index_(0), bit_(0)
+    {
+    }
+
+    template<class Source>
+    bool get_bit(Source& src)
+    {
+        if (index_ == size_)
+        {
+            std::streamsize amt = io::read(src, &buffer_[0], buffer_size);
+            if (amt <= 0)
+                throw io::detail::bad_read();
+            size_ = static_cast<std::size_t>(amt);
+            index_ = 0;
+            bit_ = 0;
+        }
+
+        bool result = (buffer_[index_] & traits_type::mask(bit_)) != 0;
+        if (++bit_ == 8)
+        {
+            bit_ = 0;
+            ++index_;
+        }
+        return result;
+    }
+
+    template<class Source>
+    unsigned read_bits(Source& src, std::size_t bit_count)
+    {
+        unsigned tmp = 0;
+        while (bit_count--)
+            tmp |= (static_cast<unsigned>(this->get_bit(src)) << bit_count);
+        return tmp;
+    }
+
+private:
+    std::vector<char> buffer_;
+    std::size_t size_;
+    std::size_t index_;
+    std::size_t bit_;
+};
+
+template<class Reader>
+void benchmark(
+    const char* name, const std::string& data,
+    const std::vector<std::size_t>& bits)
+{
+    unsigned sum = 0;
+    std::clock_t start = std::clock();
+    {
+        source_type src(io::array_source(data.c_str(), data.size()));
+        Reader reader;
+        for (std::size_t i = 0; i < bits.size(); ++i)
+            sum += reader.read_bits(src, bits[i]);
+    }
+    double sec =
+        static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+
+    std::cout
+        << std::setw(12) << name
+        << std::setw(10) << std::fixed << std::setprecision(2)
+        << (sec != 0.0
+            ? static_cast<double>(data.size()) / sec / (1024.0*1024.0)
+            : 0.0)
+        << " MB/s"
+        << " (" << sum << ")"
+        << std::endl;
+}
+
+template<io_ex::bit_flow Flow>
+void benchmark_flow(const char* name, std::size_t size)
+{
+    // the widths of LZH codes
+    std::vector<std::size_t> bits;
+    std::string data;
+    {
+        io::back_insert_device<std::string> sink(data);
+        io_ex::output_bit_filter<Flow> filter;
+
+        unsigned seed = 1;
+        std::size_t total = 0;
+        while (total < size * 8)
+        {
+            seed = seed * 1103515245u + 12345u;
+            std::size_t n = 1 + (seed >> 16) % 16;
+            filter.write_bits(sink, seed >> 8, n);
+            bits.push_back(n);
+            total += n;
+        }
+        filter.flush(sink);
+    }
+
+    std::cout << name << std::endl;
+    benchmark<per_bit_reader<Flow> >("per bit", data, bits);
+    benchmark<io_ex::input_bit_filter<Flow> >("reservoir", data, bits);
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        std::size_t size = 16;
+        if (argc > 1)
+            size = boost::lexical_cast<std::size_t>(argv[1]);
+        size *= 1024*1024;
+
+        benchmark_flow<io_ex::left_to_right>("left_to_right", size);
+        benchmark_flow<io_ex::right_to_left>("right_to_left", size);
+
+        return 0;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+    return 1;
+}
@@ -0,0 +1,119 @@
+// lzhuf_benchmark.cpp: compares the match finders of LZHUF compressor
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/iostreams for library home page.
+
+// Usage: lzhuf_benchmark (window bits) (file)...
+// Prints the throughput and the compression ratio of the files
+// (e.g. the Canterbury corpus) for each match finder and level.
+
+#include <hamigaki/iostreams/filter/lzhuf.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/device/file.hpp>
+#include <boost/iostreams/compose.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/lexical_cast.hpp>
+#include <ctime>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace io_ex = hamigaki::iostreams;
+namespace io = boost::iostreams;
+
+template<class MatchFinder>
+void benchmark(
+    const char* name, const std::vector<std::string>& files,
+    std::size_t window_bits, int level)
+{
+    double total_size = 0.0;
+    double total_compressed = 0.0;
+
+    std::clock_t start = std::clock();
+    for (std::size_t i = 0; i < files.size(); ++i)
+    {
+        const std::string& src = files[i];
+
+        std::string dst;
+        io::copy(
+            io::array_source(src.c_str(), src.size()),
+            io::compose(
+                io_ex::basic_lzhuf_compressor<MatchFinder>(
+                    window_bits, 16*1024, level),
+                io::back_inserter(dst)
+            )
+        );
+
+        total_size += static_cast<double>(src.size());
+        total_compressed += static_cast<double>(dst.size());
+    }
+    double sec =
+        static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+
+    std::cout
+        << std::setw(12) << name
+        << std::setw(6) << level
+        << std::setw(10) << std::fixed << std::setprecision(2)
+        << (sec != 0.0 ? total_size / sec / (1024.0*1024.0) : 0.0)
+        << " MB/s"
+        << std::setw(8) << std::setprecision(2)
+        << total_compressed * 100.0 / total_size << " %"
+        << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        if (argc < 3)
+        {
+            std::cerr
+                << "Usage: lzhuf_benchmark (window bits) (file)..."
+                << std::endl;
+            return 1;
+        }
+
+        std::size_t window_bits = boost::lexical_cast<std::size_t>(argv[1]);
+
+        std::vector<std::string> files;
+        for (int i = 2; i < argc; ++i)
+        {
+            std::string data;
+            io::copy(
+                io::file_source(argv[i], std::ios_base::binary),
+                io::back_inserter(data)
+            );
+            files.push_back(data);
+        }
+
+        const int levels[] = { 1, 3, 6, 9 };
+        const std::size_t count = sizeof(levels)/sizeof(levels[0]);
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            benchmark<io_ex::hash_chain_match_finder>(
+                "hash chain", files, window_bits, levels[i]);
+        }
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            benchmark<io_ex::binary_tree_match_finder>(
+                "binary tree", files, window_bits, levels[i]);
+        }
+        benchmark<io_ex::brute_force_match_finder>(
+            "brute force", files, window_bits, 0);
+
+        return 0;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+    return 1;
+}
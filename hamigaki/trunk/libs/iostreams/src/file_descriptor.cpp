@@ -10,17 +10,27 @@
 #define HAMIGAKI_IOSTREAMS_SOURCE
 #define NOMINMAX
 #define _LARGEFILE64_SOURCE
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
 #include <hamigaki/iostreams/device/file_descriptor.hpp>
+#include <hamigaki/integer/auto_min.hpp>
 #include <boost/noncopyable.hpp>
+#include <vector>
 
 #if defined(BOOST_WINDOWS)
     #include <windows.h>
 #else
     #include <sys/stat.h>
+    #include <errno.h>
     #include <fcntl.h>
     #include <unistd.h>
 #endif
 
+#if defined(__linux__) && defined(SPLICE_F_MOVE)
+    #define HAMIGAKI_IOSTREAMS_HAS_SPLICE
+#endif
+
 #if defined(__USE_LARGEFILE64)
     #define HAMIGAKI_RTL(x) ::x##64
 #else
@@ -150,8 +160,38 @@ public:
         );
     }
 
+    void skip(boost::iostreams::stream_offset off)
+    {
+        if (::GetFileType(handle_) == FILE_TYPE_DISK)
+        {
+            this->seek(off, BOOST_IOS::cur);
+            return;
+        }
+
+        detail::resize_skip_buffer(skip_buffer_, off);
+        while (off > 0)
+        {
+            std::streamsize amt = this->read(
+                &skip_buffer_[0],
+                hamigaki::auto_min(skip_buffer_.size(), off));
+            if (amt == -1)
+                throw BOOST_IOSTREAMS_FAILURE("bad skip offset");
+            off -= amt;
+        }
+    }
+
+    void truncate(boost::iostreams::stream_offset size)
+    {
+        std::streampos pos = this->seek(0, BOOST_IOS::cur);
+        this->seek(size, BOOST_IOS::beg);
+        if (::SetEndOfFile(handle_) == FALSE)
+            throw BOOST_IOSTREAMS_FAILURE("bad truncate");
+        this->seek(boost::iostreams::position_to_offset(pos), BOOST_IOS::beg);
+    }
+
 private:
     ::HANDLE handle_;
+    std::vector<char> skip_buffer_;
 };
 #else // not defined(BOOST_WINDOWS)
 namespace
@@ -183,6 +223,7 @@ class file_descriptor_impl : private boost::noncopyable
 {
 public:
     file_descriptor_impl(const std::string& filename, BOOST_IOS::openmode mode)
+        : null_fd_(-1)
     {
         fd_ = HAMIGAKI_RTL(open)(filename.c_str(), make_open_flags(mode), 0666);
         if (fd_ == -1)
@@ -191,6 +232,8 @@ public:
 
     ~file_descriptor_impl()
     {
+        if (null_fd_ != -1)
+            ::close(null_fd_);
         ::close(fd_);
     }
 
@@ -238,8 +281,70 @@ public:
         return boost::iostreams::offset_to_position(res);
     }
 
+    void skip(boost::iostreams::stream_offset off)
+    {
+        if (HAMIGAKI_RTL(lseek)(fd_, off, SEEK_CUR) != -1)
+            return;
+        else if (errno != ESPIPE)
+            throw BOOST_IOSTREAMS_FAILURE("bad skip offset");
+
+#if defined(HAMIGAKI_IOSTREAMS_HAS_SPLICE)
+        off = this->splice_to_null(off);
+#endif
+
+        detail::resize_skip_buffer(skip_buffer_, off);
+        while (off > 0)
+        {
+            std::streamsize amt = this->read(
+                &skip_buffer_[0],
+                hamigaki::auto_min(skip_buffer_.size(), off));
+            if (amt == -1)
+                throw BOOST_IOSTREAMS_FAILURE("bad skip offset");
+            off -= amt;
+        }
+    }
+
+    void truncate(boost::iostreams::stream_offset size)
+    {
+        if (HAMIGAKI_RTL(ftruncate)(fd_, size) == -1)
+            throw BOOST_IOSTREAMS_FAILURE("bad truncate");
+    }
+
 private:
     int fd_;
+    int null_fd_;
+    std::vector<char> skip_buffer_;
+
+#if defined(HAMIGAKI_IOSTREAMS_HAS_SPLICE)
+    // moves the data from the pipe to /dev/null in the kernel
+    // returns the rest size if splice() is not supported
+    boost::iostreams::stream_offset
+    splice_to_null(boost::iostreams::stream_offset off)
+    {
+        if (null_fd_ == -1)
+        {
+            null_fd_ = ::open("/dev/null", O_WRONLY);
+            if (null_fd_ == -1)
+                return off;
+        }
+
+        while (off > 0)
+        {
+            std::size_t size = hamigaki::auto_min(skip_buffer_size, off);
+            ::ssize_t amt = ::splice(fd_, 0, null_fd_, 0, size, SPLICE_F_MOVE);
+            if (amt == -1)
+            {
+                if (errno == EINTR)
+                    continue;
+                break;
+            }
+            else if (amt == 0)
+                throw BOOST_IOSTREAMS_FAILURE("bad skip offset");
+            off -= amt;
+        }
+        return off;
+    }
+#endif
 };
 #endif // not defined(BOOST_WINDOWS)
 
@@ -262,6 +367,11 @@ std::streampos file_descriptor_source::seek(
     return pimpl_->seek(off, way);
 }
 
+void file_descriptor_source::skip(boost::iostreams::stream_offset off)
+{
+    pimpl_->skip(off);
+}
+
 
 void file_descriptor_sink::open(
     const std::string& filename, BOOST_IOS::openmode mode)
@@ -303,4 +413,14 @@ std::streampos file_descriptor::seek(
     return pimpl_->seek(off, way);
 }
 
+void file_descriptor::skip(boost::iostreams::stream_offset off)
+{
+    pimpl_->skip(off);
+}
+
+void file_descriptor::truncate(boost::iostreams::stream_offset size)
+{
+    pimpl_->truncate(size);
+}
+
 } } // End namespaces iostreams, hamigaki.
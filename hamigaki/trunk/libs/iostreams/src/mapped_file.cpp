@@ -0,0 +1,323 @@
+// mapped_file.cpp: read-only memory-mapped file device
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/iostreams for library home page.
+
+#define HAMIGAKI_IOSTREAMS_SOURCE
+#define NOMINMAX
+#define _LARGEFILE64_SOURCE
+#include <hamigaki/iostreams/device/mapped_file.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <algorithm>
+#include <cstring>
+
+#if defined(BOOST_WINDOWS)
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+#if defined(__USE_LARGEFILE64)
+    #define HAMIGAKI_RTL(x) ::x##64
+#else
+    #define HAMIGAKI_RTL(x) ::x
+#endif
+
+namespace hamigaki { namespace iostreams {
+
+namespace detail
+{
+
+namespace
+{
+
+inline std::size_t to_map_size(boost::uint64_t size)
+{
+    if (size > static_cast<std::size_t>(-1))
+        throw BOOST_IOSTREAMS_FAILURE("too large file to map");
+    return static_cast<std::size_t>(size);
+}
+
+} // namespace
+
+#if defined(BOOST_WINDOWS)
+
+#ifdef BOOST_MSVC
+    #pragma warning(disable : 4275)
+#endif
+
+class mapped_file_base : private boost::noncopyable
+{
+protected:
+    explicit mapped_file_base(const std::string& filename)
+        : data_(0), size_(0)
+    {
+        ::HANDLE file = ::CreateFileA(filename.c_str(),
+            GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE, 0,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+
+        if (file == INVALID_HANDLE_VALUE)
+            throw BOOST_IOSTREAMS_FAILURE("bad open");
+
+        ::DWORD high = 0;
+        ::DWORD low = ::GetFileSize(file, &high);
+        if ((low == INVALID_FILE_SIZE) && (::GetLastError() != NO_ERROR))
+        {
+            ::CloseHandle(file);
+            throw BOOST_IOSTREAMS_FAILURE("bad open");
+        }
+
+        try
+        {
+            size_ = to_map_size(
+                low | (static_cast<boost::uint64_t>(high) << 32));
+        }
+        catch (...)
+        {
+            ::CloseHandle(file);
+            throw;
+        }
+
+        // an empty file cannot be mapped
+        if (size_ == 0)
+        {
+            ::CloseHandle(file);
+            return;
+        }
+
+        // the view keeps the file open
+        ::HANDLE mapping =
+            ::CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+        ::CloseHandle(file);
+        if (mapping == 0)
+            throw BOOST_IOSTREAMS_FAILURE("bad open");
+
+        void* p = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        ::CloseHandle(mapping);
+        if (p == 0)
+            throw BOOST_IOSTREAMS_FAILURE("bad open");
+
+        data_ = static_cast<const char*>(p);
+    }
+
+    ~mapped_file_base()
+    {
+        if (data_)
+            ::UnmapViewOfFile(data_);
+    }
+
+    // the system read-ahead of the mapped files is not controllable
+    void advise(std::size_t, std::size_t, map_advice::values)
+    {
+    }
+
+    const char* data_;
+    std::size_t size_;
+};
+#else // not defined(BOOST_WINDOWS)
+namespace
+{
+
+inline int make_advice(map_advice::values advice)
+{
+    if (advice == map_advice::sequential)
+        return POSIX_MADV_SEQUENTIAL;
+    else if (advice == map_advice::random)
+        return POSIX_MADV_RANDOM;
+    else if (advice == map_advice::will_need)
+        return POSIX_MADV_WILLNEED;
+    else
+        return POSIX_MADV_NORMAL;
+}
+
+} // namespace
+
+class mapped_file_base : private boost::noncopyable
+{
+protected:
+    explicit mapped_file_base(const std::string& filename)
+        : data_(0), size_(0)
+    {
+        int fd = HAMIGAKI_RTL(open)(filename.c_str(), O_RDONLY);
+        if (fd == -1)
+            throw BOOST_IOSTREAMS_FAILURE("bad open");
+
+        boost::iostreams::stream_offset size =
+            HAMIGAKI_RTL(lseek)(fd, 0, SEEK_END);
+        if (size == -1)
+        {
+            ::close(fd);
+            throw BOOST_IOSTREAMS_FAILURE("bad open");
+        }
+
+        try
+        {
+            size_ = to_map_size(static_cast<boost::uint64_t>(size));
+        }
+        catch (...)
+        {
+            ::close(fd);
+            throw;
+        }
+
+        // an empty file cannot be mapped
+        if (size_ == 0)
+        {
+            ::close(fd);
+            return;
+        }
+
+        // the mapping keeps the file open
+        void* p = ::mmap(0, size_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED)
+            throw BOOST_IOSTREAMS_FAILURE("bad open");
+
+        data_ = static_cast<const char*>(p);
+    }
+
+    ~mapped_file_base()
+    {
+        if (data_)
+            ::munmap(const_cast<char*>(data_), size_);
+    }
+
+    // only a hint, so that the errors are ignored
+    void advise(std::size_t off, std::size_t n, map_advice::values advice)
+    {
+        if (!data_ || (off >= size_))
+            return;
+
+        n = (std::min)(n, size_ - off);
+
+        // the address must be aligned to the page size
+        std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        std::size_t start = off - off % page;
+        ::posix_madvise(
+            const_cast<char*>(data_) + start, n + (off - start),
+            make_advice(advice));
+    }
+
+    const char* data_;
+    std::size_t size_;
+};
+#endif // not defined(BOOST_WINDOWS)
+
+class mapped_file_impl : private mapped_file_base
+{
+public:
+    mapped_file_impl(const std::string& filename, map_advice::values advice)
+        : mapped_file_base(filename), pos_(0)
+    {
+        if (advice != map_advice::normal)
+            mapped_file_base::advise(0, size_, advice);
+    }
+
+    std::streamsize read(char* s, std::streamsize n)
+    {
+        if (pos_ >= size_)
+            return -1;
+
+        std::size_t amt = size_ - pos_;
+        if (static_cast<boost::uint64_t>(n) < amt)
+            amt = static_cast<std::size_t>(n);
+
+        std::memcpy(s, data_ + pos_, amt);
+        pos_ += amt;
+        return static_cast<std::streamsize>(amt);
+    }
+
+    std::streampos seek(
+        boost::iostreams::stream_offset off, BOOST_IOS::seekdir way)
+    {
+        boost::iostreams::stream_offset base = 0;
+        if (way == BOOST_IOS::cur)
+            base = static_cast<boost::iostreams::stream_offset>(pos_);
+        else if (way == BOOST_IOS::end)
+            base = static_cast<boost::iostreams::stream_offset>(size_);
+
+        // seeking beyond the end is allowed like the files
+        boost::iostreams::stream_offset next = base + off;
+        if (next < 0)
+            throw BOOST_IOSTREAMS_FAILURE("bad seek");
+
+        pos_ = to_map_size(static_cast<boost::uint64_t>(next));
+        return boost::iostreams::offset_to_position(next);
+    }
+
+    void advise(
+        boost::iostreams::stream_offset off, std::size_t n,
+        map_advice::values advice)
+    {
+        if (off < 0)
+            throw BOOST_IOSTREAMS_FAILURE("bad offset");
+        if (static_cast<boost::uint64_t>(off) < size_)
+        {
+            mapped_file_base::advise(
+                static_cast<std::size_t>(off), n, advice);
+        }
+    }
+
+    const char* data() const
+    {
+        return data_;
+    }
+
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+private:
+    std::size_t pos_;
+};
+
+} // namespace detail
+
+void mapped_file_source::open(
+    const std::string& filename, map_advice::values advice)
+{
+    pimpl_.reset(new impl_type(filename, advice));
+}
+
+std::streamsize mapped_file_source::read(char* s, std::streamsize n)
+{
+    return pimpl_->read(s, n);
+}
+
+std::streampos mapped_file_source::seek(
+    boost::iostreams::stream_offset off, BOOST_IOS::seekdir way)
+{
+    return pimpl_->seek(off, way);
+}
+
+void mapped_file_source::advise(map_advice::values advice)
+{
+    pimpl_->advise(0, pimpl_->size(), advice);
+}
+
+void mapped_file_source::advise(
+    boost::iostreams::stream_offset off, std::size_t n,
+    map_advice::values advice)
+{
+    pimpl_->advise(off, n, advice);
+}
+
+const char* mapped_file_source::data() const
+{
+    return pimpl_->data();
+}
+
+std::size_t mapped_file_source::size() const
+{
+    return pimpl_->size();
+}
+
+} } // End namespaces iostreams, hamigaki.
@@ -151,6 +151,15 @@ public:
         );
     }
 
+    void truncate(boost::iostreams::stream_offset size)
+    {
+        std::streampos pos = this->seek(0, BOOST_IOS::cur);
+        this->seek(size, BOOST_IOS::beg);
+        if (::SetEndOfFile(handle_) == FALSE)
+            throw BOOST_IOSTREAMS_FAILURE("bad truncate");
+        this->seek(boost::iostreams::position_to_offset(pos), BOOST_IOS::beg);
+    }
+
     void close()
     {
         if (handle_ != INVALID_HANDLE_VALUE)
@@ -231,6 +240,12 @@ public:
         return boost::iostreams::offset_to_position(res);
     }
 
+    void truncate(boost::iostreams::stream_offset size)
+    {
+        if (::ftruncate(fd_, static_cast< ::off_t>(size)) == -1)
+            throw BOOST_IOSTREAMS_FAILURE("bad truncate");
+    }
+
     void close()
     {
         if (fd_ != -1)
@@ -279,6 +294,11 @@ std::streampos tmp_file::seek(
     return pimpl_->seek(off, way);
 }
 
+void tmp_file::truncate(boost::iostreams::stream_offset size)
+{
+    pimpl_->truncate(size);
+}
+
 void tmp_file::close()
 {
     pimpl_->close();
@@ -10,9 +10,13 @@
 #include <hamigaki/iostreams/device/zero.hpp>
 #include <hamigaki/iostreams/background_copy.hpp>
 #include <hamigaki/thread/utc_time.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
 #include <boost/iostreams/device/null.hpp>
 #include <boost/iostreams/restrict.hpp>
 #include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
 
 namespace io_ex = hamigaki::iostreams;
 namespace io = boost::iostreams;
@@ -43,9 +47,108 @@ void background_copy_test()
     }
 }
 
+std::string make_data(std::size_t size)
+{
+    std::string s;
+    s.reserve(size);
+    for (std::size_t i = 0; i < size; ++i)
+        s += static_cast<char>(i * 31 + (i >> 10));
+    return s;
+}
+
+class string_source
+{
+public:
+    typedef char char_type;
+    typedef boost::iostreams::source_tag category;
+
+    explicit string_source(const std::string& s) : s_(s), pos_(0)
+    {
+    }
+
+    std::streamsize read(char* s, std::streamsize n)
+    {
+        if (pos_ == s_.size())
+            return -1;
+
+        std::size_t amt =
+            (std::min)(static_cast<std::size_t>(n), s_.size() - pos_);
+        s_.copy(s, amt, pos_);
+        pos_ += amt;
+        return static_cast<std::streamsize>(amt);
+    }
+
+private:
+    std::string s_;
+    std::size_t pos_;
+};
+
+void pipelined_copy_test()
+{
+    const std::string& data = make_data(1000000);
+
+    for (std::size_t count = 1; count <= 8; count *= 2)
+    {
+        std::string result;
+        io_ex::background_copy bg_copy(
+            string_source(data),
+            io::back_inserter(result), 4096, count);
+        bg_copy.wait();
+
+        BOOST_CHECK(result == data);
+        BOOST_CHECK_EQUAL(bg_copy.total(),
+            static_cast<std::streamsize>(data.size()));
+
+        const io_ex::background_copy_statistics& stat =
+            bg_copy.statistics();
+        BOOST_CHECK_EQUAL(stat.read_total,
+            static_cast<std::streamsize>(data.size()));
+        BOOST_CHECK_EQUAL(stat.write_total,
+            static_cast<std::streamsize>(data.size()));
+        BOOST_CHECK(stat.max_filled_buffers >= 1);
+        BOOST_CHECK(stat.max_filled_buffers <= count);
+    }
+
+    {
+        const unsigned long test_size = 32ul * 1024ul * 1024ul;
+        io_ex::background_copy bg_copy(
+            io::restrict(io_ex::zero_source(), 0, test_size),
+            io::null_sink(), 4096, 4);
+
+        bg_copy.stop();
+        BOOST_CHECK(bg_copy.statistics().write_total <=
+            bg_copy.statistics().read_total);
+    }
+}
+
+class failing_sink
+{
+public:
+    typedef char char_type;
+    typedef boost::iostreams::sink_tag category;
+
+    std::streamsize write(const char*, std::streamsize)
+    {
+        throw std::runtime_error("failing_sink");
+        return 0;
+    }
+};
+
+void pipelined_error_test()
+{
+    const unsigned long test_size = 32ul * 1024ul * 1024ul;
+    io_ex::background_copy bg_copy(
+        io::restrict(io_ex::zero_source(), 0, test_size),
+        failing_sink(), 4096, 4);
+
+    BOOST_CHECK_THROW(bg_copy.wait(), std::runtime_error);
+}
+
 ut::test_suite* init_unit_test_suite(int, char* [])
 {
     ut::test_suite* test = BOOST_TEST_SUITE("background_copy test");
     test->add(BOOST_TEST_CASE(&background_copy_test));
+    test->add(BOOST_TEST_CASE(&pipelined_copy_test));
+    test->add(BOOST_TEST_CASE(&pipelined_error_test));
     return test;
 }
@@ -0,0 +1,169 @@
+// bit_filter_test.cpp: test case for input_bit_filter/output_bit_filter
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/iostreams for library home page.
+
+#include <hamigaki/iostreams/bit_filter.hpp>
+#include <boost/iostreams/detail/adapter/direct_adapter.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/test/unit_test.hpp>
+#include <string>
+#include <vector>
+
+namespace io_ex = hamigaki::iostreams;
+namespace io = boost::iostreams;
+namespace ut = boost::unit_test;
+
+typedef io::back_insert_device<std::string> sink_type;
+typedef io::detail::direct_adapter<io::array_source> source_type;
+
+template<io_ex::bit_flow Flow>
+std::string write_pattern(
+    const std::vector<unsigned>& values, const std::vector<std::size_t>& bits)
+{
+    std::string buf;
+    sink_type sink(buf);
+    io_ex::output_bit_filter<Flow> filter;
+    for (std::size_t i = 0; i < values.size(); ++i)
+        filter.write_bits(sink, values[i], bits[i]);
+    filter.flush(sink);
+    return buf;
+}
+
+template<io_ex::bit_flow Flow>
+void round_trip_test_aux()
+{
+    std::vector<unsigned> values;
+    std::vector<std::size_t> bits;
+    unsigned seed = 12345;
+    for (std::size_t i = 0; i < 20000; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        std::size_t n = (seed >> 8) % 33;
+        seed = seed * 1103515245u + 12345u;
+        unsigned mask = (n == 32) ? ~0u : ((1u << n) - 1);
+        values.push_back((seed ^ (seed << 13)) & mask);
+        bits.push_back(n);
+    }
+
+    std::string buf = write_pattern<Flow>(values, bits);
+
+    source_type src(io::array_source(buf.c_str(), buf.size()));
+    io_ex::input_bit_filter<Flow> filter;
+    for (std::size_t i = 0; i < values.size(); ++i)
+    {
+        if (i % 3 == 0)
+        {
+            std::size_t n = (bits[i] < 25) ? bits[i] : 25;
+            BOOST_CHECK_EQUAL(
+                filter.peek_bits(src, n), values[i] >> (bits[i] - n));
+        }
+
+        if (i % 5 == 0)
+        {
+            filter.skip_bits(src, bits[i]);
+            continue;
+        }
+
+        BOOST_REQUIRE_EQUAL(filter.read_bits(src, bits[i]), values[i]);
+    }
+}
+
+void round_trip_test()
+{
+    round_trip_test_aux<io_ex::left_to_right>();
+    round_trip_test_aux<io_ex::right_to_left>();
+}
+
+void order_test()
+{
+    std::vector<unsigned> values;
+    std::vector<std::size_t> bits;
+    values.push_back(5);
+    bits.push_back(3);
+    values.push_back(0x1FF);
+    bits.push_back(9);
+
+    // 101 111111111 (0000)
+    std::string ltr = write_pattern<io_ex::left_to_right>(values, bits);
+    BOOST_REQUIRE_EQUAL(ltr.size(), 2u);
+    BOOST_CHECK_EQUAL(static_cast<unsigned char>(ltr[0]), 0xBFu);
+    BOOST_CHECK_EQUAL(static_cast<unsigned char>(ltr[1]), 0xF0u);
+
+    std::string rtl = write_pattern<io_ex::right_to_left>(values, bits);
+    BOOST_REQUIRE_EQUAL(rtl.size(), 2u);
+    BOOST_CHECK_EQUAL(static_cast<unsigned char>(rtl[0]), 0xFDu);
+    BOOST_CHECK_EQUAL(static_cast<unsigned char>(rtl[1]), 0x0Fu);
+
+    source_type src(io::array_source(rtl.c_str(), rtl.size()));
+    io_ex::input_bit_filter<io_ex::right_to_left> filter;
+    BOOST_CHECK(filter.get_bit(src));
+    BOOST_CHECK(!filter.get_bit(src));
+    BOOST_CHECK(filter.get_bit(src));
+    BOOST_CHECK_EQUAL(filter.read_bits(src, 9), 0x1FFu);
+}
+
+void end_of_stream_test()
+{
+    const char data[] = { '\xFF', '\x80' };
+    source_type src(io::array_source(data, sizeof(data)));
+    io_ex::input_bit_filter<io_ex::left_to_right> filter;
+
+    // the bits after the end are zero
+    BOOST_CHECK_EQUAL(filter.peek_bits(src, 20), 0xFF800u);
+    filter.skip_bits(src, 9);
+    BOOST_CHECK_EQUAL(filter.peek_bits(src, 8), 0u);
+    BOOST_CHECK_THROW(filter.skip_bits(src, 8), BOOST_IOSTREAMS_FAILURE);
+    BOOST_CHECK_THROW(filter.read_bits(src, 8), BOOST_IOSTREAMS_FAILURE);
+    BOOST_CHECK_EQUAL(filter.read_bits(src, 7), 0u);
+    BOOST_CHECK_THROW(filter.get_bit(src), BOOST_IOSTREAMS_FAILURE);
+}
+
+void bytes_test()
+{
+    std::string data(10000, '\0');
+    for (std::size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<char>(i * 31 + i / 7);
+
+    std::string buf;
+    {
+        sink_type sink(buf);
+        io_ex::output_bit_filter<io_ex::right_to_left> filter;
+        filter.write_bits(sink, 0xABu, 8);
+        filter.write_bytes(sink, data.c_str(), 100);
+        filter.write_bits(sink, 3u, 2);
+        filter.flush(sink);
+        filter.write_bytes(sink, data.c_str(), 10000);
+        filter.flush(sink);
+    }
+    BOOST_REQUIRE_EQUAL(buf.size(), 1u + 100u + 1u + 10000u);
+
+    source_type src(io::array_source(buf.c_str(), buf.size()));
+    io_ex::input_bit_filter<io_ex::right_to_left> filter;
+    BOOST_CHECK_EQUAL(filter.read_bits(src, 8), 0xABu);
+
+    std::vector<char> tmp(10000);
+    BOOST_CHECK_EQUAL(filter.read_bytes(src, &tmp[0], 100), 100);
+    BOOST_CHECK(std::equal(data.begin(), data.begin()+100, tmp.begin()));
+
+    BOOST_CHECK_EQUAL(filter.read_bits(src, 2), 3u);
+    filter.align();
+    BOOST_CHECK_EQUAL(filter.read_bytes(src, &tmp[0], 10000), 10000);
+    BOOST_CHECK(std::equal(data.begin(), data.end(), tmp.begin()));
+    BOOST_CHECK_EQUAL(filter.read_bytes(src, &tmp[0], 1), -1);
+}
+
+ut::test_suite* init_unit_test_suite(int, char* [])
+{
+    ut::test_suite* test = BOOST_TEST_SUITE("bit filter test");
+    test->add(BOOST_TEST_CASE(&round_trip_test));
+    test->add(BOOST_TEST_CASE(&order_test));
+    test->add(BOOST_TEST_CASE(&end_of_stream_test));
+    test->add(BOOST_TEST_CASE(&bytes_test));
+    return test;
+}
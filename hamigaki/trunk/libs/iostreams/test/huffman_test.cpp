@@ -8,10 +8,15 @@
 // See http://hamigaki.sourceforge.jp/libs/iostreams for library home page.
 
 #include <hamigaki/iostreams/utility/huffman.hpp>
+#include <hamigaki/iostreams/bit_stream.hpp>
+#include <boost/iostreams/detail/adapter/direct_adapter.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
 #include <boost/test/unit_test.hpp>
 #include <boost/cstdint.hpp>
 
 namespace io_ex = hamigaki::iostreams;
+namespace io = boost::iostreams;
 namespace ut = boost::unit_test;
 
 typedef io_ex::huffman_decoder<boost::uint16_t,16> huffman_dec;
@@ -127,6 +132,53 @@ void huffman_encode_test2()
     huffman_code_check(table, 4, 3, 2);
 }
 
+void huffman_decode_test()
+{
+    // a complete code with both short and long (> table_bits) lengths
+    length_dec decoder;
+    for (boost::uint16_t i = 1; i < 16; ++i)
+        decoder.push_back(i);
+    decoder.push_back(15);
+
+    huffman_dec tree;
+    decoder.decode(tree);
+
+    huffman huff;
+    for (boost::uint16_t i = 0; i < 16; ++i)
+    {
+        for (int j = 0; j < (1 << (15-i)); ++j)
+            huff.insert(i);
+    }
+    huff.insert(15);
+
+    huffman_enc table;
+    huff.make_encoder(table);
+
+    std::string buf;
+    typedef io::back_insert_device<std::string> sink_type;
+    sink_type sink(buf);
+    io_ex::output_bit_filter<io_ex::left_to_right> out_filter;
+    {
+        io_ex::output_bit_stream<io_ex::left_to_right,sink_type>
+            bs(out_filter, sink);
+        for (boost::uint16_t i = 0; i < 16; ++i)
+            table.encode(bs, i);
+        for (boost::uint16_t i = 16; i-- != 0; )
+            table.encode(bs, i);
+        bs.flush();
+    }
+
+    typedef io::detail::direct_adapter<io::array_source> source_type;
+    source_type src(io::array_source(buf.c_str(), buf.size()));
+    io_ex::input_bit_filter<io_ex::left_to_right> in_filter;
+    io_ex::input_bit_stream<io_ex::left_to_right,source_type>
+        bs(in_filter, src);
+    for (boost::uint16_t i = 0; i < 16; ++i)
+        BOOST_CHECK_EQUAL(tree.decode(bs), i);
+    for (boost::uint16_t i = 16; i-- != 0; )
+        BOOST_CHECK_EQUAL(tree.decode(bs), i);
+}
+
 ut::test_suite* init_unit_test_suite(int, char* [])
 {
     ut::test_suite* test = BOOST_TEST_SUITE("Huffman test");
@@ -136,5 +188,6 @@ ut::test_suite* init_unit_test_suite(int, char* [])
     test->add(BOOST_TEST_CASE(&bad_huffman_test3));
     test->add(BOOST_TEST_CASE(&huffman_encode_test));
     test->add(BOOST_TEST_CASE(&huffman_encode_test2));
+    test->add(BOOST_TEST_CASE(&huffman_decode_test));
     return test;
 }
@@ -21,7 +21,8 @@ namespace ut = boost::unit_test;
 
 const std::size_t window_bits = 13;
 
-std::string lzhuf_compress(const std::string& src)
+template<class MatchFinder>
+std::string lzhuf_compress(const std::string& src, int level)
 {
     const char* start = src.c_str();
 
@@ -29,13 +30,20 @@ std::string lzhuf_compress(const std::string& src)
     io::copy(
         io::array_source(start, start + src.size()),
         io::compose(
-            io_ex::lzhuf_compressor(window_bits),
+            io_ex::basic_lzhuf_compressor<MatchFinder>(
+                window_bits, 16*1024, level),
             io::back_inserter(dst)
         )
     );
     return dst;
 }
 
+std::string lzhuf_compress(const std::string& src)
+{
+    return lzhuf_compress<io_ex::default_match_finder>(
+        src, io_ex::compression_level::default_compression);
+}
+
 std::string lzhuf_decompress(const std::string& src, std::size_t size)
 {
     const char* start = src.c_str();
@@ -59,6 +67,26 @@ bool lzhuf_test_aux(const std::string& s)
     return lzhuf_decompress(lzhuf_compress(s), s.size()) == s;
 }
 
+template<class MatchFinder>
+bool lzhuf_test_aux(const std::string& s, int level)
+{
+    return lzhuf_decompress(
+        lzhuf_compress<MatchFinder>(s, level), s.size()) == s;
+}
+
+std::string make_test_data()
+{
+    std::string s;
+    unsigned seed = 1;
+    for (std::size_t i = 0; i < 65536; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        unsigned n = (seed >> 16) & 0xFF;
+        s += static_cast<char>(n & (n >> 3));
+    }
+    return s;
+}
+
 void lzhuf_test()
 {
     BOOST_CHECK(lzhuf_test_aux(""));
@@ -72,11 +100,42 @@ void lzhuf_test()
 
     BOOST_CHECK(lzhuf_test_aux(std::string(4096+1, 'a')));
     BOOST_CHECK(lzhuf_test_aux(std::string(4096*2+1, 'a')));
+
+    BOOST_CHECK(lzhuf_test_aux(make_test_data()));
+}
+
+template<class MatchFinder>
+void match_finder_test_aux()
+{
+    const std::string& s = make_test_data();
+    const int levels[] =
+    {
+        io_ex::compression_level::best_speed,
+        io_ex::compression_level::default_compression,
+        io_ex::compression_level::best_compression
+    };
+
+    for (std::size_t i = 0; i < sizeof(levels)/sizeof(levels[0]); ++i)
+    {
+        BOOST_CHECK(lzhuf_test_aux<MatchFinder>("", levels[i]));
+        BOOST_CHECK(lzhuf_test_aux<MatchFinder>("aaaaa", levels[i]));
+        BOOST_CHECK(lzhuf_test_aux<MatchFinder>("ababababa", levels[i]));
+        BOOST_CHECK(lzhuf_test_aux<MatchFinder>(
+            std::string(4096*2+1, 'a'), levels[i]));
+        BOOST_CHECK(lzhuf_test_aux<MatchFinder>(s, levels[i]));
+    }
+}
+
+void match_finder_test()
+{
+    match_finder_test_aux<io_ex::hash_chain_match_finder>();
+    match_finder_test_aux<io_ex::binary_tree_match_finder>();
 }
 
 ut::test_suite* init_unit_test_suite(int, char* [])
 {
     ut::test_suite* test = BOOST_TEST_SUITE("LZHUF test");
     test->add(BOOST_TEST_CASE(&lzhuf_test));
+    test->add(BOOST_TEST_CASE(&match_finder_test));
     return test;
 }
@@ -0,0 +1,114 @@
+// mapped_file_test.cpp: test case for memory-mapped file device
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/iostreams for library home page.
+
+#include <hamigaki/iostreams/device/mapped_file.hpp>
+#include <hamigaki/iostreams/device/file_descriptor.hpp>
+#include <boost/iterator/counting_iterator.hpp>
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <cstdio>
+
+namespace io_ex = hamigaki::iostreams;
+namespace io = boost::iostreams;
+namespace ut = boost::unit_test;
+
+void mapped_file_test()
+{
+    const std::string filename("mapped_file_test.dat");
+
+    char data[100];
+    std::copy(
+        boost::counting_iterator<char>(0),
+        boost::counting_iterator<char>(100),
+        &data[0]);
+
+    const std::streamsize size = static_cast<std::streamsize>(sizeof(data));
+
+    {
+        io_ex::file_descriptor_sink sink(filename);
+        BOOST_CHECK_EQUAL(sink.write(data, size), size);
+    }
+
+    io_ex::mapped_file_source src(filename, io_ex::map_advice::sequential);
+    BOOST_CHECK(src.is_open());
+    BOOST_CHECK_EQUAL(src.size(), sizeof(data));
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        data, data+size, src.data(), src.data()+src.size());
+
+    char data2[100];
+    BOOST_CHECK_EQUAL(src.read(data2, 60), 60);
+    BOOST_CHECK_EQUAL(src.read(data2+60, size), 40);
+    BOOST_CHECK_EQUAL(src.read(data2, size), -1);
+    BOOST_CHECK_EQUAL_COLLECTIONS(data, data+size, data2, data2+size);
+
+    BOOST_CHECK_EQUAL(
+        io::position_to_offset(src.seek(0, BOOST_IOS::cur)), 100);
+    BOOST_CHECK_EQUAL(
+        io::position_to_offset(src.seek(-10, BOOST_IOS::end)), 90);
+    BOOST_CHECK_EQUAL(
+        io::position_to_offset(src.seek(-20, BOOST_IOS::cur)), 70);
+
+    char c;
+    BOOST_CHECK_EQUAL(src.read(&c, 1), 1);
+    BOOST_CHECK_EQUAL(c, data[70]);
+
+    BOOST_CHECK_EQUAL(
+        io::position_to_offset(src.seek(200, BOOST_IOS::beg)), 200);
+    BOOST_CHECK_EQUAL(src.read(&c, 1), -1);
+    BOOST_CHECK_THROW(src.seek(-1, BOOST_IOS::beg), BOOST_IOSTREAMS_FAILURE);
+
+    src.advise(io_ex::map_advice::random);
+    src.advise(50, 10, io_ex::map_advice::will_need);
+    src.advise(500, 10, io_ex::map_advice::will_need);
+
+    // the copies share the mapping
+    io_ex::mapped_file_source src2(src);
+    src.close();
+    BOOST_CHECK(!src.is_open());
+    BOOST_CHECK(src2.is_open());
+    BOOST_CHECK_EQUAL(src2.data()[99], data[99]);
+    src2.close();
+
+    std::remove(filename.c_str());
+}
+
+void empty_test()
+{
+    const std::string filename("mapped_file_test.dat");
+
+    io_ex::file_descriptor_sink(filename).close();
+
+    io_ex::mapped_file_source src(filename);
+    BOOST_CHECK(src.is_open());
+    BOOST_CHECK_EQUAL(src.size(), 0u);
+
+    char c;
+    BOOST_CHECK_EQUAL(src.read(&c, 1), -1);
+    src.close();
+
+    std::remove(filename.c_str());
+}
+
+void open_error_test()
+{
+    io_ex::mapped_file_source src;
+    BOOST_CHECK(!src.is_open());
+    BOOST_CHECK_THROW(
+        src.open("mapped_file_test_not_found.dat"), BOOST_IOSTREAMS_FAILURE);
+    BOOST_CHECK(!src.is_open());
+}
+
+ut::test_suite* init_unit_test_suite(int, char* [])
+{
+    ut::test_suite* test = BOOST_TEST_SUITE("mapped file test");
+    test->add(BOOST_TEST_CASE(&mapped_file_test));
+    test->add(BOOST_TEST_CASE(&empty_test));
+    test->add(BOOST_TEST_CASE(&open_error_test));
+    return test;
+}
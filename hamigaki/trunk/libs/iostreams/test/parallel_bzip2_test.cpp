@@ -0,0 +1,131 @@
+// parallel_bzip2_test.cpp: test case for parallel_bzip2_decompressor
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/iostreams for library home page.
+
+#include <hamigaki/iostreams/filter/parallel_bzip2.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/bzip2.hpp>
+#include <boost/iostreams/compose.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/test/unit_test.hpp>
+#include <sstream>
+
+namespace io_ex = hamigaki::iostreams;
+namespace io = boost::iostreams;
+namespace ut = boost::unit_test;
+
+std::string make_data(std::size_t size)
+{
+    std::ostringstream os;
+    boost::uint32_t x = 1;
+    while (os.tellp() < static_cast<std::streamoff>(size))
+    {
+        x = x * 1103515245u + 12345u;
+        if ((x >> 28) == 0)
+            os << static_cast<char>(x >> 16);
+        else
+            os << "line " << ((x >> 16) % 1000) << '\n';
+    }
+    return os.str().substr(0, size);
+}
+
+std::string compress(const std::string& data, int block_size)
+{
+    std::string compressed;
+    io::copy(
+        io::array_source(data.c_str(), data.size()),
+        io::compose(
+            io::bzip2_compressor(io::bzip2_params(block_size)),
+            io::back_inserter(compressed)
+        )
+    );
+    return compressed;
+}
+
+std::string decompress(
+    const std::string& compressed, const io_ex::parallel_bzip2_decompressor& f)
+{
+    std::string decompressed;
+    io::copy(
+        io::compose(
+            f,
+            io::array_source(compressed.c_str(), compressed.size())
+        ),
+        io::back_inserter(decompressed)
+    );
+    return decompressed;
+}
+
+std::string decompress(const std::string& compressed, std::size_t threads)
+{
+    return decompress(
+        compressed, io_ex::parallel_bzip2_decompressor(threads, 4096));
+}
+
+void parallel_bzip2_test()
+{
+    BOOST_CHECK(decompress(compress(std::string(), 1), 2).empty());
+    BOOST_CHECK(decompress(compress("a", 1), 2) == "a");
+
+    const std::string& data = make_data(1024*1024 + 123);
+    const std::string& compressed = compress(data, 1);
+    BOOST_CHECK(decompress(compressed, 1) == data);
+    BOOST_CHECK(decompress(compressed, 4) == data);
+
+    const std::string& small = data.substr(0, 64*1024);
+    BOOST_CHECK(decompress(compress(small, 9), 3) == small);
+}
+
+void multi_stream_test()
+{
+    // like "cat a.bz2 b.bz2" or the output of pbzip2
+    const std::string& first = make_data(300*1024);
+    const std::string& second = make_data(200*1024 + 7);
+    const std::string& compressed =
+        compress(first, 1) + compress(std::string(), 9) + compress(second, 2);
+
+    BOOST_CHECK(decompress(compressed, 3) == first + second);
+}
+
+void reuse_test()
+{
+    const std::string& data = make_data(300*1024);
+    const std::string& compressed = compress(data, 1);
+
+    // the state is reset by close()
+    io_ex::parallel_bzip2_decompressor f(2);
+    BOOST_CHECK(decompress(compressed, f) == data);
+    BOOST_CHECK(decompress(compressed, f) == data);
+}
+
+void broken_data_test()
+{
+    const std::string& data = make_data(500*1024);
+    const std::string& compressed = compress(data, 1);
+
+    std::string broken(compressed);
+    broken[broken.size() / 2] ^= 0x55;
+    BOOST_CHECK_THROW(decompress(broken, 2), BOOST_IOSTREAMS_FAILURE);
+
+    std::string truncated(compressed, 0, compressed.size() - 20);
+    BOOST_CHECK_THROW(decompress(truncated, 2), BOOST_IOSTREAMS_FAILURE);
+
+    BOOST_CHECK_THROW(
+        decompress("not bzip2 data", 2), BOOST_IOSTREAMS_FAILURE);
+}
+
+ut::test_suite* init_unit_test_suite(int, char* [])
+{
+    ut::test_suite* test = BOOST_TEST_SUITE("parallel bzip2 test");
+    test->add(BOOST_TEST_CASE(&parallel_bzip2_test));
+    test->add(BOOST_TEST_CASE(&multi_stream_test));
+    test->add(BOOST_TEST_CASE(&reuse_test));
+    test->add(BOOST_TEST_CASE(&broken_data_test));
+    return test;
+}
@@ -0,0 +1,112 @@
+// parallel_gzip_test.cpp: test case for parallel_gzip_compressor
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/iostreams for library home page.
+
+#include <hamigaki/iostreams/filter/parallel_gzip.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/compose.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/test/unit_test.hpp>
+#include <sstream>
+
+namespace io_ex = hamigaki::iostreams;
+namespace io = boost::iostreams;
+namespace ut = boost::unit_test;
+
+std::string make_data(std::size_t size)
+{
+    std::ostringstream os;
+    boost::uint32_t x = 1;
+    while (os.tellp() < static_cast<std::streamoff>(size))
+    {
+        x = x * 1103515245u + 12345u;
+        if ((x >> 28) == 0)
+            os << static_cast<char>(x >> 16);
+        else
+            os << "line " << ((x >> 16) % 1000) << '\n';
+    }
+    return os.str().substr(0, size);
+}
+
+void parallel_gzip_test_aux(
+    const std::string& data, std::size_t thread_count, std::size_t block_size)
+{
+    std::string compressed;
+    io::copy(
+        io::array_source(data.c_str(), data.size()),
+        io::compose(
+            io_ex::parallel_gzip_compressor(thread_count, block_size),
+            io::back_inserter(compressed)
+        )
+    );
+
+    BOOST_CHECK_EQUAL(
+        static_cast<unsigned char>(compressed[0]), 0x1Fu);
+    BOOST_CHECK_EQUAL(
+        static_cast<unsigned char>(compressed[1]), 0x8Bu);
+
+    std::string decompressed;
+    io::copy(
+        io::compose(
+            io::gzip_decompressor(),
+            io::array_source(compressed.c_str(), compressed.size())
+        ),
+        io::back_inserter(decompressed)
+    );
+    BOOST_CHECK(decompressed == data);
+}
+
+void parallel_gzip_test()
+{
+    parallel_gzip_test_aux(std::string(), 2, 32*1024);
+    parallel_gzip_test_aux("a", 2, 32*1024);
+
+    const std::string& data = make_data(1024*1024 + 123);
+    parallel_gzip_test_aux(data, 1, 32*1024);
+    parallel_gzip_test_aux(data, 4, 32*1024);
+    parallel_gzip_test_aux(data, 4, 128*1024);
+    parallel_gzip_test_aux(data.substr(0, 64*1024), 3, 32*1024);
+}
+
+void dictionary_test()
+{
+    // the second block must be compressed by referring to the first block
+    const std::string& quarter = make_data(16*1024);
+    const std::string& half = quarter + quarter;
+    const std::string& data = half + half;
+
+    std::string compressed;
+    io::copy(
+        io::array_source(data.c_str(), data.size()),
+        io::compose(
+            io_ex::parallel_gzip_compressor(2, 32*1024),
+            io::back_inserter(compressed)
+        )
+    );
+
+    std::string single;
+    io::copy(
+        io::array_source(half.c_str(), half.size()),
+        io::compose(
+            io_ex::parallel_gzip_compressor(2, 32*1024),
+            io::back_inserter(single)
+        )
+    );
+
+    BOOST_CHECK(compressed.size() < single.size() + 1024);
+}
+
+ut::test_suite* init_unit_test_suite(int, char* [])
+{
+    ut::test_suite* test = BOOST_TEST_SUITE("parallel gzip test");
+    test->add(BOOST_TEST_CASE(&parallel_gzip_test));
+    test->add(BOOST_TEST_CASE(&dictionary_test));
+    return test;
+}
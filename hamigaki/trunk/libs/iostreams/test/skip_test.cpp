@@ -0,0 +1,292 @@
+// skip_test.cpp: test case for skip()
+
+// Copyright Takeshi Mouri 2008.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// See http://hamigaki.sourceforge.jp/libs/iostreams for library home page.
+
+#include <hamigaki/iostreams/device/file.hpp>
+#include <hamigaki/iostreams/device/file_descriptor.hpp>
+#include <hamigaki/iostreams/skip.hpp>
+#include <boost/iostreams/detail/adapter/direct_adapter.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/read.hpp>
+#include <boost/iostreams/write.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#if !defined(BOOST_WINDOWS)
+    #include <signal.h>
+    #include <sys/stat.h>
+    #include <sys/types.h>
+    #include <unistd.h>
+#endif
+
+namespace io_ex = hamigaki::iostreams;
+namespace io = boost::iostreams;
+namespace ut = boost::unit_test;
+
+inline char pattern(io::stream_offset pos)
+{
+    return static_cast<char>(pos % 251);
+}
+
+// non-seekable source which counts the calls of read()
+class counting_source
+{
+public:
+    typedef char char_type;
+    typedef io::source_tag category;
+
+    explicit counting_source(io::stream_offset size)
+        : size_(size), pos_(0), reads_(0)
+    {
+    }
+
+    std::streamsize read(char* s, std::streamsize n)
+    {
+        ++reads_;
+        if (pos_ == size_)
+            return -1;
+
+        std::streamsize amt = hamigaki::auto_min(n, size_ - pos_);
+        for (std::streamsize i = 0; i < amt; ++i)
+            s[i] = pattern(pos_++);
+        return amt;
+    }
+
+    io::stream_offset position() const
+    {
+        return pos_;
+    }
+
+    std::size_t reads() const
+    {
+        return reads_;
+    }
+
+private:
+    io::stream_offset size_;
+    io::stream_offset pos_;
+    std::size_t reads_;
+};
+
+class skippable_source : public counting_source
+{
+public:
+    struct category
+        : io::source_tag
+        , io_ex::skippable_tag
+    {};
+
+    explicit skippable_source(io::stream_offset size)
+        : counting_source(size), skips_(0)
+    {
+    }
+
+    void skip(io::stream_offset off)
+    {
+        ++skips_;
+        char c;
+        while (off-- > 0)
+            counting_source::read(&c, 1);
+    }
+
+    std::size_t skips() const
+    {
+        return skips_;
+    }
+
+private:
+    std::size_t skips_;
+};
+
+class pass_through_filter
+{
+public:
+    typedef char char_type;
+
+    struct category
+        : io::input_filter_tag
+        , io::multichar_tag
+    {};
+
+    template<class Source>
+    std::streamsize read(Source& src, char* s, std::streamsize n)
+    {
+        return io::read(src, s, n);
+    }
+};
+
+void read_through_test()
+{
+    const io::stream_offset size = 1000000;
+    counting_source src(size);
+
+    std::vector<char> buffer;
+    io_ex::skip(src, 3, buffer);
+    BOOST_CHECK_EQUAL(src.position(), 3);
+
+    // the buffer is not larger than the skip size
+    BOOST_CHECK_EQUAL(buffer.size(), 3u);
+
+    io_ex::skip(src, size-4, buffer);
+    BOOST_CHECK_EQUAL(src.position(), size-1);
+    BOOST_CHECK_EQUAL(buffer.size(), io_ex::skip_buffer_size);
+    BOOST_CHECK(src.reads() <= 1 + (size / io_ex::skip_buffer_size) + 1);
+
+    char c;
+    BOOST_CHECK_EQUAL(io::read(src, &c, 1), 1);
+    BOOST_CHECK_EQUAL(c, pattern(size-1));
+
+    BOOST_CHECK_THROW(io_ex::skip(src, 1), BOOST_IOSTREAMS_FAILURE);
+}
+
+void skippable_test()
+{
+    skippable_source src(1000);
+    io_ex::skip(src, 500);
+    BOOST_CHECK_EQUAL(src.skips(), 1u);
+    BOOST_CHECK_EQUAL(src.position(), 500);
+}
+
+void seekable_test()
+{
+    char data[100];
+    for (int i = 0; i < 100; ++i)
+        data[i] = pattern(i);
+
+    io::detail::direct_adapter<io::array_source>
+        src(io::array_source(data, sizeof(data)));
+    io_ex::skip(src, 60);
+
+    char c;
+    BOOST_CHECK_EQUAL(io::read(src, &c, 1), 1);
+    BOOST_CHECK_EQUAL(c, pattern(60));
+}
+
+void filter_test()
+{
+    const io::stream_offset size = 500000;
+    counting_source src(size);
+    pass_through_filter flt;
+
+    io_ex::skip(flt, src, size-1);
+    BOOST_CHECK_EQUAL(src.position(), size-1);
+    BOOST_CHECK(src.reads() <= 1 + (size / io_ex::skip_buffer_size));
+}
+
+template<class Sink>
+void write_pattern(Sink& sink, io::stream_offset size)
+{
+    std::vector<char> buffer(4096);
+    for (io::stream_offset pos = 0; pos < size; )
+    {
+        std::streamsize amt = hamigaki::auto_min(buffer.size(), size-pos);
+        for (std::streamsize i = 0; i < amt; ++i)
+            buffer[i] = pattern(pos+i);
+        io::write(sink, &buffer[0], amt);
+        pos += amt;
+    }
+}
+
+template<class Source>
+void check_skip(Source& src, io::stream_offset size, io::stream_offset off)
+{
+    io_ex::skip(src, off);
+
+    char c;
+    BOOST_CHECK_EQUAL(io::read(src, &c, 1), 1);
+    BOOST_CHECK_EQUAL(c, pattern(off));
+
+    io_ex::skip(src, size-off-2);
+    BOOST_CHECK_EQUAL(io::read(src, &c, 1), 1);
+    BOOST_CHECK_EQUAL(c, pattern(size-1));
+}
+
+void file_test()
+{
+    const io::stream_offset size = 300000;
+    const std::string filename("skip_test.dat");
+    {
+        io_ex::file_sink sink(filename, BOOST_IOS::binary);
+        write_pattern(sink, size);
+    }
+
+    {
+        io_ex::file_source src(filename, BOOST_IOS::binary);
+        check_skip(src, size, 100000);
+    }
+
+    {
+        io_ex::file_descriptor_source src(filename);
+        check_skip(src, size, 100000);
+    }
+
+    std::remove(filename.c_str());
+}
+
+#if !defined(BOOST_WINDOWS)
+void write_fifo(const std::string& filename, io::stream_offset size)
+{
+    try
+    {
+        io_ex::file_descriptor_sink sink(filename);
+        write_pattern(sink, size);
+    }
+    catch (...)
+    {
+    }
+}
+
+template<class Source>
+void fifo_test_impl()
+{
+    const io::stream_offset size = 1000000;
+    const std::string filename("skip_test.fifo");
+
+    BOOST_REQUIRE(::mkfifo(filename.c_str(), 0600) == 0);
+    ::signal(SIGPIPE, SIG_IGN);
+
+    boost::thread writer(boost::bind(&write_fifo, filename, size));
+    try
+    {
+        Source src(filename, BOOST_IOS::in|BOOST_IOS::binary);
+        check_skip(src, size, 300000);
+    }
+    catch (...)
+    {
+        writer.join();
+        ::unlink(filename.c_str());
+        throw;
+    }
+    writer.join();
+    ::unlink(filename.c_str());
+}
+
+void fifo_test()
+{
+    fifo_test_impl<io_ex::file_source>();
+    fifo_test_impl<io_ex::file_descriptor_source>();
+}
+#endif // !defined(BOOST_WINDOWS)
+
+ut::test_suite* init_unit_test_suite(int, char* [])
+{
+    ut::test_suite* test = BOOST_TEST_SUITE("skip test");
+    test->add(BOOST_TEST_CASE(&read_through_test));
+    test->add(BOOST_TEST_CASE(&skippable_test));
+    test->add(BOOST_TEST_CASE(&seekable_test));
+    test->add(BOOST_TEST_CASE(&filter_test));
+    test->add(BOOST_TEST_CASE(&file_test));
+#if !defined(BOOST_WINDOWS)
+    test->add(BOOST_TEST_CASE(&fifo_test));
+#endif
+    return test;
+}